@@ -0,0 +1,382 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
+#define HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/fe_hash.h"
+
+namespace hybridse {
+namespace base {
+
+// mergeable summaries of a column. the pre-aggregator keeps one sketch per bucket,
+// so a long window merges a few sketches instead of scanning the raw rows
+class Sketch {
+ public:
+    virtual ~Sketch() {}
+    virtual std::unique_ptr<Sketch> Clone() const = 0;
+    // append the state to `out`
+    virtual void Serialize(std::string* out) const = 0;
+    // merge a state produced by `Serialize`, return false if it is malformed
+    virtual bool MergeFrom(const char* data, size_t size) = 0;
+    virtual void Reset() = 0;
+};
+
+static constexpr uint32_t kSketchHashSeed = 0xe17a1465;
+
+// the tablet and the sql engine must hash a value the same way,
+// integers are widened to int64 and floats to double before hashing
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>{}, uint64_t> SketchHash(T val) {
+    if constexpr (std::is_floating_point<T>{}) {
+        double v = val;
+        return MurmurHash64A(&v, sizeof(double), kSketchHashSeed);
+    } else {
+        int64_t v = val;
+        return MurmurHash64A(&v, sizeof(int64_t), kSketchHashSeed);
+    }
+}
+
+inline uint64_t SketchHash(const char* data, size_t size) {
+    return MurmurHash64A(data, static_cast<int>(size), kSketchHashSeed);
+}
+
+/**
+ * HyperLogLog distinct counter with 2^12 registers, the standard error is about 1.6%.
+ *
+ * Sketches of small sets keep the touched registers only, a dense register
+ * array is used once that gets larger than 1/8 of the dense one.
+ *
+ * state := precision(uint8) encoding(uint8) [registers(uint8 * 4096) | cnt(uint32) (idx(uint16) rank(uint8)) * cnt]
+ */
+class HyperLogLog : public Sketch {
+ public:
+    static constexpr uint32_t kPrecision = 12;
+    static constexpr uint32_t kRegisterNum = 1u << kPrecision;
+
+    HyperLogLog() {}
+    HyperLogLog(const HyperLogLog&) = default;
+    HyperLogLog& operator=(const HyperLogLog&) = default;
+
+    void Add(uint64_t hash) {
+        uint32_t idx = hash >> (64 - kPrecision);
+        uint64_t rest = (hash << kPrecision) | (1ull << (kPrecision - 1));
+        SetRegister(idx, static_cast<uint8_t>(__builtin_clzll(rest) + 1));
+    }
+
+    void Merge(const HyperLogLog& other) {
+        if (other.dense_.empty()) {
+            for (uint32_t entry : other.sparse_) {
+                SetRegister(entry >> 8, entry & 0xFF);
+            }
+            return;
+        }
+        ToDense();
+        for (uint32_t i = 0; i < kRegisterNum; i++) {
+            dense_[i] = std::max(dense_[i], other.dense_[i]);
+        }
+    }
+
+    uint64_t Estimate() const {
+        double sum = 0;
+        uint32_t zeros = 0;
+        if (dense_.empty()) {
+            zeros = kRegisterNum - sparse_.size();
+            sum = zeros;
+            for (uint32_t entry : sparse_) {
+                sum += std::ldexp(1.0, -static_cast<int>(entry & 0xFF));
+            }
+        } else {
+            for (uint8_t rank : dense_) {
+                sum += std::ldexp(1.0, -static_cast<int>(rank));
+                zeros += rank == 0;
+            }
+        }
+        const double m = kRegisterNum;
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0) {
+            // linear counting is more accurate for small sets
+            estimate = m * std::log(m / zeros);
+        }
+        return static_cast<uint64_t>(estimate + 0.5);
+    }
+
+    std::unique_ptr<Sketch> Clone() const override { return std::make_unique<HyperLogLog>(*this); }
+
+    void Serialize(std::string* out) const override {
+        out->push_back(static_cast<char>(kPrecision));
+        if (dense_.empty()) {
+            out->push_back(kSparse);
+            uint32_t cnt = sparse_.size();
+            out->append(reinterpret_cast<const char*>(&cnt), sizeof(uint32_t));
+            for (uint32_t entry : sparse_) {
+                uint16_t idx = entry >> 8;
+                out->append(reinterpret_cast<const char*>(&idx), sizeof(uint16_t));
+                out->push_back(static_cast<char>(entry & 0xFF));
+            }
+        } else {
+            out->push_back(kDense);
+            out->append(reinterpret_cast<const char*>(dense_.data()), kRegisterNum);
+        }
+    }
+
+    bool MergeFrom(const char* data, size_t size) override {
+        if (size < 2 || static_cast<uint8_t>(data[0]) != kPrecision) {
+            return false;
+        }
+        if (data[1] == kDense) {
+            if (size != 2 + kRegisterNum) {
+                return false;
+            }
+            ToDense();
+            for (uint32_t i = 0; i < kRegisterNum; i++) {
+                dense_[i] = std::max(dense_[i], static_cast<uint8_t>(data[2 + i]));
+            }
+            return true;
+        }
+        uint32_t cnt = 0;
+        if (data[1] != kSparse || size < 2 + sizeof(uint32_t)) {
+            return false;
+        }
+        memcpy(&cnt, data + 2, sizeof(uint32_t));
+        if (size != 2 + sizeof(uint32_t) + cnt * 3ull) {
+            return false;
+        }
+        const char* entry = data + 2 + sizeof(uint32_t);
+        for (uint32_t i = 0; i < cnt; i++, entry += 3) {
+            uint16_t idx = 0;
+            memcpy(&idx, entry, sizeof(uint16_t));
+            if (idx >= kRegisterNum) {
+                return false;
+            }
+            SetRegister(idx, static_cast<uint8_t>(entry[2]));
+        }
+        return true;
+    }
+
+    void Reset() override {
+        sparse_.clear();
+        dense_.clear();
+    }
+
+ private:
+    static constexpr char kDense = 0;
+    static constexpr char kSparse = 1;
+    static constexpr uint32_t kMaxSparseSize = kRegisterNum / 8;
+
+    void SetRegister(uint32_t idx, uint8_t rank) {
+        if (!dense_.empty()) {
+            dense_[idx] = std::max(dense_[idx], rank);
+            return;
+        }
+        // a sparse entry is idx << 8 | rank, the entries are sorted by idx
+        auto it = std::lower_bound(sparse_.begin(), sparse_.end(), idx << 8);
+        if (it != sparse_.end() && (*it >> 8) == idx) {
+            if ((*it & 0xFF) < rank) {
+                *it = idx << 8 | rank;
+            }
+            return;
+        }
+        sparse_.insert(it, idx << 8 | rank);
+        if (sparse_.size() > kMaxSparseSize) {
+            ToDense();
+        }
+    }
+
+    void ToDense() {
+        if (!dense_.empty()) {
+            return;
+        }
+        dense_.assign(kRegisterNum, 0);
+        for (uint32_t entry : sparse_) {
+            dense_[entry >> 8] = entry & 0xFF;
+        }
+        sparse_.clear();
+        sparse_.shrink_to_fit();
+    }
+
+    std::vector<uint32_t> sparse_;
+    std::vector<uint8_t> dense_;
+};
+
+/**
+ * KLL quantile sketch of doubles. The rank error is about 1.7 / k, k = 200 keeps
+ * the error of a median under 1% of the values.
+ *
+ * Level i keeps items of weight 2^i, a full level is sorted and every other item
+ * is promoted to the next level. The lower levels get smaller capacities, so the
+ * sketch keeps at most about 3k items whatever the number of values added.
+ *
+ * state := k(uint32) n(uint64) level_cnt(uint32) (size(uint32) item(double) * size) * level_cnt
+ */
+class QuantileSketch : public Sketch {
+ public:
+    static constexpr uint32_t kDefaultK = 200;
+
+    explicit QuantileSketch(uint32_t k = kDefaultK) : k_(std::max<uint32_t>(k, 8)), levels_(1) {}
+    QuantileSketch(const QuantileSketch&) = default;
+    QuantileSketch& operator=(const QuantileSketch&) = default;
+
+    void Add(double val) {
+        levels_[0].push_back(val);
+        n_++;
+        if (levels_[0].size() >= LevelCapacity(0)) {
+            Compress();
+        }
+    }
+
+    void Merge(const QuantileSketch& other) {
+        if (levels_.size() < other.levels_.size()) {
+            levels_.resize(other.levels_.size());
+        }
+        for (size_t level = 0; level < other.levels_.size(); level++) {
+            levels_[level].insert(levels_[level].end(), other.levels_[level].begin(), other.levels_[level].end());
+        }
+        n_ += other.n_;
+        Compress();
+    }
+
+    // the number of values added
+    uint64_t Count() const { return n_; }
+
+    // the value of rank q * n, q in [0, 1]
+    double Quantile(double q) const {
+        std::vector<std::pair<double, uint64_t>> items;
+        uint64_t total = 0;
+        for (size_t level = 0; level < levels_.size(); level++) {
+            for (double item : levels_[level]) {
+                items.emplace_back(item, 1ull << level);
+                total += 1ull << level;
+            }
+        }
+        if (items.empty()) {
+            return 0;
+        }
+        std::sort(items.begin(), items.end());
+        double target = std::min(std::max(q, 0.0), 1.0) * total;
+        uint64_t cum = 0;
+        for (const auto& item : items) {
+            cum += item.second;
+            if (cum >= target) {
+                return item.first;
+            }
+        }
+        return items.back().first;
+    }
+
+    std::unique_ptr<Sketch> Clone() const override { return std::make_unique<QuantileSketch>(*this); }
+
+    void Serialize(std::string* out) const override {
+        uint32_t level_cnt = levels_.size();
+        out->append(reinterpret_cast<const char*>(&k_), sizeof(uint32_t));
+        out->append(reinterpret_cast<const char*>(&n_), sizeof(uint64_t));
+        out->append(reinterpret_cast<const char*>(&level_cnt), sizeof(uint32_t));
+        for (const auto& level : levels_) {
+            uint32_t level_size = level.size();
+            out->append(reinterpret_cast<const char*>(&level_size), sizeof(uint32_t));
+            out->append(reinterpret_cast<const char*>(level.data()), level_size * sizeof(double));
+        }
+    }
+
+    bool MergeFrom(const char* data, size_t size) override {
+        QuantileSketch other;
+        size_t pos = 0;
+        auto read = [&](void* dst, size_t len) {
+            if (pos + len > size) {
+                return false;
+            }
+            memcpy(dst, data + pos, len);
+            pos += len;
+            return true;
+        };
+        uint32_t level_cnt = 0;
+        if (!read(&other.k_, sizeof(uint32_t)) || !read(&other.n_, sizeof(uint64_t)) ||
+            !read(&level_cnt, sizeof(uint32_t)) || level_cnt > 64) {
+            return false;
+        }
+        other.levels_.resize(level_cnt);
+        for (auto& level : other.levels_) {
+            uint32_t level_size = 0;
+            if (!read(&level_size, sizeof(uint32_t)) || level_size > (size - pos) / sizeof(double)) {
+                return false;
+            }
+            level.resize(level_size);
+            read(level.data(), level_size * sizeof(double));
+        }
+        if (pos != size) {
+            return false;
+        }
+        Merge(other);
+        return true;
+    }
+
+    void Reset() override {
+        levels_.assign(1, {});
+        n_ = 0;
+    }
+
+ private:
+    uint32_t LevelCapacity(size_t level) const {
+        double depth = levels_.size() - 1 - level;
+        return std::max<uint32_t>(2, static_cast<uint32_t>(std::ceil(k_ * std::pow(2.0 / 3.0, depth))));
+    }
+
+    void Compress() {
+        while (true) {
+            size_t level = 0;
+            while (level < levels_.size() && levels_[level].size() < LevelCapacity(level)) {
+                level++;
+            }
+            if (level == levels_.size()) {
+                return;
+            }
+            if (level + 1 == levels_.size()) {
+                levels_.emplace_back();
+            }
+            auto& items = levels_[level];
+            auto& next = levels_[level + 1];
+            std::sort(items.begin(), items.end());
+            // promote the odd or the even items in turn, so the error does not drift to one side
+            size_t paired = items.size() & ~static_cast<size_t>(1);
+            for (size_t i = odd_ ? 1 : 0; i < paired; i += 2) {
+                next.push_back(items[i]);
+            }
+            odd_ = !odd_;
+            items.erase(items.begin(), items.begin() + paired);
+        }
+    }
+
+    uint32_t k_;
+    uint64_t n_ = 0;
+    bool odd_ = false;
+    std::vector<std::vector<double>> levels_;
+};
+
+}  // namespace base
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
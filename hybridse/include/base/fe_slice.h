@@ -150,6 +150,9 @@ class RefCountedSlice : public Slice {
     RefCountedSlice &operator=(const RefCountedSlice &);
     RefCountedSlice &operator=(RefCountedSlice &&);
 
+    // true if the slice owns its buffer
+    bool IsManaged() const { return ref_cnt_ != nullptr; }
+
  private:
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
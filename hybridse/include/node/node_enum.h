@@ -98,6 +98,7 @@ enum SqlNodeType {
     kAlterTableStmt,
     kShowStmt,
     kCompressType,
+    kMemoryHeadMinutes,
     kSqlNodeTypeLast,  // debug type
 };
 
@@ -347,6 +348,7 @@ enum StorageMode {
 enum CompressType {
     kNoCompress = 0,
     kSnappy = 1,
+    kZlibDict = 2,
 };
 
 // batch plan node type
@@ -324,6 +324,8 @@ inline const StorageMode NameToStorageMode(const std::string& name) {
 inline absl::StatusOr<CompressType> NameToCompressType(const std::string& name) {
     if (absl::EqualsIgnoreCase(name, "snappy")) {
         return CompressType::kSnappy;
+    } else if (absl::EqualsIgnoreCase(name, "zlibdict")) {
+        return CompressType::kZlibDict;
     } else if (absl::EqualsIgnoreCase(name, "nocompress")) {
         return CompressType::kNoCompress;
     }
@@ -1911,6 +1913,20 @@ class CompressTypeNode : public SqlNode {
     CompressType compress_type_;
 };
 
+class MemoryHeadMinutesNode : public SqlNode {
+ public:
+    explicit MemoryHeadMinutesNode(int64_t minutes) : SqlNode(kMemoryHeadMinutes, 0, 0), minutes_(minutes) {}
+
+    ~MemoryHeadMinutesNode() {}
+
+    int64_t GetMinutes() const { return minutes_; }
+
+    void Print(std::ostream &output, const std::string &org_tab) const;
+
+ private:
+    int64_t minutes_;
+};
+
 class CreateTableLikeClause {
  public:
     CreateTableLikeClause() = default;
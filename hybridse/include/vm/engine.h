@@ -35,6 +35,8 @@
 #include "vm/catalog.h"
 #include "vm/engine_context.h"
 #include "vm/router.h"
+#include "vm/parallel_executor.h"
+#include "vm/run_trace.h"
 
 namespace hybridse {
 namespace vm {
@@ -44,6 +46,7 @@ using ::hybridse::codec::Row;
 inline constexpr const char* LONG_WINDOWS = "long_windows";
 
 class Engine;
+struct RunMemoryQuota;
 /// \brief An options class for controlling engine behaviour.
 class EngineOptions {
  public:
@@ -170,6 +173,32 @@ class RunSession {
     /// Return if this run session support printing debug information.
     bool IsDebug() { return is_debug_; }
 
+    /// Set the max number of producer subtrees evaluated concurrently while
+    /// running a request, default `0` which runs all producers serially.
+    /// It takes effect only with a parallel executor.
+    void SetMaxParallelProducers(uint32_t num) { max_parallel_producers_ = num; }
+    /// Return the max number of producer subtrees evaluated concurrently.
+    uint32_t GetMaxParallelProducers() const { return max_parallel_producers_; }
+    /// Set the executor which runs the concurrent producer subtrees, default `nullptr`
+    /// which runs all producers serially. The executor should outlive the runs.
+    void SetParallelExecutor(ParallelExecutor* executor) { parallel_executor_ = executor; }
+    /// Return the executor of the concurrent producer subtrees.
+    ParallelExecutor* GetParallelExecutor() const { return parallel_executor_; }
+
+    /// Set the max bytes of runtime memory of each run step, default `0` which means unlimited.
+    /// The run fails if any step exceeds the limit.
+    void SetMemoryLimit(size_t bytes) { memory_limit_ = bytes; }
+    /// Return the peak bytes of runtime memory of a run step in the last run.
+    size_t GetPeakMemory() const { return peak_memory_; }
+    /// Return if the last run failed because of the memory limit.
+    bool IsMemoryExceeded() const { return memory_exceeded_; }
+
+    /// Record the time of each runner into `trace` in the following runs, default `nullptr`
+    /// which disables tracing. The trace should outlive the runs.
+    void SetTrace(RunTrace* trace) { trace_ = trace; }
+    /// Return the trace of the runs.
+    RunTrace* GetTrace() const { return trace_; }
+
     /// Bind this run session with specific procedure
     void SetSpName(const std::string& sp_name) { sp_name_ = sp_name; }
     /// Return the engine mode of this run session
@@ -184,11 +213,20 @@ class RunSession {
     }
 
  protected:
+    // record the memory usage of the last run, return false if it exceeds the limit
+    bool UpdateMemoryStat(const RunMemoryQuota& quota);
+
     std::shared_ptr<hybridse::vm::CompileInfo> compile_info_;
     hybridse::vm::EngineMode engine_mode_;
     bool is_debug_;
     std::string sp_name_;
     std::shared_ptr<const std::unordered_map<std::string, std::string>> options_ = nullptr;
+    uint32_t max_parallel_producers_ = 0;
+    ParallelExecutor* parallel_executor_ = nullptr;
+    size_t memory_limit_ = 0;
+    size_t peak_memory_ = 0;
+    bool memory_exceeded_ = false;
+    RunTrace* trace_ = nullptr;
     friend Engine;
 };
 
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_VM_PARALLEL_EXECUTOR_H_
+#define HYBRIDSE_INCLUDE_VM_PARALLEL_EXECUTOR_H_
+
+#include <functional>
+#include <vector>
+
+namespace hybridse {
+namespace vm {
+
+/// \brief ParallelExecutor runs the independent producer subtrees of a request concurrently.
+///
+/// It is supplied by the server which embeds the engine, so producers run on the server's
+/// own workers, e.g. bthreads, instead of a thread per producer. Bind it with
+/// RunSession::SetParallelExecutor.
+class ParallelExecutor {
+ public:
+    virtual ~ParallelExecutor() {}
+
+    /// Run all the tasks and return after every one of them has finished.
+    /// The first task should run on the calling thread.
+    virtual void RunAll(const std::vector<std::function<void()>>& tasks) = 0;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_VM_PARALLEL_EXECUTOR_H_
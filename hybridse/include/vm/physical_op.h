@@ -16,6 +16,7 @@
 
 #ifndef HYBRIDSE_INCLUDE_VM_PHYSICAL_OP_H_
 #define HYBRIDSE_INCLUDE_VM_PHYSICAL_OP_H_
+#include <deque>
 #include <list>
 #include <memory>
 #include <set>
@@ -1613,6 +1614,18 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
     void set_out_request_row(bool flag) { output_request_row_ = flag; }
     const RequestWindowOp &window() const { return window_; }
 
+    // add a pre-aggr table of coarser buckets, levels are added from fine to coarse
+    // and the i-th level is the (3 + i)-th producer
+    void AddAggLevel(PhysicalOpNode *aggr, const RequestWindowOp &aggr_window) {
+        level_windows_.push_back(aggr_window);
+        auto &window = level_windows_.back();
+        AddFnInfo(&window.partition_.fn_info());
+        AddFnInfo(&window.sort_.fn_info());
+        AddFnInfo(&window.range_.fn_info());
+        AddFnInfo(&window.index_key_.fn_info());
+        AddProducer(aggr);
+    }
+
     base::Status WithNewChildren(node::NodeManager *nm,
                                  const std::vector<PhysicalOpNode *> &children,
                                  PhysicalOpNode **out) override {
@@ -1621,6 +1634,8 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
 
     RequestWindowOp window_;
     RequestWindowOp agg_window_;
+    // windows of the coarser pre-aggr tables, deque keeps the fn infos in place
+    std::deque<RequestWindowOp> level_windows_;
 
     // for long window, each node has only one projection node
     const node::CallExprNode* project_;
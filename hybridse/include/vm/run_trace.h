@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_VM_RUN_TRACE_H_
+#define HYBRIDSE_INCLUDE_VM_RUN_TRACE_H_
+
+#include <chrono>  // NOLINT
+#include <map>
+#include <mutex>   // NOLINT
+#include <string>
+#include <vector>
+
+namespace hybridse {
+namespace vm {
+
+/// \brief The time a runner took in a traced run.
+struct RunSpan {
+    /// The runner type name
+    std::string name;
+    int32_t runner_id;
+    /// Microseconds from the start of the trace to the start of the runner
+    int64_t start_us;
+    /// Microseconds of the runner, including its producers
+    int64_t cost_us;
+    /// Microseconds of the runner itself, without the spans of its producers finished inside it.
+    /// Lazy handlers are iterated by their consumers, so the time of a storage scan is counted here
+    /// by the runner which reads the rows.
+    int64_t self_us;
+};
+
+/// \brief RunTrace collects the spans of the runners of the runs of a RunSession.
+///
+/// Bind it with RunSession::SetTrace before the run. Producers run in parallel add
+/// their spans concurrently.
+class RunTrace {
+ public:
+    RunTrace() : start_(std::chrono::steady_clock::now()) {}
+    RunTrace(const RunTrace&) = delete;
+    RunTrace& operator=(const RunTrace&) = delete;
+
+    /// Return microseconds since the trace is created
+    int64_t ElapsedMicros() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_)
+            .count();
+    }
+
+    void AddSpan(RunSpan span);
+
+    /// Return the total cost of the finished spans of a runner
+    int64_t GetCost(int32_t runner_id) const;
+
+    /// Return the spans in the order the runners finish
+    std::vector<RunSpan> GetSpans() const;
+
+ private:
+    const std::chrono::steady_clock::time_point start_;
+    mutable std::mutex mu_;
+    std::vector<RunSpan> spans_;
+    std::map<int32_t, int64_t> costs_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_VM_RUN_TRACE_H_
@@ -102,8 +102,12 @@ class SimpleCatalog : public Catalog {
                                              const std::string &partition_cols, const std::string &order_col,
                                              const std::string &filter_col) override;
 
+    // bucket size of the pre-aggr table returned by GetAggrTables, '|' separates the levels
+    void SetAggrBucketSize(const std::string &bucket_size) { aggr_bucket_size_ = bucket_size; }
+
  private:
     bool enable_index_;
+    std::string aggr_bucket_size_ = "1000";
     std::map<std::string,
              std::map<std::string, std::shared_ptr<SimpleCatalogTableHandler>>>
         table_handlers_;
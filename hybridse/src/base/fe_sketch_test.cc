@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/fe_sketch.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace base {
+
+class SketchTest : public ::testing::Test {};
+
+TEST_F(SketchTest, HashWiden) {
+    ASSERT_EQ(SketchHash(static_cast<int16_t>(7)), SketchHash(static_cast<int64_t>(7)));
+    ASSERT_EQ(SketchHash(7), SketchHash(static_cast<int64_t>(7)));
+    ASSERT_EQ(SketchHash(1.5f), SketchHash(1.5));
+    ASSERT_NE(SketchHash(1), SketchHash(2));
+}
+
+TEST_F(SketchTest, HyperLogLog) {
+    for (int64_t n : {0, 1, 100, 10000, 1000000}) {
+        HyperLogLog hll;
+        for (int64_t i = 0; i < n; i++) {
+            hll.Add(SketchHash(i));
+            // duplicates do not count
+            hll.Add(SketchHash(i));
+        }
+        double err = n == 0 ? hll.Estimate() : std::abs(static_cast<double>(hll.Estimate()) - n) / n;
+        ASSERT_LE(err, 0.05) << "n = " << n << ", estimate = " << hll.Estimate();
+    }
+}
+
+TEST_F(SketchTest, HyperLogLogMerge) {
+    // buckets of overlapping keys, small ones stay sparse
+    std::vector<HyperLogLog> buckets(20);
+    for (int64_t i = 0; i < 200000; i++) {
+        buckets[i % 20].Add(SketchHash(i % 50000));
+    }
+    HyperLogLog small;
+    small.Add(SketchHash(std::string("a").data(), 1));
+    buckets.push_back(small);
+
+    HyperLogLog merged;
+    HyperLogLog decoded;
+    for (const auto& bucket : buckets) {
+        merged.Merge(bucket);
+        std::string state;
+        bucket.Serialize(&state);
+        ASSERT_TRUE(decoded.MergeFrom(state.data(), state.size()));
+    }
+    ASSERT_EQ(merged.Estimate(), decoded.Estimate());
+    ASSERT_LE(std::abs(static_cast<double>(merged.Estimate()) - 50001) / 50001, 0.05);
+
+    std::string state;
+    small.Serialize(&state);
+    ASSERT_LT(state.size(), 16u);
+    ASSERT_FALSE(decoded.MergeFrom(state.data(), state.size() - 1));
+    ASSERT_FALSE(decoded.MergeFrom(state.data(), 1));
+    decoded.Reset();
+    ASSERT_EQ(0u, decoded.Estimate());
+}
+
+TEST_F(SketchTest, Quantile) {
+    QuantileSketch empty;
+    ASSERT_EQ(0u, empty.Count());
+    std::vector<QuantileSketch> buckets(100);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(0, 1000);
+    for (int i = 0; i < 1000000; i++) {
+        buckets[i % 100].Add(dist(rng));
+    }
+    QuantileSketch merged;
+    for (const auto& bucket : buckets) {
+        std::string state;
+        bucket.Serialize(&state);
+        ASSERT_TRUE(merged.MergeFrom(state.data(), state.size()));
+    }
+    ASSERT_EQ(1000000u, merged.Count());
+    ASSERT_NEAR(500, merged.Quantile(0.5), 10);
+    ASSERT_NEAR(100, merged.Quantile(0.1), 10);
+    ASSERT_NEAR(990, merged.Quantile(0.99), 10);
+    // the state keeps a few thousand items only
+    std::string state;
+    merged.Serialize(&state);
+    ASSERT_LT(state.size(), 8 * 1000u);
+    ASSERT_FALSE(merged.MergeFrom(state.data(), state.size() - 1));
+}
+
+TEST_F(SketchTest, QuantileSmall) {
+    QuantileSketch sketch;
+    for (int i = 1; i <= 5; i++) {
+        sketch.Add(i);
+    }
+    ASSERT_EQ(3, sketch.Quantile(0.5));
+    ASSERT_EQ(1, sketch.Quantile(0));
+    ASSERT_EQ(5, sketch.Quantile(1));
+}
+
+}  // namespace base
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
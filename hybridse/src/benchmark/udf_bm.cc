@@ -81,6 +81,30 @@ static void BM_AllocFromByteMemPool1000(benchmark::State& state) {  // NOLINT
 static void BM_AllocFromNewFree1000(benchmark::State& state) {  // NOLINT
     NewFree1000(&state, BENCHMARK, state.range(0));
 }
+static void BM_DistinctCountHeapSet(benchmark::State& state) {  // NOLINT
+    DistinctCountHeapSet(&state, BENCHMARK, state.range(0));
+}
+static void BM_DistinctCountManagedSet(benchmark::State& state) {  // NOLINT
+    DistinctCountManagedSet(&state, BENCHMARK, state.range(0));
+}
+static void BM_CateHeapMap(benchmark::State& state) {  // NOLINT
+    CateHeapMap(&state, BENCHMARK, state.range(0));
+}
+static void BM_CateManagedMap(benchmark::State& state) {  // NOLINT
+    CateManagedMap(&state, BENCHMARK, state.range(0));
+}
+static void BM_DistinctCountUdaf(benchmark::State& state) {  // NOLINT
+    DistinctCountUdaf(&state, BENCHMARK, state.range(0));
+}
+static void BM_MedianUdaf(benchmark::State& state) {  // NOLINT
+    MedianUdaf(&state, BENCHMARK, state.range(0));
+}
+static void BM_TopKUdaf(benchmark::State& state) {  // NOLINT
+    TopKUdaf(&state, BENCHMARK, state.range(0));
+}
+static void BM_CountCateUdaf(benchmark::State& state) {  // NOLINT
+    CountCateUdaf(&state, BENCHMARK, state.range(0));
+}
 static void BM_HistoryWindowBuffer(benchmark::State& state) {  // NOLINT
     HistoryWindowBuffer(&state, BENCHMARK, state.range(0));
 }
@@ -157,6 +181,47 @@ BENCHMARK(BM_AllocFromNewFree1000)
     ->Args({1000})
     ->Args({10000});
 
+BENCHMARK(BM_DistinctCountHeapSet)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_DistinctCountManagedSet)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_CateHeapMap)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_CateManagedMap)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_DistinctCountUdaf)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_MedianUdaf)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_TopKUdaf)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_CountCateUdaf)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+
 BENCHMARK(BM_TimestampFormat);
 BENCHMARK(BM_TimestampToString);
 BENCHMARK(BM_DateFormat);
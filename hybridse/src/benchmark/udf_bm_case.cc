@@ -15,15 +15,20 @@
  */
 
 #include "benchmark/udf_bm_case.h"
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include "absl/container/flat_hash_set.h"
 #include "case/case_data_mock.h"
 #include "codec/fe_row_codec.h"
 #include "codec/type_codec.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/window_ir_builder.h"
 #include "gtest/gtest.h"
+#include "udf/containers.h"
 #include "udf/udf.h"
 #include "udf/udf_test.h"
 #include "vm/jit_runtime.h"
@@ -513,6 +518,142 @@ void ByteMemPoolAlloc1000(benchmark::State* state, MODE mode,
         }
     }
 }
+template <typename SetT>
+int64_t RunDistinctCount(int64_t data_size) {
+    int64_t size = 0;
+    {
+        SetT set;
+        for (int64_t i = 0; i < data_size; i++) {
+            set.insert(i % 100);
+        }
+        size = set.size();
+    }
+    hybridse::vm::JitRuntime::get()->ReleaseRunStep();
+    return size;
+}
+template <typename MapT>
+int64_t RunCate(int64_t data_size) {
+    int64_t size = 0;
+    {
+        MapT map;
+        for (int64_t i = 0; i < data_size; i++) {
+            map[i % 100] += i;
+        }
+        size = map.size();
+    }
+    hybridse::vm::JitRuntime::get()->ReleaseRunStep();
+    return size;
+}
+template <typename F>
+void RunContainerCase(benchmark::State* state, MODE mode, int64_t data_size, F run) {
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                benchmark::DoNotOptimize(run(data_size));
+            }
+            break;
+        }
+        case TEST: {
+            ASSERT_EQ(std::min<int64_t>(data_size, 100), run(data_size));
+        }
+    }
+}
+void DistinctCountHeapSet(benchmark::State* state, MODE mode, int64_t data_size) {
+    RunContainerCase(state, mode, data_size, RunDistinctCount<std::unordered_set<int64_t>>);
+}
+void DistinctCountManagedSet(benchmark::State* state, MODE mode, int64_t data_size) {
+    RunContainerCase(state, mode, data_size,
+                     RunDistinctCount<absl::flat_hash_set<int64_t, absl::Hash<int64_t>, std::equal_to<int64_t>,
+                                                          udf::container::ManagedAllocator<int64_t>>>);
+}
+void CateHeapMap(benchmark::State* state, MODE mode, int64_t data_size) {
+    RunContainerCase(state, mode, data_size, RunCate<std::map<int64_t, int64_t>>);
+}
+void CateManagedMap(benchmark::State* state, MODE mode, int64_t data_size) {
+    RunContainerCase(state, mode, data_size, RunCate<udf::container::ManagedMap<int64_t, int64_t>>);
+}
+
+// run the udaf as a window projection does, the states are released with the run step
+template <typename Ret, typename... Args>
+void RunUdafCase(benchmark::State* state, MODE mode, const std::string& name, const Ret& expect,
+                 Args... args) {
+    auto udaf = udf::UdfFunctionBuilder(name)
+                    .args<Args...>()
+                    .template returns<Ret>()
+                    .library(udf::DefaultUdfLibrary::get())
+                    .build();
+    ASSERT_TRUE(udaf.valid());
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                vm::JitRuntime::get()->InitRunStep();
+                benchmark::DoNotOptimize(udaf(args...));
+                vm::JitRuntime::get()->ReleaseRunStep();
+            }
+            break;
+        }
+        case TEST: {
+            vm::JitRuntime::get()->InitRunStep();
+            udf::EqualValChecker<Ret>::check(expect, udaf(args...));
+            vm::JitRuntime::get()->ReleaseRunStep();
+        }
+    }
+}
+static std::vector<int64_t> BuildUdafValues(int64_t data_size) {
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < data_size; i++) {
+        values.push_back(i % 100);
+    }
+    return values;
+}
+void DistinctCountUdaf(benchmark::State* state, MODE mode, int64_t data_size) {
+    auto values = BuildUdafValues(data_size);
+    codec::ArrayListV<int64_t> list(&values);
+    codec::ListRef<int64_t> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    RunUdafCase(state, mode, "distinct_count", std::min<int64_t>(data_size, 100), list_ref);
+}
+void MedianUdaf(benchmark::State* state, MODE mode, int64_t data_size) {
+    std::vector<double> values;
+    for (int64_t i = 0; i < data_size; i++) {
+        values.push_back(static_cast<double>(i));
+    }
+    codec::ArrayListV<double> list(&values);
+    codec::ListRef<double> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    RunUdafCase(state, mode, "median", udf::Nullable<double>((data_size - 1) / 2.0), list_ref);
+}
+void TopKUdaf(benchmark::State* state, MODE mode, int64_t data_size) {
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < data_size; i++) {
+        values.push_back(i);
+    }
+    std::vector<int32_t> bounds(data_size, 3);
+    codec::ArrayListV<int64_t> list(&values);
+    codec::ArrayListV<int32_t> bound_list(&bounds);
+    codec::ListRef<int64_t> list_ref;
+    codec::ListRef<int32_t> bound_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    bound_ref.list = reinterpret_cast<int8_t*>(&bound_list);
+    auto expect = std::to_string(data_size - 1) + "," + std::to_string(data_size - 2) + "," +
+                  std::to_string(data_size - 3);
+    RunUdafCase(state, mode, "top", codec::StringRef(expect), list_ref, bound_ref);
+}
+void CountCateUdaf(benchmark::State* state, MODE mode, int64_t data_size) {
+    auto values = BuildUdafValues(data_size);
+    std::vector<int64_t> cates;
+    for (int64_t i = 0; i < data_size; i++) {
+        cates.push_back(i % 2);
+    }
+    codec::ArrayListV<int64_t> list(&values);
+    codec::ArrayListV<int64_t> cate_list(&cates);
+    codec::ListRef<int64_t> list_ref;
+    codec::ListRef<int64_t> cate_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    cate_ref.list = reinterpret_cast<int8_t*>(&cate_list);
+    auto expect = "0:" + std::to_string((data_size + 1) / 2) + ",1:" + std::to_string(data_size / 2);
+    RunUdafCase(state, mode, "count_cate", codec::StringRef(expect), list_ref, cate_ref);
+}
 void TimestampFormat(benchmark::State* state, MODE mode) {
     codec::Timestamp timestamp(1590115420000L);
     const std::string format = "%Y-%m-%d %H:%M:%S";
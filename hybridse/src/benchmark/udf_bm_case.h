@@ -43,6 +43,17 @@ void DateFormat(benchmark::State* state, MODE mode);
 void ByteMemPoolAlloc1000(benchmark::State* state, MODE mode,
                           size_t request_size);
 void NewFree1000(benchmark::State* state, MODE mode, size_t request_size);
+// udaf state containers on the global heap and on the memory pool of jit runtime,
+// `data_size` values of 100 distinct keys are pushed in each run step
+void DistinctCountHeapSet(benchmark::State* state, MODE mode, int64_t data_size);
+void DistinctCountManagedSet(benchmark::State* state, MODE mode, int64_t data_size);
+void CateHeapMap(benchmark::State* state, MODE mode, int64_t data_size);
+void CateManagedMap(benchmark::State* state, MODE mode, int64_t data_size);
+// compiled udafs over a window of `data_size` rows
+void DistinctCountUdaf(benchmark::State* state, MODE mode, int64_t data_size);
+void MedianUdaf(benchmark::State* state, MODE mode, int64_t data_size);
+void TopKUdaf(benchmark::State* state, MODE mode, int64_t data_size);
+void CountCateUdaf(benchmark::State* state, MODE mode, int64_t data_size);
 
 int64_t RunHistoryWindowBuffer(const hybridse::vm::WindowRange& window_range,
                                uint64_t data_size,
@@ -72,6 +72,24 @@ TEST_F(UdfBMCaseTest, ByteMemPoolAlloc1000_TEST) {
     ByteMemPoolAlloc1000(nullptr, TEST, 1000);
     ByteMemPoolAlloc1000(nullptr, TEST, 10000);
 }
+TEST_F(UdfBMCaseTest, UdafContainer_TEST) {
+    DistinctCountHeapSet(nullptr, TEST, 10);
+    DistinctCountManagedSet(nullptr, TEST, 10);
+    DistinctCountManagedSet(nullptr, TEST, 10000);
+    CateHeapMap(nullptr, TEST, 10);
+    CateManagedMap(nullptr, TEST, 10);
+    CateManagedMap(nullptr, TEST, 10000);
+}
+TEST_F(UdfBMCaseTest, Udaf_TEST) {
+    DistinctCountUdaf(nullptr, TEST, 10);
+    DistinctCountUdaf(nullptr, TEST, 1000);
+    MedianUdaf(nullptr, TEST, 10);
+    MedianUdaf(nullptr, TEST, 1001);
+    TopKUdaf(nullptr, TEST, 10);
+    TopKUdaf(nullptr, TEST, 1000);
+    CountCateUdaf(nullptr, TEST, 10);
+    CountCateUdaf(nullptr, TEST, 1001);
+}
 TEST_F(UdfBMCaseTest, TimestampToString_TEST) {
     TimestampToString(nullptr, TEST);
 }
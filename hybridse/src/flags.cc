@@ -19,6 +19,13 @@
 DEFINE_string(default_db_name, "_hybridse",
               "config the default batch catalog db name");
 
+// batch spill config
+DEFINE_uint64(batch_operator_mem_limit, 0,
+              "config the bytes of rows a batch sort or group aggregation keeps in memory before it spills them "
+              "to files, 0 means unlimited. only the rows created by the query are counted, rows read from "
+              "tables in place are not");
+DEFINE_string(batch_spill_dir, "/tmp", "config the directory of the spill files of batch operators");
+
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
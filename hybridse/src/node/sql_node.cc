@@ -1170,6 +1170,7 @@ static absl::flat_hash_map<SqlNodeType, absl::string_view> CreateSqlNodeTypeToNa
         {kPartitionNum, "kPartitionNum"},
         {kStorageMode, "kStorageMode"},
         {kCompressType, "kCompressType"},
+        {kMemoryHeadMinutes, "kMemoryHeadMinutes"},
         {kFn, "kFn"},
         {kFnParaList, "kFnParaList"},
         {kCreateSpStmt, "kCreateSpStmt"},
@@ -2611,11 +2612,20 @@ void CompressTypeNode::Print(std::ostream &output, const std::string &org_tab) c
     output << "\n";
     if (compress_type_ == CompressType::kSnappy) {
         PrintValue(output, tab, "snappy", "compress_type", true);
+    } else if (compress_type_ == CompressType::kZlibDict) {
+        PrintValue(output, tab, "zlibdict", "compress_type", true);
     }  else {
         PrintValue(output, tab, "nocompress", "compress_type", true);
     }
 }
 
+void MemoryHeadMinutesNode::Print(std::ostream &output, const std::string &org_tab) const {
+    SqlNode::Print(output, org_tab);
+    const std::string tab = org_tab + INDENT + SPACE_ED;
+    output << "\n";
+    PrintValue(output, tab, std::to_string(minutes_), "memory_head_minutes", true);
+}
+
 void PartitionNumNode::Print(std::ostream &output, const std::string &org_tab) const {
     SqlNode::Print(output, org_tab);
     const std::string tab = org_tab + INDENT + SPACE_ED;
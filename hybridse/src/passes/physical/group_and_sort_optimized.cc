@@ -226,6 +226,18 @@ bool GroupAndSortOptimized::Transform(PhysicalOpNode* in,
                         return false;
                     }
                 }
+
+                size_t idx = 3;
+                for (auto& level_window : union_op->level_windows_) {
+                    if (KeysAndOrderFilterOptimized(union_op->GetProducer(idx)->schemas_ctx(),
+                                                    union_op->GetProducer(idx), &level_window.partition_,
+                                                    &level_window.index_key_, &level_window.sort_, &new_producer)) {
+                        if (!ResetProducer(plan_ctx_, union_op, idx, new_producer)) {
+                            return false;
+                        }
+                    }
+                    idx++;
+                }
             }
             return true;
         }
@@ -22,6 +22,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "vm/engine.h"
 #include "vm/physical_op.h"
 
@@ -161,61 +162,20 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
     }
 
     // TODO(zhanghao): optimize the selection of the best pre-aggregation tables
-    auto table = catalog_->GetTable(table_infos[0].aggr_db, table_infos[0].aggr_table);
-    if (!table) {
-        LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << table_infos[0].aggr_db << "."
-                   << table_infos[0].aggr_table;
-        return false;
-    }
-
+    const auto& aggr_db = table_infos[0].aggr_db;
+    const auto& aggr_table = table_infos[0].aggr_table;
+    auto req_window = req_union_op->window();
     vm::PhysicalTableProviderNode* aggr = nullptr;
-    auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(&aggr, table);
-    if (!status.isOK()) {
-        LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << table_infos[0].aggr_db
-                   << "." << table_infos[0].aggr_table << ": " << status;
+    vm::RequestWindowOp aggr_window(plan_ctx_->node_manager()->MakeExprList());
+    if (!CreateAggrWindow(aggr_db, aggr_table, req_window, &aggr, &aggr_window)) {
         return false;
     }
 
-    if (table->GetIndex().size() != 1) {
-        LOG(ERROR) << "PreAggregation table index size != 1";
-        return false;
-    }
-    auto index = table->GetIndex().cbegin()->second;
-    auto nm = plan_ctx_->node_manager();
-
     auto request = req_union_op->GetProducer(0);
     auto raw = req_union_op->GetProducer(1);
 
-    // generate an aggregation window for the aggr table
-    auto req_window = req_union_op->window();
-    auto partitions = nm->MakeExprList();
-    for (size_t i = 0; i < index.keys.size(); i++) {
-        auto col_ref = nm->MakeColumnRefNode(index.keys[i].name, table->GetName(), table->GetDatabase());
-        partitions->AddChild(col_ref);
-    }
-    vm::RequestWindowOp aggr_window(partitions);
-
-    auto order_col_ref =
-        nm->MakeColumnRefNode((*table->GetSchema())[index.ts_pos].name(), table->GetName(), table->GetDatabase());
-    auto order_expr = nm->MakeOrderExpression(order_col_ref, true);
-    auto orders = nm->MakeExprList();
-    orders->AddChild(order_expr);
-
-    auto partition_by = nm->MakeExprList();
-    for (size_t i = 0; i < index.keys.size(); i++) {
-        auto col_ref = nm->MakeColumnRefNode((*table->GetSchema())[index.keys[i].idx].name(), table->GetName(),
-                                             table->GetDatabase());
-        partition_by->AddChild(col_ref);
-    }
-
-    aggr_window.sort_.orders_ = nm->MakeOrderByNode(orders);
-    aggr_window.name_ = req_window.name();
-    aggr_window.range_ = req_window.range_;
-    aggr_window.range_.range_key_ = order_col_ref;
-    aggr_window.partition_.keys_ = partition_by;
-
     vm::PhysicalRequestAggUnionNode* request_aggr_union = nullptr;
-    status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
+    auto status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
         &request_aggr_union, request, raw, aggr, req_union_op->window(), aggr_window,
         req_union_op->instance_not_in_window(), req_union_op->exclude_current_time(),
         req_union_op->output_request_row(), aggr_op);
@@ -227,6 +187,20 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
         return false;
     }
 
+    // the coarser levels of a multi-level long window, e.g bucket size '1h|1d|30d',
+    // are kept in the tables named {aggr_table}_{bucket_size}
+    std::vector<std::string> levels = absl::StrSplit(table_infos[0].bucket_size, '|');
+    for (size_t level = 1; level < levels.size(); level++) {
+        std::string level_table = absl::StrCat(aggr_table, "_", levels[level]);
+        vm::PhysicalTableProviderNode* level_aggr = nullptr;
+        vm::RequestWindowOp level_window(plan_ctx_->node_manager()->MakeExprList());
+        if (!CreateAggrWindow(aggr_db, level_table, req_window, &level_aggr, &level_window)) {
+            LOG(WARNING) << "Skip the pre-aggregation levels from " << aggr_db << "." << level_table;
+            break;
+        }
+        request_aggr_union->AddAggLevel(level_aggr, level_window);
+    }
+
     vm::PhysicalReduceAggregationNode* reduce_aggr = nullptr;
     auto condition = in->having_condition_.condition();
     if (condition) {
@@ -255,6 +229,51 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
 
 bool LongWindowOptimized::VerifySingleAggregation(vm::PhysicalProjectNode* op) { return op->project().size() == 1; }
 
+bool LongWindowOptimized::CreateAggrWindow(const std::string& db, const std::string& name,
+                                           const vm::RequestWindowOp& req_window,
+                                           vm::PhysicalTableProviderNode** aggr, vm::RequestWindowOp* aggr_window) {
+    auto table = catalog_->GetTable(db, name);
+    if (!table) {
+        LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << db << "." << name;
+        return false;
+    }
+
+    auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(aggr, table);
+    if (!status.isOK()) {
+        LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << db << "." << name
+                   << ": " << status;
+        return false;
+    }
+
+    if (table->GetIndex().size() != 1) {
+        LOG(ERROR) << "PreAggregation table index size != 1";
+        return false;
+    }
+    auto index = table->GetIndex().cbegin()->second;
+    auto nm = plan_ctx_->node_manager();
+
+    // generate an aggregation window for the aggr table
+    auto order_col_ref =
+        nm->MakeColumnRefNode((*table->GetSchema())[index.ts_pos].name(), table->GetName(), table->GetDatabase());
+    auto order_expr = nm->MakeOrderExpression(order_col_ref, true);
+    auto orders = nm->MakeExprList();
+    orders->AddChild(order_expr);
+
+    auto partition_by = nm->MakeExprList();
+    for (size_t i = 0; i < index.keys.size(); i++) {
+        auto col_ref = nm->MakeColumnRefNode((*table->GetSchema())[index.keys[i].idx].name(), table->GetName(),
+                                             table->GetDatabase());
+        partition_by->AddChild(col_ref);
+    }
+
+    aggr_window->sort_.orders_ = nm->MakeOrderByNode(orders);
+    aggr_window->name_ = req_window.name();
+    aggr_window->range_ = req_window.range_;
+    aggr_window->range_.range_key_ = order_col_ref;
+    aggr_window->partition_.keys_ = partition_by;
+    return true;
+}
+
 std::string LongWindowOptimized::ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter) {
     std::string str = "";
     for (const auto expr : exprs) {
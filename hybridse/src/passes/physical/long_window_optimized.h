@@ -43,6 +43,9 @@ class LongWindowOptimized : public TransformUpPysicalPass {
     bool Transform(PhysicalOpNode* in, PhysicalOpNode** output) override;
     bool VerifySingleAggregation(vm::PhysicalProjectNode* op);
     bool OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, PhysicalOpNode** output);
+    // create the provider and the request window of the pre-aggr table `db`.`name`
+    bool CreateAggrWindow(const std::string& db, const std::string& name, const vm::RequestWindowOp& req_window,
+                          vm::PhysicalTableProviderNode** aggr, vm::RequestWindowOp* aggr_window);
 
     static std::string ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter = ",");
 
@@ -1724,6 +1724,7 @@ base::Status ConvertIndexOption(const zetasql::ASTOptionsEntry* entry, node::Nod
 // case entry
 //   ("partitionnum", int) -> PartitionNumNode(int)
 //   ("replicanum", int)   -> ReplicaNumNode(int)
+//   ("memory_head_minutes", int) -> MemoryHeadMinutesNode(int)
 //   ("distribution", [ (string, [string] ) ] ) ->
 base::Status ConvertTableOption(const zetasql::ASTOptionsEntry* entry, node::NodeManager* node_manager,
                                 node::SqlNode** output) {
@@ -1786,6 +1787,10 @@ base::Status ConvertTableOption(const zetasql::ASTOptionsEntry* entry, node::Nod
         } else {
             return base::Status(common::kSqlAstError, ret.status().ToString());
         }
+    } else if (absl::EqualsIgnoreCase("memory_head_minutes", identifier_v)) {
+        int64_t value = 0;
+        CHECK_STATUS(ASTIntLiteralToNum(entry->value(), &value));
+        *output = node_manager->MakeNode<node::MemoryHeadMinutesNode>(value);
     } else {
         return base::Status(common::kSqlAstError, absl::StrCat("invalid option ", identifier));
     }
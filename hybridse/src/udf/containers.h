@@ -68,6 +68,40 @@ struct ContainerStorageTypeTrait<openmldb::base::Timestamp> {
     }
 };
 
+/**
+ * Stateless allocator over the memory pool of jit runtime on current thread.
+ *
+ * Memory is only released by `JitRuntime::ReleaseRunStep()`, so a container
+ * using it must not outlive the run step, which holds for udaf states that are
+ * initialized and output within one call of the compiled function.
+ */
+template <typename T>
+struct ManagedAllocator {
+    using value_type = T;
+
+    ManagedAllocator() = default;
+    template <typename U>
+    ManagedAllocator(const ManagedAllocator<U>&) {}  // NOLINT
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(v1::AllocManagedBuf(n * sizeof(T), alignof(T)));
+    }
+    // released together with the run step
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ManagedAllocator<U>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const ManagedAllocator<U>&) const {
+        return false;
+    }
+};
+
+template <typename K, typename V, typename Cmp = std::less<K>>
+using ManagedMap = std::map<K, V, Cmp, ManagedAllocator<std::pair<const K, V>>>;
+
 template <typename T, typename BoundT>
 class TopKContainer {
  public:
@@ -160,7 +194,7 @@ class TopKContainer {
     }
 
  private:
-    std::map<StorageT, size_t, std::less<StorageT>> map_;
+    ManagedMap<StorageT, size_t> map_;
     BoundT elem_cnt_ = 0;
     BoundT bound_ = -1;  // delayed to be set by first push
 };
@@ -356,7 +390,9 @@ class BoundedGroupByDict {
             output->data_ = "";
             return;
         }
-        std::set<std::pair<StorageK, StorageV>, PairCmp<StorageK, StorageV>> ordered_set;
+        std::set<std::pair<StorageK, StorageV>, PairCmp<StorageK, StorageV>,
+                 ManagedAllocator<std::pair<StorageK, StorageV>>>
+            ordered_set;
         for (auto& kv : map_) {
             ordered_set.emplace(kv.first, kv.second);
 
@@ -421,7 +457,7 @@ class BoundedGroupByDict {
     auto& map() { return map_; }
 
  private:
-    std::map<StorageK, StorageV, std::less<StorageK>> map_;
+    ManagedMap<StorageK, StorageV> map_;
 
     static const size_t MAX_OUTPUT_STR_SIZE = 4096;
 };
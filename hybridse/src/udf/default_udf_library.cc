@@ -20,12 +20,13 @@
 #include <limits>
 #include <string>
 #include <tuple>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <queue>
 #include <functional>
 
+#include "absl/container/flat_hash_set.h"
+#include "base/fe_sketch.h"
 #include "codegen/date_ir_builder.h"
 #include "codegen/string_ir_builder.h"
 #include "codegen/timestamp_ir_builder.h"
@@ -326,7 +327,7 @@ struct EwAvgUdafDef {
 template <typename T>
 struct DistinctCountDef {
     using ArgT = typename DataTypeTrait<T>::CCallArgType;
-    using SetT = std::unordered_set<T>;
+    using SetT = absl::flat_hash_set<T, absl::Hash<T>, std::equal_to<T>, container::ManagedAllocator<T>>;
 
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
         std::string suffix = ".opaque_std_set_" + DataTypeTrait<T>::to_string();
@@ -363,11 +364,48 @@ struct DistinctCountDef {
     };
 };
 
+// HyperLogLog distinct count, the sketches are merged with those kept by the long window pre-aggregator
+template <typename T>
+struct ApproxDistinctCountDef {
+    using ArgT = typename DataTypeTrait<T>::CCallArgType;
+    using ContainerT = base::HyperLogLog;
+
+    void operator()(UdafRegistryHelper& helper) {  // NOLINT
+        std::string suffix = ".opaque_hll_" + DataTypeTrait<T>::to_string();
+        helper.templates<int64_t, Opaque<ContainerT>, T>()
+            .init("approx_distinct_count_init" + suffix, Init)
+            .update("approx_distinct_count_update" + suffix, Update)
+            .output("approx_distinct_count_output" + suffix, Output);
+    }
+
+    static void Init(ContainerT* addr) { new (addr) ContainerT(); }
+
+    static ContainerT* Update(ContainerT* hll, ArgT value) {
+        hll->Add(Hash(value));
+        return hll;
+    }
+
+    static int64_t Output(ContainerT* hll) {
+        int64_t estimate = hll->Estimate();
+        hll->~ContainerT();
+        return estimate;
+    }
+
+    template <typename V>
+    static uint64_t Hash(V value) {
+        return base::SketchHash(value);
+    }
+    static uint64_t Hash(StringRef* value) { return base::SketchHash(value->data_, value->size_); }
+    static uint64_t Hash(Timestamp* value) { return base::SketchHash(value->ts_); }
+    static uint64_t Hash(Date* value) { return base::SketchHash(value->date_); }
+};
+
 template <typename T>
 struct MedianDef {
     using ArgT = typename DataTypeTrait<T>::CCallArgType;
-    using MaxHeapT = std::priority_queue<T, std::vector<T>, std::less<>>;
-    using MinHeapT = std::priority_queue<T, std::vector<T>, std::greater<>>;
+    using VectorT = std::vector<T, container::ManagedAllocator<T>>;
+    using MaxHeapT = std::priority_queue<T, VectorT, std::less<>>;
+    using MinHeapT = std::priority_queue<T, VectorT, std::greater<>>;
     using ContainerT = std::tuple<MaxHeapT, MinHeapT>;
 
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
@@ -428,6 +466,39 @@ struct MedianDef {
     }
 };
 
+// KLL sketch median, the sketches are merged with those kept by the long window pre-aggregator
+template <typename T>
+struct ApproxMedianDef {
+    using ContainerT = base::QuantileSketch;
+
+    void operator()(UdafRegistryHelper& helper) {  // NOLINT
+        std::string suffix = ".opaque_kll_" + DataTypeTrait<T>::to_string();
+        helper.templates<Nullable<double>, Opaque<ContainerT>, Nullable<T>>()
+            .init("approx_median_init" + suffix, Init)
+            .update("approx_median_update" + suffix, Update)
+            .output("approx_median_output" + suffix, reinterpret_cast<void*>(Output), true);
+    }
+
+    static void Init(ContainerT* addr) { new (addr) ContainerT(); }
+
+    static ContainerT* Update(ContainerT* sketch, T value, bool is_null) {
+        if (!is_null) {
+            sketch->Add(value);
+        }
+        return sketch;
+    }
+
+    static void Output(ContainerT* sketch, double* ret, bool* is_null) {
+        if (sketch->Count() == 0) {
+            *is_null = true;
+        } else {
+            *is_null = false;
+            *ret = sketch->Quantile(0.5);
+        }
+        sketch->~ContainerT();
+    }
+};
+
 template <typename T>
 struct SumWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
@@ -2831,6 +2902,31 @@ void DefaultUdfLibrary::InitUdaf() {
         .args_in<bool, int16_t, int32_t, int64_t, float, double, Timestamp,
                  Date, StringRef>();
 
+    RegisterUdafTemplate<ApproxDistinctCountDef>("approx_distinct_count")
+        .doc(R"(
+            @brief Compute approximate number of distinct values with a HyperLogLog sketch.
+            The standard error is about 1.6%. Over a long window it merges the sketches of
+            the pre-aggregated buckets instead of scanning the rows.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |0|
+            |0|
+            |2|
+            |2|
+            |4|
+            @code{.sql}
+                SELECT approx_distinct_count(value) OVER w;
+                -- output 3
+            @endcode
+            @since 0.9.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double, Timestamp, Date, StringRef>();
+
     RegisterUdafTemplate<EwAvgUdafDef>("ew_avg")
         .doc(R"(
             @brief Compute exponentially-weighted average of values.
@@ -3029,6 +3125,31 @@ void DefaultUdfLibrary::InitUdaf() {
         )")
         .args_in<int16_t, int32_t, int64_t, float, double>();
 
+    RegisterUdafTemplate<ApproxMedianDef>("approx_median")
+        .doc(R"(
+            @brief Compute approximate median of values with a KLL sketch.
+            The rank error is under 1%. Over a long window it merges the sketches of
+            the pre-aggregated buckets instead of scanning the rows.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |1|
+            |2|
+            |3|
+            |4|
+            |5|
+            @code{.sql}
+                SELECT approx_median(value) OVER w;
+                -- output 3
+            @endcode
+            @since 0.9.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double>();
+
     RegisterUdafTemplate<DrawdownUdafDef>("drawdown")
         .doc(R"(
             @brief Compute drawdown of values.
@@ -101,8 +101,15 @@ TEST_F(UdafTest, CountTest) {
     CheckUdafOneParam<int64_t, Nullable<StringRef>>("count", 2, {nullptr, StringRef("abc"), StringRef("gc")});
 }
 
-// TODO(aceforeverd): add test for distinct_count
-
+TEST_F(UdafTest, DistinctCountTest) {
+    CheckUdafOneParam<int64_t, int32_t>("distinct_count", 0, {});
+    CheckUdafOneParam<int64_t, int32_t>("distinct_count", 3, {0, 0, 2, 2, 4});
+    CheckUdafOneParam<int64_t, int64_t>("distinct_count", 1, {5, 5, 5});
+    CheckUdafOneParam<int64_t, double>("distinct_count", 2, {1.0, 2.0, 1.0});
+    CheckUdafOneParam<int64_t, Timestamp>("distinct_count", 2, {Timestamp(1), Timestamp(2), Timestamp(2)});
+    CheckUdafOneParam<int64_t, Date>("distinct_count", 1, {Date(1), Date(1)});
+    CheckUdafOneParam<int64_t, StringRef>("distinct_count", 2, {StringRef("a"), StringRef("b"), StringRef("a")});
+}
 
 TEST_F(UdafTest, MedianTest) {
     CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("median", nullptr, {});
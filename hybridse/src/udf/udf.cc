@@ -1320,6 +1320,10 @@ char *AllocManagedStringBuf(int32_t bytes) {
     return reinterpret_cast<char *>(vm::JitRuntime::get()->AllocManaged(bytes));
 }
 
+void *AllocManagedBuf(size_t bytes, size_t align) {
+    return vm::JitRuntime::get()->AllocManaged(bytes, align);
+}
+
 template <class V>
 bool iterator_list(int8_t *input, int8_t *output) {
     if (nullptr == input || nullptr == output) {
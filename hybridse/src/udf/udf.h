@@ -91,6 +91,11 @@ void RegisterManagedObj(base::FeBaseObject* obj);
  */
 char *AllocManagedStringBuf(int32_t bytes);
 
+/**
+ * Allocate buffer aligned to `align` from jit runtime, e.g. for udaf states.
+ */
+void *AllocManagedBuf(size_t bytes, size_t align);
+
 // alloc necessary space for ArrayRef and let Jit runtime manage its lifetime
 //
 // type T should be of UDF type systems: bool/intxx/float/double/StringRef/TimeStamp/Date
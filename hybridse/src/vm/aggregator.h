@@ -23,6 +23,7 @@
 #include <string>
 #include <boost/algorithm/string/compare.hpp>
 
+#include "base/fe_sketch.h"
 #include "codec/fe_row_codec.h"
 #include "codec/row.h"
 #include "proto/fe_type.pb.h"
@@ -368,6 +369,106 @@ class MaxAggregator : public Aggregator<T> {
     }
 };
 
+// values of the base table are added to the sketch, encoded sketches of the agg table are merged into it
+template <class T, class SketchT>
+class SketchAggregator : public Aggregator<T> {
+ public:
+    SketchAggregator(type::Type type, const Schema& output_schema) : Aggregator<T>(type, output_schema, T()) {}
+
+    // val is assumed to be not null
+    void UpdateValue(const T& val) override {
+        AddValue(val);
+        this->counter_++;
+    }
+
+    void Update(const std::string& bval) override {
+        if (!sketch_.MergeFrom(bval.data(), bval.size())) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        this->counter_++;
+    }
+
+    void Reset() override {
+        Aggregator<T>::Reset();
+        sketch_.Reset();
+    }
+
+ protected:
+    virtual void AddValue(const T& val) = 0;
+
+    template <class V>
+    Row OutputValue(const V& val) {
+        uint32_t total_len = this->row_builder_.CalTotalLength(0);
+        int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+        this->row_builder_.SetBuffer(buf, total_len);
+        if (this->IsNull()) {
+            this->row_builder_.AppendNULL();
+        } else if constexpr (std::is_same<V, int64_t>::value) {
+            this->row_builder_.AppendInt64(val);
+        } else {
+            this->row_builder_.AppendDouble(val);
+        }
+        return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
+    }
+
+    SketchT sketch_;
+};
+
+template <class T>
+class ApproxDistinctCountAggregator : public SketchAggregator<T, base::HyperLogLog> {
+ public:
+    ApproxDistinctCountAggregator(type::Type type, const Schema& output_schema)
+        : SketchAggregator<T, base::HyperLogLog>(type, output_schema) {}
+
+    bool IsNull() const override {
+        return false;
+    }
+
+    Row Output() override {
+        int64_t estimate = this->sketch_.Estimate();
+        auto row = this->OutputValue(estimate);
+        this->Reset();
+        return row;
+    }
+
+ protected:
+    void AddValue(const T& val) override {
+        if constexpr (std::is_arithmetic<T>::value) {
+            this->sketch_.Add(base::SketchHash(val));
+        } else {
+            this->sketch_.Add(base::SketchHash(val.data(), val.size()));
+        }
+    }
+};
+
+template <class T>
+class ApproxMedianAggregator : public SketchAggregator<T, base::QuantileSketch> {
+ public:
+    ApproxMedianAggregator(type::Type type, const Schema& output_schema)
+        : SketchAggregator<T, base::QuantileSketch>(type, output_schema) {}
+
+    bool IsNull() const override {
+        return this->sketch_.Count() == 0;
+    }
+
+    Row Output() override {
+        double median = this->sketch_.Quantile(0.5);
+        auto row = this->OutputValue(median);
+        this->Reset();
+        return row;
+    }
+
+ protected:
+    void AddValue(const T& val) override {
+        if constexpr (std::is_arithmetic<T>::value) {
+            this->sketch_.Add(val);
+        } else {
+            LOG(ERROR) << "approx_median does not support string values";
+        }
+    }
+};
+
 template <template<class> class AggregatorClass>
 std::unique_ptr<BaseAggregator> MakeOverflowAggregator(type::Type agg_col_type, const Schema& output_schema) {
     switch (agg_col_type) {
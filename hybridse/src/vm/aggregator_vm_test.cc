@@ -550,6 +550,59 @@ TEST_F(AggregatorVMTest, NullTest) {
     check_null(aggregator.get());
 }
 
+TEST_F(AggregatorVMTest, SketchTest) {
+    codec::Schema count_schema;
+    auto column = count_schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    codec::Schema median_schema;
+    column = median_schema.Add();
+    column->set_type(type::kDouble);
+    column->set_name("val");
+
+    // the values of base rows are added, the sketches of pre-aggr buckets are merged
+    ApproxDistinctCountAggregator<int64_t> count_aggregator(type::kInt64, count_schema);
+    ApproxMedianAggregator<int64_t> median_aggregator(type::kInt64, median_schema);
+    base::HyperLogLog hll;
+    base::QuantileSketch quantile;
+    for (int64_t i = 0; i < 1000; i++) {
+        if (i < 900) {
+            hll.Add(base::SketchHash(i % 500));
+            quantile.Add(i);
+        } else {
+            count_aggregator.UpdateValue(i);
+            median_aggregator.UpdateValue(i);
+        }
+    }
+    std::string bval;
+    hll.Serialize(&bval);
+    count_aggregator.Update(bval);
+    bval.clear();
+    quantile.Serialize(&bval);
+    median_aggregator.Update(bval);
+
+    codec::RowView count_view(count_schema);
+    Row row = count_aggregator.Output();
+    count_view.Reset(row.buf());
+    int64_t distinct = 0;
+    count_view.GetInt64(0, &distinct);
+    EXPECT_NEAR(600, distinct, 600 * 0.05);
+
+    codec::RowView median_view(median_schema);
+    row = median_aggregator.Output();
+    median_view.Reset(row.buf());
+    double median = 0;
+    median_view.GetDouble(0, &median);
+    EXPECT_NEAR(500, median, 10);
+
+    // reset after output
+    EXPECT_FALSE(count_aggregator.IsNull());
+    EXPECT_TRUE(median_aggregator.IsNull());
+    row = median_aggregator.Output();
+    median_view.Reset(row.buf());
+    EXPECT_TRUE(median_view.IsNULL(0));
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -15,6 +15,9 @@
  */
 
 #include "vm/catalog_wrapper.h"
+
+#include <algorithm>
+
 namespace hybridse {
 namespace vm {
 
@@ -25,7 +28,7 @@ std::shared_ptr<TableHandler> PartitionProjectWrapper::GetSegment(
         return std::shared_ptr<TableHandler>();
     } else {
         return std::shared_ptr<TableHandler>(
-            new TableProjectWrapper(segment, parameter_, fun_));
+            new TableProjectWrapper(segment, parameter_, fun_, quota_));
     }
 }
 codec::RowIterator* PartitionProjectWrapper::GetRawIterator() {
@@ -33,7 +36,7 @@ codec::RowIterator* PartitionProjectWrapper::GetRawIterator() {
     if (!iter) {
         return nullptr;
     } else {
-        return new IteratorProjectWrapper(std::move(iter), parameter_, fun_);
+        return new IteratorProjectWrapper(std::move(iter), parameter_, fun_, quota_);
     }
 }
 
@@ -62,7 +65,7 @@ std::shared_ptr<PartitionHandler> TableProjectWrapper::GetPartition(
         return std::shared_ptr<PartitionHandler>();
     } else {
         return std::shared_ptr<PartitionHandler>(
-            new PartitionProjectWrapper(partition, parameter_, fun_));
+            new PartitionProjectWrapper(partition, parameter_, fun_, quota_));
     }
 }
 std::shared_ptr<PartitionHandler> TableFilterWrapper::GetPartition(
@@ -203,7 +206,7 @@ const Row& LazyAggIterator::GetValue() {
         auto request = it_->GetValue();
         auto window = func_(request);
         if (window) {
-            buf_ = agg_gen_->Gen(parameter_, window);
+            buf_ = agg_gen_->Gen(parameter_, window, quota_);
             return buf_;
         }
     }
@@ -220,7 +223,7 @@ codec::RowIterator* LazyAggTableHandler::GetRawIterator() {
     if (!it) {
         return nullptr;
     }
-    return new LazyAggIterator(std::move(it), func_, agg_gen_, parameter_);
+    return new LazyAggIterator(std::move(it), func_, agg_gen_, parameter_, quota_);
 }
 
 const Types& LazyAggTableHandler::GetTypes() { return left_->GetTypes(); }
@@ -230,13 +233,24 @@ const std::string& LazyAggTableHandler::GetName() { return left_->GetName(); }
 const std::string& LazyAggTableHandler::GetDatabase() { return left_->GetDatabase(); }
 std::shared_ptr<TableHandler> LazyAggPartitionHandler::GetSegment(const std::string& key) {
     auto seg = input_->Left()->GetSegment(key);
-    return std::shared_ptr<TableHandler>(new LazyAggTableHandler(seg, input_->Func(), agg_gen_, parameter_));
+    return std::shared_ptr<TableHandler>(new LazyAggTableHandler(seg, input_->Func(), agg_gen_, parameter_, quota_));
 }
 const std::string LazyAggPartitionHandler::GetHandlerTypeName() { return "LazyLastJoinPartitionHandler"; }
 
+std::shared_ptr<PartitionHandler> LazyGroupPartitionHandler::Materialize() {
+    if (!partitions_) {
+        partitions_ = partition_gen_->Partition(table_, parameter_);
+        if (!partitions_) {
+            LOG(WARNING) << "fail to group table " << table_->GetName();
+            partitions_ = std::make_shared<MemPartitionHandler>(table_->GetSchema());
+        }
+    }
+    return partitions_;
+}
+
 codec::RowIterator* LazyAggPartitionHandler::GetRawIterator() {
     auto it = input_->Left()->GetIterator();
-    return new LazyAggIterator(std::move(it), input_->Func(), agg_gen_, parameter_);
+    return new LazyAggIterator(std::move(it), input_->Func(), agg_gen_, parameter_, quota_);
 }
 
 bool ConcatIterator::Valid() const { return left_ && left_->Valid(); }
@@ -280,7 +294,7 @@ std::unique_ptr<WindowIterator> ConcatPartitionHandler::GetWindowIterator() { re
 std::unique_ptr<WindowIterator> LazyAggPartitionHandler::GetWindowIterator() {
     auto w = input_->Left()->GetWindowIterator();
     return std::unique_ptr<WindowIterator>(
-        new LazyAggWindowIterator(std::move(w), input_->Func(), agg_gen_, parameter_));
+        new LazyAggWindowIterator(std::move(w), input_->Func(), agg_gen_, parameter_, quota_));
 }
 
 RowIterator* LazyAggWindowIterator::GetRawValue() {
@@ -289,7 +303,7 @@ RowIterator* LazyAggWindowIterator::GetRawValue() {
         return nullptr;
     }
 
-    return new LazyAggIterator(std::move(w), func_, agg_gen_, parameter_);
+    return new LazyAggIterator(std::move(w), func_, agg_gen_, parameter_, quota_);
 }
 void LazyRequestUnionIterator::Next() {
     if (Valid()) {
@@ -397,5 +411,32 @@ void LazyLeftJoinIterator::onNewLeftRow() {
     value_ = res.first;
     matches_right_ |= res.second;
 }
+SharedSegmentHandler::SharedSegmentHandler(std::shared_ptr<TableHandler> segment, uint64_t start_key)
+    : TableHandler(), segment_(segment), iter_(segment->GetIterator()), rows_() {
+    if (iter_) {
+        iter_->Seek(start_key);
+    }
+}
+
+RowIterator* SharedSegmentHandler::GetRawIterator() { return new SharedSegmentIterator(shared_from_this()); }
+
+bool SharedSegmentHandler::Load(size_t pos) {
+    while (rows_.size() <= pos && iter_ && iter_->Valid()) {
+        rows_.emplace_back(iter_->GetKey(), iter_->GetValue());
+        iter_->Next();
+    }
+    return pos < rows_.size();
+}
+
+size_t SharedSegmentHandler::Seek(uint64_t key) {
+    // the rows are in descending order of key
+    auto it = std::partition_point(rows_.begin(), rows_.end(),
+                                   [key](const std::pair<uint64_t, Row>& row) { return row.first > key; });
+    size_t pos = it - rows_.begin();
+    while (pos == rows_.size() && Load(pos) && rows_[pos].first > key) {
+        pos++;
+    }
+    return pos;
+}
 }  // namespace vm
 }  // namespace hybridse
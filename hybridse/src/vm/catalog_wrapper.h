@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/attributes.h"
 #include "codec/row_iterator.h"
@@ -32,14 +33,15 @@ namespace vm {
 
 class IteratorProjectWrapper : public RowIterator {
  public:
-    IteratorProjectWrapper(std::unique_ptr<RowIterator>&& iter, const Row& parameter, const ProjectFun* fun)
-        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), fun_(fun), value_() {}
+    IteratorProjectWrapper(std::unique_ptr<RowIterator>&& iter, const Row& parameter, const ProjectFun* fun,
+                           RunMemoryQuota* quota)
+        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), fun_(fun), quota_(quota), value_() {}
     virtual ~IteratorProjectWrapper() {}
     bool Valid() const override { return iter_->Valid(); }
     void Next() override { iter_->Next(); }
     const uint64_t& GetKey() const override { return iter_->GetKey(); }
     const Row& GetValue() override {
-        value_ = fun_->operator()(iter_->GetValue(), parameter_);
+        value_ = fun_->operator()(iter_->GetValue(), parameter_, quota_);
         return value_;
     }
     void Seek(const uint64_t& k) override { iter_->Seek(k); }
@@ -48,6 +50,7 @@ class IteratorProjectWrapper : public RowIterator {
     std::unique_ptr<RowIterator> iter_;
     const Row& parameter_;
     const ProjectFun* fun_;
+    RunMemoryQuota* quota_;
     Row value_;
 };
 
@@ -142,15 +145,15 @@ class WindowIteratorProjectWrapper : public WindowIterator {
  public:
     WindowIteratorProjectWrapper(std::unique_ptr<WindowIterator> iter,
                                  const Row& parameter,
-                                 const ProjectFun* fun)
-        : WindowIterator(), iter_(std::move(iter)), parameter_(parameter), fun_(fun) {}
+                                 const ProjectFun* fun, RunMemoryQuota* quota)
+        : WindowIterator(), iter_(std::move(iter)), parameter_(parameter), fun_(fun), quota_(quota) {}
     virtual ~WindowIteratorProjectWrapper() {}
     RowIterator* GetRawValue() override {
         auto iter = iter_->GetValue();
         if (!iter) {
             return nullptr;
         } else {
-            return new IteratorProjectWrapper(std::move(iter), parameter_, fun_);
+            return new IteratorProjectWrapper(std::move(iter), parameter_, fun_, quota_);
         }
     }
     void Seek(const std::string& key) override { iter_->Seek(key); }
@@ -161,6 +164,7 @@ class WindowIteratorProjectWrapper : public WindowIterator {
     std::unique_ptr<WindowIterator> iter_;
     const Row& parameter_;
     const ProjectFun* fun_;
+    RunMemoryQuota* quota_;
 };
 
 class WindowIteratorFilterWrapper : public WindowIterator {
@@ -195,12 +199,13 @@ class PartitionProjectWrapper : public PartitionHandler {
  public:
     PartitionProjectWrapper(std::shared_ptr<PartitionHandler> partition_handler,
                             const Row& parameter,
-                            const ProjectFun* fun)
+                            const ProjectFun* fun, RunMemoryQuota* quota)
         : PartitionHandler(),
           partition_handler_(partition_handler),
           parameter_(parameter),
           value_(),
-          fun_(fun) {}
+          fun_(fun),
+          quota_(quota) {}
     virtual ~PartitionProjectWrapper() {}
     std::unique_ptr<WindowIterator> GetWindowIterator() override {
         auto iter = partition_handler_->GetWindowIterator();
@@ -208,7 +213,7 @@ class PartitionProjectWrapper : public PartitionHandler {
             return std::unique_ptr<WindowIterator>();
         } else {
             return std::unique_ptr<WindowIterator>(
-                new WindowIteratorProjectWrapper(std::move(iter), parameter_, fun_));
+                new WindowIteratorProjectWrapper(std::move(iter), parameter_, fun_, quota_));
         }
     }
     const Types& GetTypes() override { return partition_handler_->GetTypes(); }
@@ -227,7 +232,7 @@ class PartitionProjectWrapper : public PartitionHandler {
     }
     codec::RowIterator* GetRawIterator() override;
     Row At(uint64_t pos) override {
-        value_ = fun_->operator()(partition_handler_->At(pos), parameter_);
+        value_ = fun_->operator()(partition_handler_->At(pos), parameter_, quota_);
         return value_;
     }
     const uint64_t GetCount() override {
@@ -245,6 +250,7 @@ class PartitionProjectWrapper : public PartitionHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    RunMemoryQuota* quota_;
 };
 class PartitionFilterWrapper : public PartitionHandler {
  public:
@@ -298,8 +304,8 @@ class TableProjectWrapper : public TableHandler {
  public:
     TableProjectWrapper(std::shared_ptr<TableHandler> table_handler,
                         const Row& parameter,
-                        const ProjectFun* fun)
-        : TableHandler(), table_hander_(table_handler), parameter_(parameter), value_(), fun_(fun) {}
+                        const ProjectFun* fun, RunMemoryQuota* quota)
+        : TableHandler(), table_hander_(table_handler), parameter_(parameter), value_(), fun_(fun), quota_(quota) {}
     virtual ~TableProjectWrapper() {}
 
     const Types& GetTypes() override { return table_hander_->GetTypes(); }
@@ -311,7 +317,7 @@ class TableProjectWrapper : public TableHandler {
             return std::unique_ptr<WindowIterator>();
         } else {
             return std::unique_ptr<WindowIterator>(
-                new WindowIteratorProjectWrapper(std::move(iter), parameter_, fun_));
+                new WindowIteratorProjectWrapper(std::move(iter), parameter_, fun_, quota_));
         }
     }
     const Schema* GetSchema() override { return table_hander_->GetSchema(); }
@@ -324,11 +330,11 @@ class TableProjectWrapper : public TableHandler {
         if (!iter) {
             return nullptr;
         } else {
-            return new IteratorProjectWrapper(std::move(iter), parameter_, fun_);
+            return new IteratorProjectWrapper(std::move(iter), parameter_, fun_, quota_);
         }
     }
     Row At(uint64_t pos) override {
-        value_ = fun_->operator()(table_hander_->At(pos), parameter_);
+        value_ = fun_->operator()(table_hander_->At(pos), parameter_, quota_);
         return value_;
     }
 
@@ -340,6 +346,7 @@ class TableProjectWrapper : public TableHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    RunMemoryQuota* quota_;
 };
 
 class TableFilterWrapper : public TableHandler {
@@ -425,8 +432,8 @@ class RowProjectWrapper : public RowHandler {
  public:
     RowProjectWrapper(std::shared_ptr<RowHandler> row_handler,
                       const Row& parameter,
-                      const ProjectFun* fun)
-        : RowHandler(), row_handler_(row_handler), parameter_(parameter), value_(), fun_(fun) {}
+                      const ProjectFun* fun, RunMemoryQuota* quota)
+        : RowHandler(), row_handler_(row_handler), parameter_(parameter), value_(), fun_(fun), quota_(quota) {}
     virtual ~RowProjectWrapper() {}
     const Row& GetValue() override {
         auto& row = row_handler_->GetValue();
@@ -434,7 +441,7 @@ class RowProjectWrapper : public RowHandler {
             value_ = row;
             return value_;
         }
-        value_ = fun_->operator()(row, parameter_);
+        value_ = fun_->operator()(row, parameter_, quota_);
         return value_;
     }
     const Schema* GetSchema() override { return row_handler_->GetSchema(); }
@@ -446,6 +453,7 @@ class RowProjectWrapper : public RowHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    RunMemoryQuota* quota_;
 };
 class RowCombineWrapper : public RowHandler {
  public:
@@ -776,8 +784,8 @@ class LazyRequestUnionPartitionHandler final : public PartitionHandler {
 class LazyAggIterator final : public RowIterator {
  public:
     LazyAggIterator(std::unique_ptr<RowIterator>&& it, std::function<std::shared_ptr<TableHandler>(const Row&)> func,
-                    std::shared_ptr<AggGenerator> agg_gen, const Row& param)
-        : it_(std::move(it)), func_(func), agg_gen_(agg_gen), parameter_(param) {
+                    std::shared_ptr<AggGenerator> agg_gen, const Row& param, RunMemoryQuota* quota)
+        : it_(std::move(it)), func_(func), agg_gen_(agg_gen), parameter_(param), quota_(quota) {
         SeekToFirst();
     }
 
@@ -797,6 +805,7 @@ class LazyAggIterator final : public RowIterator {
     std::function<std::shared_ptr<TableHandler>(const Row&)> func_;
     std::shared_ptr<AggGenerator> agg_gen_;
     const Row& parameter_;
+    RunMemoryQuota* quota_;
 
     Row buf_;
 };
@@ -805,8 +814,8 @@ class LazyAggTableHandler final : public TableHandler {
  public:
     LazyAggTableHandler(std::shared_ptr<TableHandler> left,
                         std::function<std::shared_ptr<TableHandler>(const Row&)> func,
-                        std::shared_ptr<AggGenerator> agg_gen, const Row& param)
-        : left_(left), func_(func), agg_gen_(agg_gen), parameter_(param) {
+                        std::shared_ptr<AggGenerator> agg_gen, const Row& param, RunMemoryQuota* quota)
+        : left_(left), func_(func), agg_gen_(agg_gen), parameter_(param), quota_(quota) {
         DLOG(INFO) << "iterator count = " << left_->GetCount();
     }
     ~LazyAggTableHandler() override {}
@@ -825,14 +834,15 @@ class LazyAggTableHandler final : public TableHandler {
     std::function<std::shared_ptr<TableHandler>(const Row&)> func_;
     std::shared_ptr<AggGenerator> agg_gen_;
     const Row& parameter_;
+    RunMemoryQuota* quota_;
 };
 
 class LazyAggWindowIterator final : public codec::WindowIterator {
  public:
     LazyAggWindowIterator(std::unique_ptr<codec::WindowIterator> left,
                           std::function<std::shared_ptr<TableHandler>(const Row&)> func,
-                          std::shared_ptr<AggGenerator> gen, const Row& p)
-        : left_(std::move(left)), func_(func), agg_gen_(gen), parameter_(p) {}
+                          std::shared_ptr<AggGenerator> gen, const Row& p, RunMemoryQuota* quota)
+        : left_(std::move(left)), func_(func), agg_gen_(gen), parameter_(p), quota_(quota) {}
     ~LazyAggWindowIterator() override {}
 
     RowIterator* GetRawValue() override;
@@ -848,13 +858,14 @@ class LazyAggWindowIterator final : public codec::WindowIterator {
     std::function<std::shared_ptr<TableHandler>(const Row&)> func_;
     std::shared_ptr<AggGenerator> agg_gen_;
     const Row& parameter_;
+    RunMemoryQuota* quota_;
 };
 
 class LazyAggPartitionHandler final : public PartitionHandler {
  public:
     LazyAggPartitionHandler(std::shared_ptr<LazyRequestUnionPartitionHandler> input,
-                            std::shared_ptr<AggGenerator> agg_gen, const Row& param)
-        : input_(input), agg_gen_(agg_gen), parameter_(param) {}
+                            std::shared_ptr<AggGenerator> agg_gen, const Row& param, RunMemoryQuota* quota)
+        : input_(input), agg_gen_(agg_gen), parameter_(param), quota_(quota) {}
     ~LazyAggPartitionHandler() override {}
 
     std::shared_ptr<TableHandler> GetSegment(const std::string& key) override;
@@ -877,6 +888,94 @@ class LazyAggPartitionHandler final : public PartitionHandler {
     std::shared_ptr<LazyRequestUnionPartitionHandler> input_;
     std::shared_ptr<AggGenerator> agg_gen_;
     const Row& parameter_;
+    RunMemoryQuota* quota_;
+};
+
+// Groups of a table by `partition_gen`, only materialized into a MemPartitionHandler when they are iterated.
+// GroupAggRunner reads the table and the key function directly and buckets the rows into a hash table instead.
+class LazyGroupPartitionHandler final : public PartitionHandler {
+ public:
+    LazyGroupPartitionHandler(std::shared_ptr<TableHandler> table, PartitionGenerator* partition_gen,
+                              const Row& param)
+        : table_(table), partition_gen_(partition_gen), parameter_(param) {}
+    ~LazyGroupPartitionHandler() override {}
+
+    std::shared_ptr<TableHandler> GetSegment(const std::string& key) override { return Materialize()->GetSegment(key); }
+
+    const std::string GetHandlerTypeName() override { return "LazyGroupPartitionHandler"; }
+
+    codec::RowIterator* GetRawIterator() override { return Materialize()->GetRawIterator(); }
+
+    std::unique_ptr<WindowIterator> GetWindowIterator() override { return Materialize()->GetWindowIterator(); }
+
+    const uint64_t GetCount() override { return Materialize()->GetCount(); }
+
+    const Types& GetTypes() override { return table_->GetTypes(); }
+    const IndexHint& GetIndex() override { return table_->GetIndex(); }
+    const Schema* GetSchema() override { return table_->GetSchema(); }
+    const std::string& GetName() override { return table_->GetName(); }
+    const std::string& GetDatabase() override { return table_->GetDatabase(); }
+    const OrderType GetOrderType() const override { return table_->GetOrderType(); }
+
+    std::shared_ptr<TableHandler> Table() const { return table_; }
+    const std::string GetKey(const Row& row) const { return partition_gen_->GetKey(row, parameter_); }
+
+ private:
+    std::shared_ptr<PartitionHandler> Materialize();
+
+    std::shared_ptr<TableHandler> table_;
+    PartitionGenerator* partition_gen_;
+    Row parameter_;
+    std::shared_ptr<PartitionHandler> partitions_;
+};
+
+// The rows of a window segment shared by the requests of a batch with the same window key. The segment is read
+// once from the first row not newer than `start_key`, which is the latest window end of the requests, and the
+// rows are kept in the order of the segment as they are read.
+class SharedSegmentHandler final : public TableHandler, public std::enable_shared_from_this<SharedSegmentHandler> {
+ public:
+    SharedSegmentHandler(std::shared_ptr<TableHandler> segment, uint64_t start_key);
+    ~SharedSegmentHandler() override {}
+
+    RowIterator* GetRawIterator() override;
+
+    const Types& GetTypes() override { return segment_->GetTypes(); }
+    const IndexHint& GetIndex() override { return segment_->GetIndex(); }
+    const Schema* GetSchema() override { return segment_->GetSchema(); }
+    const std::string& GetName() override { return segment_->GetName(); }
+    const std::string& GetDatabase() override { return segment_->GetDatabase(); }
+    const OrderType GetOrderType() const override { return segment_->GetOrderType(); }
+    const std::string GetHandlerTypeName() override { return "SharedSegmentHandler"; }
+
+    // read the segment until the `pos`-th row, return false if there are not so many rows
+    bool Load(size_t pos);
+    // position of the first row whose key is not greater than `key`
+    size_t Seek(uint64_t key);
+    const std::pair<uint64_t, Row>& GetEntry(size_t pos) const { return rows_[pos]; }
+
+ private:
+    std::shared_ptr<TableHandler> segment_;
+    std::unique_ptr<RowIterator> iter_;
+    std::vector<std::pair<uint64_t, Row>> rows_;
+};
+
+class SharedSegmentIterator final : public RowIterator {
+ public:
+    explicit SharedSegmentIterator(std::shared_ptr<SharedSegmentHandler> segment)
+        : RowIterator(), segment_(segment), pos_(0) {}
+    ~SharedSegmentIterator() override {}
+
+    bool Valid() const override { return segment_->Load(pos_); }
+    void Next() override { pos_++; }
+    const uint64_t& GetKey() const override { return segment_->GetEntry(pos_).first; }
+    const Row& GetValue() override { return segment_->GetEntry(pos_).second; }
+    void Seek(const uint64_t& key) override { pos_ = segment_->Seek(key); }
+    void SeekToFirst() override { pos_ = 0; }
+    bool IsSeekable() const override { return true; }
+
+ private:
+    std::shared_ptr<SharedSegmentHandler> segment_;
+    size_t pos_;
 };
 
 class ConcatIterator final : public RowIterator {
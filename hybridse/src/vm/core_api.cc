@@ -191,60 +191,14 @@ hybridse::vm::TableHandler* GroupbyInterface::GetTableHandler() {
 hybridse::codec::Row CoreAPI::RowConstProject(const RawPtrHandle fn,
                                               const Row parameter,
                                               const bool need_free) {
-    // Init current run step runtime
-    JitRuntime::get()->InitRunStep();
-
-    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t*,
-                                            const int8_t*, const int8_t*, int8_t**)>(
-        const_cast<int8_t*>(fn));
-    int8_t* buf = nullptr;
-    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
-    uint32_t ret = udf(0, nullptr, nullptr, parameter_ptr, &buf);
-
-    // Release current run step resources
-    JitRuntime::get()->ReleaseRunStep();
-
-    if (ret != 0) {
-        LOG(WARNING) << "fail to run udf " << ret;
-        return hybridse::codec::Row();
-    }
-    return Row(base::RefCountedSlice::CreateManaged(
-        buf, hybridse::codec::RowView::GetSize(buf)));
+    return Runner::RowConstProject(fn, parameter, need_free, nullptr);
 }
 
 hybridse::codec::Row CoreAPI::RowProject(const RawPtrHandle fn,
                                          const hybridse::codec::Row& row,
                                          const hybridse::codec::Row& parameter,
                                          const bool need_free) {
-    if (row.empty()) {
-        return hybridse::codec::Row();
-    }
-
-    // Init current run step runtime
-    JitRuntime::get()->InitRunStep();
-
-    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t*,
-                                            const int8_t*, const int8_t*, int8_t**)>(
-        const_cast<int8_t*>(fn));
-
-    auto row_ptr = reinterpret_cast<const int8_t*>(&row);
-
-    // TODO(tobe): do not need to pass parameter row for offline
-    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
-
-    int8_t* buf = nullptr;
-    uint32_t ret = udf(0, row_ptr, nullptr, parameter_ptr, &buf);
-
-    // Release current run step resources
-    JitRuntime::get()->ReleaseRunStep();
-
-    if (ret != 0) {
-        LOG(WARNING) << "fail to run udf " << ret;
-        return hybridse::codec::Row();
-    }
-
-    return Row(base::RefCountedSlice::CreateManaged(
-        buf, hybridse::codec::RowView::GetSize(buf)));
+    return Runner::RowProject(fn, row, parameter, need_free, nullptr);
 }
 
 hybridse::codec::Row CoreAPI::UnsafeRowProject(
@@ -27,6 +27,7 @@
 #include "vm/mem_catalog.h"
 #include "vm/sql_compiler.h"
 #include "vm/internal/node_helper.h"
+#include "vm/jit_runtime.h"
 #include "vm/runner_ctx.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
@@ -374,6 +375,17 @@ bool RunSession::SetCompileInfo(const std::shared_ptr<CompileInfo>& compile_info
     return true;
 }
 
+bool RunSession::UpdateMemoryStat(const RunMemoryQuota& quota) {
+    peak_memory_ = quota.peak_bytes.load(std::memory_order_relaxed);
+    memory_exceeded_ = quota.IsExceeded();
+    if (memory_exceeded_) {
+        LOG(WARNING) << "fail to run " << sp_name_ << ": run step memory " << peak_memory_ << " exceeds limit "
+                     << memory_limit_;
+        return false;
+    }
+    return true;
+}
+
 int32_t RequestRunSession::Run(const Row& in_row, Row* out_row) {
     DLOG(INFO) << "Request Row Run with main task";
     return Run(std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job.main_task_id(),
@@ -391,7 +403,15 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row, Row* o
     DLOG(INFO) << "Request Row Run with task_id " << task_id;
     RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job, in_row,
                       sp_name_, is_debug_);
-    auto output = task->RunWithCache(ctx);
+    ctx.set_max_parallel_producers(max_parallel_producers_);
+    ctx.set_parallel_executor(parallel_executor_);
+    ctx.set_trace(trace_);
+    RunMemoryQuota quota(memory_limit_);
+    ctx.set_memory_quota(&quota);
+    std::shared_ptr<DataHandler> output = task->RunWithCache(ctx);
+    if (!UpdateMemoryStat(quota)) {
+        return -3;
+    }
     if (!output) {
         LOG(WARNING) << "Run request plan output is null";
         return -1;
@@ -411,13 +431,19 @@ int32_t BatchRequestRunSession::Run(const uint32_t id, const std::vector<Row>& r
                                     std::vector<Row>& output) {
     RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job,
                       request_batch, sp_name_, is_debug_);
+    ctx.set_trace(trace_);
     auto task =
         std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job.GetTask(id).GetRoot();
     if (nullptr == task) {
         LOG(WARNING) << "Fail to run request plan: taskid" << id << " not exist!";
         return -2;
     }
-    auto handler = task->BatchRequestRun(ctx);
+    RunMemoryQuota quota(memory_limit_);
+    ctx.set_memory_quota(&quota);
+    std::shared_ptr<DataHandlerList> handler = task->BatchRequestRun(ctx);
+    if (!UpdateMemoryStat(quota)) {
+        return -3;
+    }
     if (!handler) {
         LOG(WARNING) << "Run request plan output is null";
         return -1;
@@ -435,7 +461,18 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
     RunnerContext ctx(&sql_ctx.cluster_job, parameter_row, is_debug_);
-    auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
+    ctx.set_trace(trace_);
+    RunMemoryQuota quota(memory_limit_);
+    // the output may be lazy, which fails the run through the quota if it can't be iterated
+    ctx.set_memory_quota(&quota);
+    std::shared_ptr<DataHandler> output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
+    if (!UpdateMemoryStat(quota)) {
+        return -3;
+    }
+    if (quota.IsFailed()) {
+        LOG(WARNING) << "fail to run batch plan: a runner fails to read its inputs";
+        return -1;
+    }
     if (!output) {
         DLOG(INFO) << "Run batch plan output is empty";
         return 0;
@@ -451,6 +488,11 @@ int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, u
                 rows.push_back(iter->GetValue());
                 iter->Next();
             }
+            if (quota.IsFailed()) {
+                LOG(WARNING) << "fail to run batch plan: fail to read the output";
+                rows.clear();
+                return -1;
+            }
             return 0;
         }
         case kRowHandler: {
@@ -16,12 +16,15 @@
 
 #include "vm/generator.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "node/sql_node.h"
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/runner.h"
+#include "vm/spill.h"
 
 namespace hybridse {
 namespace vm {
@@ -110,14 +113,14 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
     return output_partitions;
 }
 std::shared_ptr<DataHandler> SortGenerator::Sort(
-    std::shared_ptr<DataHandler> input, const bool reverse) {
+    std::shared_ptr<DataHandler> input, const bool reverse, RunMemoryQuota* quota) {
     if (!input || !is_valid_ || !order_gen_.Valid()) {
         return input;
     }
     switch (input->GetHandlerType()) {
         case kTableHandler:
             return Sort(std::dynamic_pointer_cast<TableHandler>(input),
-                        reverse);
+                        reverse, quota);
         case kPartitionHandler:
             return Sort(std::dynamic_pointer_cast<PartitionHandler>(input),
                         reverse);
@@ -178,7 +181,7 @@ std::shared_ptr<PartitionHandler> SortGenerator::Sort(
 }
 
 std::shared_ptr<TableHandler> SortGenerator::Sort(
-    std::shared_ptr<TableHandler> table, const bool reverse) {
+    std::shared_ptr<TableHandler> table, const bool reverse, RunMemoryQuota* quota) {
     bool is_asc = reverse ? !is_asc_ : is_asc_;
     if (!table || !is_valid_) {
         return table;
@@ -187,46 +190,97 @@ std::shared_ptr<TableHandler> SortGenerator::Sort(
         is_asc == (table->GetOrderType() == kAscOrder)) {
         return table;
     }
-    auto output_table = std::make_shared<MemTimeTableHandler>(table->GetSchema());
-    output_table->SetOrderType(table->GetOrderType());
     auto iter = std::dynamic_pointer_cast<TableHandler>(table)->GetIterator();
     if (!iter) {
         LOG(WARNING) << "Sort table fail: table is Empty";
         return std::shared_ptr<TableHandler>();
     }
     iter->SeekToFirst();
-    while (iter->Valid()) {
-        if (order_gen_.Valid()) {
+    if (order_gen_.Valid()) {
+        // sorted runs are spilled to files if the rows exceed the memory limit of batch operators
+        ExternalSorter sorter(table->GetSchema(), is_asc, quota);
+        while (iter->Valid()) {
             int64_t key = order_gen_.Gen(iter->GetValue());
-            output_table->AddRow(static_cast<uint64_t>(key), iter->GetValue());
-        } else {
-            output_table->AddRow(iter->GetKey(), iter->GetValue());
+            sorter.Add(static_cast<uint64_t>(key), iter->GetValue());
+            iter->Next();
         }
+        return sorter.Finish();
+    }
+    auto output_table = std::make_shared<MemTimeTableHandler>(table->GetSchema());
+    output_table->SetOrderType(table->GetOrderType());
+    while (iter->Valid()) {
+        output_table->AddRow(iter->GetKey(), iter->GetValue());
         iter->Next();
     }
 
-    if (order_gen_.Valid()) {
-        output_table->Sort(is_asc);
-    } else {
-        switch (table->GetOrderType()) {
-            case kDescOrder:
-                if (is_asc) {
-                    output_table->Reverse();
-                }
-                break;
-            case kAscOrder:
-                if (!is_asc) {
-                    output_table->Reverse();
-                }
-                break;
-            default: {
-                LOG(WARNING) << "Fail to Sort, order type invalid";
-                return std::shared_ptr<TableHandler>();
+    switch (table->GetOrderType()) {
+        case kDescOrder:
+            if (is_asc) {
+                output_table->Reverse();
             }
+            break;
+        case kAscOrder:
+            if (!is_asc) {
+                output_table->Reverse();
+            }
+            break;
+        default: {
+            LOG(WARNING) << "Fail to Sort, order type invalid";
+            return std::shared_ptr<TableHandler>();
         }
     }
     return output_table;
 }
+std::shared_ptr<TableHandler> SortGenerator::TopN(std::shared_ptr<TableHandler> table, const int32_t n) {
+    if (!table || !is_valid_ || !order_gen_.Valid()) {
+        auto sorted = Sort(table);
+        return sorted ? std::make_shared<LimitTableHandler>(sorted, n) : sorted;
+    }
+    auto iter = table->GetIterator();
+    if (!iter) {
+        LOG(WARNING) << "Sort table fail: table is Empty";
+        return std::shared_ptr<TableHandler>();
+    }
+    struct Entry {
+        uint64_t key;
+        uint64_t seq;
+        Row row;
+    };
+    // keys are compared as in MemTimeTableHandler::Sort, ties keep the input order
+    bool is_asc = is_asc_;
+    auto before = [is_asc](const Entry& l, const Entry& r) {
+        if (l.key != r.key) {
+            return is_asc ? l.key < r.key : l.key > r.key;
+        }
+        return l.seq < r.seq;
+    };
+    // the top of the heap is the last one of the first n rows
+    // n comes from the query and may be far larger than the input, so the heap grows as rows come
+    std::vector<Entry> heap;
+    heap.reserve(std::min(n > 0 ? n : 0, 1024));
+    uint64_t seq = 0;
+    for (iter->SeekToFirst(); n > 0 && iter->Valid(); iter->Next()) {
+        Entry entry{static_cast<uint64_t>(order_gen_.Gen(iter->GetValue())), seq++, Row()};
+        if (heap.size() < static_cast<size_t>(n)) {
+            entry.row = iter->GetValue();
+            heap.push_back(std::move(entry));
+            std::push_heap(heap.begin(), heap.end(), before);
+        } else if (before(entry, heap.front())) {
+            entry.row = iter->GetValue();
+            std::pop_heap(heap.begin(), heap.end(), before);
+            heap.back() = std::move(entry);
+            std::push_heap(heap.begin(), heap.end(), before);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), before);
+    auto output_table = std::make_shared<MemTimeTableHandler>(table->GetSchema());
+    for (auto& entry : heap) {
+        output_table->AddRow(entry.key, entry.row);
+    }
+    output_table->SetOrderType(is_asc ? kAscOrder : kDescOrder);
+    return output_table;
+}
+
 Row JoinGenerator::RowLastJoinDropLeftSlices(
     const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter) {
     Row joined = RowLastJoin(left_row, right, parameter);
@@ -661,24 +715,29 @@ const bool ConditionGenerator::Gen(std::shared_ptr<TableHandler> table, const co
     return Runner::GetColumnBool(cond_row.buf(), &row_view_, idxs_[0],
                                  row_view_.GetSchema()->Get(idxs_[0]).type());
 }
-const Row ProjectGenerator::Gen(const Row& row, const Row& parameter) {
-    return CoreAPI::RowProject(fn_, row, parameter, false);
+Row RowProjectFun::operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const {
+    return Runner::RowProject(fn_, row, parameter, false, quota);
+}
+
+const Row ProjectGenerator::Gen(const Row& row, const Row& parameter, RunMemoryQuota* quota) {
+    return Runner::RowProject(fn_, row, parameter, false, quota);
 }
 
-const Row ConstProjectGenerator::Gen(const Row& parameter) {
-    return CoreAPI::RowConstProject(fn_, parameter, false);
+const Row ConstProjectGenerator::Gen(const Row& parameter, RunMemoryQuota* quota) {
+    return Runner::RowConstProject(fn_, parameter, false, quota);
 }
 
-const Row AggGenerator::Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table) {
-    return Runner::GroupbyProject(fn_, parameter_row, table.get());
+const Row AggGenerator::Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table,
+                            RunMemoryQuota* quota) {
+    return Runner::GroupbyProject(fn_, parameter_row, table.get(), quota);
 }
 
 const Row WindowProjectGenerator::Gen(const uint64_t key, const Row row,
                                       const codec::Row& parameter,
                                       bool is_instance, size_t append_slices,
-                                      Window* window) {
+                                      Window* window, RunMemoryQuota* quota) {
     return Runner::WindowProject(fn_, key, row, parameter, is_instance, append_slices,
-                                 window);
+                                 window, quota);
 }
 
 std::shared_ptr<TableHandler> IndexSeekGenerator::SegmnetOfConstKey(
@@ -803,11 +862,7 @@ bool FilterGenerator::ValidIndex() const {
 }
 std::vector<std::shared_ptr<DataHandler>> InputsGenerator::RunInputs(
     RunnerContext& ctx) {
-    std::vector<std::shared_ptr<DataHandler>> union_inputs;
-    for (auto runner : input_runners_) {
-        union_inputs.push_back(runner->RunWithCache(ctx));
-    }
-    return union_inputs;
+    return Runner::RunProducers(ctx, input_runners_);
 }
 
 std::vector<std::shared_ptr<PartitionHandler>> WindowUnionGenerator::PartitionEach(
@@ -825,13 +880,10 @@ std::vector<std::shared_ptr<PartitionHandler>> WindowUnionGenerator::PartitionEa
 
 std::vector<std::shared_ptr<DataHandler>> WindowJoinGenerator::RunInputs(
     RunnerContext& ctx) {
-    std::vector<std::shared_ptr<DataHandler>> union_inputs;
-    if (!input_runners_.empty()) {
-        for (auto runner : input_runners_) {
-            union_inputs.push_back(runner->RunWithCache(ctx));
-        }
+    if (input_runners_.empty()) {
+        return {};
     }
-    return union_inputs;
+    return Runner::RunProducers(ctx, input_runners_);
 }
 Row WindowJoinGenerator::Join(
     const Row& left_row,
@@ -858,6 +910,21 @@ std::vector<std::shared_ptr<TableHandler>> RequestWindowUnionGenerator::GetReque
     }
     return union_segments;
 }
+std::string RequestWindowUnionGenerator::GetRequestWindowsKey(const Row& row, const Row& parameter) {
+    std::string windows_key;
+    for (auto& window_gen : windows_gen_) {
+        for (const auto& key : {window_gen.index_seek_gen_.Valid()
+                                    ? window_gen.index_seek_gen_.index_key_gen_.Gen(row, parameter)
+                                    : std::string(),
+                                window_gen.filter_gen_.GetKey(row, parameter)}) {
+            // the keys are prefixed by their size so that they never run into each other
+            uint32_t size = key.size();
+            windows_key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            windows_key.append(key);
+        }
+    }
+    return windows_key;
+}
 void RequestWindowUnionGenerator::AddWindowUnion(const RequestWindowOp& window_op, Runner* runner) {
     windows_gen_.emplace_back(window_op);
     AddInput(runner);
@@ -32,10 +32,12 @@ namespace vm {
 // forward
 class Runner;
 class RunnerContext;
+struct RunMemoryQuota;
 
+// project a row in a run step, whose runtime memory is accounted to `quota` if it is not null
 class ProjectFun {
  public:
-    virtual Row operator()(const Row& row, const Row& parameter) const = 0;
+    virtual Row operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const = 0;
 };
 class PredicateFun {
  public:
@@ -62,9 +64,7 @@ class RowProjectFun : public ProjectFun {
  public:
     explicit RowProjectFun(const int8_t* fn) : ProjectFun(), fn_(fn) {}
     ~RowProjectFun() {}
-    Row operator()(const Row& row, const Row& parameter) const override {
-        return CoreAPI::RowProject(fn_, row, parameter, false);
-    }
+    Row operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const override;
     const int8_t* fn_;
 };
 
@@ -72,7 +72,7 @@ class ProjectGenerator : public FnGenerator {
  public:
     explicit ProjectGenerator(const FnInfo& info) : FnGenerator(info), fun_(info.fn_ptr()) {}
     virtual ~ProjectGenerator() {}
-    const Row Gen(const Row& row, const Row& parameter);
+    const Row Gen(const Row& row, const Row& parameter, RunMemoryQuota* quota);
     RowProjectFun fun_;
 };
 
@@ -80,7 +80,7 @@ class ConstProjectGenerator : public FnGenerator {
  public:
     explicit ConstProjectGenerator(const FnInfo& info) : FnGenerator(info), fun_(info.fn_ptr()) {}
     virtual ~ConstProjectGenerator() {}
-    const Row Gen(const Row& parameter);
+    const Row Gen(const Row& parameter, RunMemoryQuota* quota);
     RowProjectFun fun_;
 };
 class AggGenerator : public FnGenerator, public std::enable_shared_from_this<AggGenerator> {
@@ -90,7 +90,7 @@ class AggGenerator : public FnGenerator, public std::enable_shared_from_this<Agg
     }
 
     virtual ~AggGenerator() {}
-    const Row Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table);
+    const Row Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table, RunMemoryQuota* quota);
 
  private:
     explicit AggGenerator(const FnInfo& info) : FnGenerator(info) {}
@@ -100,7 +100,7 @@ class WindowProjectGenerator : public FnGenerator {
     explicit WindowProjectGenerator(const FnInfo& info) : FnGenerator(info) {}
     virtual ~WindowProjectGenerator() {}
     const Row Gen(const uint64_t key, const Row row, const codec::Row& parameter_row, const bool is_instance,
-                  size_t append_slices, Window* window);
+                  size_t append_slices, Window* window, RunMemoryQuota* quota);
 };
 class KeyGenerator : public FnGenerator {
  public:
@@ -199,9 +199,15 @@ class SortGenerator {
 
     const bool Valid() const { return is_valid_; }
 
-    std::shared_ptr<DataHandler> Sort(std::shared_ptr<DataHandler> input, const bool reverse = false);
+    // a large table is sorted with spill files only if `quota` is set, which fails the run if they
+    // can't be read back
+    std::shared_ptr<DataHandler> Sort(std::shared_ptr<DataHandler> input, const bool reverse = false,
+                                      RunMemoryQuota* quota = nullptr);
     std::shared_ptr<PartitionHandler> Sort(std::shared_ptr<PartitionHandler> partition, const bool reverse = false);
-    std::shared_ptr<TableHandler> Sort(std::shared_ptr<TableHandler> table, const bool reverse = false);
+    std::shared_ptr<TableHandler> Sort(std::shared_ptr<TableHandler> table, const bool reverse = false,
+                                       RunMemoryQuota* quota = nullptr);
+    // the first `n` rows of the sorted table, kept in a bounded heap instead of sorting all of them
+    std::shared_ptr<TableHandler> TopN(std::shared_ptr<TableHandler> table, const int32_t n);
     const OrderGenerator& order_gen() const { return order_gen_; }
 
  private:
@@ -383,6 +389,8 @@ class RequestWindowUnionGenerator : public InputsGenerator,
 
     std::vector<std::shared_ptr<TableHandler>> GetRequestWindows(
         const Row& row, const Row& parameter, std::vector<std::shared_ptr<DataHandler>> union_inputs);
+    // requests with the same key get the same windows of the union inputs
+    std::string GetRequestWindowsKey(const Row& row, const Row& parameter);
     std::vector<RequestWindowGenertor> windows_gen_;
 
  private:
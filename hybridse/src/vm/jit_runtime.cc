@@ -20,12 +20,25 @@ namespace vm {
 
 thread_local JitRuntime JitRuntime::tls_runtime_inst_;
 
+void RunMemoryQuota::Account(size_t used) {
+    size_t peak = peak_bytes.load(std::memory_order_relaxed);
+    while (used > peak && !peak_bytes.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+    if (limit > 0 && used > limit) {
+        exceeded.store(true, std::memory_order_relaxed);
+    }
+}
+
 JitRuntime* JitRuntime::get() { return &tls_runtime_inst_; }
 
 int8_t* JitRuntime::AllocManaged(size_t bytes) {
     return reinterpret_cast<int8_t*>(mem_pool_.Alloc(bytes));
 }
 
+int8_t* JitRuntime::AllocManaged(size_t bytes, size_t align) {
+    return reinterpret_cast<int8_t*>(mem_pool_.Alloc(bytes, align));
+}
+
 void JitRuntime::AddManagedObject(base::FeBaseObject* obj) {
     if (obj != nullptr) {
         allocated_obj_pool_.push_back(obj);
@@ -34,7 +47,10 @@ void JitRuntime::AddManagedObject(base::FeBaseObject* obj) {
 
 void JitRuntime::InitRunStep() {}
 
-void JitRuntime::ReleaseRunStep() {
+void JitRuntime::ReleaseRunStep(RunMemoryQuota* quota) {
+    if (quota != nullptr) {
+        quota->Account(mem_pool_.GetAllocatedSize());
+    }
     mem_pool_.Reset();
     for (base::FeBaseObject* obj : allocated_obj_pool_) {
         if (obj != nullptr) {
@@ -16,6 +16,7 @@
 #ifndef HYBRIDSE_SRC_VM_JIT_RUNTIME_H_
 #define HYBRIDSE_SRC_VM_JIT_RUNTIME_H_
 
+#include <atomic>
 #include <list>
 
 #include "base/fe_object.h"
@@ -24,6 +25,32 @@
 namespace hybridse {
 namespace vm {
 
+/**
+ * Memory quota of a running query, shared by all threads running it.
+ *
+ * It is carried by the RunnerContext and the lazy handlers of the run and passed
+ * to each run step explicitly, never bound to a thread, since a bthread running
+ * the query may move to another pthread between two steps.
+ */
+struct RunMemoryQuota {
+    explicit RunMemoryQuota(size_t limit) : limit(limit), peak_bytes(0), exceeded(false), failed(false) {}
+    // max bytes of runtime memory of a run step, 0 means unlimited
+    const size_t limit;
+    std::atomic<size_t> peak_bytes;
+    std::atomic<bool> exceeded;
+    // set if a lazy handler fails while it is iterated, e.g. a spill file can't be read
+    std::atomic<bool> failed;
+
+    // record the bytes of a finished run step
+    void Account(size_t used);
+
+    bool IsExceeded() const { return exceeded.load(std::memory_order_relaxed); }
+
+    void SetFailed() { failed.store(true, std::memory_order_relaxed); }
+
+    bool IsFailed() const { return failed.load(std::memory_order_relaxed); }
+};
+
 class JitRuntime {
  public:
     JitRuntime() {}
@@ -40,6 +67,11 @@ class JitRuntime {
      */
     int8_t* AllocManaged(size_t bytes);
 
+    /**
+     * Allocate raw memory aligned to `align`, which is a power of 2.
+     */
+    int8_t* AllocManaged(size_t bytes, size_t align);
+
     openmldb::base::ByteMemoryPool* GetMemPool() { return &mem_pool_; }
 
     /**
@@ -54,9 +86,10 @@ class JitRuntime {
     void InitRunStep();
 
     /**
-     * Release resources allocated in run step
+     * Release resources allocated in run step, the bytes of the step are
+     * accounted to `quota` if it is not null.
      */
-    void ReleaseRunStep();
+    void ReleaseRunStep(RunMemoryQuota* quota = nullptr);
 
  private:
     openmldb::base::ByteMemoryPool mem_pool_;
@@ -139,7 +139,7 @@ class SimpleWrapperFun : public ProjectFun {
  public:
     SimpleWrapperFun() : ProjectFun() {}
     ~SimpleWrapperFun() {}
-    Row operator()(const Row& row, const Row& parameter) const override { return project(row); }
+    Row operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const override { return project(row); }
 };
 
 TEST_F(MemCataLogTest, table_hander_wrapper_test) {
@@ -155,7 +155,7 @@ TEST_F(MemCataLogTest, table_hander_wrapper_test) {
 
     SimpleWrapperFun fn;
     Row parameter;
-    vm::TableProjectWrapper wrapper(table_handler, parameter, &fn);
+    vm::TableProjectWrapper wrapper(table_handler, parameter, &fn, nullptr);
 
     type::TableDef table2;
     {
@@ -200,7 +200,7 @@ TEST_F(MemCataLogTest, partition_hander_wrapper_test) {
 
     SimpleWrapperFun fn;
     Row parameter;
-    vm::PartitionProjectWrapper wrapper(partition_handler, parameter, &fn);
+    vm::PartitionProjectWrapper wrapper(partition_handler, parameter, &fn, nullptr);
 
     type::TableDef table2;
     {
@@ -465,6 +465,43 @@ TEST_F(MemCataLogTest, mem_row_comcat_test) {
     }
 }
 
+TEST_F(MemCataLogTest, shared_segment_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // keys 10, 8, 8, 6, 4
+    auto segment = std::make_shared<MemTimeTableHandler>("t1", "temp", &(table.columns()));
+    std::vector<uint64_t> keys = {10, 8, 8, 6, 4};
+    for (size_t i = 0; i < rows.size(); i++) {
+        segment->AddRow(keys[i], rows[i]);
+    }
+    segment->SetOrderType(kDescOrder);
+
+    // the rows newer than 9 are never read
+    auto shared = std::make_shared<SharedSegmentHandler>(segment, 9);
+    auto iter = shared->GetIterator();
+    auto iter2 = shared->GetIterator();
+    iter->Seek(6);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(6u, iter->GetKey());
+    ASSERT_EQ(0, iter->GetValue().compare(rows[3]));
+    iter2->SeekToFirst();
+    for (size_t i = 1; i < rows.size(); i++) {
+        ASSERT_TRUE(iter2->Valid());
+        ASSERT_EQ(keys[i], iter2->GetKey());
+        ASSERT_EQ(0, iter2->GetValue().compare(rows[i]));
+        iter2->Next();
+    }
+    ASSERT_FALSE(iter2->Valid());
+    iter->Seek(8);
+    ASSERT_EQ(8u, iter->GetKey());
+    ASSERT_EQ(0, iter->GetValue().compare(rows[1]));
+    iter->Seek(7);
+    ASSERT_EQ(6u, iter->GetKey());
+    iter->Seek(3);
+    ASSERT_FALSE(iter->Valid());
+}
+
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
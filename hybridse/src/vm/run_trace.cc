@@ -0,0 +1,42 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/run_trace.h"
+
+#include <utility>
+
+namespace hybridse {
+namespace vm {
+
+void RunTrace::AddSpan(RunSpan span) {
+    std::lock_guard<std::mutex> lock(mu_);
+    costs_[span.runner_id] += span.cost_us;
+    spans_.push_back(std::move(span));
+}
+
+int64_t RunTrace::GetCost(int32_t runner_id) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = costs_.find(runner_id);
+    return it == costs_.end() ? 0 : it->second;
+}
+
+std::vector<RunSpan> RunTrace::GetSpans() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return spans_;
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -16,10 +16,15 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/substitute.h"
 #include "base/texttable.h"
@@ -31,8 +36,10 @@
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
 #include "vm/runner_ctx.h"
+#include "vm/spill.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_uint64(batch_operator_mem_limit);
 
 namespace hybridse {
 namespace vm {
@@ -40,6 +47,53 @@ namespace vm {
 #define MAX_DEBUG_LINES_CNT 20
 #define MAX_DEBUG_COLUMN_MAX 20
 
+// Records the span of a runner into the trace of the run context, does nothing if the run isn't traced.
+// The self time takes off the spans of the given producers finished meanwhile, taken from the trace
+// rather than any thread state since a run may switch threads while it waits for a remote producer.
+class ScopedRunnerSpan {
+ public:
+    ScopedRunnerSpan(const RunnerContext& ctx, RunnerType type, int32_t id, const std::vector<Runner*>& producers,
+                     Runner* extra_producer = nullptr)
+        : trace_(ctx.trace()),
+          type_(type),
+          id_(id),
+          start_us_(0),
+          producers_(producers),
+          extra_producer_(extra_producer) {
+        if (trace_ != nullptr) {
+            start_us_ = trace_->ElapsedMicros();
+            producer_us_ = ProducerCost();
+        }
+    }
+    ~ScopedRunnerSpan() {
+        if (trace_ == nullptr) {
+            return;
+        }
+        int64_t cost_us = trace_->ElapsedMicros() - start_us_;
+        int64_t self_us = std::max<int64_t>(0, cost_us - (ProducerCost() - producer_us_));
+        trace_->AddSpan({RunnerTypeName(type_), id_, start_us_, cost_us, self_us});
+    }
+
+ private:
+    int64_t ProducerCost() const {
+        int64_t cost = extra_producer_ == nullptr ? 0 : trace_->GetCost(extra_producer_->id_);
+        for (auto producer : producers_) {
+            if (producer != nullptr) {
+                cost += trace_->GetCost(producer->id_);
+            }
+        }
+        return cost;
+    }
+
+    RunTrace* trace_;
+    RunnerType type_;
+    int32_t id_;
+    int64_t start_us_;
+    int64_t producer_us_ = 0;
+    const std::vector<Runner*>& producers_;
+    Runner* extra_producer_;
+};
+
 bool Runner::GetColumnBool(const int8_t* buf, const RowView* row_view, int idx,
                            type::Type type) {
     bool key = false;
@@ -103,11 +157,65 @@ bool Runner::GetColumnBool(const int8_t* buf, const RowView* row_view, int idx,
 
 // cache the row into window and
 // if `is_instance`, compute window project for current row
+Row Runner::RowConstProject(const int8_t* fn, const Row& parameter, const bool need_free,
+                            RunMemoryQuota* quota) {
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+
+    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t*,
+                                            const int8_t*, const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(fn));
+    int8_t* buf = nullptr;
+    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
+    uint32_t ret = udf(0, nullptr, nullptr, parameter_ptr, &buf);
+
+    // Release current run step resources
+    JitRuntime::get()->ReleaseRunStep(quota);
+
+    if (ret != 0) {
+        LOG(WARNING) << "fail to run udf " << ret;
+        return Row();
+    }
+    return Row(base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf)));
+}
+
+Row Runner::RowProject(const int8_t* fn, const Row& row, const Row& parameter, const bool need_free,
+                       RunMemoryQuota* quota) {
+    if (row.empty()) {
+        return Row();
+    }
+
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+
+    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t*,
+                                            const int8_t*, const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(fn));
+
+    auto row_ptr = reinterpret_cast<const int8_t*>(&row);
+
+    // TODO(tobe): do not need to pass parameter row for offline
+    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
+
+    int8_t* buf = nullptr;
+    uint32_t ret = udf(0, row_ptr, nullptr, parameter_ptr, &buf);
+
+    // Release current run step resources
+    JitRuntime::get()->ReleaseRunStep(quota);
+
+    if (ret != 0) {
+        LOG(WARNING) << "fail to run udf " << ret;
+        return Row();
+    }
+
+    return Row(base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf)));
+}
+
 Row Runner::WindowProject(const int8_t* fn, const uint64_t row_key,
                           const Row row,
                           const codec::Row& parameter,
                           const bool is_instance,
-                          size_t append_slices, Window* window) {
+                          size_t append_slices, Window* window, RunMemoryQuota* quota) {
     if (row.empty()) {
         return row;
     }
@@ -135,7 +243,7 @@ Row Runner::WindowProject(const int8_t* fn, const uint64_t row_key,
     uint32_t ret = udf(row_key, row_ptr, window_ptr, parameter_ptr, &out_buf);
 
     // Release current run step resources
-    JitRuntime::get()->ReleaseRunStep();
+    JitRuntime::get()->ReleaseRunStep(quota);
 
     if (ret != 0) {
         LOG(WARNING) << "fail to run udf " << ret;
@@ -233,6 +341,7 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
         }
     }
 
+    ScopedRunnerSpan span(ctx, type_, id_, producers_);
     std::shared_ptr<DataHandlerVector> outputs = std::make_shared<DataHandlerVector>();
     std::vector<std::shared_ptr<DataHandler>> inputs(producers_.size());
     std::vector<std::shared_ptr<DataHandlerList>> batch_inputs(producers_.size());
@@ -294,12 +403,18 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
             return cached;
         }
     }
-    std::vector<std::shared_ptr<DataHandler>> inputs(producers_.size());
-    for (size_t idx = producers_.size(); idx > 0; idx--) {
-        inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
-    }
+    ScopedRunnerSpan span(ctx, type_, id_, producers_);
+    auto inputs = RunProducers(ctx, producers_);
 
     auto res = Run(ctx, inputs);
+    if (ctx.IsMemoryExceeded()) {
+        LOG(WARNING) << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << " exceeds memory limit";
+        return nullptr;
+    }
+    if (ctx.IsRunFailed()) {
+        LOG(WARNING) << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << " fails to read its inputs";
+        return nullptr;
+    }
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << "\n";
@@ -311,6 +426,79 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
     }
     return res;
 }
+
+bool Runner::HasBlockingRunner() const {
+    int8_t flag = has_blocking_runner_.load(std::memory_order_relaxed);
+    if (flag < 0) {
+        bool has_blocking = IsBlockingRunner(type_);
+        for (auto producer : producers_) {
+            if (has_blocking) {
+                break;
+            }
+            has_blocking = producer != nullptr && producer->HasBlockingRunner();
+        }
+        flag = has_blocking ? 1 : 0;
+        has_blocking_runner_.store(flag, std::memory_order_relaxed);
+    }
+    return flag > 0;
+}
+
+std::vector<std::shared_ptr<DataHandler>> Runner::RunProducers(RunnerContext& ctx,
+                                                               const std::vector<Runner*>& producers) {
+    std::vector<std::shared_ptr<DataHandler>> inputs(producers.size());
+    std::vector<bool> dispatched(producers.size(), false);
+    std::vector<std::function<void()>> tasks;
+    auto executor = ctx.parallel_executor();
+    if (executor != nullptr && ctx.max_parallel_producers() > 0 && producers.size() > 1) {
+        size_t blocking_cnt = 0;
+        for (auto producer : producers) {
+            if (producer != nullptr && producer->HasBlockingRunner()) {
+                blocking_cnt++;
+            }
+        }
+        // it only pays off to overlap the waits of several blocking subtrees
+        if (blocking_cnt > 1) {
+            // keep the first blocking subtree on the current thread, it would wait anyway
+            bool has_inline_blocking = false;
+            tasks.emplace_back();
+            for (size_t idx = producers.size(); idx > 0; idx--) {
+                auto producer = producers[idx - 1];
+                if (producer == nullptr || !producer->HasBlockingRunner()) {
+                    continue;
+                }
+                if (!has_inline_blocking) {
+                    has_inline_blocking = true;
+                    continue;
+                }
+                if (!ctx.AcquireParallelSlot()) {
+                    break;
+                }
+                dispatched[idx - 1] = true;
+                auto* output = &inputs[idx - 1];
+                // the run steps of the producer account to the quota of `ctx`, nothing is bound to the worker
+                tasks.emplace_back([&ctx, producer, output]() {
+                    *output = producer->RunWithCache(ctx);
+                    ctx.ReleaseParallelSlot();
+                });
+            }
+        }
+    }
+    auto run_inline = [&ctx, &producers, &inputs, &dispatched]() {
+        for (size_t idx = producers.size(); idx > 0; idx--) {
+            if (!dispatched[idx - 1]) {
+                inputs[idx - 1] = producers[idx - 1]->RunWithCache(ctx);
+            }
+        }
+    };
+    if (tasks.size() > 1) {
+        tasks[0] = run_inline;
+        executor->RunAll(tasks);
+    } else {
+        run_inline();
+    }
+    return inputs;
+}
+
 std::shared_ptr<DataHandler> DataRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -392,6 +580,15 @@ std::shared_ptr<DataHandler> GroupRunner::Run(
         LOG(WARNING) << "input is empty";
         return fail_ptr;
     }
+    if (kTableHandler == input->GetHandlerType() && partition_gen_.Valid()) {
+        auto table = std::dynamic_pointer_cast<TableHandler>(input);
+        if (!table) {
+            LOG(WARNING) << "input table is null";
+            return fail_ptr;
+        }
+        // the groups are built by the consumer, GroupAggRunner hashes the rows without ordering them by key
+        return std::make_shared<LazyGroupPartitionHandler>(table, &partition_gen_, ctx.GetParameterRow());
+    }
     return partition_gen_.Partition(input, ctx.GetParameterRow());
 }
 std::shared_ptr<DataHandler> SortRunner::Run(
@@ -407,14 +604,22 @@ std::shared_ptr<DataHandler> SortRunner::Run(
         LOG(WARNING) << "input is empty";
         return fail_ptr;
     }
-    return sort_gen_.Sort(input);
+    if (limit_cnt_.has_value()) {
+        // the limit is pushed down by LimitOptimized, no LimitRunner follows
+        if (kTableHandler != input->GetHandlerType()) {
+            LOG(WARNING) << "fail to sort with limit when input type isn't table";
+            return fail_ptr;
+        }
+        return sort_gen_.TopN(std::dynamic_pointer_cast<TableHandler>(input), limit_cnt_.value());
+    }
+    return sort_gen_.Sort(input, false, ctx.memory_quota());
 }
 
 std::shared_ptr<DataHandler> ConstProjectRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
     auto output_table = std::shared_ptr<MemTableHandler>(new MemTableHandler());
-    output_table->AddRow(project_gen_.Gen(ctx.GetParameterRow()));
+    output_table->AddRow(project_gen_.Gen(ctx.GetParameterRow(), ctx.memory_quota()));
     return output_table;
 }
 std::shared_ptr<DataHandler> TableProjectRunner::Run(
@@ -445,7 +650,7 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
         if (limit_cnt_.has_value() && cnt++ >= limit_cnt_) {
             break;
         }
-        output_table->AddRow(project_gen_.Gen(iter->GetValue(), parameter));
+        output_table->AddRow(project_gen_.Gen(iter->GetValue(), parameter, ctx.memory_quota()));
         iter->Next();
     }
     return output_table;
@@ -460,7 +665,7 @@ std::shared_ptr<DataHandler> RowProjectRunner::Run(
     }
     auto row = std::dynamic_pointer_cast<RowHandler>(inputs[0]);
     return std::shared_ptr<RowHandler>(
-        new MemRowHandler(project_gen_.Gen(row->GetValue(), ctx.GetParameterRow())));
+        new MemRowHandler(project_gen_.Gen(row->GetValue(), ctx.GetParameterRow(), ctx.memory_quota())));
 }
 
 std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
@@ -482,17 +687,17 @@ std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
         case kTableHandler: {
             return std::shared_ptr<TableHandler>(new TableProjectWrapper(
                 std::dynamic_pointer_cast<TableHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, ctx.memory_quota()));
         }
         case kPartitionHandler: {
             return std::shared_ptr<TableHandler>(new PartitionProjectWrapper(
                 std::dynamic_pointer_cast<PartitionHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, ctx.memory_quota()));
         }
         case kRowHandler: {
             return std::shared_ptr<RowHandler>(new RowProjectWrapper(
                 std::dynamic_pointer_cast<RowHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, ctx.memory_quota()));
         }
         default: {
             LOG(WARNING) << "Fail run simple project, invalid handler type "
@@ -503,7 +708,7 @@ std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
     return std::shared_ptr<DataHandler>();
 }
 
-Row SelectSliceRunner::GetSliceFn::operator()(const Row& row, const Row& parameter) const {
+Row SelectSliceRunner::GetSliceFn::operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const {
     if (slice_ < static_cast<size_t>(row.GetRowPtrCnt())) {
         return Row(row.GetSlice(slice_));
     } else {
@@ -528,16 +733,16 @@ std::shared_ptr<DataHandler> SelectSliceRunner::Run(
         case kTableHandler: {
             return std::shared_ptr<TableHandler>(new TableProjectWrapper(
                 std::dynamic_pointer_cast<TableHandler>(input), parameter,
-                &get_slice_fn_));
+                &get_slice_fn_, nullptr));
         }
         case kPartitionHandler: {
             return std::shared_ptr<TableHandler>(new PartitionProjectWrapper(
                 std::dynamic_pointer_cast<PartitionHandler>(input), parameter,
-                &get_slice_fn_));
+                &get_slice_fn_, nullptr));
         }
         case kRowHandler: {
             return std::make_shared<RowProjectWrapper>(
-                std::dynamic_pointer_cast<RowHandler>(input), parameter, &get_slice_fn_);
+                std::dynamic_pointer_cast<RowHandler>(input), parameter, &get_slice_fn_, nullptr);
         }
         default: {
             LOG(WARNING) << "Fail run select slice, invalid handler type "
@@ -586,7 +791,7 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     std::shared_ptr<MemTableHandler> output_table = std::make_shared<MemTableHandler>();
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
-        RunWindowAggOnKey(parameter, instance_partition, union_partitions,
+        RunWindowAggOnKey(parameter, ctx.memory_quota(), instance_partition, union_partitions,
                           join_right_tables, key, output_table);
         instance_partition_iter->Next();
     }
@@ -595,14 +800,14 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
 
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
-    const Row& parameter,
+    const Row& parameter, RunMemoryQuota* quota,
     std::shared_ptr<PartitionHandler> instance_partition,
     std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
     std::vector<std::shared_ptr<DataHandler>> join_right_tables,
     const std::string& key, std::shared_ptr<MemTableHandler> output_table) {
     // Prepare Instance Segment
     auto instance_segment = instance_partition->GetSegment(key);
-    instance_segment = instance_window_gen_.sort_gen_.Sort(instance_segment);
+    instance_segment = instance_window_gen_.sort_gen_.Sort(instance_segment, false, quota);
     if (!instance_segment) {
         LOG(WARNING) << "Instance Segment is Empty";
         return;
@@ -626,7 +831,7 @@ void WindowAggRunner::RunWindowAggOnKey(
             continue;
         }
         auto segment = union_partitions[i]->GetSegment(key);
-        segment = windows_union_gen_.windows_gen_[i].sort_gen_.Sort(segment);
+        segment = windows_union_gen_.windows_gen_[i].sort_gen_.Sort(segment, false, quota);
         union_segments[i] = segment;
         if (!segment) {
             union_segment_status[i] = IteratorStatus();
@@ -668,7 +873,7 @@ void WindowAggRunner::RunWindowAggOnKey(
             }
             window_project_gen_.Gen(
                 union_segment_iters[min_union_pos]->GetKey(), row, parameter,
-                false, append_slices_, &window);
+                false, append_slices_, &window, quota);
 
             // Update Iterator Status
             union_segment_iters[min_union_pos]->Next();
@@ -685,10 +890,11 @@ void WindowAggRunner::RunWindowAggOnKey(
         if (windows_join_gen_.Valid()) {
             Row row = windows_join_gen_.Join(instance_row, join_right_tables, parameter);
             output_table->AddRow(
-                window_project_gen_.Gen(instance_order, row, parameter, true, append_slices_, &window));
+                window_project_gen_.Gen(instance_order, row, parameter, true, append_slices_, &window, quota));
         } else {
             output_table->AddRow(
-                window_project_gen_.Gen(instance_order, instance_row, parameter, true, append_slices_, &window));
+                window_project_gen_.Gen(instance_order, instance_row, parameter, true, append_slices_, &window,
+                                        quota));
         }
 
         cnt++;
@@ -1345,10 +1551,13 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
             return std::shared_ptr<DataHandler>();
         }
         if (!having_condition_.Valid() || having_condition_.Gen(table, parameter)) {
-            output_table->AddRow(agg_gen_->Gen(parameter, table));
+            output_table->AddRow(agg_gen_->Gen(parameter, table, ctx.memory_quota()));
         }
         return output_table;
     } else if (kPartitionHandler == input->GetHandlerType()) {
+        if (auto groups = std::dynamic_pointer_cast<LazyGroupPartitionHandler>(input)) {
+            return BucketGroupAgg(groups, parameter, ctx.memory_quota());
+        }
         auto partition = std::dynamic_pointer_cast<PartitionHandler>(input);
         auto iter = partition->GetWindowIterator();
         if (!iter) {
@@ -1368,7 +1577,7 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
                 if (limit_cnt_.has_value() && cnt++ >= limit_cnt_) {
                     break;
                 }
-                output_table->AddRow(agg_gen_->Gen(parameter, segment));
+                output_table->AddRow(agg_gen_->Gen(parameter, segment, ctx.memory_quota()));
             }
             iter->Next();
         }
@@ -1379,6 +1588,214 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
     }
 }
 
+using GroupSegments = absl::flat_hash_map<std::string, std::shared_ptr<MemTimeTableHandler>>;
+
+static void AddGroupRow(std::shared_ptr<TableHandler> table, const std::string& key, uint64_t ts, const Row& row,
+                        GroupSegments* segments) {
+    auto& segment = (*segments)[key];
+    if (!segment) {
+        segment = std::make_shared<MemTimeTableHandler>(table->GetSchema());
+        segment->SetOrderType(table->GetOrderType());
+    }
+    segment->AddRow(ts, row);
+}
+
+// move the rows of `segments` to new spill files partitioned by the group key, return empty if it fails
+static std::vector<std::shared_ptr<SpillFile>> SpillGroups(GroupSegments* segments) {
+    std::vector<std::shared_ptr<SpillFile>> files;
+    for (size_t i = 0; i < kGroupSpillPartitions; i++) {
+        auto file = SpillFile::Create();
+        if (!file) {
+            return {};
+        }
+        files.push_back(file);
+    }
+    for (auto& kv : *segments) {
+        auto& file = files[GroupSpillPartition(kv.first, 0)];
+        auto iter = kv.second->GetIterator();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            if (!file->Append(iter->GetKey(), iter->GetValue())) {
+                return {};
+            }
+        }
+    }
+    segments->clear();
+    return files;
+}
+
+std::shared_ptr<DataHandler> GroupAggRunner::BucketGroupAgg(std::shared_ptr<LazyGroupPartitionHandler> groups,
+                                                            const Row& parameter, RunMemoryQuota* quota) {
+    auto table = groups->Table();
+    auto iter = table->GetIterator();
+    if (!iter) {
+        LOG(WARNING) << "group aggregation fail: input iterator is null";
+        return std::shared_ptr<DataHandler>();
+    }
+    // one pass over the rows, each key is hashed once instead of compared along an ordered map. the groups keep
+    // their rows since the aggregation consumes a whole group. once the rows exceed the memory limit, all of them
+    // go to spill files partitioned by key
+    GroupSegments segments;
+    std::vector<std::shared_ptr<SpillFile>> spills;
+    bool spillable = FLAGS_batch_operator_mem_limit > 0;
+    size_t bytes = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        auto key = groups->GetKey(iter->GetValue());
+        if (!spills.empty()) {
+            if (!spills[GroupSpillPartition(key, 0)]->Append(iter->GetKey(), iter->GetValue())) {
+                LOG(WARNING) << "group aggregation fail: fail to spill rows";
+                return std::shared_ptr<DataHandler>();
+            }
+            continue;
+        }
+        AddGroupRow(table, key, iter->GetKey(), iter->GetValue(), &segments);
+        bytes += RowBytes(iter->GetValue());
+        if (spillable && bytes > FLAGS_batch_operator_mem_limit) {
+            spills = SpillGroups(&segments);
+            if (spills.empty()) {
+                LOG(WARNING) << "fail to spill the groups, keep the rest of them in memory";
+                spillable = false;
+            }
+        }
+    }
+    if (!spills.empty()) {
+        return SpilledGroupAgg(groups, spills, parameter, quota);
+    }
+
+    // only the groups are sorted, in the same descending key order as MemPartitionHandler
+    std::vector<GroupSegments::value_type*> sorted;
+    sorted.reserve(segments.size());
+    for (auto& kv : segments) {
+        sorted.push_back(&kv);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* l, const auto* r) { return l->first > r->first; });
+
+    auto output_table = std::make_shared<MemTableHandler>();
+    int32_t cnt = 0;
+    for (auto* kv : sorted) {
+        std::shared_ptr<TableHandler> segment = kv->second;
+        if (!having_condition_.Valid() || having_condition_.Gen(segment, parameter)) {
+            if (limit_cnt_.has_value() && cnt++ >= limit_cnt_) {
+                break;
+            }
+            output_table->AddRow(agg_gen_->Gen(parameter, segment, quota));
+        }
+    }
+    return output_table;
+}
+
+std::shared_ptr<DataHandler> GroupAggRunner::SpilledGroupAgg(std::shared_ptr<LazyGroupPartitionHandler> groups,
+                                                             const std::vector<std::shared_ptr<SpillFile>>& spills,
+                                                             const Row& parameter, RunMemoryQuota* quota) {
+    auto table = groups->Table();
+    GroupKeyFn key_fn = [&groups](const Row& row) { return groups->GetKey(row); };
+    auto aggregate = [&](const std::string& key, std::shared_ptr<TableHandler> segment,
+                         std::vector<std::pair<std::string, Row>>* outputs) {
+        if (!having_condition_.Valid() || having_condition_.Gen(segment, parameter)) {
+            outputs->emplace_back(key, agg_gen_->Gen(parameter, segment, quota));
+        }
+    };
+    // each file holds whole groups and is loaded one at a time. a file larger than the memory limit is split
+    // again by more bits of the key hash, a file which can not be split any more, e.g. a single huge group,
+    // is split into one file per group and each group is aggregated from its file without loading it
+    struct Partition {
+        std::shared_ptr<SpillFile> file;
+        size_t level;
+        bool single_group;
+    };
+    std::vector<Partition> partitions;
+    for (auto it = spills.rbegin(); it != spills.rend(); ++it) {
+        partitions.push_back({*it, 0, false});
+    }
+    std::vector<std::pair<std::string, Row>> outputs;
+    while (!partitions.empty()) {
+        auto partition = partitions.back();
+        partitions.pop_back();
+        if (!partition.file->Flush()) {
+            LOG(WARNING) << "group aggregation fail: fail to spill rows";
+            return std::shared_ptr<DataHandler>();
+        }
+        if (partition.file->GetCount() == 0) {
+            continue;
+        }
+        GroupSegments segments;
+        SpillFileReader reader(partition.file);
+        uint64_t ts = 0;
+        Row row;
+        size_t bytes = 0;
+        bool oversized = false;
+        while (reader.Next(&ts, &row)) {
+            AddGroupRow(table, groups->GetKey(row), ts, row, &segments);
+            bytes += RowBytes(row);
+            if (FLAGS_batch_operator_mem_limit > 0 && bytes > FLAGS_batch_operator_mem_limit) {
+                oversized = true;
+                break;
+            }
+        }
+        if (reader.HasError()) {
+            LOG(WARNING) << "group aggregation fail: fail to read spilled rows";
+            return std::shared_ptr<DataHandler>();
+        }
+        if (oversized) {
+            segments.clear();
+            if (!partition.single_group && partition.level + 1 < kGroupSpillMaxLevel) {
+                auto parts = SplitGroupSpill(partition.file, key_fn, partition.level + 1);
+                if (!parts.empty()) {
+                    size_t non_empty = 0;
+                    for (const auto& part : parts) {
+                        non_empty += part->GetCount() > 0 ? 1 : 0;
+                    }
+                    for (auto it = parts.rbegin(); it != parts.rend(); ++it) {
+                        if ((*it)->GetCount() > 0) {
+                            partitions.push_back({*it, partition.level + 1, non_empty == 1});
+                        }
+                    }
+                    continue;
+                }
+                LOG(WARNING) << "fail to split the spilled groups, try to aggregate them from the file";
+            }
+            // the spilled rows of a group are read through the quota, so a read error fails the query
+            // instead of aggregating part of the group
+            auto files = quota != nullptr ? SplitGroupSpillByKey(partition.file, key_fn)
+                                          : std::vector<std::pair<std::string, std::shared_ptr<SpillFile>>>();
+            if (!files.empty()) {
+                for (const auto& kv : files) {
+                    aggregate(kv.first,
+                              std::make_shared<SpillSortedTableHandler>(
+                                  table->GetSchema(), std::vector<std::shared_ptr<SpillFile>>{kv.second},
+                                  table->GetOrderType() == kAscOrder, quota),
+                              &outputs);
+                    if (quota->IsFailed()) {
+                        LOG(WARNING) << "group aggregation fail: fail to read spilled rows";
+                        return std::shared_ptr<DataHandler>();
+                    }
+                }
+                continue;
+            }
+            LOG(WARNING) << "can not aggregate the spilled groups from the file, load them into memory";
+            SpillFileReader full_reader(partition.file);
+            while (full_reader.Next(&ts, &row)) {
+                AddGroupRow(table, groups->GetKey(row), ts, row, &segments);
+            }
+            if (full_reader.HasError()) {
+                LOG(WARNING) << "group aggregation fail: fail to read spilled rows";
+                return std::shared_ptr<DataHandler>();
+            }
+        }
+        for (auto& kv : segments) {
+            aggregate(kv.first, kv.second, &outputs);
+        }
+    }
+    std::sort(outputs.begin(), outputs.end(), [](const auto& l, const auto& r) { return l.first > r.first; });
+    auto output_table = std::make_shared<MemTableHandler>();
+    for (const auto& output : outputs) {
+        if (limit_cnt_.has_value() && output_table->GetCount() >= static_cast<uint64_t>(limit_cnt_.value())) {
+            break;
+        }
+        output_table->AddRow(output.second);
+    }
+    return output_table;
+}
+
 bool RequestAggUnionRunner::InitAggregator() {
     auto func_name = func_->GetName();
     auto type_it = agg_type_map_.find(func_name);
@@ -1420,6 +1837,11 @@ std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const
         case kMax:
         case kMaxWhere:
             return MakeSameTypeAggregator<MaxAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+        case kApproxDistinctCount:
+            return MakeSameTypeAggregator<ApproxDistinctCountAggregator>(agg_col_type_,
+                                                                         *output_schemas_->GetOutputSchema());
+        case kApproxMedian:
+            return MakeSameTypeAggregator<ApproxMedianAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
         default:
             LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_->GetName();
             return nullptr;
@@ -1459,15 +1881,21 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
 
     auto& key_gen = windows_union_gen_->windows_gen_[0].index_seek_gen_.index_key_gen_;
     std::string key = key_gen.Gen(request, ctx.GetParameterRow());
-    // do not use codegen to gen the union outputs for aggr segment
-    union_inputs.pop_back();
+    // do not use codegen to gen the union outputs for aggr segments
+    std::vector<std::shared_ptr<DataHandler>> agg_inputs(union_inputs.begin() + 1, union_inputs.end());
+    union_inputs.resize(1);
 
     auto union_segments =
         windows_union_gen_->GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
     // code_gen result of agg_segment is not correct. we correct the result here
-    auto agg_segment = std::dynamic_pointer_cast<PartitionHandler>(union_inputs[1])->GetSegment(key);
+    auto agg_segment = std::dynamic_pointer_cast<PartitionHandler>(agg_inputs[0])->GetSegment(key);
     if (agg_segment) {
         union_segments.emplace_back(agg_segment);
+        // segments of the coarser levels, a missing level is skipped by the planner
+        for (size_t i = 1; i < agg_inputs.size(); i++) {
+            auto level_partition = std::dynamic_pointer_cast<PartitionHandler>(agg_inputs[i]);
+            union_segments.emplace_back(level_partition ? level_partition->GetSegment(key) : nullptr);
+        }
     }
 
     if (ctx.is_debug()) {
@@ -1496,10 +1924,10 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
 std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
     const WindowRange& window_range, const bool output_request_row, const bool exclude_current_time) const {
-    // TOOD(zhanghao): for now, we only support AggUnion with 1 base table and 1 agg table
+    // union_segments: the base table, the finest agg table and the agg tables of coarser levels
     size_t unions_cnt = union_segments.size();
-    if (unions_cnt != 2) {
-        LOG(ERROR) << "Not support of RequestAggUnion with more than 2 unions";
+    if (unions_cnt < 2) {
+        LOG(ERROR) << "Not support of RequestAggUnion with less than 2 unions";
         return nullptr;
     }
 
@@ -1654,6 +2082,13 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     }
     base_it->Seek(end);
 
+    if (unions_cnt > 2 && window_range.frame_type_ == Window::kFrameRowsRange && max_size <= 0) {
+        MultiLevelAggregate(union_segments, start, end, base_it.get(), update_base_aggregator,
+                            update_agg_aggregator);
+        window_table->AddRow(start, aggregator->Output());
+        return window_table;
+    }
+
     auto agg_it = union_segments[1]->GetIterator();
     if (agg_it) {
         agg_it->Seek(end);
@@ -1862,6 +2297,102 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     return window_table;
 }
 
+void RequestAggUnionRunner::MultiLevelAggregate(const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+                                                int64_t start, int64_t end, RowIterator* base_it,
+                                                const std::function<void(const Row&)>& update_base,
+                                                const std::function<void(const Row&)>& update_agg) const {
+    const auto agg_row_parser = producers_[2]->row_parser();
+    // buckets of a level are aligned to the bucket width and flushed in order,
+    // so a level has every bucket up to the end of its latest one
+    struct AggLevel {
+        std::unique_ptr<RowIterator> it;
+        int64_t width;
+        int64_t complete_end;
+    };
+    std::vector<AggLevel> levels;
+    for (size_t i = 1; i < union_segments.size(); i++) {
+        if (!union_segments[i]) {
+            continue;
+        }
+        auto it = union_segments[i]->GetIterator();
+        if (!it) {
+            continue;
+        }
+        it->Seek(end);
+        while (it->Valid()) {
+            int64_t ts_start = static_cast<int64_t>(it->GetKey());
+            int64_t ts_end = -1;
+            agg_row_parser->GetValue(it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
+            if (ts_end <= end) {
+                if (ts_end >= ts_start) {
+                    levels.push_back({std::move(it), ts_end - ts_start + 1, ts_end});
+                }
+                break;
+            }
+            it->Next();
+        }
+    }
+
+    // 1. base rows after the latest complete bucket: (cur, end]
+    int64_t cur = end;
+    if (!levels.empty()) {
+        int64_t frontier = start - 1;
+        for (const auto& level : levels) {
+            frontier = std::max(frontier, level.complete_end);
+        }
+        cur = frontier;
+    }
+    while (base_it->Valid() && static_cast<int64_t>(base_it->GetKey()) > cur) {
+        update_base(base_it->GetValue());
+        base_it->Next();
+    }
+
+    // 2. cover [start, cur] from the end with the coarsest bucket which fits, keys are never negative
+    // so buckets are not looked up below 0 for a window larger than the data
+    start = std::max<int64_t>(start, 0);
+    while (cur >= start) {
+        AggLevel* picked = nullptr;
+        for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+            if (it->complete_end >= cur && (cur + 1) % it->width == 0 && cur + 1 - it->width >= start) {
+                picked = &(*it);
+                break;
+            }
+        }
+        if (picked == nullptr) {
+            break;
+        }
+        int64_t bucket_start = cur + 1 - picked->width;
+        auto& agg_it = picked->it;
+        agg_it->Seek(bucket_start);
+        std::set<std::string> filter_vals;
+        while (agg_it->Valid() && static_cast<int64_t>(agg_it->GetKey()) == bucket_start) {
+            const Row& row = agg_it->GetValue();
+            if (cond_ == nullptr) {
+                // the rest are stale entries of the same bucket
+                update_agg(row);
+                break;
+            }
+            std::string filter_val;
+            if (!agg_row_parser->IsNull(row, "filter_key") &&
+                0 == agg_row_parser->GetString(row, "filter_key", &filter_val) &&
+                filter_vals.insert(filter_val).second) {
+                update_agg(row);
+            }
+            agg_it->Next();
+        }
+        cur = bucket_start - 1;
+    }
+
+    // 3. base rows before the covered buckets: [start, cur]
+    if (cur >= start) {
+        base_it->Seek(cur);
+        while (base_it->Valid() && static_cast<int64_t>(base_it->GetKey()) >= start) {
+            update_base(base_it->GetValue());
+            base_it->Next();
+        }
+    }
+}
+
 std::string RequestAggUnionRunner::PrintEvalValue(const absl::StatusOr<std::optional<bool>>& val) {
     std::ostringstream os;
     if (!val.ok()) {
@@ -1930,6 +2461,103 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(RunnerContext& ctx,
     LOG(WARNING) << "skip due to performance: left source of request union is table handler(unoptimized)";
     return std::shared_ptr<DataHandler>();
 }
+std::shared_ptr<DataHandlerList> RequestUnionRunner::BatchRequestRun(RunnerContext& ctx) {
+    if (need_batch_cache_ || ctx.GetRequestSize() < 2) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    if (producers_.size() < 2u) {
+        LOG(WARNING) << "inputs size < 2";
+        return nullptr;
+    }
+    ScopedRunnerSpan span(ctx, type_, id_, producers_);
+    auto right = producers_[1]->BatchRequestRun(ctx);
+    auto left = producers_[0]->BatchRequestRun(ctx);
+    if (!left || !right) {
+        LOG(WARNING) << "the result of producers is null";
+        return nullptr;
+    }
+
+    // group the requests by the key of their windows, and the windows of a group read from the latest window end
+    const auto& parameter = ctx.GetParameterRow();
+    const auto& window_range = range_gen_->window_range_;
+    struct SharedWindows {
+        size_t request_cnt = 0;
+        uint64_t start_key = 0;
+        std::vector<std::shared_ptr<TableHandler>> segments;
+    };
+    // the windows are referred by the requests, node map keeps them at the same address
+    absl::node_hash_map<std::string, SharedWindows> shared_windows;
+    std::vector<SharedWindows*> request_windows(ctx.GetRequestSize(), nullptr);
+    std::vector<int64_t> request_ts(ctx.GetRequestSize(), -1);
+    for (size_t idx = 0; idx < ctx.GetRequestSize(); idx++) {
+        auto request = left->Get(idx);
+        if (!request || kRowHandler != request->GetHandlerType() || !right->Get(idx)) {
+            continue;
+        }
+        const auto& row = std::dynamic_pointer_cast<RowHandler>(request)->GetValue();
+        int64_t ts_gen = range_gen_->Valid() ? range_gen_->ts_gen_.Gen(row) : -1;
+        // not earlier than the window end of the request
+        uint64_t end_key =
+            ts_gen >= 0 ? static_cast<uint64_t>(std::max<int64_t>(0, ts_gen + window_range.end_offset_)) : UINT64_MAX;
+        auto& windows = shared_windows[windows_union_gen_->GetRequestWindowsKey(row, parameter)];
+        windows.request_cnt++;
+        windows.start_key = std::max(windows.start_key, end_key);
+        request_windows[idx] = &windows;
+        request_ts[idx] = ts_gen;
+    }
+
+    auto union_inputs = windows_union_gen_->RunInputs(ctx);
+    std::shared_ptr<DataHandlerVector> outputs = std::make_shared<DataHandlerVector>();
+    for (size_t idx = 0; idx < ctx.GetRequestSize(); idx++) {
+        auto windows = request_windows[idx];
+        if (windows == nullptr) {
+            outputs->Add(Run(ctx, {left->Get(idx), right->Get(idx)}));
+            continue;
+        }
+        const auto& row = std::dynamic_pointer_cast<RowHandler>(left->Get(idx))->GetValue();
+        if (windows->request_cnt < 2) {
+            auto union_segments = windows_union_gen_->GetRequestWindows(row, parameter, union_inputs);
+            outputs->Add(RequestUnionWindow(row, union_segments, request_ts[idx], window_range, output_request_row_,
+                                            exclude_current_time_));
+            continue;
+        }
+        if (windows->segments.empty()) {
+            windows->segments = windows_union_gen_->GetRequestWindows(row, parameter, union_inputs);
+            for (auto& segment : windows->segments) {
+                if (segment && kAscOrder != segment->GetOrderType()) {
+                    segment = std::make_shared<SharedSegmentHandler>(segment, windows->start_key);
+                }
+            }
+        }
+        outputs->Add(RequestUnionWindow(row, windows->segments, request_ts[idx], window_range, output_request_row_,
+                                        exclude_current_time_));
+    }
+
+    if (ctx.is_debug()) {
+        std::ostringstream oss;
+        oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << ", Shared windows "
+            << shared_windows.size() << "\n";
+        for (size_t idx = 0; idx < outputs->GetSize(); idx++) {
+            if (idx >= MAX_DEBUG_BATCH_SiZE) {
+                oss << ">= MAX_DEBUG_BATCH_SiZE...\n";
+                break;
+            }
+            Runner::PrintData(oss, output_schemas_, outputs->Get(idx));
+        }
+        LOG(INFO) << oss.str();
+    }
+    if (need_cache_) {
+        ctx.SetBatchCache(id_, outputs);
+    }
+    return outputs;
+}
 std::shared_ptr<TableHandler> RequestUnionRunner::RunOneRequest(RunnerContext* ctx, const Row& request) {
     // ts_gen < 0 if there is no ORDER BY clause for WINDOW
     int64_t ts_gen = range_gen_->Valid() ? range_gen_->ts_gen_.Gen(request) : -1;
@@ -2094,7 +2722,8 @@ std::shared_ptr<DataHandler> AggRunner::Run(
         if (having_condition_.Valid() && !having_condition_.Gen(table, parameter)) {
             return std::shared_ptr<DataHandler>();
         }
-        auto row_handler = std::shared_ptr<RowHandler>(new MemRowHandler(agg_gen_->Gen(parameter, table)));
+        auto row_handler =
+            std::shared_ptr<RowHandler>(new MemRowHandler(agg_gen_->Gen(parameter, table, ctx.memory_quota())));
         return row_handler;
     } else if (kPartitionHandler == input->GetHandlerType()) {
         // lazify
@@ -2103,7 +2732,8 @@ std::shared_ptr<DataHandler> AggRunner::Run(
             return std::shared_ptr<DataHandler>();
         }
 
-        return std::shared_ptr<DataHandler>(new LazyAggPartitionHandler(data_set, agg_gen_, ctx.GetParameterRow()));
+        return std::shared_ptr<DataHandler>(
+            new LazyAggPartitionHandler(data_set, agg_gen_, ctx.GetParameterRow(), ctx.memory_quota()));
     }
 
     return std::shared_ptr<DataHandler>();
@@ -2117,6 +2747,7 @@ std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
             return cached;
         }
     }
+    ScopedRunnerSpan span(ctx, type_, id_, producers_, index_input_);
     std::shared_ptr<DataHandlerList> proxy_batch_input =
         producers_[0]->BatchRequestRun(ctx);
     std::shared_ptr<DataHandlerList> index_key_input =
@@ -2486,7 +3117,8 @@ std::shared_ptr<TableHandler> ProxyRequestRunner::RunWithRowsInput(
     return fail_ptr;
 }
 
-Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableHandler* table) {
+Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableHandler* table,
+                           RunMemoryQuota* quota) {
     auto iter = table->GetIterator();
     if (!iter) {
         LOG(WARNING) << "Agg table is empty";
@@ -2517,7 +3149,7 @@ Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableH
     uint32_t ret = udf(row_key, row_ptr, window_ptr, parameter_ptr, &buf);
 
     // Release current run step resources
-    JitRuntime::get()->ReleaseRunStep();
+    JitRuntime::get()->ReleaseRunStep(quota);
 
     if (ret != 0) {
         LOG(WARNING) << "fail to run udf " << ret;
@@ -17,6 +17,8 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
@@ -45,6 +47,8 @@ using vm::Schema;
 using vm::TableHandler;
 using vm::Window;
 
+class LazyGroupPartitionHandler;
+class SpillFile;
 class Runner;
 class RunnerContext;
 
@@ -223,15 +227,17 @@ class Runner : public node::NodeBase<Runner> {
                                   int pos, type::Type type);
     static bool GetColumnBool(const int8_t* buf, const RowView* view, int idx,
                               type::Type type);
-    static Row RowConstProject(
-        const int8_t* fn, const bool need_free = false);
+    // Run steps of the compiled functions. The runtime memory of each step is
+    // accounted to `quota` if it is not null.
+    static Row RowConstProject(const int8_t* fn, const Row& parameter, const bool need_free, RunMemoryQuota* quota);
     static Row RowProject(const int8_t* fn, const hybridse::codec::Row& row, const hybridse::codec::Row& parameter,
-                          const bool need_free);
+                          const bool need_free, RunMemoryQuota* quota);
     static Row WindowProject(const int8_t* fn, const uint64_t key,
                              const Row row, const Row& parameter,
                              const bool is_instance,
-                             size_t append_slices, Window* window);
-    static Row GroupbyProject(const int8_t* fn, const Row& parameter, TableHandler* table);
+                             size_t append_slices, Window* window, RunMemoryQuota* quota = nullptr);
+    static Row GroupbyProject(const int8_t* fn, const Row& parameter, TableHandler* table,
+                              RunMemoryQuota* quota = nullptr);
     static const Row RowLastJoinTable(size_t left_slices, const Row& left_row,
                                       size_t right_slices,
                                       std::shared_ptr<TableHandler> right_table,
@@ -251,6 +257,22 @@ class Runner : public node::NodeBase<Runner> {
         return kRunnerRequestRunProxy == type ||
                kRunnerBatchRequestRunProxy == type;
     }
+    // runners which may block on storage scan or remote sub query
+    static const bool IsBlockingRunner(const RunnerType& type) {
+        return IsProxyRunner(type) || kRunnerRequestUnion == type ||
+               kRunnerRequestAggUnion == type || kRunnerRequestJoin == type;
+    }
+    // Run producers and return their outputs in the same order.
+    //
+    // When at least two independent producer subtrees contain blocking runners,
+    // `ctx.parallel_executor()` is set and `ctx.max_parallel_producers()` > 0,
+    // they are run concurrently by the executor, so the latency is close to the
+    // slowest subtree instead of the sum.
+    static std::vector<std::shared_ptr<DataHandler>> RunProducers(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<Runner*>& producers);
+    // return true if this runner or any of its producers is a blocking runner
+    bool HasBlockingRunner() const;
     static bool ExtractRows(std::shared_ptr<DataHandlerList> handlers,
                             std::vector<Row>& out_rows);  // NOLINT
     static bool ExtractRow(std::shared_ptr<DataHandler> handler,
@@ -291,6 +313,10 @@ class Runner : public node::NodeBase<Runner> {
     std::vector<Runner*> producers_;
     const vm::SchemasContext* output_schemas_;
     std::unique_ptr<RowParser> row_parser_ = nullptr;
+
+ private:
+    // lazily computed result of `HasBlockingRunner`, -1 means unknown
+    mutable std::atomic<int8_t> has_blocking_runner_ = -1;
 };
 
 class IteratorStatus {
@@ -464,7 +490,7 @@ class SelectSliceRunner : public Runner {
  private:
     struct GetSliceFn : public ProjectFun {
         explicit GetSliceFn(size_t slice) : slice_(slice) {}
-        Row operator()(const Row& row, const Row& parameter) const override;
+        Row operator()(const Row& row, const Row& parameter, RunMemoryQuota* quota) const override;
         size_t slice_;
     } get_slice_fn_;
 };
@@ -485,6 +511,18 @@ class GroupAggRunner : public Runner {
     KeyGenerator group_;
     ConditionGenerator having_condition_;
     std::shared_ptr<AggGenerator> agg_gen_;
+
+ private:
+    // aggregate the groups of a table which are not built yet. the rows are bucketed into the groups in a hash
+    // table keyed by the group key, then the compiled aggregation runs over each whole group as before: it is
+    // not a streaming hash aggregation, every row of a group is held until the group is aggregated
+    std::shared_ptr<DataHandler> BucketGroupAgg(std::shared_ptr<LazyGroupPartitionHandler> groups,
+                                                const Row& parameter, RunMemoryQuota* quota);
+    // aggregate the groups spilled by BucketGroupAgg, one file after another. a file over the memory limit is
+    // split again, a group over the limit is aggregated from its own spill file
+    std::shared_ptr<DataHandler> SpilledGroupAgg(std::shared_ptr<LazyGroupPartitionHandler> groups,
+                                                 const std::vector<std::shared_ptr<SpillFile>>& spills,
+                                                 const Row& parameter, RunMemoryQuota* quota);
 };
 class AggRunner : public Runner {
  public:
@@ -544,7 +582,7 @@ class WindowAggRunner : public Runner {
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
     void RunWindowAggOnKey(
-        const Row& parameter,
+        const Row& parameter, RunMemoryQuota* quota,
         std::shared_ptr<PartitionHandler> instance_partition,
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
@@ -575,6 +613,9 @@ class RequestUnionRunner : public Runner {
     std::shared_ptr<DataHandler> Run(RunnerContext& ctx,  // NOLINT
                                      const std::vector<std::shared_ptr<DataHandler>>& inputs) override;
 
+    // requests of the batch with the same window key read the segments of their windows only once
+    std::shared_ptr<DataHandlerList> BatchRequestRun(RunnerContext& ctx) override;  // NOLINT
+
     std::shared_ptr<TableHandler> RunOneRequest(RunnerContext* ctx, const Row& request);
 
     static std::shared_ptr<TableHandler> RequestUnionWindow(const Row& request,
@@ -649,6 +690,8 @@ class RequestAggUnionRunner : public Runner {
         kAvgWhere,
         kMinWhere,
         kMaxWhere,
+        kApproxDistinctCount,
+        kApproxMedian,
     };
 
     std::shared_ptr<RequestWindowUnionGenerator> windows_union_gen_;
@@ -671,6 +714,11 @@ class RequestAggUnionRunner : public Runner {
 
     std::unique_ptr<BaseAggregator> CreateAggregator() const;
 
+    // aggregate a ROWS_RANGE window [start, end] over multi-level pre-aggr tables with the fewest buckets
+    void MultiLevelAggregate(const std::vector<std::shared_ptr<TableHandler>>& union_segments, int64_t start,
+                             int64_t end, RowIterator* base_it, const std::function<void(const Row&)>& update_base,
+                             const std::function<void(const Row&)>& update_agg) const;
+
     static inline const absl::flat_hash_map<absl::string_view, AggType> agg_type_map_ = {
         {"sum", kSum},
         {"count", kCount},
@@ -681,7 +729,9 @@ class RequestAggUnionRunner : public Runner {
         {"sum_where", kSumWhere},
         {"avg_where", kAvgWhere},
         {"min_where", kMinWhere},
-        {"max_where", kMaxWhere}};
+        {"max_where", kMaxWhere},
+        {"approx_distinct_count", kApproxDistinctCount},
+        {"approx_median", kApproxMedian}};
 };
 
 class PostRequestUnionRunner : public Runner {
@@ -60,6 +60,7 @@ static vm::PhysicalDataProviderNode* request_node(vm::PhysicalOpNode* n) {
 // kPhysicalOpPostRequestUnion
 //      --> build proxy runner if need
 // GroupRunner --> LocalTask, Unsupport in distribute database
+// SortRunner --> LocalTask, Unsupport in distribute database
 // kPhysicalOpFilter
 // kPhysicalOpLimit
 // kPhysicalOpRename
@@ -448,6 +449,25 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
             GroupRunner* runner = CreateRunner<GroupRunner>(id_++, node->schemas_ctx(), op->GetLimitCnt(), op->group());
             return RegisterTask(node, UnaryInheritTask(cluster_task, runner));
         }
+        case kPhysicalOpSortBy: {
+            if (support_cluster_optimized_) {
+                // Non-support sort under distribution env
+                status.msg = "fail to build cluster with sort node";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto cluster_task = Build(node->producers().at(0), status);
+            if (!cluster_task.IsValid()) {
+                status.msg = "fail to build input runner";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto op = dynamic_cast<const PhysicalSortNode*>(node);
+            SortRunner* runner = CreateRunner<SortRunner>(id_++, node->schemas_ctx(), op->GetLimitCnt(), op->sort());
+            return RegisterTask(node, UnaryInheritTask(cluster_task, runner));
+        }
         case kPhysicalOpFilter: {
             auto producer_task = Build(node->GetProducer(0), status);
             if (!producer_task.IsValid()) {
@@ -556,6 +576,16 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
         LOG(WARNING) << status;
         return fail;
     }
+    std::vector<ClusterTask> level_tasks;
+    for (size_t i = 3; i < node->producers().size(); i++) {
+        level_tasks.push_back(Build(node->producers().at(i), status));
+        if (!level_tasks.back().IsValid()) {
+            status.msg = "fail to build agg_table level input runner";
+            status.code = common::kExecutionPlanError;
+            LOG(WARNING) << status;
+            return fail;
+        }
+    }
     auto op = dynamic_cast<const PhysicalRequestAggUnionNode*>(node);
     RequestAggUnionRunner* runner =
         CreateRunner<RequestAggUnionRunner>(id_++, node->schemas_ctx(), op->GetLimitCnt(), op->window().range_,
@@ -565,9 +595,17 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
         index_key = op->window_.index_key();
         runner->AddWindowUnion(op->window_, base_table);
         runner->AddWindowUnion(op->agg_window_, agg_table);
+        size_t level = 0;
+        for (const auto& level_window : op->level_windows_) {
+            runner->AddWindowUnion(level_window, level_tasks[level].GetRoot());
+            level++;
+        }
+    }
+    std::vector<const ClusterTask*> children = {&request_task, &base_table_task, &agg_table_task};
+    for (const auto& level_task : level_tasks) {
+        children.push_back(&level_task);
     }
-    auto task = RegisterTask(
-        node, MultipleInherit({&request_task, &base_table_task, &agg_table_task}, runner, index_key, kRightBias));
+    auto task = RegisterTask(node, MultipleInherit(children, runner, index_key, kRightBias));
     if (!runner->InitAggregator()) {
         return fail;
     } else {
@@ -16,10 +16,13 @@
 
 #include "vm/runner_ctx.h"
 
+#include "vm/jit_runtime.h"
+
 namespace hybridse {
 namespace vm {
 
 std::shared_ptr<DataHandlerList> RunnerContext::GetBatchCache(int64_t id) const {
+    std::lock_guard<std::mutex> lock(cache_mu_);
     auto iter = batch_cache_.find(id);
     if (iter == batch_cache_.end()) {
         return std::shared_ptr<DataHandlerList>();
@@ -28,9 +31,13 @@ std::shared_ptr<DataHandlerList> RunnerContext::GetBatchCache(int64_t id) const
     }
 }
 
-void RunnerContext::SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data) { batch_cache_[id] = data; }
+void RunnerContext::SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data) {
+    std::lock_guard<std::mutex> lock(cache_mu_);
+    batch_cache_[id] = data;
+}
 
 std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
+    std::lock_guard<std::mutex> lock(cache_mu_);
     auto iter = cache_.find(id);
     if (iter == cache_.end()) {
         return std::shared_ptr<DataHandler>();
@@ -39,7 +46,27 @@ std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
     }
 }
 
-void RunnerContext::SetCache(int64_t id, const std::shared_ptr<DataHandler> data) { cache_[id] = data; }
+void RunnerContext::SetCache(int64_t id, const std::shared_ptr<DataHandler> data) {
+    std::lock_guard<std::mutex> lock(cache_mu_);
+    // a shared producer may be evaluated by two concurrent subtrees, keep the first result
+    cache_.emplace(id, data);
+}
+
+bool RunnerContext::AcquireParallelSlot() {
+    uint32_t in_use = parallel_producers_in_use_.load(std::memory_order_relaxed);
+    while (in_use < max_parallel_producers_) {
+        if (parallel_producers_in_use_.compare_exchange_weak(in_use, in_use + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RunnerContext::ReleaseParallelSlot() { parallel_producers_in_use_.fetch_sub(1, std::memory_order_relaxed); }
+
+bool RunnerContext::IsMemoryExceeded() const { return memory_quota_ != nullptr && memory_quota_->IsExceeded(); }
+
+bool RunnerContext::IsRunFailed() const { return memory_quota_ != nullptr && memory_quota_->IsFailed(); }
 
 void RunnerContext::SetRequest(const hybridse::codec::Row& request) { request_ = request; }
 void RunnerContext::SetRequests(const std::vector<hybridse::codec::Row>& requests) { requests_ = requests; }
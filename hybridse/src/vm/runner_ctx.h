@@ -17,16 +17,22 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_CTX_H_
 #define HYBRIDSE_SRC_VM_RUNNER_CTX_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
 #include "vm/cluster_task.h"
+#include "vm/parallel_executor.h"
+#include "vm/run_trace.h"
 
 namespace hybridse {
 namespace vm {
 
+struct RunMemoryQuota;
+
 class RunnerContext {
  public:
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
@@ -73,10 +79,38 @@ class RunnerContext {
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
 
+    /// Max number of producer subtrees which may be evaluated concurrently
+    /// by the parallel executor, 0 means all producers run serially.
+    uint32_t max_parallel_producers() const { return max_parallel_producers_; }
+    void set_max_parallel_producers(uint32_t num) { max_parallel_producers_ = num; }
+    /// The executor of the concurrent producer subtrees, null if producers run serially
+    ParallelExecutor* parallel_executor() const { return parallel_executor_; }
+    void set_parallel_executor(ParallelExecutor* executor) { parallel_executor_ = executor; }
+    // try to reserve a concurrent slot for a producer subtree, return false if
+    // parallel evaluation is disabled or all slots are in use
+    bool AcquireParallelSlot();
+    void ReleaseParallelSlot();
+
+    /// The memory quota the run steps of this run account to, null if the run is unlimited.
+    /// Runners pass it to the run steps and to the lazy handlers they create.
+    RunMemoryQuota* memory_quota() const { return memory_quota_; }
+    void set_memory_quota(RunMemoryQuota* quota) { memory_quota_ = quota; }
+    // return true if a run step exceeds the memory limit
+    bool IsMemoryExceeded() const;
+    // return true if a lazy handler of this run fails to read its input
+    bool IsRunFailed() const;
+
+    /// The trace the runners record their spans into, null if the run isn't traced
+    RunTrace* trace() const { return trace_; }
+    void set_trace(RunTrace* trace) { trace_ = trace; }
+
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
     void SetCache(int64_t id, std::shared_ptr<DataHandler> data);
-    void ClearCache() { cache_.clear(); }
+    void ClearCache() {
+        std::lock_guard<std::mutex> lock(cache_mu_);
+        cache_.clear();
+    }
     std::shared_ptr<DataHandlerList> GetBatchCache(int64_t id) const;
     void SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data);
 
@@ -88,6 +122,13 @@ class RunnerContext {
     hybridse::codec::Row parameter_;
     size_t idx_;
     const bool is_debug_;
+    uint32_t max_parallel_producers_ = 0;
+    std::atomic<uint32_t> parallel_producers_in_use_ = 0;
+    ParallelExecutor* parallel_executor_ = nullptr;
+    RunMemoryQuota* memory_quota_ = nullptr;
+    RunTrace* trace_ = nullptr;
+    // guard caches since producers may run concurrently
+    mutable std::mutex cache_mu_;
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
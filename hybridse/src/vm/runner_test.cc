@@ -14,13 +14,18 @@
  * limitations under the License.
  */
 
+#include <functional>
 #include <memory>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "case/sql_case.h"
 #include "gtest/gtest.h"
 #include "llvm/Support/TargetSelect.h"
 #include "testing/test_base.h"
+#include "vm/jit_runtime.h"
+#include "vm/runner_ctx.h"
 #include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT
@@ -509,6 +514,217 @@ TEST_F(RunnerTest, RunnerPrintDataMemTimeTableTest) {
         LOG(INFO) << oss.str();
     }
 }
+
+TEST_F(RunnerTest, RunnerContextParallelSlotTest) {
+    Row empty_parameter;
+    RunnerContext ctx(nullptr, empty_parameter, false);
+    // parallel producers are disabled by default
+    ASSERT_FALSE(ctx.AcquireParallelSlot());
+
+    ctx.set_max_parallel_producers(2);
+    ASSERT_TRUE(ctx.AcquireParallelSlot());
+    ASSERT_TRUE(ctx.AcquireParallelSlot());
+    ASSERT_FALSE(ctx.AcquireParallelSlot());
+    ctx.ReleaseParallelSlot();
+    ASSERT_TRUE(ctx.AcquireParallelSlot());
+}
+
+TEST_F(RunnerTest, RunnerContextMemoryQuotaTest) {
+    Row empty_parameter;
+    RunnerContext ctx(nullptr, empty_parameter, false);
+    ASSERT_FALSE(ctx.IsMemoryExceeded());
+    ASSERT_FALSE(ctx.IsRunFailed());
+
+    RunMemoryQuota quota(1024);
+    ctx.set_memory_quota(&quota);
+    // a run step on another thread accounts to the quota of the context
+    std::thread worker([&ctx]() {
+        auto jit = JitRuntime::get();
+        jit->InitRunStep();
+        ASSERT_NE(nullptr, jit->AllocManaged(4096));
+        jit->ReleaseRunStep(ctx.memory_quota());
+    });
+    worker.join();
+    ASSERT_GE(quota.peak_bytes.load(), 4096u);
+    ASSERT_TRUE(ctx.IsMemoryExceeded());
+
+    // a run step without quota accounts to nothing
+    RunMemoryQuota other(1024);
+    auto jit = JitRuntime::get();
+    jit->InitRunStep();
+    ASSERT_NE(nullptr, jit->AllocManaged(4096));
+    jit->ReleaseRunStep();
+    ASSERT_EQ(0u, other.peak_bytes.load());
+    ASSERT_FALSE(other.IsExceeded());
+
+    quota.SetFailed();
+    ASSERT_TRUE(ctx.IsRunFailed());
+}
+
+class CountingExecutor : public ParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override {
+        run_cnt++;
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+    int run_cnt = 0;
+};
+
+TEST_F(RunnerTest, RunProducersKeepOrderTest) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    vm::SchemasContext schemas_ctx;
+    schemas_ctx.BuildTrivial(table_def.catalog(), {&table_def});
+
+    std::vector<std::shared_ptr<DataHandler>> handlers;
+    std::vector<std::unique_ptr<DataRunner>> runners;
+    std::vector<Runner*> producers;
+    for (int32_t i = 0; i < 4; i++) {
+        handlers.push_back(std::make_shared<MemTableHandler>());
+        runners.push_back(std::make_unique<DataRunner>(i, &schemas_ctx, handlers.back()));
+        producers.push_back(runners.back().get());
+        ASSERT_FALSE(producers.back()->HasBlockingRunner());
+    }
+    Row empty_parameter;
+    RunnerContext ctx(nullptr, empty_parameter, false);
+    ctx.set_max_parallel_producers(4);
+    CountingExecutor executor;
+    ctx.set_parallel_executor(&executor);
+    auto inputs = Runner::RunProducers(ctx, producers);
+    ASSERT_EQ(handlers.size(), inputs.size());
+    for (size_t i = 0; i < handlers.size(); i++) {
+        ASSERT_EQ(handlers[i], inputs[i]);
+    }
+    // producers without blocking runners are not worth dispatching
+    ASSERT_EQ(0, executor.run_cnt);
+    ASSERT_TRUE(ctx.AcquireParallelSlot());
+}
+
+// a blocking producer which runs one step of `step_bytes` runtime memory
+class BlockingStepRunner : public Runner {
+ public:
+    BlockingStepRunner(const int32_t id, const SchemasContext* schema, std::shared_ptr<DataHandler> data_handler,
+                       size_t step_bytes)
+        : Runner(id, kRunnerRequestRunProxy, schema), data_handler_(data_handler), step_bytes_(step_bytes) {}
+    std::shared_ptr<DataHandler> Run(RunnerContext& ctx,  // NOLINT
+                                     const std::vector<std::shared_ptr<DataHandler>>& inputs) override {
+        thread_id_ = std::this_thread::get_id();
+        auto jit = JitRuntime::get();
+        jit->InitRunStep();
+        if (jit->AllocManaged(step_bytes_) == nullptr) {
+            return nullptr;
+        }
+        jit->ReleaseRunStep(ctx.memory_quota());
+        return data_handler_;
+    }
+    const std::shared_ptr<DataHandler> data_handler_;
+    const size_t step_bytes_;
+    std::thread::id thread_id_;
+};
+
+// run the first task inline and each other task on its own thread
+class ThreadExecutor : public ParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override {
+        run_cnt++;
+        task_cnt += tasks.size();
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < tasks.size(); i++) {
+            threads.emplace_back(tasks[i]);
+        }
+        tasks[0]();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    int run_cnt = 0;
+    size_t task_cnt = 0;
+};
+
+TEST_F(RunnerTest, RunBlockingProducersTest) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    vm::SchemasContext schemas_ctx;
+    schemas_ctx.BuildTrivial(table_def.catalog(), {&table_def});
+
+    std::vector<std::shared_ptr<DataHandler>> handlers;
+    for (int32_t i = 0; i < 4; i++) {
+        handlers.push_back(std::make_shared<MemTableHandler>());
+    }
+    BlockingStepRunner blocking_a(0, &schemas_ctx, handlers[0], 8 * 1024);
+    DataRunner data(1, &schemas_ctx, handlers[1]);
+    BlockingStepRunner blocking_b(2, &schemas_ctx, handlers[2], 64 * 1024);
+    BlockingStepRunner blocking_c(3, &schemas_ctx, handlers[3], 8 * 1024);
+    std::vector<Runner*> producers = {&blocking_a, &data, &blocking_b, &blocking_c};
+
+    Row empty_parameter;
+    RunnerContext ctx(nullptr, empty_parameter, false);
+    RunMemoryQuota quota(32 * 1024);
+    ctx.set_memory_quota(&quota);
+    ctx.set_max_parallel_producers(4);
+    ThreadExecutor executor;
+    ctx.set_parallel_executor(&executor);
+    auto inputs = Runner::RunProducers(ctx, producers);
+
+    // outputs keep the order of the producers
+    ASSERT_EQ(handlers.size(), inputs.size());
+    for (size_t i = 0; i < handlers.size(); i++) {
+        ASSERT_EQ(handlers[i], inputs[i]);
+    }
+    // the last blocking producer stays inline with the non blocking one, the other two are dispatched
+    ASSERT_EQ(1, executor.run_cnt);
+    ASSERT_EQ(3u, executor.task_cnt);
+    ASSERT_EQ(std::this_thread::get_id(), blocking_c.thread_id_);
+    ASSERT_NE(std::this_thread::get_id(), blocking_a.thread_id_);
+    ASSERT_NE(std::this_thread::get_id(), blocking_b.thread_id_);
+
+    // steps of the dispatched producers account to the quota of the context
+    ASSERT_GE(quota.peak_bytes.load(), 64u * 1024);
+    ASSERT_TRUE(ctx.IsMemoryExceeded());
+    ASSERT_FALSE(ctx.IsRunFailed());
+
+    // all slots are released
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ctx.AcquireParallelSlot());
+    }
+    ASSERT_FALSE(ctx.AcquireParallelSlot());
+}
+
+TEST_F(RunnerTest, RunTraceTest) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    vm::SchemasContext schemas_ctx;
+    schemas_ctx.BuildTrivial(table_def.catalog(), {&table_def});
+
+    DataRunner data_runner(0, &schemas_ctx, std::make_shared<MemTableHandler>());
+    LimitRunner limit_runner(1, &schemas_ctx, 10);
+    limit_runner.AddProducer(&data_runner);
+    Row empty_parameter;
+    {
+        // no spans without a trace
+        RunnerContext ctx(nullptr, empty_parameter, false);
+        ASSERT_TRUE(limit_runner.RunWithCache(ctx) != nullptr);
+    }
+    RunTrace trace;
+    RunnerContext ctx(nullptr, empty_parameter, false);
+    ctx.set_trace(&trace);
+    ASSERT_TRUE(limit_runner.RunWithCache(ctx) != nullptr);
+    auto spans = trace.GetSpans();
+    ASSERT_EQ(2u, spans.size());
+    // the producer finishes first, and its cost is excluded from the self time of the consumer
+    ASSERT_EQ(RunnerTypeName(kRunnerData), spans[0].name);
+    ASSERT_EQ(0, spans[0].runner_id);
+    ASSERT_EQ(spans[0].cost_us, spans[0].self_us);
+    ASSERT_EQ(RunnerTypeName(kRunnerLimit), spans[1].name);
+    ASSERT_EQ(1, spans[1].runner_id);
+    ASSERT_LE(spans[1].start_us, spans[0].start_us);
+    ASSERT_GE(spans[1].cost_us, spans[0].cost_us);
+    ASSERT_EQ(spans[1].cost_us - spans[0].cost_us, spans[1].self_us);
+    ASSERT_EQ(spans[0].cost_us, trace.GetCost(0));
+    ASSERT_EQ(0, trace.GetCost(2));
+}
 }  // namespace vm
 }  // namespace hybridse
 
@@ -221,8 +221,9 @@ std::vector<AggrTableInfo> SimpleCatalog::GetAggrTables(const std::string &base_
                                                         const std::string &aggr_func, const std::string &aggr_col,
                                                         const std::string &partition_cols, const std::string &order_col,
                                                         const std::string &filter_col) {
-    ::hybridse::vm::AggrTableInfo info = {"aggr_" + base_table, "aggr_db", base_db, base_table, aggr_func, aggr_col,
-                                          partition_cols,       order_col, "1000",  filter_col};
+    ::hybridse::vm::AggrTableInfo info = {"aggr_" + base_table, "aggr_db", base_db, base_table,
+                                          aggr_func, aggr_col, partition_cols, order_col, aggr_bucket_size_,
+                                          filter_col};
     return {info};
 }
 
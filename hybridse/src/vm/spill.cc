@@ -0,0 +1,379 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/spill.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "absl/container/flat_hash_map.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "vm/jit_runtime.h"
+
+DECLARE_uint64(batch_operator_mem_limit);
+DECLARE_string(batch_spill_dir);
+
+namespace hybridse {
+namespace vm {
+
+static constexpr size_t kSpillBlockSize = 64 * 1024;
+
+size_t RowBytes(const Row& row) {
+    size_t bytes = 0;
+    for (int32_t i = 0; i < row.GetRowPtrCnt(); i++) {
+        if (row.GetSlice(i).IsManaged()) {
+            bytes += row.size(i);
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<SpillFile> SpillFile::Create() {
+    std::string path = FLAGS_batch_spill_dir + "/hybridse_spill_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        LOG(WARNING) << "fail to create spill file in " << FLAGS_batch_spill_dir << ": " << strerror(errno);
+        return nullptr;
+    }
+    unlink(path.c_str());
+    return std::shared_ptr<SpillFile>(new SpillFile(fd));
+}
+
+SpillFile::~SpillFile() { close(fd_); }
+
+bool SpillFile::Append(uint64_t key, const Row& row) {
+    uint32_t cnt = row.GetRowPtrCnt();
+    buf_.append(reinterpret_cast<const char*>(&key), sizeof(key));
+    buf_.append(reinterpret_cast<const char*>(&cnt), sizeof(cnt));
+    for (uint32_t i = 0; i < cnt; i++) {
+        uint32_t size = row.size(i);
+        buf_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        if (size > 0) {
+            buf_.append(reinterpret_cast<const char*>(row.buf(i)), size);
+        }
+    }
+    count_++;
+    if (buf_.size() >= kSpillBlockSize) {
+        return Flush();
+    }
+    return true;
+}
+
+bool SpillFile::Flush() {
+    size_t done = 0;
+    while (done < buf_.size()) {
+        ssize_t n = pwrite(fd_, buf_.data() + done, buf_.size() - done, size_ + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(WARNING) << "fail to write spill file: " << strerror(errno);
+            return false;
+        }
+        done += n;
+    }
+    size_ += done;
+    buf_.clear();
+    return true;
+}
+
+bool SpillFileReader::Fill(size_t n) {
+    size_t avail = buf_.size() - pos_;
+    if (avail >= n) {
+        return true;
+    }
+    buf_.erase(0, pos_);
+    pos_ = 0;
+    uint64_t remain = file_->size_ - offset_;
+    if (remain < n - avail) {
+        LOG(WARNING) << "spill file is truncated at " << offset_;
+        error_ = true;
+        return false;
+    }
+    size_t len = std::min<uint64_t>(remain, std::max(n - avail, kSpillBlockSize));
+    buf_.resize(avail + len);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = pread(file_->fd_, &buf_[avail + done], len - done, offset_ + done);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            LOG(WARNING) << "fail to read spill file: " << (r < 0 ? strerror(errno) : "unexpected end");
+            error_ = true;
+            return false;
+        }
+        done += r;
+    }
+    offset_ += len;
+    return true;
+}
+
+bool SpillFileReader::Next(uint64_t* key, Row* row) {
+    if (error_ || (pos_ == buf_.size() && offset_ == file_->size_)) {
+        return false;
+    }
+    uint32_t cnt = 0;
+    if (!Fill(sizeof(*key) + sizeof(cnt))) {
+        return false;
+    }
+    memcpy(key, &buf_[pos_], sizeof(*key));
+    memcpy(&cnt, &buf_[pos_ + sizeof(*key)], sizeof(cnt));
+    pos_ += sizeof(*key) + sizeof(cnt);
+    Row value;
+    for (uint32_t i = 0; i < cnt; i++) {
+        uint32_t size = 0;
+        if (!Fill(sizeof(size))) {
+            return false;
+        }
+        memcpy(&size, &buf_[pos_], sizeof(size));
+        pos_ += sizeof(size);
+        base::RefCountedSlice slice;
+        if (size > 0) {
+            if (!Fill(size)) {
+                return false;
+            }
+            int8_t* data = reinterpret_cast<int8_t*>(malloc(size));
+            memcpy(data, &buf_[pos_], size);
+            pos_ += size;
+            slice = base::RefCountedSlice::CreateManaged(data, size);
+        }
+        if (i == 0) {
+            value.Reset(slice);
+        } else {
+            value.Append(slice);
+        }
+    }
+    *row = value;
+    return true;
+}
+
+size_t GroupSpillPartition(const std::string& key, size_t level) {
+    return (std::hash<std::string>()(key) >> (4 * level)) % kGroupSpillPartitions;
+}
+
+std::vector<std::shared_ptr<SpillFile>> SplitGroupSpill(const std::shared_ptr<SpillFile>& file,
+                                                        const GroupKeyFn& key_fn, size_t level) {
+    std::vector<std::shared_ptr<SpillFile>> parts;
+    for (size_t i = 0; i < kGroupSpillPartitions; i++) {
+        auto part = SpillFile::Create();
+        if (!part) {
+            return {};
+        }
+        parts.push_back(part);
+    }
+    if (!file->Flush()) {
+        return {};
+    }
+    SpillFileReader reader(file);
+    uint64_t key = 0;
+    Row row;
+    while (reader.Next(&key, &row)) {
+        if (!parts[GroupSpillPartition(key_fn(row), level)]->Append(key, row)) {
+            return {};
+        }
+    }
+    if (reader.HasError()) {
+        return {};
+    }
+    for (auto& part : parts) {
+        if (!part->Flush()) {
+            return {};
+        }
+    }
+    return parts;
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<SpillFile>>> SplitGroupSpillByKey(
+    const std::shared_ptr<SpillFile>& file, const GroupKeyFn& key_fn) {
+    std::vector<std::pair<std::string, std::shared_ptr<SpillFile>>> groups;
+    absl::flat_hash_map<std::string, size_t> positions;
+    if (!file->Flush()) {
+        return {};
+    }
+    SpillFileReader reader(file);
+    uint64_t key = 0;
+    Row row;
+    while (reader.Next(&key, &row)) {
+        auto group_key = key_fn(row);
+        auto it = positions.find(group_key);
+        if (it == positions.end()) {
+            auto group_file = SpillFile::Create();
+            if (!group_file) {
+                return {};
+            }
+            it = positions.emplace(group_key, groups.size()).first;
+            groups.emplace_back(group_key, group_file);
+        }
+        if (!groups[it->second].second->Append(key, row)) {
+            return {};
+        }
+    }
+    if (reader.HasError()) {
+        return {};
+    }
+    for (auto& group : groups) {
+        if (!group.second->Flush()) {
+            return {};
+        }
+    }
+    return groups;
+}
+
+SpillMergeIterator::SpillMergeIterator(const std::vector<std::shared_ptr<SpillFile>>& runs, bool is_asc,
+                                       RunMemoryQuota* quota)
+    : runs_(runs), is_asc_(is_asc), quota_(quota), readers_(), heads_(runs.size()), heap_(), error_(false) {
+    SeekToFirst();
+}
+
+bool SpillMergeIterator::After(size_t l, size_t r) const {
+    uint64_t lk = heads_[l].first;
+    uint64_t rk = heads_[r].first;
+    if (lk == rk) {
+        return l > r;
+    }
+    return is_asc_ ? lk > rk : lk < rk;
+}
+
+bool SpillMergeIterator::ReadHead(size_t idx) {
+    if (readers_[idx].Next(&heads_[idx].first, &heads_[idx].second)) {
+        return true;
+    }
+    if (readers_[idx].HasError() && !error_) {
+        // the rest of the rows would be silently missing, so the query fails
+        LOG(WARNING) << "fail to merge sorted runs: fail to read spill file";
+        error_ = true;
+        if (quota_ != nullptr) {
+            quota_->SetFailed();
+        }
+    }
+    return false;
+}
+
+void SpillMergeIterator::SeekToFirst() {
+    readers_.clear();
+    readers_.reserve(runs_.size());
+    heap_.clear();
+    error_ = false;
+    auto after = [this](size_t l, size_t r) { return After(l, r); };
+    for (size_t i = 0; i < runs_.size(); i++) {
+        readers_.emplace_back(runs_[i]);
+        if (ReadHead(i)) {
+            heap_.push_back(i);
+        }
+    }
+    if (error_) {
+        heap_.clear();
+        return;
+    }
+    std::make_heap(heap_.begin(), heap_.end(), after);
+}
+
+void SpillMergeIterator::Next() {
+    auto after = [this](size_t l, size_t r) { return After(l, r); };
+    std::pop_heap(heap_.begin(), heap_.end(), after);
+    size_t idx = heap_.back();
+    heap_.pop_back();
+    if (ReadHead(idx)) {
+        heap_.push_back(idx);
+        std::push_heap(heap_.begin(), heap_.end(), after);
+    } else if (error_) {
+        heap_.clear();
+    }
+}
+
+void SpillMergeIterator::Seek(const uint64_t& key) {
+    SeekToFirst();
+    while (Valid() && (is_asc_ ? GetKey() < key : GetKey() > key)) {
+        Next();
+    }
+}
+
+SpillSortedTableHandler::SpillSortedTableHandler(const Schema* schema, std::vector<std::shared_ptr<SpillFile>> runs,
+                                                 bool is_asc, RunMemoryQuota* quota)
+    : table_name_(""),
+      db_(""),
+      schema_(schema),
+      types_(),
+      index_hint_(),
+      runs_(std::move(runs)),
+      is_asc_(is_asc),
+      quota_(quota),
+      count_(0) {
+    for (const auto& run : runs_) {
+        count_ += run->GetCount();
+    }
+}
+
+ExternalSorter::ExternalSorter(const Schema* schema, bool is_asc, RunMemoryQuota* quota)
+    : schema_(schema),
+      is_asc_(is_asc),
+      quota_(quota),
+      run_(std::make_shared<MemTimeTableHandler>(schema)),
+      run_bytes_(0),
+      runs_(),
+      spillable_(quota != nullptr && FLAGS_batch_operator_mem_limit > 0) {}
+
+void ExternalSorter::Add(uint64_t key, const Row& row) {
+    run_->AddRow(key, row);
+    run_bytes_ += RowBytes(row);
+    if (spillable_ && run_bytes_ > FLAGS_batch_operator_mem_limit && !SpillRun()) {
+        LOG(WARNING) << "fail to spill the rows to sort, keep the rest of them in memory";
+        spillable_ = false;
+    }
+}
+
+bool ExternalSorter::SpillRun() {
+    auto file = SpillFile::Create();
+    if (!file) {
+        return false;
+    }
+    run_->Sort(is_asc_);
+    auto iter = run_->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        if (!file->Append(iter->GetKey(), iter->GetValue())) {
+            return false;
+        }
+    }
+    if (!file->Flush()) {
+        return false;
+    }
+    runs_.push_back(file);
+    run_ = std::make_shared<MemTimeTableHandler>(schema_);
+    run_bytes_ = 0;
+    return true;
+}
+
+std::shared_ptr<TableHandler> ExternalSorter::Finish() {
+    if (runs_.empty()) {
+        run_->Sort(is_asc_);
+        return run_;
+    }
+    if (run_->GetCount() > 0 && !SpillRun()) {
+        LOG(WARNING) << "fail to spill the last run of sorted rows";
+        return nullptr;
+    }
+    DLOG(INFO) << "merge " << runs_.size() << " sorted runs from spill files";
+    return std::make_shared<SpillSortedTableHandler>(schema_, std::move(runs_), is_asc_, quota_);
+}
+
+}  // namespace vm
+}  // namespace hybridse
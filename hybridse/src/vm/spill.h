@@ -0,0 +1,189 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_SPILL_H_
+#define HYBRIDSE_SRC_VM_SPILL_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vm/catalog.h"
+#include "vm/jit_runtime.h"
+#include "vm/mem_catalog.h"
+
+namespace hybridse {
+namespace vm {
+
+// bytes of the slices a row owns, which is what the memory limit of batch operators counts.
+// slices pointing into table storage are left out, spilling them would free nothing
+size_t RowBytes(const Row& row);
+
+// A temporary file of rows, stored as [key u64][slice cnt u32]([slice size u32][slice data])*.
+// The file is unlinked right after it is created, so it goes away with the last handle.
+class SpillFile {
+ public:
+    // create a file in FLAGS_batch_spill_dir, return null if it fails
+    static std::shared_ptr<SpillFile> Create();
+    ~SpillFile();
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    bool Append(uint64_t key, const Row& row);
+    // write the buffered rows, the rows appended before it are visible to readers
+    bool Flush();
+    uint64_t GetCount() const { return count_; }
+
+ private:
+    friend class SpillFileReader;
+    explicit SpillFile(int fd) : fd_(fd), buf_(), size_(0), count_(0) {}
+
+    int fd_;
+    std::string buf_;
+    uint64_t size_;
+    uint64_t count_;
+};
+
+// Reads the rows of a spill file in the appended order, each reader has its own offset
+class SpillFileReader {
+ public:
+    explicit SpillFileReader(std::shared_ptr<SpillFile> file)
+        : file_(std::move(file)), offset_(0), buf_(), pos_(0), error_(false) {}
+
+    // return false at the end of the file or if it fails
+    bool Next(uint64_t* key, Row* row);
+    bool HasError() const { return error_; }
+
+ private:
+    // make sure `n` unread bytes are in the buffer
+    bool Fill(size_t n);
+
+    std::shared_ptr<SpillFile> file_;
+    uint64_t offset_;
+    std::string buf_;
+    size_t pos_;
+    bool error_;
+};
+
+// The group spill files of GroupAggRunner hold whole groups. A group goes to one of kGroupSpillPartitions
+// files by 4 bits of the hash of its key, a partition too large to load is split again by the next 4 bits,
+// at most kGroupSpillMaxLevel times
+constexpr size_t kGroupSpillPartitions = 16;
+constexpr size_t kGroupSpillMaxLevel = 4;
+
+// the partition of the group `key` at split `level`
+size_t GroupSpillPartition(const std::string& key, size_t level);
+
+using GroupKeyFn = std::function<std::string(const Row&)>;
+
+// split the rows of `file` into kGroupSpillPartitions files by GroupSpillPartition at `level`,
+// return empty if it fails
+std::vector<std::shared_ptr<SpillFile>> SplitGroupSpill(const std::shared_ptr<SpillFile>& file,
+                                                        const GroupKeyFn& key_fn, size_t level);
+
+// split the rows of `file` into one file per group, in the order the groups first appear.
+// return empty if it fails
+std::vector<std::pair<std::string, std::shared_ptr<SpillFile>>> SplitGroupSpillByKey(
+    const std::shared_ptr<SpillFile>& file, const GroupKeyFn& key_fn);
+
+// Merges sorted runs of spill files by key. If a run can't be read, the iterator ends
+// and fails the running query through its memory quota
+class SpillMergeIterator : public RowIterator {
+ public:
+    SpillMergeIterator(const std::vector<std::shared_ptr<SpillFile>>& runs, bool is_asc, RunMemoryQuota* quota);
+    ~SpillMergeIterator() override {}
+    bool Valid() const override { return !heap_.empty(); }
+    void Next() override;
+    const uint64_t& GetKey() const override { return heads_[heap_.front()].first; }
+    const Row& GetValue() override { return heads_[heap_.front()].second; }
+    void Seek(const uint64_t& key) override;
+    void SeekToFirst() override;
+    bool IsSeekable() const override { return true; }
+    bool HasError() const { return error_; }
+
+ private:
+    // the heap order, true if run `l` is read after run `r`
+    bool After(size_t l, size_t r) const;
+    // read the next row of run `idx` into its head, return false at its end or if it fails
+    bool ReadHead(size_t idx);
+
+    std::vector<std::shared_ptr<SpillFile>> runs_;
+    bool is_asc_;
+    RunMemoryQuota* quota_;
+    std::vector<SpillFileReader> readers_;
+    std::vector<std::pair<uint64_t, Row>> heads_;
+    std::vector<size_t> heap_;
+    bool error_;
+};
+
+// A table sorted by key, whose rows are in sorted runs of spill files
+class SpillSortedTableHandler : public TableHandler {
+ public:
+    SpillSortedTableHandler(const Schema* schema, std::vector<std::shared_ptr<SpillFile>> runs, bool is_asc,
+                            RunMemoryQuota* quota);
+    ~SpillSortedTableHandler() override {}
+
+    const Types& GetTypes() override { return types_; }
+    const IndexHint& GetIndex() override { return index_hint_; }
+    const Schema* GetSchema() override { return schema_; }
+    const std::string& GetName() override { return table_name_; }
+    const std::string& GetDatabase() override { return db_; }
+    RowIterator* GetRawIterator() override { return new SpillMergeIterator(runs_, is_asc_, quota_); }
+    const uint64_t GetCount() override { return count_; }
+    const OrderType GetOrderType() const override { return is_asc_ ? kAscOrder : kDescOrder; }
+    const std::string GetHandlerTypeName() override { return "SpillSortedTableHandler"; }
+
+ private:
+    const std::string table_name_;
+    const std::string db_;
+    const Schema* schema_;
+    Types types_;
+    IndexHint index_hint_;
+    std::vector<std::shared_ptr<SpillFile>> runs_;
+    bool is_asc_;
+    RunMemoryQuota* quota_;
+    uint64_t count_;
+};
+
+// Sorts rows by key. Once the rows in memory exceed FLAGS_batch_operator_mem_limit they are sorted
+// and spilled as a run, the runs are merged when the result is iterated. Nothing is spilled without
+// a `quota`, since a run which can't be read back must fail the query through it.
+class ExternalSorter {
+ public:
+    ExternalSorter(const Schema* schema, bool is_asc, RunMemoryQuota* quota);
+
+    void Add(uint64_t key, const Row& row);
+    // the sorted rows, in memory if nothing is spilled. return null if it fails
+    std::shared_ptr<TableHandler> Finish();
+
+ private:
+    bool SpillRun();
+
+    const Schema* schema_;
+    bool is_asc_;
+    RunMemoryQuota* quota_;
+    std::shared_ptr<MemTimeTableHandler> run_;
+    size_t run_bytes_;
+    std::vector<std::shared_ptr<SpillFile>> runs_;
+    // falls back to sort in memory if no spill file can be written
+    bool spillable_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_SPILL_H_
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/spill.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "testing/test_base.h"
+#include "vm/jit_runtime.h"
+
+DECLARE_uint64(batch_operator_mem_limit);
+
+namespace hybridse {
+namespace vm {
+using hybridse::codec::Row;
+class SpillTest : public ::testing::Test {
+ public:
+    SpillTest() {}
+    ~SpillTest() { FLAGS_batch_operator_mem_limit = 0; }
+};
+
+// rows built by the tests point to buffers they don't own, which the memory limit doesn't count
+static void ManageRows(std::vector<Row>* rows) {
+    for (auto& row : *rows) {
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(row.size()));
+        memcpy(buf, row.buf(), row.size());
+        row = Row(base::RefCountedSlice::CreateManaged(buf, row.size()));
+    }
+}
+
+// truncate the open spill files of this process, as if they fail to be read
+static int TruncateSpillFiles() {
+    int cnt = 0;
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return 0;
+    }
+    while (auto entry = readdir(dir)) {
+        char path[256];
+        std::string fd_path = std::string("/proc/self/fd/") + entry->d_name;
+        ssize_t len = readlink(fd_path.c_str(), path, sizeof(path) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        path[len] = 0;
+        if (strstr(path, "hybridse_spill_") != nullptr && ftruncate(atoi(entry->d_name), 0) == 0) {
+            cnt++;
+        }
+    }
+    closedir(dir);
+    return cnt;
+}
+
+TEST_F(SpillTest, row_bytes_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    ASSERT_EQ(0u, RowBytes(rows[0]));
+    size_t size = rows[0].size();
+    ManageRows(&rows);
+    ASSERT_EQ(size, RowBytes(rows[0]));
+    ASSERT_EQ(size, RowBytes(Row(1, rows[0], 1, Row(base::RefCountedSlice::Create(rows[1].buf(), rows[1].size())))));
+}
+
+TEST_F(SpillTest, spill_file_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    auto file = SpillFile::Create();
+    ASSERT_TRUE(file);
+    // a joined row, and a joined row whose right side is null
+    Row joined(1, rows[0], 1, rows[1]);
+    Row left_only(1, rows[2], 1, Row());
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(file->Append(i, rows[i % rows.size()]));
+    }
+    ASSERT_TRUE(file->Append(10000, joined));
+    ASSERT_TRUE(file->Append(10001, left_only));
+    ASSERT_TRUE(file->Flush());
+    ASSERT_EQ(10002u, file->GetCount());
+
+    SpillFileReader reader(file);
+    uint64_t key = 0;
+    Row row;
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(reader.Next(&key, &row));
+        ASSERT_EQ(static_cast<uint64_t>(i), key);
+        ASSERT_EQ(0, row.compare(rows[i % rows.size()]));
+    }
+    ASSERT_TRUE(reader.Next(&key, &row));
+    ASSERT_EQ(2, row.GetRowPtrCnt());
+    ASSERT_EQ(0, row.compare(joined));
+    ASSERT_TRUE(reader.Next(&key, &row));
+    ASSERT_EQ(2, row.GetRowPtrCnt());
+    ASSERT_EQ(0, row.size(1));
+    ASSERT_EQ(0, row.compare(left_only));
+    ASSERT_FALSE(reader.Next(&key, &row));
+    ASSERT_FALSE(reader.HasError());
+}
+
+TEST_F(SpillTest, external_sort_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    ManageRows(&rows);
+    RunMemoryQuota quota(0);
+    for (bool is_asc : {true, false}) {
+        for (uint64_t limit : {0ul, 1024ul}) {
+            FLAGS_batch_operator_mem_limit = limit;
+            ExternalSorter sorter(&table.columns(), is_asc, &quota);
+            for (uint64_t i = 0; i < 1000; i++) {
+                sorter.Add((i * 7919) % 1000, rows[i % rows.size()]);
+            }
+            auto sorted = sorter.Finish();
+            ASSERT_TRUE(sorted);
+            ASSERT_EQ(limit == 0 ? "MemTimeTableHandler" : "SpillSortedTableHandler", sorted->GetHandlerTypeName());
+            ASSERT_EQ(is_asc ? kAscOrder : kDescOrder, sorted->GetOrderType());
+            ASSERT_EQ(1000u, sorted->GetCount());
+            auto iter = sorted->GetIterator();
+            iter->SeekToFirst();
+            for (uint64_t i = 0; i < 1000; i++) {
+                ASSERT_TRUE(iter->Valid());
+                uint64_t key = is_asc ? i : 999 - i;
+                ASSERT_EQ(key, iter->GetKey());
+                // 7919 * 679 % 1000 == 1, so key k is added at the position k * 679 % 1000
+                ASSERT_EQ(0, iter->GetValue().compare(rows[(key * 679 % 1000) % rows.size()]));
+                iter->Next();
+            }
+            ASSERT_FALSE(iter->Valid());
+            if (limit > 0) {
+                iter->Seek(500);
+                ASSERT_TRUE(iter->Valid());
+                ASSERT_EQ(500u, iter->GetKey());
+            }
+        }
+    }
+}
+
+TEST_F(SpillTest, external_sort_read_error_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    ManageRows(&rows);
+    FLAGS_batch_operator_mem_limit = 1024;
+    RunMemoryQuota quota(0);
+    ExternalSorter sorter(&table.columns(), true, &quota);
+    for (uint64_t i = 0; i < 1000; i++) {
+        sorter.Add(i, rows[i % rows.size()]);
+    }
+    auto sorted = sorter.Finish();
+    ASSERT_TRUE(sorted);
+    ASSERT_EQ("SpillSortedTableHandler", sorted->GetHandlerTypeName());
+    ASSERT_GT(TruncateSpillFiles(), 0);
+
+    std::unique_ptr<RowIterator> iter(sorted->GetRawIterator());
+    uint64_t cnt = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        cnt++;
+    }
+    // the rows are never silently truncated, the run fails instead
+    ASSERT_LT(cnt, 1000u);
+    ASSERT_TRUE(dynamic_cast<SpillMergeIterator*>(iter.get())->HasError());
+    ASSERT_TRUE(quota.IsFailed());
+}
+
+TEST_F(SpillTest, external_sort_without_quota_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    ManageRows(&rows);
+    FLAGS_batch_operator_mem_limit = 1024;
+    // a read error could not fail the run, so the rows stay in memory
+    ExternalSorter sorter(&table.columns(), true, nullptr);
+    for (uint64_t i = 0; i < 1000; i++) {
+        sorter.Add(i, rows[i % rows.size()]);
+    }
+    auto sorted = sorter.Finish();
+    ASSERT_TRUE(sorted);
+    ASSERT_EQ("MemTimeTableHandler", sorted->GetHandlerTypeName());
+    ASSERT_EQ(1000u, sorted->GetCount());
+}
+
+TEST_F(SpillTest, split_group_spill_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // each distinct row is a group
+    GroupKeyFn key_fn = [](const Row& row) {
+        return std::string(reinterpret_cast<const char*>(row.buf()), row.size());
+    };
+    auto file = SpillFile::Create();
+    ASSERT_TRUE(file);
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_TRUE(file->Append(i, rows[i % rows.size()]));
+    }
+
+    // the rows of a group stay in one part, in the appended order
+    auto parts = SplitGroupSpill(file, key_fn, 1);
+    ASSERT_EQ(kGroupSpillPartitions, parts.size());
+    uint64_t cnt = 0;
+    for (size_t i = 0; i < parts.size(); i++) {
+        SpillFileReader reader(parts[i]);
+        uint64_t key = 0;
+        Row row;
+        uint64_t last_key = 0;
+        for (uint64_t j = 0; reader.Next(&key, &row); j++) {
+            ASSERT_EQ(i, GroupSpillPartition(key_fn(row), 1));
+            ASSERT_EQ(0, row.compare(rows[key % rows.size()]));
+            ASSERT_TRUE(j == 0 || key > last_key);
+            last_key = key;
+        }
+        ASSERT_FALSE(reader.HasError());
+        cnt += parts[i]->GetCount();
+    }
+    ASSERT_EQ(1000u, cnt);
+
+    // a single group can not be split by the key hash, but into a file of its own
+    auto single = SpillFile::Create();
+    ASSERT_TRUE(single);
+    for (uint64_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(single->Append(i, rows[0]));
+    }
+    parts = SplitGroupSpill(single, key_fn, 2);
+    ASSERT_EQ(kGroupSpillPartitions, parts.size());
+    ASSERT_EQ(100u, parts[GroupSpillPartition(key_fn(rows[0]), 2)]->GetCount());
+
+    auto groups = SplitGroupSpillByKey(file, key_fn);
+    ASSERT_EQ(rows.size(), groups.size());
+    cnt = 0;
+    for (size_t i = 0; i < groups.size(); i++) {
+        ASSERT_EQ(key_fn(rows[i]), groups[i].first);
+        SpillFileReader reader(groups[i].second);
+        uint64_t key = 0;
+        Row row;
+        while (reader.Next(&key, &row)) {
+            ASSERT_EQ(i, key % rows.size());
+        }
+        ASSERT_FALSE(reader.HasError());
+        cnt += groups[i].second->GetCount();
+    }
+    ASSERT_EQ(1000u, cnt);
+}
+
+}  // namespace vm
+}  // namespace hybridse
+int main(int argc, char** argv) {
+    ::testing::GTEST_FLAG(color) = "yes";
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
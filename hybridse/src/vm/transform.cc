@@ -303,6 +303,11 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                                           node->producers()[0]));
             CHECK_STATUS(GenRequestWindow(&request_union_op->agg_window_,
                                           node->producers()[2]));
+            size_t level = 0;
+            for (auto& level_window : request_union_op->level_windows_) {
+                CHECK_STATUS(GenRequestWindow(&level_window, node->producers()[3 + level]));
+                level++;
+            }
             break;
         }
         case kPhysicalOpPostRequestUnion: {
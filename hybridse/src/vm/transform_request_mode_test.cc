@@ -663,6 +663,65 @@ TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedTest) {
     PhysicalPlanCheck(catalog, sql, expected, extra_passes, &options);
 }
 
+TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedLevelTest) {
+    // the coarser level tables are extra producers, levels stop at the first missing table
+    const std::string sql =
+        R"(SELECT
+            col1,
+            sum(col2) OVER w1,
+        FROM t1
+        WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE BETWEEN 3h PRECEDING AND CURRENT ROW);)";
+
+    const std::string expected =
+        R"(SIMPLE_PROJECT(sources=(col1, sum(col2)over w1))
+  REQUEST_JOIN(type=kJoinTypeConcat)
+    PROJECT(type=RowProject)
+      DATA_PROVIDER(request=t1)
+    PROJECT(type=ReduceAggregation: sum(col2)over w1 (range[10800000 PRECEDING,0 CURRENT]))
+      REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 10800000 PRECEDING, 0 CURRENT), index_keys=(col1))
+        DATA_PROVIDER(request=t1)
+        DATA_PROVIDER(type=Partition, table=t1, index=index1)
+        DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
+        DATA_PROVIDER(type=Partition, table=aggr_t1_1m, index=index1_t2))";
+
+    std::shared_ptr<SimpleCatalog> catalog(new SimpleCatalog(true));
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    {
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index1");
+        index->add_first_keys("col1");
+        index->set_second_key("col5");
+    }
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    {
+        hybridse::type::Database db;
+        db.set_name("aggr_db");
+        for (const std::string& name : {"aggr_t1", "aggr_t1_1m"}) {
+            hybridse::type::TableDef table_def;
+            BuildAggTableDef(table_def, name, "aggr_db");
+            ::hybridse::type::IndexDef* index = table_def.add_indexes();
+            index->set_name("index1_t2");
+            index->add_first_keys("key");
+            index->set_second_key("ts_start");
+            AddTable(db, table_def);
+        }
+        catalog->AddDatabase(db);
+    }
+    catalog->SetAggrBucketSize("1s|1m|1h");
+
+    std::unordered_map<std::string, std::string> options;
+    options[LONG_WINDOWS] = "w1:1s|1m|1h";
+    std::vector<passes::PhysicalPlanPassType> extra_passes = {passes::kPassSplitAggregationOptimized,
+                                                              passes::kPassLongWindowOptimized};
+    PhysicalPlanCheck(catalog, sql, expected, extra_passes, &options);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
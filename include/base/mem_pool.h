@@ -43,6 +43,15 @@ class MemoryChunk {
         allocated_size_ += request_size;
         return addr;
     }
+    // `align` must be a power of 2
+    char* Alloc(size_t request_size, size_t align) {
+        size_t padding = -reinterpret_cast<uintptr_t>(mem_ + allocated_size_) & (align - 1);
+        if (request_size + padding > available_size()) {
+            return nullptr;
+        }
+        allocated_size_ += padding;
+        return Alloc(request_size);
+    }
     inline MemoryChunk* next() { return next_; }
     enum { DEFAULT_CHUCK_SIZE = 4096 };
 
@@ -55,7 +64,7 @@ class MemoryChunk {
 class ByteMemoryPool {
  public:
     explicit ByteMemoryPool(size_t init_size = MemoryChunk::DEFAULT_CHUCK_SIZE)
-        : chucks_(nullptr) {
+        : chucks_(nullptr), allocated_size_(0) {
         ExpandStorage(init_size);
     }
     ~ByteMemoryPool() {
@@ -67,6 +76,15 @@ class ByteMemoryPool {
         }
         return chucks_->Alloc(request_size);
     }
+    char* Alloc(size_t request_size, size_t align) {
+        char* addr = nullptr == chucks_ ? nullptr : chucks_->Alloc(request_size, align);
+        if (nullptr == addr) {
+            // a new chuck fits the request with any padding
+            ExpandStorage(request_size + align - 1);
+            addr = chucks_->Alloc(request_size, align);
+        }
+        return addr;
+    }
 
     // clear last chuck
     // and delete other chucks
@@ -77,13 +95,19 @@ class ByteMemoryPool {
             delete chuck;
             chuck = chucks_;
         }
+        allocated_size_ = 0;
     }
     void ExpandStorage(size_t request_size) {
         chucks_ = new MemoryChunk(chucks_, request_size);
+        allocated_size_ += request_size > MemoryChunk::DEFAULT_CHUCK_SIZE ? request_size
+                                                                          : MemoryChunk::DEFAULT_CHUCK_SIZE;
     }
+    // total bytes of chucks held by the pool
+    inline size_t GetAllocatedSize() const { return allocated_size_; }
 
  private:
     MemoryChunk* chucks_;
+    size_t allocated_size_;
 };
 }  // namespace base
 }  // namespace openmldb
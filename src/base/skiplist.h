@@ -21,9 +21,13 @@
 #include <stdint.h>
 
 #include <atomic>
+#include <cstring>
 #include <iostream>
+#include <new>
+#include <type_traits>
 
 #include "base/random.h"
+#include "base/slice.h"
 
 namespace openmldb {
 namespace base {
@@ -39,6 +43,34 @@ struct DefaultComparator {
     }
 };
 
+// The first 8 bytes of a key in big endian, zero padded. Comparing them as integers orders the keys
+// like memcmp, so most comparisons of short pks are done without reading the key data
+template <class K>
+struct KeyPrefix {
+    KeyPrefix() {}
+    explicit KeyPrefix(const K&) {}
+};
+
+template <>
+struct KeyPrefix<Slice> {
+    KeyPrefix() : value(0) {}
+    explicit KeyPrefix(const Slice& key) : value(0) {
+        memcpy(&value, key.data(), key.size() < sizeof(value) ? key.size() : sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        value = __builtin_bswap64(value);
+#endif
+    }
+    uint64_t value;
+};
+
+// A comparator of Slice keys declares `static constexpr bool kBytewise = true` if it orders the keys
+// like Slice::compare, then the key prefixes are compared first
+template <class C, class = void>
+struct IsBytewiseComparator : std::false_type {};
+
+template <class C>
+struct IsBytewiseComparator<C, std::void_t<decltype(C::kBytewise)>> : std::integral_constant<bool, C::kBytewise> {};
+
 // Skiplist node , a thread safe structure
 template <class K, class V>
 class Node {
@@ -83,6 +115,13 @@ class Node {
 
     ~Node() { delete[] nexts_; }
 
+    // the height is only used by the nodes with inline towers
+    static void* operator new(size_t size, uint8_t) { return ::operator new(size); }
+    static void operator delete(void* p) { ::operator delete(p); }
+    static void operator delete(void* p, uint8_t) { ::operator delete(p); }
+
+    void PrefetchNext(uint8_t) const {}
+
  private:
     uint8_t const height_;
     K const key_;
@@ -90,6 +129,87 @@ class Node {
     std::atomic<Node<K, V>*>* nexts_;
 };
 
+// Node whose tower of nexts is allocated inline right after it, so a search reads the key and the
+// next to follow from the same allocation. A node of height 1 takes 32 bytes, half a cache line
+template <class N, class K, class V>
+class InlineNode : public KeyPrefix<K> {
+ public:
+    InlineNode(const K& key, V& value, uint8_t height)  // NOLINT
+        : KeyPrefix<K>(key), key_(key), value_(value), height_(height) {
+        InitNexts();
+    }
+
+    explicit InlineNode(uint8_t height) : KeyPrefix<K>(), key_(), value_(), height_(height) { InitNexts(); }
+
+    InlineNode(const InlineNode&) = delete;
+    InlineNode& operator=(const InlineNode&) = delete;
+
+    static void* operator new(size_t size, uint8_t height) {
+        return ::operator new(size + (height - 1) * sizeof(std::atomic<N*>));
+    }
+    static void operator delete(void* p) { ::operator delete(p); }
+    static void operator delete(void* p, uint8_t) { ::operator delete(p); }
+
+    void SetNext(uint8_t level, N* node) {
+        assert(level < height_);
+        nexts_[level].store(node, std::memory_order_release);
+    }
+
+    void SetNextNoBarrier(uint8_t level, N* node) {
+        assert(level < height_);
+        nexts_[level].store(node, std::memory_order_relaxed);
+    }
+
+    uint8_t Height() { return height_; }
+
+    N* GetNext(uint8_t level) {
+        assert(level < height_);
+        return nexts_[level].load(std::memory_order_acquire);
+    }
+
+    N* GetNextNoBarrier(uint8_t level) {
+        assert(level < height_);
+        return nexts_[level].load(std::memory_order_relaxed);
+    }
+
+    V& GetValue() { return value_; }
+
+    const K& GetKey() const { return key_; }
+
+    const KeyPrefix<K>& GetKeyPrefix() const { return *this; }
+
+    // prefetch the node after the next one, which is compared if the search moves to the next
+    void PrefetchNext(uint8_t level) const { __builtin_prefetch(nexts_[level].load(std::memory_order_relaxed)); }
+
+ private:
+    void InitNexts() {
+        for (uint8_t i = 0; i < height_; i++) {
+            nexts_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    K const key_;
+    V value_;
+    uint8_t const height_;
+    std::atomic<N*> nexts_[1];
+};
+
+// ts entries and their gc lists
+template <class V>
+class Node<uint64_t, V> : public InlineNode<Node<uint64_t, V>, uint64_t, V> {
+ public:
+    using Base = InlineNode<Node<uint64_t, V>, uint64_t, V>;
+    using Base::Base;
+};
+
+// pk entries
+template <class V>
+class Node<Slice, V> : public InlineNode<Node<Slice, V>, Slice, V> {
+ public:
+    using Base = InlineNode<Node<Slice, V>, Slice, V>;
+    using Base::Base;
+};
+
 template <class K, class V, class Comparator>
 class Skiplist {
  public:
@@ -101,7 +221,7 @@ class Skiplist {
           rand_(0xdeadbeef),
           head_(NULL),
           tail_(NULL) {
-        head_ = new Node<K, V>(MaxHeight);
+        head_ = new (MaxHeight) Node<K, V>(MaxHeight);
         for (uint8_t i = 0; i < head_->Height(); i++) {
             head_->SetNext(i, NULL);
         }
@@ -364,7 +484,7 @@ class Skiplist {
 
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
-        Node<K, V>* node = new Node<K, V>(key, value, height);
+        Node<K, V>* node = new (height) Node<K, V>(key, value, height);
         return node;
     }
 
@@ -378,11 +498,15 @@ class Skiplist {
 
     Node<K, V>* FindLessOrEqual(const K& key, Node<K, V>** nodes) {
         assert(nodes != NULL);
+        const KeyPrefix<K> prefix(key);
         Node<K, V>* node = head_;
         uint8_t level = GetMaxHeight() - 1;
         while (true) {
             Node<K, V>* next = node->GetNext(level);
-            if (IsAfterNode(key, next)) {
+            if (next != NULL) {
+                next->PrefetchNext(level);
+            }
+            if (IsAfterNode(key, prefix, next)) {
                 node = next;
             } else {
                 nodes[level] = node;
@@ -395,11 +519,15 @@ class Skiplist {
     }
 
     Node<K, V>* FindEqual(const K& key) {
+        const KeyPrefix<K> prefix(key);
         Node<K, V>* node = head_;
         uint8_t level = GetMaxHeight() - 1;
         while (true) {
             Node<K, V>* next = node->GetNext(level);
-            if (next == NULL || compare_(next->GetKey(), key) > 0) {
+            if (next != NULL) {
+                next->PrefetchNext(level);
+            }
+            if (next == NULL || CompareNode(next, key, prefix) > 0) {
                 if (level <= 0) {
                     return node;
                 }
@@ -411,12 +539,16 @@ class Skiplist {
     }
 
     Node<K, V>* FindLessThan(const K& key) {
+        const KeyPrefix<K> prefix(key);
         Node<K, V>* node = head_;
         uint8_t level = GetMaxHeight() - 1;
         while (true) {
             assert(node == head_ || compare_(node->GetKey(), key) < 0);
             Node<K, V>* next = node->GetNext(level);
-            if (next == NULL || compare_(next->GetKey(), key) >= 0) {
+            if (next != NULL) {
+                next->PrefetchNext(level);
+            }
+            if (next == NULL || CompareNode(next, key, prefix) >= 0) {
                 if (level <= 0) {
                     return node;
                 }
@@ -427,8 +559,19 @@ class Skiplist {
         }
     }
 
-    bool IsAfterNode(const K& key, const Node<K, V>* node) const {
-        return (node != NULL) && (compare_(key, node->GetKey()) > 0);
+    // compare the key of node with key, whose prefix is given
+    int CompareNode(const Node<K, V>* node, const K& key, const KeyPrefix<K>& prefix) const {
+        if constexpr (std::is_same<K, Slice>::value && IsBytewiseComparator<Comparator>::value) {
+            uint64_t node_prefix = node->GetKeyPrefix().value;
+            if (node_prefix != prefix.value) {
+                return node_prefix < prefix.value ? -1 : 1;
+            }
+        }
+        return compare_(node->GetKey(), key);
+    }
+
+    bool IsAfterNode(const K& key, const KeyPrefix<K>& prefix, const Node<K, V>* node) const {
+        return (node != NULL) && (CompareNode(node, key, prefix) < 0);
     }
 
     uint8_t GetMaxHeight() const { return max_height_.load(std::memory_order_relaxed); }
@@ -16,10 +16,14 @@
 
 #include "base/skiplist.h"
 
+#include <algorithm>
+#include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "base/slice.h"
+#include "common/timer.h"
 #include "gtest/gtest.h"
 
 namespace openmldb {
@@ -38,6 +42,7 @@ class SkiplistTest : public ::testing::Test {
 };
 
 struct SliceComparator {
+    static constexpr bool kBytewise = true;
     int operator()(const Slice& a, const Slice& b) const { return a.compare(b); }
 };
 
@@ -90,8 +95,28 @@ TEST_F(NodeTest, SetNext) {
 TEST_F(NodeTest, NodeByteSize) {
     std::atomic<Node<Slice, std::string*>*> node0[12];
     ASSERT_EQ(96u, sizeof(node0));
+    // the first next and the key prefix are inline
     ASSERT_EQ(32u, sizeof(Node<uint64_t, void*>));
-    ASSERT_EQ(40u, sizeof(Node<Slice, void*>));
+    ASSERT_EQ(48u, sizeof(Node<Slice, void*>));
+}
+
+TEST_F(NodeTest, InlineNode) {
+    uint64_t key = 1;
+    uint64_t value = 2;
+    for (uint8_t height : {1, 5, 12}) {
+        auto node = new (height) Node<uint64_t, uint64_t>(key, value, height);
+        ASSERT_EQ(height, node->Height());
+        for (uint8_t i = 0; i < height; i++) {
+            ASSERT_EQ(nullptr, node->GetNext(i));
+        }
+        auto next = new (1) Node<uint64_t, uint64_t>(key, value, 1);
+        node->SetNext(height - 1, next);
+        ASSERT_EQ(next, node->GetNext(height - 1));
+        ASSERT_EQ(1u, node->GetKey());
+        ASSERT_EQ(2u, node->GetValue());
+        delete next;
+        delete node;
+    }
 }
 
 TEST_F(NodeTest, SliceTest) {
@@ -663,6 +688,133 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, SliceKeyPrefix) {
+    // keys sharing the first 8 bytes, keys with zero bytes and keys of the same prefix but other lengths
+    std::vector<std::string> keys = {"",         std::string("a\0", 2), std::string("a\0\0", 3),
+                                     "a",        "ab",                  "abcdefgh",
+                                     "abcdefgg", "abcdefghi",           "abcdefgha",
+                                     "b",        "\xff",                std::string("abcdefgh\0", 9),
+                                     "\xff\xff\xff\xff\xff\xff\xff\xff\x01"};
+    std::mt19937 rng(0xdeadbeef);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    SliceComparator cmp;
+    Skiplist<Slice, uint32_t, SliceComparator> sl(12, 4, cmp);
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        Slice key(keys[i].data(), keys[i].size());
+        sl.Insert(key, i);
+    }
+    std::vector<std::string> sorted = keys;
+    std::sort(sorted.begin(), sorted.end(), [](const std::string& a, const std::string& b) {
+        return Slice(a.data(), a.size()).compare(Slice(b.data(), b.size())) < 0;
+    });
+    std::unique_ptr<Skiplist<Slice, uint32_t, SliceComparator>::Iterator> it(sl.NewIterator());
+    it->SeekToFirst();
+    for (const auto& key : sorted) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(key, it->GetKey().ToString());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        Slice key(keys[i].data(), keys[i].size());
+        uint32_t value = 0;
+        ASSERT_EQ(0, sl.Get(key, value));
+        ASSERT_EQ(i, value);
+        it->Seek(key);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(keys[i], it->GetKey().ToString());
+    }
+    uint32_t value = 0;
+    ASSERT_EQ(-1, sl.Get(Slice("abcdefgh\x01", 9), value));
+    ASSERT_EQ(keys.size(), sl.Clear());
+}
+
+// the comparator and the key types before the specialized nodes, which use the generic node
+struct BranchDescComparator {
+    int operator()(int64_t a, int64_t b) const {
+        if (a > b) {
+            return -1;
+        } else if (a == b) {
+            return 0;
+        }
+        return 1;
+    }
+};
+
+struct BranchlessDescComparator {
+    int operator()(uint64_t a, uint64_t b) const { return static_cast<int>(a < b) - static_cast<int>(a > b); }
+};
+
+class PlainSlice : public Slice {
+ public:
+    using Slice::Slice;
+};
+
+struct PlainSliceComparator {
+    int operator()(const PlainSlice& a, const PlainSlice& b) const { return a.compare(b); }
+};
+
+template <class K, class C>
+uint64_t RunTsBench(const std::vector<uint64_t>& ts_vec) {
+    C cmp;
+    Skiplist<K, uint64_t, C> sl(12, 4, cmp);
+    uint64_t start = ::baidu::common::timer::get_micros();
+    for (uint64_t ts : ts_vec) {
+        sl.Insert(static_cast<K>(ts), ts);
+    }
+    std::unique_ptr<typename Skiplist<K, uint64_t, C>::Iterator> it(sl.NewIterator());
+    uint64_t sum = 0;
+    for (uint64_t ts : ts_vec) {
+        it->Seek(static_cast<K>(ts));
+        sum += it->GetValue();
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() - start;
+    EXPECT_EQ(ts_vec.size(), sl.Clear());
+    return sum == 0 ? 0 : cost;
+}
+
+template <class K, class C>
+uint64_t RunPkBench(const std::vector<std::string>& pks) {
+    C cmp;
+    Skiplist<K, uint32_t, C> sl(12, 4, cmp);
+    uint64_t start = ::baidu::common::timer::get_micros();
+    for (uint32_t i = 0; i < pks.size(); i++) {
+        K key(pks[i].data(), pks[i].size());
+        sl.Insert(key, i);
+    }
+    uint32_t found = 0;
+    for (const auto& pk : pks) {
+        uint32_t value = 0;
+        if (sl.Get(K(pk.data(), pk.size()), value) == 0) {
+            found++;
+        }
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() - start;
+    EXPECT_EQ(pks.size(), found);
+    EXPECT_EQ(pks.size(), sl.Clear());
+    return cost;
+}
+
+TEST_F(SkiplistTest, SpecializedNodeBenchmark) {
+    const uint32_t num = 200000;
+    std::mt19937_64 rng(0xdeadbeef);
+    std::vector<uint64_t> ts_vec;
+    std::vector<std::string> pks;
+    uint64_t cur_time = 1650000000000;
+    for (uint32_t i = 0; i < num; i++) {
+        ts_vec.push_back(cur_time - rng() % (24 * 3600 * 1000));
+        pks.push_back("user_" + std::to_string(rng()));
+    }
+    uint64_t generic_cost = RunTsBench<int64_t, BranchDescComparator>(ts_vec);
+    uint64_t inline_cost = RunTsBench<uint64_t, BranchlessDescComparator>(ts_vec);
+    std::cout << "insert and seek " << num << " ts, generic node " << generic_cost << " us, inline node "
+              << inline_cost << " us" << std::endl;
+    generic_cost = RunPkBench<PlainSlice, PlainSliceComparator>(pks);
+    inline_cost = RunPkBench<Slice, SliceComparator>(pks);
+    std::cout << "insert and get " << num << " pks, generic node " << generic_cost
+              << " us, inline node with key prefix " << inline_cost << " us" << std::endl;
+}
+
 }  // namespace base
 }  // namespace openmldb
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "catalog/catalog_change.h"
+
+#include <snappy.h>
+
+#include <utility>
+
+#include "catalog/base.h"
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace catalog {
+
+using ::openmldb::nameserver::CatalogChange;
+
+std::string CatalogChangePath(const std::string& zk_root_path) { return zk_root_path + "/table/changes"; }
+
+std::string CatalogTablePath(const std::string& zk_root_path) { return zk_root_path + "/table/db_table_data"; }
+
+std::string CatalogProcedurePath(const std::string& zk_root_path) {
+    return zk_root_path + "/store_procedure/db_sp_data";
+}
+
+namespace {
+
+// load `node`, `*exist` is false if the node has been deleted. return false on zk errors
+bool LoadNode(::openmldb::zk::ZkClient* zk_client, const std::string& node, std::string* value, bool* exist) {
+    if (zk_client->GetNodeValue(node, *value)) {
+        *exist = true;
+        return true;
+    }
+    *exist = false;
+    return zk_client->IsExistNode(node) == 1;
+}
+
+}  // namespace
+
+bool LoadCatalogDelta(::openmldb::zk::ZkClient* zk_client, const std::string& zk_root_path, uint64_t from,
+                      uint64_t to, CatalogDelta* delta) {
+    if (from == 0 || to <= from) {
+        return false;
+    }
+    // only the last change of a node matters, the node itself holds the latest value
+    std::map<uint32_t, CatalogChange> tables;
+    std::map<std::string, CatalogChange> procedures;
+    const std::string change_path = CatalogChangePath(zk_root_path);
+    for (uint64_t version = from + 1; version <= to; version++) {
+        std::string value;
+        if (!zk_client->GetNodeValue(change_path + "/" + std::to_string(version), value)) {
+            LOG(INFO) << "change record of version " << version << " is missing";
+            return false;
+        }
+        ::openmldb::nameserver::CatalogChangeRecord record;
+        if (!record.ParseFromString(value)) {
+            LOG(WARNING) << "fail to parse change record of version " << version;
+            return false;
+        }
+        for (const auto& change : record.change()) {
+            if (change.type() == CatalogChange::kTable) {
+                tables[change.tid()] = change;
+            } else if (change.type() == CatalogChange::kProcedure) {
+                procedures[change.db() + "." + change.name()] = change;
+            }
+        }
+    }
+    const std::string table_path = CatalogTablePath(zk_root_path);
+    for (auto& kv : tables) {
+        std::string value;
+        bool exist = false;
+        if (!kv.second.deleted()) {
+            if (!LoadNode(zk_client, table_path + "/" + std::to_string(kv.first), &value, &exist)) {
+                LOG(WARNING) << "fail to get table data. tid " << kv.first;
+                return false;
+            }
+        }
+        if (!exist) {
+            kv.second.set_deleted(true);
+            delta->deleted_tables.push_back(std::move(kv.second));
+            continue;
+        }
+        ::openmldb::nameserver::TableInfo table_info;
+        if (!table_info.ParseFromString(value)) {
+            LOG(WARNING) << "fail to parse table proto. tid " << kv.first;
+            return false;
+        }
+        delta->tables.push_back(std::move(table_info));
+    }
+    const std::string sp_path = CatalogProcedurePath(zk_root_path);
+    for (auto& kv : procedures) {
+        std::string value;
+        bool exist = false;
+        if (!kv.second.deleted()) {
+            if (!LoadNode(zk_client, sp_path + "/" + kv.first, &value, &exist)) {
+                LOG(WARNING) << "fail to get procedure data. node " << kv.first;
+                return false;
+            }
+        }
+        if (!exist) {
+            kv.second.set_deleted(true);
+            delta->deleted_procedures.push_back(std::move(kv.second));
+            continue;
+        }
+        std::string uncompressed;
+        ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
+        ::openmldb::api::ProcedureInfo sp_info_pb;
+        if (!sp_info_pb.ParseFromString(uncompressed)) {
+            LOG(WARNING) << "fail to parse procedure proto. node " << kv.first;
+            return false;
+        }
+        delta->procedures.push_back(std::make_shared<ProcedureInfoImpl>(sp_info_pb));
+    }
+    return true;
+}
+
+}  // namespace catalog
+}  // namespace openmldb
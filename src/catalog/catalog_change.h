@@ -0,0 +1,59 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CATALOG_CATALOG_CHANGE_H_
+#define SRC_CATALOG_CATALOG_CHANGE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "proto/name_server.pb.h"
+#include "sdk/base.h"
+#include "zk/zk_client.h"
+
+namespace openmldb {
+namespace catalog {
+
+// the table and procedure nodes which changed between two versions of the table notify node
+struct CatalogDelta {
+    std::vector<::openmldb::nameserver::TableInfo> tables;
+    // db, name and tid of the dropped tables
+    std::vector<::openmldb::nameserver::CatalogChange> deleted_tables;
+    std::vector<std::shared_ptr<::hybridse::sdk::ProcedureInfo>> procedures;
+    // db and name of the dropped procedures
+    std::vector<::openmldb::nameserver::CatalogChange> deleted_procedures;
+
+    bool Empty() const {
+        return tables.empty() && deleted_tables.empty() && procedures.empty() && deleted_procedures.empty();
+    }
+};
+
+// paths of the catalog nodes under zk_root_path
+std::string CatalogChangePath(const std::string& zk_root_path);
+std::string CatalogTablePath(const std::string& zk_root_path);
+std::string CatalogProcedurePath(const std::string& zk_root_path);
+
+// read the change records of the versions in (from, to] and load the nodes they name.
+// return false if a record is missing or unreadable, the caller has to do a full refresh then
+bool LoadCatalogDelta(::openmldb::zk::ZkClient* zk_client, const std::string& zk_root_path, uint64_t from,
+                      uint64_t to, CatalogDelta* delta);
+
+}  // namespace catalog
+}  // namespace openmldb
+
+#endif  // SRC_CATALOG_CATALOG_CHANGE_H_
@@ -154,6 +154,45 @@ bool SDKCatalog::Init(const std::vector<::openmldb::nameserver::TableInfo>& tabl
     return true;
 }
 
+bool SDKCatalog::Init(const SDKCatalog& base, const CatalogDelta& delta) {
+    tables_ = base.tables_;
+    db_sp_map_ = base.db_sp_map_;
+    for (const auto& change : delta.deleted_tables) {
+        auto db_it = tables_.find(change.db());
+        if (db_it == tables_.end()) {
+            continue;
+        }
+        auto it = db_it->second.find(change.name());
+        if (it != db_it->second.end() && it->second->GetTid() == change.tid()) {
+            db_it->second.erase(it);
+            if (db_it->second.empty()) {
+                tables_.erase(db_it);
+            }
+        }
+    }
+    for (const auto& table_meta : delta.tables) {
+        auto table = std::make_shared<SDKTableHandler>(table_meta, *client_manager_);
+        if (!table->Init()) {
+            LOG(WARNING) << "fail to init table " << table_meta.name();
+            return false;
+        }
+        tables_[table->GetDatabase()][table->GetName()] = table;
+    }
+    for (const auto& change : delta.deleted_procedures) {
+        auto db_it = db_sp_map_.find(change.db());
+        if (db_it != db_sp_map_.end()) {
+            db_it->second.erase(change.name());
+            if (db_it->second.empty()) {
+                db_sp_map_.erase(db_it);
+            }
+        }
+    }
+    for (const auto& sp_info : delta.procedures) {
+        db_sp_map_[sp_info->GetDbName()][sp_info->GetSpName()] = sp_info;
+    }
+    return true;
+}
+
 std::shared_ptr<::hybridse::vm::TableHandler> SDKCatalog::GetTable(const std::string& db,
                                                                    const std::string& table_name) {
     auto db_it = tables_.find(db);
@@ -26,6 +26,7 @@
 
 #include "base/spinlock.h"
 #include "catalog/base.h"
+#include "catalog/catalog_change.h"
 #include "catalog/client_manager.h"
 #include "client/tablet_client.h"
 #include "proto/name_server.pb.h"
@@ -121,6 +122,9 @@ class SDKCatalog : public ::hybridse::vm::Catalog {
 
     bool Init(const std::vector<::openmldb::nameserver::TableInfo>& tables, const Procedures& db_sp_map);
 
+    // copy `base` and apply `delta`, the handlers of unchanged tables are shared with `base`
+    bool Init(const SDKCatalog& base, const CatalogDelta& delta);
+
     std::shared_ptr<::hybridse::type::Database> GetDatabase(const std::string& db) override {
         return std::shared_ptr<::hybridse::type::Database>();
     }
@@ -121,6 +121,46 @@ TEST_F(SDKCatalogTest, SdkLastjoinSmokeTest) {
     std::cout << ss.str() << std::endl;*/
 }
 
+TEST_F(SDKCatalogTest, InitWithDelta) {
+    TestArgs* args = PrepareTable("t1", "db1");
+    args->meta.set_tid(1);
+    TestArgs* args2 = PrepareTable("t2", "db1");
+    args2->meta.set_tid(2);
+    std::vector<::openmldb::nameserver::TableInfo> tables = {args->meta, args2->meta};
+    auto client_manager = std::make_shared<ClientManager>();
+    SDKCatalog base(client_manager);
+    ASSERT_TRUE(base.Init(tables, Procedures()));
+
+    CatalogDelta delta;
+    // t1 is recreated with a new tid, the drop of the old tid comes later and must not remove it
+    args->meta.set_tid(3);
+    delta.tables.push_back(args->meta);
+    ::openmldb::nameserver::CatalogChange change;
+    change.set_type(::openmldb::nameserver::CatalogChange::kTable);
+    change.set_db("db1");
+    change.set_name("t1");
+    change.set_tid(1);
+    change.set_deleted(true);
+    delta.deleted_tables.push_back(change);
+    change.set_name("t2");
+    change.set_tid(2);
+    delta.deleted_tables.push_back(change);
+    TestArgs* args3 = PrepareTable("t3", "db2");
+    args3->meta.set_tid(4);
+    delta.tables.push_back(args3->meta);
+
+    SDKCatalog catalog(client_manager);
+    ASSERT_TRUE(catalog.Init(base, delta));
+    auto t1 = std::dynamic_pointer_cast<SDKTableHandler>(catalog.GetTable("db1", "t1"));
+    ASSERT_TRUE(t1);
+    ASSERT_EQ(3u, t1->GetTid());
+    ASSERT_FALSE(catalog.GetTable("db1", "t2"));
+    ASSERT_TRUE(catalog.GetTable("db2", "t3"));
+    // the base catalog is untouched
+    ASSERT_TRUE(base.GetTable("db1", "t2"));
+    ASSERT_FALSE(base.GetTable("db2", "t3"));
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
@@ -568,6 +568,26 @@ bool TabletCatalog::UpdateClient(const std::map<std::string, std::string>& real_
 
 uint64_t TabletCatalog::GetVersion() const { return version_.load(std::memory_order_relaxed); }
 
+void TabletCatalog::SetVersion(uint64_t version) { version_.store(version, std::memory_order_relaxed); }
+
+bool TabletCatalog::RemoveTable(const std::string& db, const std::string& table_name, uint32_t tid) {
+    std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
+    auto db_it = tables_.find(db);
+    if (db_it == tables_.end()) {
+        return false;
+    }
+    auto it = db_it->second.find(table_name);
+    if (it == db_it->second.end() || it->second->GetTid() != tid || it->second->HasLocalTable()) {
+        return false;
+    }
+    LOG(INFO) << "delete table from catalog. db: " << db << ", table: " << table_name;
+    db_it->second.erase(it);
+    if (db_it->second.empty()) {
+        tables_.erase(db_it);
+    }
+    return true;
+}
+
 std::shared_ptr<::hybridse::sdk::ProcedureInfo> TabletCatalog::GetProcedureInfo(const std::string& db,
                                                                                 const std::string& sp_name) {
     std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
@@ -240,6 +240,11 @@ class TabletCatalog : public ::hybridse::vm::Catalog {
     void Refresh(const std::vector<::openmldb::nameserver::TableInfo> &table_info_vec, uint64_t version,
                  const Procedures &db_sp_map, bool* updated);
 
+    // drop the table refreshed from zk if it is still the one with `tid` and has no local partition
+    bool RemoveTable(const std::string &db, const std::string &table_name, uint32_t tid);
+
+    void SetVersion(uint64_t version);
+
     bool AddProcedure(const std::string &db, const std::string &sp_name,
                       const std::shared_ptr<hybridse::sdk::ProcedureInfo> &sp_info);
 
@@ -17,6 +17,9 @@
 #include "catalog/tablet_catalog.h"
 
 #include <absl/strings/str_cat.h>
+
+#include <algorithm>
+#include <sstream>
 #include <vector>
 
 #include "base/fe_status.h"
@@ -1021,6 +1024,115 @@ TEST_F(TabletCatalogTest, long_window_equal_test) {
     }
 }
 
+// buckets aligned to `width` as the aggregator flushes them, only complete buckets are kept
+TestArgs PrepareAlignedAggTable(const std::string &tname, int num_pk, uint64_t num_ts, int64_t width) {
+    TestArgs args;
+    ::openmldb::api::TableMeta meta;
+    meta.set_name(tname);
+    meta.set_db("aggr_db");
+    meta.set_tid(2);
+    meta.set_pid(0);
+    meta.set_seg_cnt(8);
+    meta.add_table_partition();
+    meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "key", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_start", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_end", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "num_rows", openmldb::type::DataType::kInt);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "agg_val", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "binlog_offset", openmldb::type::DataType::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "index0", "key", "ts_start", ::openmldb::type::kAbsoluteTime, 0, 0);
+
+    ::openmldb::storage::MemTable *table = new ::openmldb::storage::MemTable(meta);
+    table->Init();
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(meta.column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    for (int i = 0; i < num_pk; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        for (int64_t ts_start = 0; ts_start + width - 1 <= static_cast<int64_t>(num_ts); ts_start += width) {
+            int64_t ts_end = ts_start + width - 1;
+            int64_t sum = 0;
+            int32_t count = 0;
+            for (int64_t ts = std::max<int64_t>(ts_start, 1); ts <= ts_end; ts++) {
+                sum += ts;
+                count++;
+            }
+            std::string value;
+            uint32_t size = rb.CalTotalLength(pk.size() + sizeof(int64_t));
+            value.resize(size);
+            rb.SetBuffer(reinterpret_cast<int8_t *>(&(value[0])), size);
+            rb.AppendString(pk.c_str(), pk.size());
+            rb.AppendTimestamp(ts_start);
+            rb.AppendTimestamp(ts_end);
+            rb.AppendInt32(count);
+            rb.AppendString(reinterpret_cast<const char *>(&sum), sizeof(int64_t));
+            rb.AppendInt64(i * num_ts + ts_end);
+            table->Put(pk, ts_start, value.c_str(), value.size());
+        }
+    }
+    args.tables.push_back(std::shared_ptr<::openmldb::storage::MemTable>(table));
+    args.meta.push_back(meta);
+    return args;
+}
+
+TEST_F(TabletCatalogTest, long_window_multi_level_test) {
+    std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
+    ASSERT_TRUE(catalog->Init());
+    int num_pk = 2, num_ts = 1000;
+
+    TestArgs args = PrepareTable("t1", num_pk, num_ts);
+    ASSERT_TRUE(catalog->AddTable(args.meta[0], args.tables[0]));
+    // the finest level keeps the meta info, the coarser one is named by its bucket size
+    TestArgs level0 = PrepareAlignedAggTable("aggr_t1", num_pk, num_ts, 10);
+    ASSERT_TRUE(catalog->AddTable(level0.meta[0], level0.tables[0]));
+    TestArgs level1 = PrepareAlignedAggTable("aggr_t1_100", num_pk, num_ts, 100);
+    ASSERT_TRUE(catalog->AddTable(level1.meta[0], level1.tables[0]));
+    ::hybridse::vm::AggrTableInfo info = {"aggr_t1", "aggr_db", "db1", "t1", "sum", "col2", "col1", "col2", "10|100"};
+    catalog->RefreshAggrTables({info});
+
+    ::hybridse::vm::Engine engine(catalog);
+    auto options = std::make_shared<std::unordered_map<std::string, std::string>>();
+    (*options)[::hybridse::vm::LONG_WINDOWS] = "w1";
+    ::hybridse::vm::RequestRunSession session_lw;
+    session_lw.SetOptions(options);
+    ::hybridse::vm::RequestRunSession session;
+    ::hybridse::codec::Row request_row(::hybridse::base::RefCountedSlice::Create(args.row.c_str(), args.row.size()));
+
+    std::vector<std::string> excludes = {"", "EXCLUDE CURRENT_TIME"};
+    // ranges inside one fine bucket, across fine buckets only and across both levels
+    std::vector<int> ranges = {5, 37, 150, 555, 999, 2000};
+    for (const auto &exclude : excludes) {
+        for (int range : ranges) {
+            std::string sql = absl::StrCat(
+                "SELECT col1, sum(col2) OVER w1 FROM t1 "
+                "WINDOW w1 AS (PARTITION BY col1 ORDER BY col2 ROWS_RANGE BETWEEN ",
+                range, " PRECEDING AND CURRENT ROW ", exclude, ");");
+            ::hybridse::base::Status status;
+            ASSERT_TRUE(engine.Get(sql, "db1", session, status)) << status.msg;
+            hybridse::codec::Row output;
+            ASSERT_EQ(0, session.Run(request_row, &output));
+
+            ASSERT_TRUE(engine.Get(sql, "db1", session_lw, status)) << status.msg;
+            std::ostringstream plan;
+            session_lw.GetCompileInfo()->DumpPhysicalPlan(plan, "\t");
+            ASSERT_NE(std::string::npos, plan.str().find("table=aggr_t1_100")) << plan.str();
+            hybridse::codec::Row output_lw;
+            ASSERT_EQ(0, session_lw.Run(request_row, &output_lw));
+
+            ::hybridse::codec::RowView rv(session.GetSchema());
+            ::hybridse::codec::RowView rv_lw(session_lw.GetSchema());
+            rv.Reset(output.buf(), output.size());
+            rv_lw.Reset(output_lw.buf(), output_lw.size());
+            int64_t val = 0, val_lw = 0;
+            ASSERT_EQ(0, rv.GetInt64(1, &val));
+            ASSERT_EQ(0, rv_lw.GetInt64(1, &val_lw));
+            ASSERT_EQ(val, val_lw) << sql;
+        }
+    }
+}
+
 template <class T>
 void CheckAggResult(::hybridse::vm::Engine* engine, ::hybridse::vm::RequestRunSession session,
                     const hybridse::codec::Row &request_row, const std::string &col, T exp) {
@@ -71,13 +71,15 @@ bool TabletClient::Query(const std::string& db, const std::string& sql, const st
 bool TabletClient::Query(const std::string& db, const std::string& sql,
                          const std::vector<openmldb::type::DataType>& parameter_types,
                          const std::string& parameter_row,
-                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug) {
+                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug,
+                         ::openmldb::api::ResultFormat result_format) {
     if (cntl == NULL || response == NULL) return false;
     ::openmldb::api::QueryRequest request;
     request.set_sql(sql);
     request.set_db(db);
     request.set_is_batch(true);
     request.set_is_debug(is_debug);
+    request.set_result_format(result_format);
     request.set_parameter_row_size(parameter_row.size());
     request.set_parameter_row_slices(1);
     for (auto& type : parameter_types) {
@@ -97,6 +99,20 @@ bool TabletClient::Query(const std::string& db, const std::string& sql,
     return true;
 }
 
+bool TabletClient::FetchColumnarResult(uint64_t result_id, brpc::Controller* cntl,
+                                       ::openmldb::api::QueryResponse* response) {
+    if (cntl == NULL || response == NULL) return false;
+    ::openmldb::api::QueryRequest request;
+    request.set_is_batch(true);
+    request.set_result_id(result_id);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Query, cntl, &request, response);
+    if (!ok || response->code() != 0) {
+        LOG(WARNING) << "fail to fetch columnar result " << result_id;
+        return false;
+    }
+    return true;
+}
+
 /**
  * Utility function to encode row batch data into rpc attachment buffer
  */
@@ -1128,6 +1144,25 @@ bool TabletClient::Scan(const ::openmldb::api::ScanRequest& request, brpc::Contr
     return true;
 }
 
+bool TabletClient::MultiScan(const ::openmldb::api::MultiScanRequest& request, brpc::Controller* cntl,
+                             ::openmldb::api::MultiScanResponse* response) {
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::MultiScan, cntl, &request, response);
+    if (!ok || response->code() != 0) {
+        LOG(WARNING) << "fail to multi scan table with tid " << request.tid();
+        return false;
+    }
+    return true;
+}
+
+bool TabletClient::AsyncMultiScan(const ::openmldb::api::MultiScanRequest& request,
+                                  openmldb::RpcCallback<openmldb::api::MultiScanResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::MultiScan, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::CallProcedure(const std::string& db, const std::string& sp_name, const base::Slice& row,
                                  brpc::Controller* cntl, openmldb::api::QueryResponse* response, bool is_debug,
                                  uint64_t timeout_ms) {
@@ -63,11 +63,15 @@ class TabletClient : public Client {
 
     bool Query(const std::string& db, const std::string& sql,
                const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
-               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false);
+               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false,
+               ::openmldb::api::ResultFormat result_format = ::openmldb::api::kRowResult);
 
     bool Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
                ::openmldb::api::QueryResponse* response, const bool is_debug = false);
 
+    // fetch the next chunk of a columnar batch query result kept by the tablet
+    bool FetchColumnarResult(uint64_t result_id, brpc::Controller* cntl, ::openmldb::api::QueryResponse* response);
+
     bool SQLBatchRequestQuery(const std::string& db, const std::string& sql,
                               std::shared_ptr<::openmldb::sdk::SQLRequestRowBatch>, brpc::Controller* cntl,
                               ::openmldb::api::SQLBatchRequestQueryResponse* response, const bool is_debug = false);
@@ -115,6 +119,12 @@ class TabletClient : public Client {
     bool AsyncScan(const ::openmldb::api::ScanRequest& request,
                    openmldb::RpcCallback<openmldb::api::ScanResponse>* callback);
 
+    bool MultiScan(const ::openmldb::api::MultiScanRequest& request, brpc::Controller* cntl,
+                   ::openmldb::api::MultiScanResponse* response);
+
+    bool AsyncMultiScan(const ::openmldb::api::MultiScanRequest& request,
+                        openmldb::RpcCallback<openmldb::api::MultiScanResponse>* callback);
+
     bool GetTableSchema(uint32_t tid, uint32_t pid,
                         ::openmldb::api::TableMeta& table_meta);  // NOLINT
 
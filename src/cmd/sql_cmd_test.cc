@@ -459,6 +459,20 @@ TEST_F(SqlCmdTest, TableReader) {
     int32_t val2 = 0;
     result_set->GetInt32(2, &val2);
     ASSERT_EQ(10, val2);
+
+    sql = "insert into " + name + " values('key2', 2, '2', '2021-01-01', 20);";
+    ASSERT_TRUE(sr->ExecuteInsert(db_name, sql, &status));
+    auto result_sets = reader->MultiScan(db_name, name, {"key2", "key3", "key1"}, 0, 0, option, 1000, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_EQ(3u, result_sets.size());
+    ASSERT_EQ(1, result_sets[0]->Size());
+    ASSERT_TRUE(result_sets[0]->Next());
+    result_sets[0]->GetInt32(2, &val2);
+    ASSERT_EQ(20, val2);
+    ASSERT_EQ(0, result_sets[1]->Size());
+    ASSERT_TRUE(result_sets[2]->Next());
+    result_sets[2]->GetString(0, &val);
+    ASSERT_EQ("key1", val);
     ProcessSQLs(sr, {absl::StrCat("drop table ", name, ";"), absl::StrCat("drop database ", db_name, ";")});
 }
 
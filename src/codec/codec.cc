@@ -18,7 +18,6 @@
 
 #include <algorithm>
 #include <array>
-#include <unordered_set>
 
 #include "base/glog_wrapper.h"
 #include "boost/lexical_cast.hpp"
@@ -28,11 +27,6 @@ namespace codec {
 
 #define BitMapSize(size) (((size) >> 3) + !!((size)&0x07))
 
-static const std::unordered_set<::openmldb::type::DataType> TYPE_SET(
-    {::openmldb::type::kBool, ::openmldb::type::kSmallInt, ::openmldb::type::kInt, ::openmldb::type::kBigInt,
-     ::openmldb::type::kFloat, ::openmldb::type::kDouble, ::openmldb::type::kDate, ::openmldb::type::kTimestamp,
-     ::openmldb::type::kVarchar, ::openmldb::type::kString});
-
 static constexpr std::array<uint32_t, 9> TYPE_SIZE_ARRAY = {
     0,
     sizeof(bool),     // kBool
@@ -57,6 +51,49 @@ static inline uint8_t GetAddrLength(uint32_t size) {
     }
 }
 
+static inline bool IsStringType(::openmldb::type::DataType type) {
+    return type == ::openmldb::type::kVarchar || type == ::openmldb::type::kString;
+}
+
+static inline bool IsFieldNull(const int8_t* row, uint32_t idx) {
+    return *(reinterpret_cast<const uint8_t*>(row + HEADER_LENGTH + (idx >> 3))) & (1 << (idx & 0x07));
+}
+
+// fill the value offset of fixed size columns and the string slot of string columns in column order,
+// return the offset where the string addresses start or 0 if a column type is not supported
+static uint32_t CalColumnOffsets(const Schema& schema, std::vector<uint32_t>* offsets, uint32_t* str_field_cnt) {
+    uint32_t offset = HEADER_LENGTH + BitMapSize(schema.size());
+    *str_field_cnt = 0;
+    offsets->clear();
+    offsets->reserve(schema.size());
+    for (const auto& column : schema) {
+        ::openmldb::type::DataType cur_type = column.data_type();
+        if (IsStringType(cur_type)) {
+            offsets->push_back((*str_field_cnt)++);
+        } else if (cur_type < TYPE_SIZE_ARRAY.size() && cur_type > 0) {
+            offsets->push_back(offset);
+            offset += TYPE_SIZE_ARRAY[cur_type];
+        } else {
+            return 0;
+        }
+    }
+    return offset;
+}
+
+static inline void SetStrAddr(int8_t* ptr, uint8_t str_addr_length, uint32_t str_offset) {
+    if (str_addr_length == 1) {
+        *(reinterpret_cast<uint8_t*>(ptr)) = (uint8_t)str_offset;
+    } else if (str_addr_length == 2) {
+        *(reinterpret_cast<uint16_t*>(ptr)) = (uint16_t)str_offset;
+    } else if (str_addr_length == 3) {
+        *(reinterpret_cast<uint8_t*>(ptr)) = str_offset >> 16;
+        *(reinterpret_cast<uint8_t*>(ptr + 1)) = (str_offset & 0xFF00) >> 8;
+        *(reinterpret_cast<uint8_t*>(ptr + 2)) = str_offset & 0x00FF;
+    } else {
+        *(reinterpret_cast<uint32_t*>(ptr)) = str_offset;
+    }
+}
+
 RowBuilder::RowBuilder(const Schema& schema)
     : schema_(schema),
       buf_(NULL),
@@ -67,21 +104,13 @@ RowBuilder::RowBuilder(const Schema& schema)
       str_field_start_offset_(0),
       str_offset_(0),
       schema_version_(1) {
-    str_field_start_offset_ = HEADER_LENGTH + BitMapSize(schema.size());
-    for (int idx = 0; idx < schema.size(); idx++) {
-        const ::openmldb::common::ColumnDesc& column = schema.Get(idx);
-        openmldb::type::DataType cur_type = column.data_type();
-        if (cur_type == ::openmldb::type::kVarchar || cur_type == ::openmldb::type::kString) {
-            offset_vec_.push_back(str_field_cnt_);
-            str_field_cnt_++;
-        } else {
-            if (cur_type < TYPE_SIZE_ARRAY.size() && cur_type > 0) {
-                offset_vec_.push_back(str_field_start_offset_);
-                str_field_start_offset_ += TYPE_SIZE_ARRAY[cur_type];
-            } else {
-                PDLOG(WARNING, "type is not supported");
-            }
-        }
+    str_field_start_offset_ = CalColumnOffsets(schema, &offset_vec_, &str_field_cnt_);
+    if (str_field_start_offset_ == 0) {
+        PDLOG(WARNING, "type is not supported");
+    }
+    types_.reserve(schema.size());
+    for (const auto& column : schema) {
+        types_.push_back(column.data_type());
     }
 }
 
@@ -131,17 +160,7 @@ uint32_t RowBuilder::CalTotalLength(uint32_t string_length) {
 }
 
 bool RowBuilder::Check(uint32_t index, ::openmldb::type::DataType type) {
-    if ((int32_t)index >= schema_.size()) {
-        return false;
-    }
-    const ::openmldb::common::ColumnDesc& column = schema_.Get(index);
-    if (column.data_type() != type) {
-        return false;
-    }
-    if (TYPE_SET.find(column.data_type()) == TYPE_SET.end()) {
-        return false;
-    }
-    return true;
+    return index < types_.size() && types_[index] == type && str_field_start_offset_ > 0;
 }
 
 bool RowBuilder::AppendDate(int32_t date) {
@@ -210,7 +229,7 @@ bool RowBuilder::SetNULL(uint32_t index) {
     if (column.not_null()) return false;
     int8_t* ptr = buf_ + HEADER_LENGTH + (index >> 3);
     *(reinterpret_cast<uint8_t*>(ptr)) |= 1 << (index & 0x07);
-    if (column.data_type() == ::openmldb::type::kVarchar || column.data_type() == openmldb::type::kString) {
+    if (IsStringType(types_[index])) {
         uint32_t str_pos = offset_vec_[index];
         SetStrOffset(str_pos + 1);
     }
@@ -222,7 +241,7 @@ bool RowBuilder::SetNULL(int8_t* buf, uint32_t size, uint32_t index) {
     if (column.not_null()) return false;
     int8_t* ptr = buf + HEADER_LENGTH + (index >> 3);
     *(reinterpret_cast<uint8_t*>(ptr)) |= 1 << (index & 0x07);
-    if (column.data_type() == ::openmldb::type::kVarchar || column.data_type() == openmldb::type::kString) {
+    if (IsStringType(types_[index])) {
         uint32_t str_offset = 0;
         uint32_t str_pos = offset_vec_[index];
         auto str_addr_length = GetAddrLength(size);
@@ -245,18 +264,7 @@ void RowBuilder::SetStrOffset(int8_t* buf, uint32_t size, uint32_t str_pos, uint
         return;
     }
     auto str_addr_length = GetAddrLength(size);
-    int8_t* ptr = buf + str_field_start_offset_ + str_addr_length * str_pos;
-    if (str_addr_length == 1) {
-        *(reinterpret_cast<uint8_t*>(ptr)) = (uint8_t)str_offset;
-    } else if (str_addr_length == 2) {
-        *(reinterpret_cast<uint16_t*>(ptr)) = (uint16_t)str_offset;
-    } else if (str_addr_length == 3) {
-        *(reinterpret_cast<uint8_t*>(ptr)) = str_offset >> 16;
-        *(reinterpret_cast<uint8_t*>(ptr + 1)) = (str_offset & 0xFF00) >> 8;
-        *(reinterpret_cast<uint8_t*>(ptr + 2)) = str_offset & 0x00FF;
-    } else {
-        *(reinterpret_cast<uint32_t*>(ptr)) = str_offset;
-    }
+    SetStrAddr(buf + str_field_start_offset_ + str_addr_length * str_pos, str_addr_length, str_offset);
 }
 
 bool RowBuilder::GetStrOffset(int8_t* buf, uint32_t size, uint32_t str_pos, uint32_t* offset) {
@@ -400,7 +408,7 @@ bool RowBuilder::AppendString(const char* val, uint32_t length) {
 }
 
 bool RowBuilder::SetString(uint32_t index, const char* val, uint32_t length) {
-    if (val == NULL || (!Check(index, ::openmldb::type::kVarchar) && !Check(index, openmldb::type::kString))) {
+    if (val == NULL || index >= types_.size() || !IsStringType(types_[index])) {
         return false;
     }
     if (str_offset_ + length > size_) return false;
@@ -418,7 +426,7 @@ bool RowBuilder::SetString(uint32_t index, const char* val, uint32_t length) {
 }
 
 bool RowBuilder::SetString(int8_t* buf, uint32_t size, uint32_t index, const char* val, uint32_t length) {
-    if (val == NULL || (!Check(index, ::openmldb::type::kVarchar) && !Check(index, openmldb::type::kString))) {
+    if (val == NULL || index >= types_.size() || !IsStringType(types_[index])) {
         return false;
     }
     uint32_t str_offset = 0;
@@ -444,9 +452,11 @@ bool RowBuilder::SetString(int8_t* buf, uint32_t size, uint32_t index, const cha
 
 bool RowBuilder::AppendValue(const std::string& val) {
     bool ok = false;
-    const ::openmldb::common::ColumnDesc& col = schema_.Get(cnt_);
+    if (cnt_ >= types_.size()) {
+        return false;
+    }
     try {
-        switch (col.data_type()) {
+        switch (types_[cnt_]) {
             case openmldb::type::kString:
             case openmldb::type::kVarchar:
                 ok = AppendString(val.c_str(), val.length());
@@ -511,7 +521,8 @@ RowView::RowView(const Schema& schema)
       size_(0),
       row_(NULL),
       schema_(schema),
-      offset_vec_() {
+      offset_vec_(),
+      types_() {
     Init();
 }
 
@@ -523,7 +534,8 @@ RowView::RowView(const Schema& schema, const int8_t* row, uint32_t size)
       size_(size),
       row_(row),
       schema_(schema),
-      offset_vec_() {
+      offset_vec_(),
+      types_() {
     if (schema_.size() == 0) {
         is_valid_ = false;
         return;
@@ -534,24 +546,15 @@ RowView::RowView(const Schema& schema, const int8_t* row, uint32_t size)
 }
 
 bool RowView::Init() {
-    uint32_t offset = HEADER_LENGTH + BitMapSize(schema_.size());
-    for (int idx = 0; idx < schema_.size(); idx++) {
-        const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
-        openmldb::type::DataType cur_type = column.data_type();
-        if (cur_type == ::openmldb::type::kVarchar || cur_type == ::openmldb::type::kString) {
-            offset_vec_.push_back(string_field_cnt_);
-            string_field_cnt_++;
-        } else {
-            if (cur_type < TYPE_SIZE_ARRAY.size() && cur_type > 0) {
-                offset_vec_.push_back(offset);
-                offset += TYPE_SIZE_ARRAY[cur_type];
-            } else {
-                is_valid_ = false;
-                return false;
-            }
-        }
+    str_field_start_offset_ = CalColumnOffsets(schema_, &offset_vec_, &string_field_cnt_);
+    if (str_field_start_offset_ == 0) {
+        is_valid_ = false;
+        return false;
+    }
+    types_.reserve(schema_.size());
+    for (const auto& column : schema_) {
+        types_.push_back(column.data_type());
     }
-    str_field_start_offset_ = offset;
     return true;
 }
 
@@ -583,17 +586,7 @@ bool RowView::Reset(const int8_t* row) {
 }
 
 bool RowView::CheckValid(uint32_t idx, ::openmldb::type::DataType type) const {
-    if (row_ == NULL || !is_valid_) {
-        return false;
-    }
-    if ((int32_t)idx >= schema_.size()) {
-        return false;
-    }
-    const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
-    if (column.data_type() != type) {
-        return false;
-    }
-    return true;
+    return row_ != NULL && is_valid_ && idx < types_.size() && types_[idx] == type;
 }
 
 int32_t RowView::GetBool(uint32_t idx, bool* val) const {
@@ -769,14 +762,7 @@ int32_t RowView::GetInteger(const int8_t* row, uint32_t idx, ::openmldb::type::D
 }
 
 int32_t RowView::GetValue(const int8_t* row, uint32_t idx, ::openmldb::type::DataType type, void* val) const {
-    if (schema_.size() == 0 || row == NULL) {
-        return -1;
-    }
-    if ((int32_t)idx >= schema_.size()) {
-        return -1;
-    }
-    const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
-    if (column.data_type() != type) {
+    if (row == NULL || idx >= types_.size() || types_[idx] != type) {
         return -1;
     }
     if (GetSize(row) <= HEADER_LENGTH) {
@@ -822,14 +808,7 @@ int32_t RowView::GetValue(const int8_t* row, uint32_t idx, ::openmldb::type::Dat
 }
 
 int32_t RowView::GetValue(const int8_t* row, uint32_t idx, char** val, uint32_t* length) const {
-    if (schema_.size() == 0 || row == NULL || length == NULL) {
-        return -1;
-    }
-    if ((int32_t)idx >= schema_.size()) {
-        return -1;
-    }
-    const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
-    if (column.data_type() != ::openmldb::type::kVarchar && column.data_type() != ::openmldb::type::kString) {
+    if (row == NULL || length == NULL || idx >= types_.size() || !IsStringType(types_[idx])) {
         return -1;
     }
     uint32_t size = GetSize(row);
@@ -853,7 +832,7 @@ int32_t RowView::GetString(uint32_t idx, char** val, uint32_t* length) const {
         return -1;
     }
 
-    if (!CheckValid(idx, ::openmldb::type::kVarchar) && !CheckValid(idx, openmldb::type::kString)) {
+    if (row_ == NULL || !is_valid_ || idx >= types_.size() || !IsStringType(types_[idx])) {
         return -1;
     }
     if (IsNULL(row_, idx)) {
@@ -871,13 +850,9 @@ int32_t RowView::GetString(uint32_t idx, char** val, uint32_t* length) const {
 int32_t RowView::GetStrValue(uint32_t idx, std::string* val) const { return GetStrValue(row_, idx, val); }
 
 int32_t RowView::GetStrValue(const int8_t* row, uint32_t idx, std::string* val) const {
-    if (schema_.size() == 0 || row == NULL) {
-        return -1;
-    }
-    if ((int32_t)idx >= schema_.size()) {
+    if (row == NULL || idx >= types_.size()) {
         return -1;
     }
-    const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
     if (GetSize(row) <= HEADER_LENGTH) {
         return -1;
     }
@@ -885,7 +860,7 @@ int32_t RowView::GetStrValue(const int8_t* row, uint32_t idx, std::string* val)
         val->assign("null");
         return 1;
     }
-    switch (column.data_type()) {
+    switch (types_[idx]) {
         case ::openmldb::type::kBool: {
             bool value = false;
             GetValue(row, idx, ::openmldb::type::kBool, &value);
@@ -897,7 +872,7 @@ int32_t RowView::GetStrValue(const int8_t* row, uint32_t idx, std::string* val)
         case ::openmldb::type::kTimestamp:
         case ::openmldb::type::kBigInt: {
             int64_t value = 0;
-            GetInteger(row, idx, column.data_type(), &value);
+            GetInteger(row, idx, types_[idx], &value);
             val->assign(std::to_string(value));
             break;
         }
@@ -1008,11 +983,15 @@ RowProject::RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_sc
     : plist_(plist),
       output_schema_(),
       row_builder_(NULL),
-      cur_rv_(nullptr),
       max_idx_(0),
-      vers_views_(),
+      vers_plans_(),
       vers_schema_(vers_schema),
-      cur_ver_(1) {}
+      cur_plan_(nullptr),
+      cur_ver_(1),
+      out_offsets_(),
+      out_str_cnt_(0),
+      out_str_start_(0),
+      str_fields_() {}
 
 RowProject::~RowProject() { delete row_builder_; }
 
@@ -1027,127 +1006,107 @@ bool RowProject::Init() {
             max_idx_ = idx;
         }
     }
+    // resolve the projected columns of every schema version once, Project only copies bytes then
     for (const auto& sch : vers_schema_) {
         if (max_idx_ >= static_cast<uint32_t>(sch.second->size())) {
             continue;
         }
-        std::shared_ptr<RowView> rv = std::make_shared<RowView>(*sch.second);
-        vers_views_.insert(std::make_pair(sch.first, rv));
+        std::vector<uint32_t> offsets;
+        uint32_t str_cnt = 0;
+        ProjectPlan plan;
+        plan.str_field_start_offset = CalColumnOffsets(*sch.second, &offsets, &str_cnt);
+        if (plan.str_field_start_offset == 0) {
+            continue;
+        }
+        for (int32_t i = 0; i < plist_.size(); i++) {
+            uint32_t idx = plist_.Get(i);
+            ProjectColumn column{idx, sch.second->Get(idx).data_type(), offsets[idx], 0};
+            if (IsStringType(column.type) && column.offset + 1 < str_cnt) {
+                column.next_slot = column.offset + 1;
+            }
+            plan.columns.push_back(column);
+        }
+        vers_plans_.emplace(sch.first, std::move(plan));
     }
-    if (vers_views_.empty()) {
+    if (vers_plans_.empty()) {
         LOG(WARNING) << "empty row views";
         return false;
     }
-    const auto it = vers_views_.begin();
-    cur_schema_ = vers_schema_.find(it->first)->second;
-    cur_rv_ = it->second;
+    const auto it = vers_plans_.begin();
+    cur_ver_ = it->first;
+    cur_plan_ = &it->second;
+    const auto& cur_schema = vers_schema_.find(it->first)->second;
     for (int32_t i = 0; i < plist_.size(); i++) {
         uint32_t idx = plist_.Get(i);
-        const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
+        const ::openmldb::common::ColumnDesc& column = cur_schema->Get(idx);
         output_schema_.Add()->CopyFrom(column);
     }
     row_builder_ = new RowBuilder(output_schema_);
+    out_str_start_ = CalColumnOffsets(output_schema_, &out_offsets_, &out_str_cnt_);
+    str_fields_.resize(plist_.size());
     return true;
 }
 
 bool RowProject::Project(const int8_t* row_ptr, uint32_t size, int8_t** output_ptr, uint32_t* out_size) {
     if (row_ptr == NULL || output_ptr == NULL || out_size == NULL) return false;
+    if (size <= HEADER_LENGTH || RowView::GetSize(row_ptr) != size) return false;
     uint8_t version = openmldb::codec::RowView::GetSchemaVersion(row_ptr);
     if (version != cur_ver_) {
-        auto it = vers_views_.find(version);
-        if (it == vers_views_.end()) {
+        auto it = vers_plans_.find(version);
+        if (it == vers_plans_.end()) {
             LOG(WARNING) << "not found valid row view for ver " << unsigned(version);
             return false;
         }
-        cur_rv_ = it->second;
+        cur_plan_ = &it->second;
         cur_ver_ = version;
-        cur_schema_ = vers_schema_.find(version)->second;
     }
-    bool ok = cur_rv_->Reset(row_ptr, size);
-    if (!ok) return false;
+    const auto& columns = cur_plan_->columns;
+    uint8_t addr_length = GetAddrLength(size);
     uint32_t str_size = 0;
-    for (int32_t i = 0; i < plist_.size(); i++) {
-        uint32_t idx = plist_.Get(i);
-        const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
-        if (column.data_type() == ::openmldb::type::kVarchar || column.data_type() == ::openmldb::type::kString) {
-            if (cur_rv_->IsNULL(idx)) continue;
-            uint32_t length = 0;
-            char* content = nullptr;
-            int32_t ret = cur_rv_->GetString(idx, &content, &length);
-            if (ret != 0) {
-                return false;
-            }
-            str_size += length;
+    for (uint32_t i = 0; i < columns.size(); i++) {
+        const auto& column = columns[i];
+        if (!IsStringType(column.type)) {
+            continue;
+        }
+        auto& field = str_fields_[i];
+        field.second = 0;
+        if (IsFieldNull(row_ptr, column.idx)) {
+            continue;
+        }
+        if (v1::GetStrField(row_ptr, column.offset, column.next_slot, cur_plan_->str_field_start_offset, addr_length,
+                            &field.first, &field.second) != 0 ||
+            field.first + field.second > row_ptr + size) {
+            PDLOG(WARNING, "fail to project column with idx %u", column.idx);
+            return false;
         }
+        str_size += field.second;
     }
     uint32_t total_size = row_builder_->CalTotalLength(str_size);
-    char* ptr = new char[total_size];
-    row_builder_->SetBuffer(reinterpret_cast<int8_t*>(ptr), total_size);
-    for (int32_t i = 0; i < plist_.size(); i++) {
-        uint32_t idx = plist_.Get(i);
-        const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
-        bool ret = false;
-        if (cur_rv_->IsNULL(idx)) {
-            ret = row_builder_->AppendNULL();
-        } else {
-            switch (column.data_type()) {
-                case ::openmldb::type::kBool: {
-                    bool val = false;
-                    ret = cur_rv_->GetBool(idx, &val) == 0 && row_builder_->AppendBool(val);
-                    break;
-                }
-                case ::openmldb::type::kSmallInt: {
-                    int16_t val = 0;
-                    ret = cur_rv_->GetInt16(idx, &val) == 0 && row_builder_->AppendInt16(val);
-                    break;
-                }
-                case ::openmldb::type::kInt: {
-                    int32_t val = 0;
-                    ret = cur_rv_->GetInt32(idx, &val) == 0 && row_builder_->AppendInt32(val);
-                    break;
-                }
-                case ::openmldb::type::kDate: {
-                    int32_t val = 0;
-                    ret = cur_rv_->GetDate(idx, &val) == 0 && row_builder_->AppendDate(val);
-                    break;
-                }
-                case ::openmldb::type::kBigInt: {
-                    int64_t val = 0;
-                    ret = cur_rv_->GetInt64(idx, &val) == 0 && row_builder_->AppendInt64(val);
-                    break;
-                }
-                case ::openmldb::type::kTimestamp: {
-                    int64_t val = 0;
-                    ret = cur_rv_->GetTimestamp(idx, &val) == 0 && row_builder_->AppendTimestamp(val);
-                    break;
-                }
-                case ::openmldb::type::kFloat: {
-                    float val = 0;
-                    ret = cur_rv_->GetFloat(idx, &val) == 0 && row_builder_->AppendFloat(val);
-                    break;
-                }
-                case ::openmldb::type::kDouble: {
-                    double val = 0;
-                    ret = cur_rv_->GetDouble(idx, &val) == 0 && row_builder_->AppendDouble(val);
-                    break;
-                }
-                case ::openmldb::type::kString:
-                case ::openmldb::type::kVarchar: {
-                    char* val = NULL;
-                    uint32_t size = 0;
-                    ret = cur_rv_->GetString(idx, &val, &size) == 0 && row_builder_->AppendString(val, size);
-                    break;
-                }
-                default: { PDLOG(WARNING, "not supported type"); }
-            }
+    int8_t* ptr = reinterpret_cast<int8_t*>(new char[total_size]);
+    if (!row_builder_->InitBuffer(ptr, total_size, true)) {
+        delete[] ptr;
+        return false;
+    }
+    uint8_t out_addr_length = GetAddrLength(total_size);
+    uint32_t str_offset = out_str_start_ + out_addr_length * out_str_cnt_;
+    for (uint32_t i = 0; i < columns.size(); i++) {
+        const auto& column = columns[i];
+        bool is_null = IsFieldNull(row_ptr, column.idx);
+        if (!is_null) {
+            *(reinterpret_cast<uint8_t*>(ptr + HEADER_LENGTH + (i >> 3))) &= ~(1 << (i & 0x07));
         }
-        if (!ret) {
-            delete[] ptr;
-            PDLOG(WARNING, "fail to project column %s with idx %u", column.name().c_str(), idx);
-            return false;
+        if (IsStringType(column.type)) {
+            // null strings still take a slot, pointing to an empty value
+            SetStrAddr(ptr + out_str_start_ + out_addr_length * out_offsets_[i], out_addr_length, str_offset);
+            if (!is_null) {
+                memcpy(ptr + str_offset, str_fields_[i].first, str_fields_[i].second);
+                str_offset += str_fields_[i].second;
+            }
+        } else if (!is_null) {
+            memcpy(ptr + out_offsets_[i], row_ptr + column.offset, TYPE_SIZE_ARRAY[column.type]);
         }
     }
-    *output_ptr = reinterpret_cast<int8_t*>(ptr);
+    *output_ptr = ptr;
     *out_size = total_size;
     return true;
 }
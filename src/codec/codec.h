@@ -53,16 +53,33 @@ class RowProject {
     uint32_t GetMaxIdx() { return max_idx_; }
 
  private:
+    struct ProjectColumn {
+        uint32_t idx;
+        ::openmldb::type::DataType type;
+        // value offset of a fixed size column or the string slot of a string column
+        uint32_t offset;
+        // slot of the next string column, 0 if it is the last one
+        uint32_t next_slot;
+    };
+    // where the projected columns live in the rows of one schema version
+    struct ProjectPlan {
+        std::vector<ProjectColumn> columns;
+        uint32_t str_field_start_offset;
+    };
+
     const ProjectList& plist_;
     Schema output_schema_;
-    // TODO(wangtaize) share the init overhead
     RowBuilder* row_builder_;
-    std::shared_ptr<Schema> cur_schema_;
-    std::shared_ptr<RowView> cur_rv_;
     uint32_t max_idx_;
-    std::map<int32_t, std::shared_ptr<RowView>> vers_views_;
+    std::map<int32_t, ProjectPlan> vers_plans_;
     std::map<int32_t, std::shared_ptr<Schema>> vers_schema_;
+    const ProjectPlan* cur_plan_;
     uint32_t cur_ver_;
+    // layout of the output row
+    std::vector<uint32_t> out_offsets_;
+    uint32_t out_str_cnt_;
+    uint32_t out_str_start_;
+    std::vector<std::pair<int8_t*, uint32_t>> str_fields_;
 };
 
 class RowBuilder {
@@ -135,6 +152,7 @@ class RowBuilder {
     uint32_t str_offset_;
     uint8_t schema_version_;
     std::vector<uint32_t> offset_vec_;
+    std::vector<::openmldb::type::DataType> types_;
 };
 
 class RowView {
@@ -190,6 +208,7 @@ class RowView {
     const int8_t* row_;
     const Schema& schema_;
     std::vector<uint32_t> offset_vec_;
+    std::vector<::openmldb::type::DataType> types_;
 };
 
 namespace v1 {
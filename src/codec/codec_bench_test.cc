@@ -15,6 +15,7 @@
  */
 
 #include <iostream>
+#include <string>
 
 #include "base/kv_iterator.h"
 #include "codec/row_codec.h"
@@ -104,6 +105,51 @@ TEST_F(CodecBenchmarkTest, ProjectTest) {
     std::cout << "project 1000 records avg consumed:" << consumed / 100 << "μs" << std::endl;
 }
 
+TEST_F(CodecBenchmarkTest, RowBuilderAndView) {
+    Schema schema;
+    for (uint32_t i = 0; i < 50; i++) {
+        common::ColumnDesc* col = schema.Add();
+        col->set_name("col" + std::to_string(i));
+        col->set_data_type(i % 5 == 0 ? type::kVarchar : type::kBigInt);
+    }
+    std::string hello = "hello";
+    RowBuilder rb(schema);
+    uint32_t total_size = rb.CalTotalLength(hello.size() * 10);
+    std::string row(total_size, '\0');
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    for (uint32_t i = 0; i < 100000; i++) {
+        rb.SetBuffer(reinterpret_cast<int8_t*>(&row[0]), total_size);
+        for (uint32_t j = 0; j < 50; j++) {
+            bool ok = j % 5 == 0 ? rb.AppendString(hello.c_str(), hello.size()) : rb.AppendInt64(i + j);
+            ASSERT_TRUE(ok);
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+
+    RowView view(schema);
+    int64_t sum = 0;
+    uint64_t vconsumed = ::baidu::common::timer::get_micros();
+    for (uint32_t i = 0; i < 100000; i++) {
+        view.Reset(reinterpret_cast<int8_t*>(&row[0]), total_size);
+        for (uint32_t j = 0; j < 50; j++) {
+            if (j % 5 == 0) {
+                char* val = NULL;
+                uint32_t length = 0;
+                ASSERT_EQ(0, view.GetString(j, &val, &length));
+                sum += length;
+            } else {
+                int64_t val = 0;
+                ASSERT_EQ(0, view.GetInt64(j, &val));
+                sum += val;
+            }
+        }
+    }
+    vconsumed = ::baidu::common::timer::get_micros() - vconsumed;
+    ASSERT_GT(sum, 0);
+    std::cout << "encode 100000 records consumed:" << consumed / 1000 << "ms" << std::endl;
+    std::cout << "decode 100000 records consumed:" << vconsumed / 1000 << "ms" << std::endl;
+}
+
 TEST_F(CodecBenchmarkTest, Encode_ts_vs_none_ts) {
     char* bd = new char[128];
     for (uint32_t i = 0; i < 128; i++) {
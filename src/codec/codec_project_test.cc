@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -400,6 +402,73 @@ TEST_P(ProjectCodecTest, common_case) {
 
 INSTANTIATE_TEST_SUITE_P(ProjectCodecTestPrefix, ProjectCodecTest, testing::ValuesIn(GenCommonCase()));
 
+class ProjectVersionTest : public ::testing::Test {};
+
+TEST_F(ProjectVersionTest, multi_version) {
+    Schema schema;
+    common::ColumnDesc* col = schema.Add();
+    col->set_name("card");
+    col->set_data_type(type::kString);
+    col = schema.Add();
+    col->set_name("ts");
+    col->set_data_type(type::kTimestamp);
+    col = schema.Add();
+    col->set_name("memo");
+    col->set_data_type(type::kVarchar);
+    auto schema_v2 = std::make_shared<Schema>(schema);
+    col = schema_v2->Add();
+    col->set_name("addr");
+    col->set_data_type(type::kString);
+    col = schema_v2->Add();
+    col->set_name("amt");
+    col->set_data_type(type::kDouble);
+    std::map<int32_t, std::shared_ptr<Schema>> vers_schema = {{1, std::make_shared<Schema>(schema)},
+                                                              {2, schema_v2}};
+    ProjectList plist;
+    for (uint32_t idx : {2, 0, 1}) {
+        plist.Add(idx);
+    }
+    Schema output_schema;
+    for (uint32_t idx : plist) {
+        output_schema.Add()->CopyFrom(schema.Get(idx));
+    }
+    RowProject rp(vers_schema, plist);
+    ASSERT_TRUE(rp.Init());
+
+    // the long memo needs 3 bytes string addresses
+    std::string memo(70000, 'm');
+    for (int32_t version : {1, 2, 1}) {
+        const Schema& cur_schema = *vers_schema[version];
+        RowBuilder rb(cur_schema);
+        rb.SetSchemaVersion(version);
+        uint32_t row_size = rb.CalTotalLength(memo.size() + (version == 2 ? 8 : 0));
+        std::string row(row_size, '\0');
+        ASSERT_TRUE(rb.SetBuffer(reinterpret_cast<int8_t*>(&row[0]), row_size));
+        ASSERT_TRUE(rb.AppendNULL());
+        ASSERT_TRUE(rb.AppendTimestamp(1000 + version));
+        ASSERT_TRUE(rb.AppendString(memo.c_str(), memo.size()));
+        if (version == 2) {
+            ASSERT_TRUE(rb.AppendString("hangzhou", 8));
+            ASSERT_TRUE(rb.AppendDouble(1.5));
+        }
+        int8_t* output = NULL;
+        uint32_t output_size = 0;
+        ASSERT_TRUE(rp.Project(reinterpret_cast<int8_t*>(&row[0]), row_size, &output, &output_size));
+        RowView view(output_schema, output, output_size);
+        char* val = NULL;
+        uint32_t length = 0;
+        ASSERT_EQ(0, view.GetString(0, &val, &length));
+        ASSERT_EQ(memo, std::string(val, length));
+        ASSERT_TRUE(view.IsNULL(1));
+        int64_t ts = 0;
+        ASSERT_EQ(0, view.GetTimestamp(2, &ts));
+        ASSERT_EQ(1000 + version, ts);
+        delete[] output;
+        // the size in the header does not match
+        ASSERT_FALSE(rp.Project(reinterpret_cast<int8_t*>(&row[0]), row_size - 1, &output, &output_size));
+    }
+}
+
 }  // namespace codec
 }  // namespace openmldb
 
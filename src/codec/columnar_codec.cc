@@ -0,0 +1,285 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/columnar_codec.h"
+
+#include <string>
+
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace codec {
+
+static constexpr uint32_t COLUMNAR_ALIGNMENT = 8;
+
+static inline uint32_t AlignSize(uint32_t size) {
+    return (size + COLUMNAR_ALIGNMENT - 1) & ~(COLUMNAR_ALIGNMENT - 1);
+}
+
+static inline uint32_t BitmapSize(uint32_t row_cnt) { return AlignSize((row_cnt + 7) >> 3); }
+
+static inline void AppendPadding(butil::IOBuf* buf, uint32_t size) {
+    static const char padding[COLUMNAR_ALIGNMENT] = {0};
+    uint32_t aligned = AlignSize(size);
+    if (aligned > size) {
+        buf->append(padding, aligned - size);
+    }
+}
+
+uint32_t GetColumnarValueWidth(hybridse::type::Type type) {
+    switch (type) {
+        case hybridse::type::kInt16:
+            return sizeof(int16_t);
+        case hybridse::type::kInt32:
+        case hybridse::type::kDate:
+            return sizeof(int32_t);
+        case hybridse::type::kInt64:
+        case hybridse::type::kTimestamp:
+            return sizeof(int64_t);
+        case hybridse::type::kFloat:
+            return sizeof(float);
+        case hybridse::type::kDouble:
+            return sizeof(double);
+        default:
+            return 0;
+    }
+}
+
+ColumnarBlockBuilder::ColumnarBlockBuilder(const hybridse::codec::Schema& schema)
+    : schema_(schema), row_view_(schema), columns_(schema.size()), row_cnt_(0) {
+    for (int i = 0; i < schema.size(); i++) {
+        columns_[i].type = schema.Get(i).type();
+        if (columns_[i].type == hybridse::type::kVarchar) {
+            columns_[i].offsets.push_back(0);
+        }
+    }
+}
+
+void ColumnarBlockBuilder::SetBit(std::string* bitmap, uint32_t idx, bool val) {
+    if ((idx >> 3) >= bitmap->size()) {
+        bitmap->push_back(0);
+    }
+    if (val) {
+        (*bitmap)[idx >> 3] |= static_cast<char>(1 << (idx & 0x07));
+    }
+}
+
+bool ColumnarBlockBuilder::Append(const hybridse::codec::Row& row) {
+    if (row.GetRowPtrCnt() != 1) {
+        LOG(WARNING) << "columnar block only supports single slice row";
+        return false;
+    }
+    return Append(row.buf(), row.size());
+}
+
+bool ColumnarBlockBuilder::Append(const int8_t* buf, uint32_t size) {
+    if (buf == nullptr || size == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < columns_.size(); i++) {
+        auto& column = columns_[i];
+        int32_t ret = 0;
+        switch (column.type) {
+            case hybridse::type::kBool: {
+                bool val = false;
+                ret = row_view_.GetValue(buf, i, column.type, &val);
+                SetBit(&column.values, row_cnt_, ret == 0 && val);
+                break;
+            }
+            case hybridse::type::kVarchar: {
+                const char* val = nullptr;
+                uint32_t length = 0;
+                ret = row_view_.GetValue(buf, i, &val, &length);
+                if (ret == 0) {
+                    column.values.append(val, length);
+                }
+                column.offsets.push_back(column.values.size());
+                break;
+            }
+            default: {
+                uint32_t width = GetColumnarValueWidth(column.type);
+                if (width == 0) {
+                    LOG(WARNING) << "unsupported columnar type " << hybridse::type::Type_Name(column.type);
+                    return false;
+                }
+                int64_t val = 0;
+                ret = row_view_.GetValue(buf, i, column.type, &val);
+                if (ret != 0) {
+                    val = 0;
+                }
+                // little endian, the low `width` bytes hold the value
+                column.values.append(reinterpret_cast<const char*>(&val), width);
+                break;
+            }
+        }
+        if (ret < 0) {
+            LOG(WARNING) << "fail to read column " << i << " from row";
+            return false;
+        }
+        if (ret == 1) {
+            column.null_cnt++;
+        }
+        SetBit(&column.validity, row_cnt_, ret == 0);
+    }
+    row_cnt_++;
+    return true;
+}
+
+bool ColumnarBlockBuilder::Flush(butil::IOBuf* buf, uint32_t* block_size) {
+    if (buf == nullptr || block_size == nullptr) {
+        return false;
+    }
+    size_t start = buf->size();
+    uint32_t col_cnt = columns_.size();
+    buf->append(&COLUMNAR_BLOCK_MAGIC, sizeof(uint32_t));
+    buf->append(&COLUMNAR_BLOCK_VERSION, sizeof(uint16_t));
+    uint16_t reserved = 0;
+    buf->append(&reserved, sizeof(uint16_t));
+    buf->append(&row_cnt_, sizeof(uint32_t));
+    buf->append(&col_cnt, sizeof(uint32_t));
+    uint32_t bitmap_size = BitmapSize(row_cnt_);
+    for (auto& column : columns_) {
+        uint8_t type = static_cast<uint8_t>(column.type);
+        char column_reserved[3] = {0};
+        buf->append(&type, sizeof(uint8_t));
+        buf->append(column_reserved, sizeof(column_reserved));
+        buf->append(&column.null_cnt, sizeof(uint32_t));
+        column.validity.resize(bitmap_size, 0);
+        buf->append(column.validity);
+        if (column.type == hybridse::type::kBool) {
+            column.values.resize(bitmap_size, 0);
+            buf->append(column.values);
+        } else if (column.type == hybridse::type::kVarchar) {
+            uint32_t offsets_size = column.offsets.size() * sizeof(int32_t);
+            buf->append(column.offsets.data(), offsets_size);
+            uint32_t data_size = column.values.size();
+            buf->append(&data_size, sizeof(uint32_t));
+            AppendPadding(buf, offsets_size + sizeof(uint32_t));
+            buf->append(column.values);
+            AppendPadding(buf, data_size);
+        } else {
+            buf->append(column.values);
+            AppendPadding(buf, column.values.size());
+        }
+        column.null_cnt = 0;
+        column.validity.clear();
+        column.values.clear();
+        column.offsets.clear();
+        if (column.type == hybridse::type::kVarchar) {
+            column.offsets.push_back(0);
+        }
+    }
+    *block_size = buf->size() - start;
+    row_cnt_ = 0;
+    return true;
+}
+
+bool ColumnarBlockView::Init(const int8_t* buf, uint32_t size) {
+    columns_.clear();
+    row_cnt_ = 0;
+    if (buf == nullptr || size < COLUMNAR_BLOCK_HEADER_SIZE) {
+        return false;
+    }
+    if (*reinterpret_cast<const uint32_t*>(buf) != COLUMNAR_BLOCK_MAGIC ||
+        *reinterpret_cast<const uint16_t*>(buf + 4) != COLUMNAR_BLOCK_VERSION) {
+        LOG(WARNING) << "invalid columnar block header";
+        return false;
+    }
+    uint32_t row_cnt = *reinterpret_cast<const uint32_t*>(buf + 8);
+    uint32_t col_cnt = *reinterpret_cast<const uint32_t*>(buf + 12);
+    if (col_cnt > 0 && row_cnt / 8 > size) {
+        LOG(WARNING) << "columnar block is truncated, row count " << row_cnt;
+        return false;
+    }
+    // sizes are computed in 64 bits so that a corrupted header can not overflow them
+    uint64_t bitmap_size = BitmapSize(row_cnt);
+    uint64_t pos = COLUMNAR_BLOCK_HEADER_SIZE;
+    for (uint32_t i = 0; i < col_cnt; i++) {
+        if (pos + COLUMNAR_COLUMN_HEADER_SIZE + bitmap_size > size) {
+            LOG(WARNING) << "columnar block is truncated at column " << i;
+            columns_.clear();
+            return false;
+        }
+        ColumnRef column;
+        column.type = static_cast<hybridse::type::Type>(*reinterpret_cast<const uint8_t*>(buf + pos));
+        column.null_cnt = *reinterpret_cast<const uint32_t*>(buf + pos + 4);
+        pos += COLUMNAR_COLUMN_HEADER_SIZE;
+        column.validity = reinterpret_cast<const uint8_t*>(buf + pos);
+        pos += bitmap_size;
+        column.values = buf + pos;
+        column.offsets = nullptr;
+        column.data = nullptr;
+        uint64_t values_size = 0;
+        if (column.type == hybridse::type::kBool) {
+            values_size = bitmap_size;
+        } else if (column.type == hybridse::type::kVarchar) {
+            uint64_t offsets_size = (static_cast<uint64_t>(row_cnt) + 1) * sizeof(int32_t);
+            if (pos + offsets_size + sizeof(uint32_t) > size) {
+                LOG(WARNING) << "columnar block is truncated at column " << i;
+                columns_.clear();
+                return false;
+            }
+            column.offsets = reinterpret_cast<const int32_t*>(buf + pos);
+            uint32_t data_size = *reinterpret_cast<const uint32_t*>(buf + pos + offsets_size);
+            // the strings are read by offsets[j] and offsets[j + 1] without any check later
+            if (column.offsets[0] != 0) {
+                LOG(WARNING) << "invalid string offsets at column " << i;
+                columns_.clear();
+                return false;
+            }
+            for (uint32_t j = 0; j < row_cnt; j++) {
+                if (column.offsets[j + 1] < column.offsets[j]) {
+                    LOG(WARNING) << "invalid string offsets at column " << i;
+                    columns_.clear();
+                    return false;
+                }
+            }
+            if (static_cast<uint32_t>(column.offsets[row_cnt]) > data_size) {
+                LOG(WARNING) << "string offsets exceed the data size at column " << i;
+                columns_.clear();
+                return false;
+            }
+            pos += AlignSize(offsets_size + sizeof(uint32_t));
+            column.data = reinterpret_cast<const char*>(buf + pos);
+            values_size = data_size;
+        } else {
+            uint32_t width = GetColumnarValueWidth(column.type);
+            if (width == 0) {
+                LOG(WARNING) << "unsupported columnar type " << static_cast<int>(column.type);
+                columns_.clear();
+                return false;
+            }
+            values_size = static_cast<uint64_t>(width) * row_cnt;
+        }
+        if (pos + values_size > size) {
+            LOG(WARNING) << "columnar block is truncated at column " << i;
+            columns_.clear();
+            return false;
+        }
+        pos += AlignSize(values_size);
+        if (pos > size) {
+            LOG(WARNING) << "columnar block is truncated at column " << i;
+            columns_.clear();
+            return false;
+        }
+        columns_.push_back(column);
+    }
+    row_cnt_ = row_cnt;
+    return true;
+}
+
+}  // namespace codec
+}  // namespace openmldb
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CODEC_COLUMNAR_CODEC_H_
+#define SRC_CODEC_COLUMNAR_CODEC_H_
+
+#include <string>
+#include <vector>
+
+#include "butil/iobuf.h"
+#include "codec/fe_row_codec.h"
+#include "codec/row.h"
+
+namespace openmldb {
+namespace codec {
+
+/**
+ * Columnar block encoding, used to transport large batch query results.
+ *
+ * The buffers of a column follow the arrow columnar layout, so a client can
+ * wrap them into arrow arrays without copy:
+ *   - validity bitmap: one bit per row, least significant bit first, 1 means valid
+ *   - bool column: values are bit-packed like the validity bitmap
+ *   - fixed width column: values stored consecutively in little endian
+ *   - string column: (row_cnt + 1) int32 offsets followed by the string data
+ * Every buffer is padded to 8 bytes.
+ *
+ * block := header column*
+ * header := magic(uint32) version(uint16) reserved(uint16) row_cnt(uint32) col_cnt(uint32)
+ * column := type(uint8) reserved(uint8 * 3) null_cnt(uint32) validity [values | offsets data_size(uint32) data]
+ *
+ * Date values keep the openmldb encoding (year, month, day packed in int32).
+ */
+constexpr uint32_t COLUMNAR_BLOCK_MAGIC = 0x4243444F;  // "ODCB"
+constexpr uint16_t COLUMNAR_BLOCK_VERSION = 1;
+constexpr uint32_t COLUMNAR_BLOCK_HEADER_SIZE = 16;
+constexpr uint32_t COLUMNAR_COLUMN_HEADER_SIZE = 8;
+
+class ColumnarBlockBuilder {
+ public:
+    explicit ColumnarBlockBuilder(const hybridse::codec::Schema& schema);
+
+    // append one single slice row encoded with `schema`
+    bool Append(const hybridse::codec::Row& row);
+    bool Append(const int8_t* buf, uint32_t size);
+
+    uint32_t GetRowCount() const { return row_cnt_; }
+
+    // encode the buffered rows as one block into `buf` and reset the builder
+    bool Flush(butil::IOBuf* buf, uint32_t* block_size);
+
+ private:
+    struct ColumnBuffer {
+        hybridse::type::Type type;
+        uint32_t null_cnt = 0;
+        std::string validity;
+        std::string values;
+        std::vector<int32_t> offsets;
+    };
+
+    static void SetBit(std::string* bitmap, uint32_t idx, bool val);
+
+    const hybridse::codec::Schema& schema_;
+    hybridse::codec::RowView row_view_;
+    std::vector<ColumnBuffer> columns_;
+    uint32_t row_cnt_;
+};
+
+class ColumnarBlockView {
+ public:
+    ColumnarBlockView() : row_cnt_(0), columns_() {}
+
+    // `buf` must be kept alive and 8 bytes aligned while the view is used.
+    // Buffer sizes and string offsets are checked, so a corrupted block fails here instead of in reading.
+    bool Init(const int8_t* buf, uint32_t size);
+
+    uint32_t GetRowCount() const { return row_cnt_; }
+    uint32_t GetColumnCount() const { return columns_.size(); }
+    hybridse::type::Type GetColumnType(uint32_t col) const { return columns_[col].type; }
+    uint32_t GetNullCount(uint32_t col) const { return columns_[col].null_cnt; }
+
+    inline bool IsNULL(uint32_t col, uint32_t row) const { return !GetBit(columns_[col].validity, row); }
+
+    // raw value buffer of a fixed width column
+    template <typename T>
+    const T* GetValues(uint32_t col) const {
+        return reinterpret_cast<const T*>(columns_[col].values);
+    }
+    const int32_t* GetOffsets(uint32_t col) const { return columns_[col].offsets; }
+    const char* GetStringData(uint32_t col) const { return columns_[col].data; }
+
+    inline bool GetBool(uint32_t col, uint32_t row) const { return GetBit(columns_[col].values, row); }
+    inline void GetString(uint32_t col, uint32_t row, const char** val, uint32_t* length) const {
+        const int32_t* offsets = columns_[col].offsets;
+        *val = columns_[col].data + offsets[row];
+        *length = offsets[row + 1] - offsets[row];
+    }
+
+ private:
+    struct ColumnRef {
+        hybridse::type::Type type;
+        uint32_t null_cnt;
+        const uint8_t* validity;
+        const int8_t* values;
+        const int32_t* offsets;
+        const char* data;
+    };
+
+    static inline bool GetBit(const void* bitmap, uint32_t idx) {
+        return reinterpret_cast<const uint8_t*>(bitmap)[idx >> 3] & (1 << (idx & 0x07));
+    }
+
+    uint32_t row_cnt_;
+    std::vector<ColumnRef> columns_;
+};
+
+// return the byte width of fixed width type, 0 for bool and string types
+uint32_t GetColumnarValueWidth(hybridse::type::Type type);
+
+}  // namespace codec
+}  // namespace openmldb
+#endif  // SRC_CODEC_COLUMNAR_CODEC_H_
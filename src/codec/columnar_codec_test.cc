@@ -0,0 +1,173 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/columnar_codec.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace codec {
+
+class ColumnarCodecTest : public ::testing::Test {};
+
+void InitColumnarSchema(hybridse::codec::Schema* schema) {
+    std::vector<hybridse::type::Type> types = {hybridse::type::kBool,  hybridse::type::kInt16,
+                                               hybridse::type::kInt32, hybridse::type::kInt64,
+                                               hybridse::type::kFloat, hybridse::type::kDouble,
+                                               hybridse::type::kVarchar, hybridse::type::kTimestamp};
+    for (size_t i = 0; i < types.size(); i++) {
+        auto column = schema->Add();
+        column->set_name("col_" + std::to_string(i));
+        column->set_type(types[i]);
+    }
+}
+
+hybridse::codec::Row BuildColumnarRow(const hybridse::codec::Schema& schema, int32_t i) {
+    hybridse::codec::RowBuilder builder(schema);
+    std::string str = "str" + std::to_string(i);
+    uint32_t buf_size = builder.CalTotalLength(i % 3 == 0 ? 0 : str.size());
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+    builder.SetBuffer(buf, buf_size);
+    builder.AppendBool(i % 2 == 0);
+    builder.AppendInt16(i);
+    builder.AppendInt32(i * 10);
+    builder.AppendInt64(i * 100L);
+    builder.AppendFloat(i * 1.5f);
+    builder.AppendDouble(i * 2.5);
+    if (i % 3 == 0) {
+        builder.AppendNULL();
+    } else {
+        builder.AppendString(str.c_str(), str.size());
+    }
+    builder.AppendTimestamp(1000L + i);
+    return hybridse::codec::Row(hybridse::codec::RefCountedSlice::CreateManaged(buf, buf_size));
+}
+
+TEST_F(ColumnarCodecTest, EncodeDecodeBlocks) {
+    hybridse::codec::Schema schema;
+    InitColumnarSchema(&schema);
+    ColumnarBlockBuilder builder(schema);
+    butil::IOBuf iobuf;
+    std::vector<uint32_t> block_sizes;
+    const int32_t row_cnt = 37;
+    for (int32_t i = 0; i < row_cnt; i++) {
+        ASSERT_TRUE(builder.Append(BuildColumnarRow(schema, i)));
+        if (builder.GetRowCount() == 16) {
+            uint32_t block_size = 0;
+            ASSERT_TRUE(builder.Flush(&iobuf, &block_size));
+            block_sizes.push_back(block_size);
+        }
+    }
+    uint32_t block_size = 0;
+    ASSERT_TRUE(builder.Flush(&iobuf, &block_size));
+    block_sizes.push_back(block_size);
+    ASSERT_EQ(3u, block_sizes.size());
+
+    size_t pos = 0;
+    int32_t i = 0;
+    for (auto size : block_sizes) {
+        ASSERT_EQ(0u, size % 8);
+        std::vector<int64_t> block(size / sizeof(int64_t));
+        iobuf.copy_to(block.data(), size, pos);
+        pos += size;
+        ColumnarBlockView view;
+        ASSERT_TRUE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+        ASSERT_EQ(8u, view.GetColumnCount());
+        ASSERT_EQ(hybridse::type::kVarchar, view.GetColumnType(6));
+        for (uint32_t row = 0; row < view.GetRowCount(); row++, i++) {
+            ASSERT_FALSE(view.IsNULL(0, row));
+            ASSERT_EQ(i % 2 == 0, view.GetBool(0, row));
+            ASSERT_EQ(i, view.GetValues<int16_t>(1)[row]);
+            ASSERT_EQ(i * 10, view.GetValues<int32_t>(2)[row]);
+            ASSERT_EQ(i * 100L, view.GetValues<int64_t>(3)[row]);
+            ASSERT_FLOAT_EQ(i * 1.5f, view.GetValues<float>(4)[row]);
+            ASSERT_DOUBLE_EQ(i * 2.5, view.GetValues<double>(5)[row]);
+            if (i % 3 == 0) {
+                ASSERT_TRUE(view.IsNULL(6, row));
+            } else {
+                ASSERT_FALSE(view.IsNULL(6, row));
+                const char* val = nullptr;
+                uint32_t length = 0;
+                view.GetString(6, row, &val, &length);
+                ASSERT_EQ("str" + std::to_string(i), std::string(val, length));
+            }
+            ASSERT_EQ(1000L + i, view.GetValues<int64_t>(7)[row]);
+        }
+    }
+    ASSERT_EQ(row_cnt, i);
+    ASSERT_EQ(pos, iobuf.size());
+}
+
+TEST_F(ColumnarCodecTest, InvalidBlock) {
+    ColumnarBlockView view;
+    std::vector<int64_t> block(4, 0);
+    ASSERT_FALSE(view.Init(reinterpret_cast<const int8_t*>(block.data()), block.size() * sizeof(int64_t)));
+    ASSERT_FALSE(view.Init(nullptr, 0));
+}
+
+TEST_F(ColumnarCodecTest, InvalidStringOffsets) {
+    hybridse::codec::Schema schema;
+    auto column = schema.Add();
+    column->set_name("col_0");
+    column->set_type(hybridse::type::kVarchar);
+    ColumnarBlockBuilder builder(schema);
+    for (int32_t i = 0; i < 4; i++) {
+        std::string str = "str" + std::to_string(i);
+        hybridse::codec::RowBuilder row_builder(schema);
+        uint32_t buf_size = row_builder.CalTotalLength(str.size());
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+        row_builder.SetBuffer(buf, buf_size);
+        row_builder.AppendString(str.c_str(), str.size());
+        ASSERT_TRUE(builder.Append(
+            hybridse::codec::Row(hybridse::codec::RefCountedSlice::CreateManaged(buf, buf_size))));
+    }
+    butil::IOBuf iobuf;
+    uint32_t size = 0;
+    ASSERT_TRUE(builder.Flush(&iobuf, &size));
+    std::vector<int64_t> block(size / sizeof(int64_t));
+    iobuf.copy_to(block.data(), size);
+    ColumnarBlockView view;
+    ASSERT_TRUE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+
+    // offsets follow the block header, the column header and the 8 bytes validity bitmap
+    int32_t* offsets = reinterpret_cast<int32_t*>(reinterpret_cast<int8_t*>(block.data()) + 32);
+    ASSERT_EQ(0, offsets[0]);
+    ASSERT_EQ(16, offsets[4]);
+    offsets[2] = 1;
+    ASSERT_FALSE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+    ASSERT_EQ(0u, view.GetColumnCount());
+    offsets[2] = 8;
+    offsets[4] = 17;
+    ASSERT_FALSE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+    offsets[4] = 16;
+    offsets[0] = -1;
+    ASSERT_FALSE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+    offsets[0] = 0;
+    ASSERT_TRUE(view.Init(reinterpret_cast<const int8_t*>(block.data()), size));
+}
+
+}  // namespace codec
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/dict_compressor.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+
+namespace openmldb {
+namespace codec {
+
+namespace {
+
+// the length of the substrings counted by BuildDict, shorter matches are not worth a reference
+constexpr uint32_t kSegmentSize = 8;
+
+// zlib streams are reused by each thread, resetting a stream is much cheaper than creating one
+struct DeflateContext {
+    DeflateContext() {
+        memset(&stream, 0, sizeof(stream));
+        ok = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~DeflateContext() {
+        if (ok) {
+            deflateEnd(&stream);
+        }
+    }
+    z_stream stream;
+    bool ok;
+};
+
+struct InflateContext {
+    InflateContext() {
+        memset(&stream, 0, sizeof(stream));
+        ok = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+    }
+    ~InflateContext() {
+        if (ok) {
+            inflateEnd(&stream);
+        }
+    }
+    z_stream stream;
+    bool ok;
+};
+
+thread_local DeflateContext t_deflate;
+thread_local InflateContext t_inflate;
+
+}  // namespace
+
+DictCompressor::DictCompressor(uint32_t sample_cnt, uint32_t max_dict_size)
+    : sample_cnt_(sample_cnt > 0 ? sample_cnt : 1),
+      max_dict_size_(std::min(max_dict_size, kMaxDictSize)),
+      slot_(0),
+      dict_mu_(),
+      sampling_(true),
+      sample_mu_(),
+      samples_(),
+      seen_cnt_(0),
+      rand_(std::random_device()()) {
+    for (auto& dict : dicts_) {
+        dict.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+DictCompressor::~DictCompressor() {
+    for (auto& dict : dicts_) {
+        delete dict.load(std::memory_order_relaxed);
+    }
+}
+
+std::string DictCompressor::BuildDict(const std::vector<std::string>& samples, uint32_t max_size) {
+    max_size = std::min(max_size, kMaxDictSize);
+    // count every substring once per sample, so a run inside one row does not look frequent
+    absl::flat_hash_map<absl::string_view, uint32_t> freq;
+    absl::flat_hash_set<absl::string_view> seen;
+    for (const auto& sample : samples) {
+        seen.clear();
+        for (size_t pos = 0; pos + kSegmentSize <= sample.size(); pos++) {
+            absl::string_view segment(sample.data() + pos, kSegmentSize);
+            if (seen.insert(segment).second) {
+                freq[segment]++;
+            }
+        }
+    }
+    // merge the overlapping frequent substrings of a sample into maximal runs, otherwise a common
+    // field would be put into the dictionary once for every offset
+    uint32_t threshold = std::max<uint32_t>(2, samples.size() / 100);
+    absl::flat_hash_map<absl::string_view, uint64_t> runs;
+    for (const auto& sample : samples) {
+        size_t pos = 0;
+        while (pos + kSegmentSize <= sample.size()) {
+            uint32_t cnt = freq[absl::string_view(sample.data() + pos, kSegmentSize)];
+            if (cnt < threshold) {
+                pos++;
+                continue;
+            }
+            size_t start = pos;
+            uint64_t score = 0;
+            while (pos + kSegmentSize <= sample.size() && cnt >= threshold) {
+                score += cnt;
+                pos++;
+                if (pos + kSegmentSize <= sample.size()) {
+                    cnt = freq[absl::string_view(sample.data() + pos, kSegmentSize)];
+                }
+            }
+            runs.emplace(absl::string_view(sample.data() + start, pos - 1 + kSegmentSize - start), score);
+        }
+    }
+    std::vector<std::pair<uint64_t, absl::string_view>> sorted_runs;
+    sorted_runs.reserve(runs.size());
+    for (const auto& kv : runs) {
+        sorted_runs.emplace_back(kv.second, kv.first);
+    }
+    std::sort(sorted_runs.begin(), sorted_runs.end(), [](const auto& l, const auto& r) {
+        return l.first != r.first ? l.first > r.first : l.second < r.second;
+    });
+    std::string picked;
+    std::vector<absl::string_view> picked_runs;
+    for (const auto& run : sorted_runs) {
+        if (picked.size() + run.second.size() > max_size) {
+            continue;
+        }
+        if (picked.find(run.second.data(), 0, run.second.size()) != std::string::npos) {
+            continue;
+        }
+        picked.append(run.second.data(), run.second.size());
+        picked_runs.push_back(run.second);
+    }
+    // closer references are encoded in fewer bits, so the most frequent runs go to the end
+    std::string dict;
+    dict.reserve(picked.size());
+    for (auto it = picked_runs.rbegin(); it != picked_runs.rend(); ++it) {
+        dict.append(it->data(), it->size());
+    }
+    return dict;
+}
+
+bool DictCompressor::AddDict(const std::string& dict) {
+    if (dict.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(dict_mu_);
+    uint32_t slot = slot_.load(std::memory_order_relaxed) + 1;
+    if (slot > kMaxSlot) {
+        return false;
+    }
+    dicts_[slot].store(new std::string(dict, 0, std::min<size_t>(dict.size(), kMaxDictSize)),
+                       std::memory_order_release);
+    slot_.store(slot, std::memory_order_release);
+    sampling_.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+void DictCompressor::Compress(const char* data, uint32_t size, std::string* out) const {
+    uint32_t slot = GetSlot();
+    if (slot > 0 && t_deflate.ok) {
+        const std::string* dict = dicts_[slot].load(std::memory_order_acquire);
+        z_stream* stream = &t_deflate.stream;
+        if (deflateReset(stream) == Z_OK &&
+            deflateSetDictionary(stream, reinterpret_cast<const Bytef*>(dict->data()), dict->size()) == Z_OK) {
+            out->resize(kHeaderSize + deflateBound(stream, size));
+            stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            stream->avail_in = size;
+            stream->next_out = reinterpret_cast<Bytef*>(&(*out)[kHeaderSize]);
+            stream->avail_out = out->size() - kHeaderSize;
+            if (deflate(stream, Z_FINISH) == Z_STREAM_END && stream->total_out + kHeaderSize < size + 1) {
+                (*out)[0] = static_cast<char>(slot);
+                memcpy(&(*out)[1], &size, sizeof(uint32_t));
+                out->resize(kHeaderSize + stream->total_out);
+                return;
+            }
+        }
+    }
+    out->resize(1 + size);
+    (*out)[0] = 0;
+    memcpy(&(*out)[1], data, size);
+}
+
+bool DictCompressor::Uncompress(const char* data, uint32_t size, std::string* out) const {
+    if (size < 1) {
+        return false;
+    }
+    uint8_t slot = static_cast<uint8_t>(data[0]);
+    if (slot == 0) {
+        out->assign(data + 1, size - 1);
+        return true;
+    }
+    if (size < kHeaderSize || !t_inflate.ok) {
+        return false;
+    }
+    const std::string* dict = dicts_[slot].load(std::memory_order_acquire);
+    if (dict == nullptr) {
+        return false;
+    }
+    uint32_t raw_size = 0;
+    memcpy(&raw_size, data + 1, sizeof(uint32_t));
+    z_stream* stream = &t_inflate.stream;
+    if (inflateReset(stream) != Z_OK ||
+        inflateSetDictionary(stream, reinterpret_cast<const Bytef*>(dict->data()), dict->size()) != Z_OK) {
+        return false;
+    }
+    out->resize(raw_size);
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + kHeaderSize));
+    stream->avail_in = size - kHeaderSize;
+    stream->next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+    stream->avail_out = raw_size;
+    return inflate(stream, Z_FINISH) == Z_STREAM_END && stream->avail_out == 0;
+}
+
+void DictCompressor::Sample(const char* data, uint32_t size) {
+    if (!sampling_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(sample_mu_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    seen_cnt_++;
+    if (samples_.size() < sample_cnt_) {
+        samples_.emplace_back(data, size);
+        return;
+    }
+    uint64_t pos = rand_() % seen_cnt_;
+    if (pos < sample_cnt_) {
+        samples_[pos].assign(data, size);
+    }
+}
+
+bool DictCompressor::Train(std::string* dict) {
+    std::vector<std::string> samples;
+    {
+        std::lock_guard<std::mutex> lock(sample_mu_);
+        if (samples_.size() < sample_cnt_) {
+            return false;
+        }
+        samples.swap(samples_);
+        seen_cnt_ = 0;
+    }
+    *dict = BuildDict(samples, max_dict_size_);
+    return !dict->empty();
+}
+
+}  // namespace codec
+}  // namespace openmldb
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CODEC_DICT_COMPRESSOR_H_
+#define SRC_CODEC_DICT_COMPRESSOR_H_
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+namespace openmldb {
+namespace codec {
+
+/**
+ * Row compression with zlib preset dictionaries trained from sampled rows.
+ *
+ * Rows of a table are small and similar, compressing them one by one finds
+ * nearly nothing to reference. A dictionary built from the frequent substrings
+ * of sampled rows gives every row those references for free.
+ *
+ * value := slot(uint8) [raw_size(uint32) raw_deflate_stream | raw_row]
+ *
+ * slot 0 means the row is kept as is, it is used before any dictionary is
+ * trained and for rows which do not get smaller. Slots are only meaningful in
+ * the process which compressed the value, they are never written to binlog or
+ * snapshot. A retrained dictionary takes the next slot and values compressed
+ * with older dictionaries stay readable, so at most 255 dictionaries can be
+ * added during the lifetime of a compressor.
+ *
+ * Rows are sampled in rounds, from the creation until the first dictionary is
+ * added and from StartSample until the next one, so writers pay nothing for
+ * sampling in between.
+ */
+class DictCompressor {
+ public:
+    static constexpr uint32_t kMaxSlot = 255;
+    static constexpr uint32_t kHeaderSize = 5;
+    // zlib window size, larger dictionaries are truncated by zlib anyway
+    static constexpr uint32_t kMaxDictSize = 32 * 1024 - 262;
+
+    DictCompressor(uint32_t sample_cnt, uint32_t max_dict_size);
+    ~DictCompressor();
+    DictCompressor(const DictCompressor&) = delete;
+    DictCompressor& operator=(const DictCompressor&) = delete;
+
+    // build a dictionary of at most `max_size` bytes from the frequent substrings of `samples`
+    static std::string BuildDict(const std::vector<std::string>& samples, uint32_t max_size);
+
+    // make `dict` the dictionary of new values and end the sample round, return false if all slots are used
+    bool AddDict(const std::string& dict);
+
+    // the slot of the latest dictionary, 0 if there is none
+    uint32_t GetSlot() const { return slot_.load(std::memory_order_acquire); }
+
+    // compress `size` bytes of `data` with the latest dictionary into `out`
+    void Compress(const char* data, uint32_t size, std::string* out) const;
+
+    // decode a value produced by `Compress` into `out`
+    bool Uncompress(const char* data, uint32_t size, std::string* out) const;
+
+    // keep a reservoir sample of the written rows during a sample round. never blocks writers
+    void Sample(const char* data, uint32_t size);
+
+    // start a sample round to retrain the dictionary
+    void StartSample() { sampling_.store(true, std::memory_order_relaxed); }
+    bool IsSampling() const { return sampling_.load(std::memory_order_relaxed); }
+
+    // build a dictionary from the samples and start a new sample round.
+    // return false if not enough rows are sampled yet
+    bool Train(std::string* dict);
+
+ private:
+    const uint32_t sample_cnt_;
+    const uint32_t max_dict_size_;
+    std::atomic<uint32_t> slot_;
+    std::atomic<const std::string*> dicts_[kMaxSlot + 1];
+    std::mutex dict_mu_;
+
+    std::atomic<bool> sampling_;
+    std::mutex sample_mu_;
+    std::vector<std::string> samples_;
+    uint64_t seen_cnt_;
+    std::mt19937_64 rand_;
+};
+
+}  // namespace codec
+}  // namespace openmldb
+
+#endif  // SRC_CODEC_DICT_COMPRESSOR_H_
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/dict_compressor.h"
+
+#include <snappy.h>
+
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace codec {
+
+class DictCompressorTest : public ::testing::Test {};
+
+// rows of a wide feature table, most of the bytes repeat across rows
+std::string BuildRow(uint32_t i) {
+    std::string row = "card_" + std::to_string(i % 1000) + "|merchant_category_" + std::to_string(i % 20) +
+                      "|city_shanghai|channel_online|device_android_" + std::to_string(i % 3) + "|";
+    for (uint32_t col = 0; col < 10; col++) {
+        row.append("feature_" + std::to_string(col) + "=" + std::to_string((i * 7 + col) % 100) + ";");
+    }
+    return row;
+}
+
+TEST_F(DictCompressorTest, NoDict) {
+    DictCompressor compressor(10, 1024);
+    std::string row = BuildRow(1);
+    std::string value;
+    compressor.Compress(row.data(), row.size(), &value);
+    ASSERT_EQ(row.size() + 1, value.size());
+    std::string raw;
+    ASSERT_TRUE(compressor.Uncompress(value.data(), value.size(), &raw));
+    ASSERT_EQ(row, raw);
+    ASSERT_FALSE(compressor.Uncompress(value.data(), 0, &raw));
+}
+
+TEST_F(DictCompressorTest, TrainAndCompress) {
+    DictCompressor compressor(1000, 16 * 1024);
+    std::string dict;
+    ASSERT_FALSE(compressor.Train(&dict));
+    for (uint32_t i = 0; i < 5000; i++) {
+        std::string row = BuildRow(i);
+        compressor.Sample(row.data(), row.size());
+    }
+    ASSERT_TRUE(compressor.Train(&dict));
+    ASSERT_LE(dict.size(), 16 * 1024u);
+    // the samples are consumed by the training
+    std::string dict2;
+    ASSERT_FALSE(compressor.Train(&dict2));
+    ASSERT_TRUE(compressor.AddDict(dict));
+    ASSERT_EQ(1u, compressor.GetSlot());
+
+    uint64_t raw_size = 0;
+    uint64_t dict_size = 0;
+    uint64_t snappy_size = 0;
+    std::string value;
+    std::string raw;
+    std::string snappy_value;
+    for (uint32_t i = 10000; i < 11000; i++) {
+        std::string row = BuildRow(i);
+        compressor.Compress(row.data(), row.size(), &value);
+        ASSERT_TRUE(compressor.Uncompress(value.data(), value.size(), &raw));
+        ASSERT_EQ(row, raw);
+        snappy::Compress(row.data(), row.size(), &snappy_value);
+        raw_size += row.size();
+        dict_size += value.size();
+        snappy_size += snappy_value.size();
+    }
+    std::cout << "raw " << raw_size << " bytes, dict " << dict_size << " bytes, snappy " << snappy_size << " bytes"
+              << std::endl;
+    ASSERT_LT(dict_size * 2, snappy_size);
+}
+
+TEST_F(DictCompressorTest, OldSlotReadable) {
+    DictCompressor compressor(100, 4096);
+    std::vector<std::string> samples;
+    for (uint32_t i = 0; i < 100; i++) {
+        samples.push_back(BuildRow(i));
+    }
+    ASSERT_TRUE(compressor.AddDict(DictCompressor::BuildDict(samples, 4096)));
+    std::string row = BuildRow(7);
+    std::string old_value;
+    compressor.Compress(row.data(), row.size(), &old_value);
+    ASSERT_EQ(1, old_value[0]);
+
+    ASSERT_TRUE(compressor.AddDict("another dictionary"));
+    std::string new_value;
+    compressor.Compress(row.data(), row.size(), &new_value);
+    ASSERT_NE(1, new_value[0]);
+    std::string raw;
+    ASSERT_TRUE(compressor.Uncompress(old_value.data(), old_value.size(), &raw));
+    ASSERT_EQ(row, raw);
+    ASSERT_TRUE(compressor.Uncompress(new_value.data(), new_value.size(), &raw));
+    ASSERT_EQ(row, raw);
+    // corrupted values are rejected
+    ASSERT_FALSE(compressor.Uncompress(old_value.data(), old_value.size() / 2, &raw));
+    old_value[0] = 100;
+    ASSERT_FALSE(compressor.Uncompress(old_value.data(), old_value.size(), &raw));
+}
+
+TEST_F(DictCompressorTest, SlotLimit) {
+    DictCompressor compressor(10, 1024);
+    for (uint32_t i = 0; i < DictCompressor::kMaxSlot; i++) {
+        ASSERT_TRUE(compressor.AddDict("dict" + std::to_string(i)));
+    }
+    ASSERT_FALSE(compressor.AddDict("one more"));
+    ASSERT_EQ(DictCompressor::kMaxSlot, compressor.GetSlot());
+    ASSERT_FALSE(compressor.AddDict(""));
+}
+
+TEST_F(DictCompressorTest, SampleRound) {
+    DictCompressor compressor(10, 1024);
+    ASSERT_TRUE(compressor.IsSampling());
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string row = BuildRow(i);
+        compressor.Sample(row.data(), row.size());
+    }
+    std::string dict;
+    ASSERT_TRUE(compressor.Train(&dict));
+    ASSERT_TRUE(compressor.AddDict(dict));
+    // rows are not sampled until the next round starts
+    ASSERT_FALSE(compressor.IsSampling());
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string row = BuildRow(i);
+        compressor.Sample(row.data(), row.size());
+    }
+    ASSERT_FALSE(compressor.Train(&dict));
+    compressor.StartSample();
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string row = BuildRow(i);
+        compressor.Sample(row.data(), row.size());
+    }
+    ASSERT_TRUE(compressor.Train(&dict));
+}
+
+TEST_F(DictCompressorTest, Concurrent) {
+    DictCompressor compressor(100, 4096);
+    std::vector<std::string> samples;
+    for (uint32_t i = 0; i < 100; i++) {
+        samples.push_back(BuildRow(i));
+    }
+    ASSERT_TRUE(compressor.AddDict(DictCompressor::BuildDict(samples, 4096)));
+    std::vector<std::thread> threads;
+    std::vector<int> failed(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            std::string value;
+            std::string raw;
+            for (uint32_t i = 0; i < 2000; i++) {
+                std::string row = BuildRow(i * 4 + t);
+                compressor.Sample(row.data(), row.size());
+                compressor.Compress(row.data(), row.size(), &value);
+                if (!compressor.Uncompress(value.data(), value.size(), &raw) || raw != row) {
+                    failed[t]++;
+                }
+                if (t == 0 && i == 1000) {
+                    std::string dict;
+                    if (compressor.Train(&dict)) {
+                        compressor.AddDict(dict);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        ASSERT_EQ(0, failed[t]);
+    }
+}
+
+}  // namespace codec
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
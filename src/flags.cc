@@ -57,11 +57,17 @@ DEFINE_uint32(name_server_op_execute_timeout, 2 * 60 * 60 * 1000,
               "config the timeout of nameserver op. unit is milliseconds");
 DEFINE_bool(auto_failover, false, "enable or disable auto failover");
 DEFINE_int32(max_op_num, 10000, "config the max op num");
+DEFINE_uint32(catalog_change_record_num, 1000,
+              "config the number of catalog change records kept in zk. tablets and sdks which fall behind more than "
+              "this number of versions reload the whole catalog");
+DEFINE_bool(enable_catalog_delta_refresh, true,
+            "config whether tablets refresh the catalog with the change records instead of reloading all the nodes");
 DEFINE_uint32(partition_num, 8, "config the default partition_num");
 DEFINE_uint32(replica_num, 3, "config the default replica_num. if set 3, there is one leader and two followers");
 DEFINE_uint32(system_table_replica_num, 1, "config the default replica_num of system table.");
 DEFINE_int32(gc_interval, 120, "the gc interval of tablet every two hour");
 DEFINE_int32(disk_gc_interval, 120, "the rocksdb gc interval of tablet");
+DEFINE_int32(memory_head_gc_interval, 1, "the gc interval in minutes of disk tables with a memory head");
 DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
@@ -74,10 +80,17 @@ DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
+DEFINE_uint32(aggr_flush_thread_num, 2, "the size of the thread pool writing filled pre-aggr buckets");
+DEFINE_uint32(aggr_max_pending_flush, 100000,
+              "the max filled buckets queued by an aggregator, puts write the buckets themselves beyond it");
+DEFINE_uint32(aggr_recover_batch_size, 1024, "the batch size of binlog rows replayed by aggregator recovery");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
 DEFINE_uint32(scan_reserve_size, 1024, "config the size of vec reserve");
+DEFINE_uint32(columnar_block_rows, 8192, "config the max row count of a block in columnar query result");
+DEFINE_uint32(columnar_result_keep_alive_ms, 60000,
+              "config the time a partly fetched columnar query result is kept on tablet after its last fetch");
 DEFINE_uint32(preview_limit_max_num, 1000, "config the max num of preview limit");
 DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview");
 // binlog configuration
@@ -97,6 +110,19 @@ DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
 DEFINE_uint32(put_slow_log_threshold, 50000, "config the threshold of put slow log");
 DEFINE_uint32(query_slow_log_threshold, 50000, "config the threshold of query slow log");
+DEFINE_uint32(query_trace_sample_interval, 0,
+              "config to trace one of every n sql queries into the latency bvars of query stages and runners, "
+              "0 means only the queries sampled by rpcz are traced");
+DEFINE_uint32(request_max_parallel_producers, 0,
+              "config the max number of extra bthreads running the independent blocking producers of a request "
+              "query concurrently, 0 means serial");
+DEFINE_uint32(deploy_result_cache_max_mb, 64,
+              "config the max memory of the result cache of each deployment which sets result_cache_ttl, "
+              "0 means disabled");
+DEFINE_uint32(request_coalesce_window_us, 0,
+              "config the max time in microseconds to collect concurrent requests of the same deployment into one "
+              "batch request while another batch of it is running, 0 means disabled");
+DEFINE_uint32(request_coalesce_max_rows, 64, "config the max number of requests coalesced into one batch request");
 
 // local db config
 DEFINE_string(db_root_path, "/tmp/", "the root path of db");
@@ -110,6 +136,12 @@ DEFINE_int32(request_timeout_ms, 20000, "rpc request timeout of misc. unit is mi
 DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error. unit is milliseconds");
 
 DEFINE_uint32(max_memory_mb, 0, "max memory limit");
+DEFINE_uint32(table_max_memory_mb, 0, "max memory limit of each memory table partition, 0 means unlimited");
+DEFINE_double(memory_soft_limit_ratio, 0.9,
+              "writes are delayed when the memory usage exceeds this ratio of max_memory_mb or table_max_memory_mb");
+DEFINE_uint32(memory_max_write_delay_us, 0,
+              "the max delay of a write when the memory usage reaches the limit, 0 means writes are not delayed");
+DEFINE_uint32(query_max_memory_mb, 0, "max runtime memory of a run step of each query, 0 means unlimited");
 
 DEFINE_uint32(max_traverse_key_cnt, 0, "max traverse iter key cnt");
 DEFINE_uint32(max_traverse_cnt, 0, "max traverse iter loop cnt");
@@ -136,6 +168,13 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
+DEFINE_uint32(compress_dict_sample_cnt, 2000, "config the number of rows sampled to train a compress dict");
+DEFINE_uint32(compress_dict_max_size, 16 * 1024, "config the max size of compress dict, no more than 32KB");
+DEFINE_int32(compress_dict_check_interval, 60 * 1000,
+             "config the interval to check training compress dict of zlib dict tables. unit is milliseconds");
+DEFINE_int32(compress_dict_retrain_interval, 24 * 60,
+             "config the interval to retrain compress dict with the rows sampled after it passes, "
+             "a table keeps its dict after 255 retrains until it is reloaded. unit is minutes");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000,
               "config the max wait time of load index. unit is milliseconds");
@@ -150,6 +189,10 @@ DEFINE_uint32(latest_ttl_max, 1000, "the max ttl of latest");
 DEFINE_uint32(absolute_ttl_max, 60 * 24 * 365 * 30, "the max ttl of absolute time");
 DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
+DEFINE_bool(enable_pk_bloom_filter, false,
+            "keep a bloom filter of the pks in each memtable segment to skip lookups of absent keys");
+DEFINE_uint32(pk_bloom_filter_bits_per_key, 10,
+              "bits per pk of the segment pk filter, 10 gives about 1% false positive");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
@@ -175,6 +218,10 @@ DEFINE_uint32(block_cache_mb, 4096,
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
+DEFINE_uint32(disk_prefix_filter_bits_per_key, 10,
+              "Bits per pk of the prefix filters in the sst files of disk tables, 0 disables the filters");
+DEFINE_bool(disk_prefix_filter_ribbon, false,
+            "Use ribbon instead of bloom prefix filters, about 30% smaller but slower to build");
 DEFINE_uint32(max_log_file_size, 100 * 1024 * 1024, "Specify the maximal size of the rocksdb info log file");
 DEFINE_uint32(keep_log_file_num, 5, "Maximal info log files to be kept");
 
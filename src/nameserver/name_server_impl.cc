@@ -60,6 +60,7 @@ DECLARE_int32(get_task_status_interval);
 DECLARE_int32(name_server_task_pool_size);
 DECLARE_int32(name_server_task_wait_time);
 DECLARE_int32(max_op_num);
+DECLARE_uint32(catalog_change_record_num);
 DECLARE_uint32(partition_num);
 DECLARE_uint32(replica_num);
 DECLARE_bool(auto_failover);
@@ -598,6 +599,14 @@ bool NameServerImpl::Recover() {
                 PDLOG(WARNING, "create zk table changed notify node failed");
                 return false;
             }
+        } else {
+            // the pending changes of the last leader are lost with it, so bump the version without a change
+            // record and every consumer reloads the whole catalog once
+            std::lock_guard<std::mutex> change_lock(change_mu_);
+            pending_changes_.Clear();
+            if (!zk_client_->Increment(zk_path_.table_changed_notify_node_)) {
+                PDLOG(WARNING, "increment failed. node is %s", zk_path_.table_changed_notify_node_.c_str());
+            }
         }
         value.clear();
         if (!zk_client_->GetNodeValue(zk_path_.globalvar_changed_notify_node_, value)) {
@@ -1405,6 +1414,7 @@ bool NameServerImpl::Init(const std::string& zk_cluster, const std::string& zk_p
         zk_path_.zone_data_path_ = zk_path + "/cluster";
         zk_path_.auto_failover_node_ = zk_config_path + "/auto_failover";
         zk_path_.table_changed_notify_node_ = zk_table_path + "/notify";
+        zk_path_.table_changes_path_ = zk_table_path + "/changes";
         zk_path_.globalvar_changed_notify_node_ = zk_path + "/notify/global_variable";
         zk_path_.external_function_path_ = zk_path + "/data/function";
         zone_info_.set_mode(kNORMAL);
@@ -2188,6 +2198,8 @@ base::Status NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmld
     ::openmldb::type::CompressType compress_type = ::openmldb::type::CompressType::kNoCompress;
     if (table_info->compress_type() == ::openmldb::type::kSnappy) {
         compress_type = ::openmldb::type::CompressType::kSnappy;
+    } else if (table_info->compress_type() == ::openmldb::type::kZlibDict) {
+        compress_type = ::openmldb::type::CompressType::kZlibDict;
     }
     ::openmldb::api::TableMeta table_meta;
     table_meta.set_db(table_info->db());
@@ -2197,6 +2209,7 @@ base::Status NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmld
     table_meta.set_compress_type(compress_type);
     table_meta.set_storage_mode(table_info->storage_mode());
     table_meta.set_base_table_tid(table_info->base_table_tid());
+    table_meta.set_memory_head_minutes(table_info->memory_head_minutes());
     if (table_info->has_key_entry_max_height()) {
         table_meta.set_key_entry_max_height(table_info->key_entry_max_height());
     }
@@ -2995,6 +3008,7 @@ void NameServerImpl::DropTableInternel(const DropTableRequest& request, GeneralR
                 code = base::ReturnCode::kSetZkFailed;
             } else {
                 PDLOG(INFO, "delete table node[%s/%u]", zk_path_.db_table_data_path_.c_str(), tid);
+                AddCatalogChange(CatalogChange::kTable, db, name, tid, true);
                 db_table_info_[db].erase(name);
             }
         } else {
@@ -3548,6 +3562,7 @@ bool NameServerImpl::SetTableInfo(std::shared_ptr<::openmldb::nameserver::TableI
         }
         PDLOG(INFO, "create db table node[%s/%u] success! value[%s] value_size[%u]",
               zk_path_.db_table_data_path_.c_str(), table_info->tid(), table_value.c_str(), table_value.length());
+        AddCatalogChange(CatalogChange::kTable, table_info->db(), table_info->name(), table_info->tid(), false);
         {
             std::lock_guard<std::mutex> lock(mu_);
             db_table_info_[table_info->db()].insert(std::make_pair(table_info->name(), table_info));
@@ -3795,6 +3810,7 @@ bool NameServerImpl::SaveTableInfo(std::shared_ptr<TableInfo> table_info) {
         }
         PDLOG(INFO, "create db table node[%s/%s] success!", zk_path_.db_table_data_path_.c_str(),
               table_info->name().c_str());
+        AddCatalogChange(CatalogChange::kTable, table_info->db(), table_info->name(), table_info->tid(), false);
     }
     return true;
 }
@@ -7393,10 +7409,36 @@ void NameServerImpl::NotifyTableChanged(::openmldb::type::NotifyType type) {
         return;
     }
     if (type == ::openmldb::type::NotifyType::kTable) {
+        std::lock_guard<std::mutex> lock(change_mu_);
+        // the record is written before the increment, so it exists once the new version is visible. if someone
+        // else increments in between, the version has no record and the consumers reload the whole catalog
+        std::string value;
+        uint64_t version = 0;
+        if (zk_client_->GetNodeValue(zk_path_.table_changed_notify_node_, value)) {
+            version = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        if (version > 0) {
+            std::string record;
+            pending_changes_.SerializeToString(&record);
+            std::string node = absl::StrCat(zk_path_.table_changes_path_, "/", version + 1);
+            if (!zk_client_->CreateNode(node, record) && !zk_client_->SetNodeValue(node, record)) {
+                PDLOG(WARNING, "write change record failed. node is %s", node.c_str());
+            }
+        }
         if (!zk_client_->Increment(zk_path_.table_changed_notify_node_)) {
             PDLOG(WARNING, "increment failed. node is %s", zk_path_.table_changed_notify_node_.c_str());
             return;
         }
+        pending_changes_.Clear();
+        std::vector<std::string> records;
+        if (version > 0 && zk_client_->GetChildren(zk_path_.table_changes_path_, records)) {
+            for (const auto& record : records) {
+                uint64_t record_version = std::strtoull(record.c_str(), nullptr, 10);
+                if (record_version + FLAGS_catalog_change_record_num <= version + 1) {
+                    zk_client_->DeleteNode(absl::StrCat(zk_path_.table_changes_path_, "/", record));
+                }
+            }
+        }
         PDLOG(INFO, "notify table changed ok");
     } else if (type == ::openmldb::type::NotifyType::kGlobalVar) {
         if (!zk_client_->Increment(zk_path_.globalvar_changed_notify_node_)) {
@@ -7409,6 +7451,20 @@ void NameServerImpl::NotifyTableChanged(::openmldb::type::NotifyType type) {
     }
 }
 
+void NameServerImpl::AddCatalogChange(CatalogChange::ChangeType type, const std::string& db,
+                                      const std::string& name, uint32_t tid, bool deleted) {
+    if (!IsClusterMode() || db.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(change_mu_);
+    auto change = pending_changes_.add_change();
+    change->set_type(type);
+    change->set_db(db);
+    change->set_name(name);
+    change->set_tid(tid);
+    change->set_deleted(deleted);
+}
+
 bool NameServerImpl::GetTableInfo(const std::string& table_name, const std::string& db_name,
                                   std::shared_ptr<TableInfo>* table_info) {
     std::lock_guard<std::mutex> lock(mu_);
@@ -8412,6 +8468,7 @@ bool NameServerImpl::UpdateZkTableNodeWithoutNotify(const TableInfo* table_info)
         return false;
     }
     LOG(INFO) << "update table node[" << temp_path << "] success";
+    AddCatalogChange(CatalogChange::kTable, table_info->db(), table_info->name(), table_info->tid(), false);
     return true;
 }
 
@@ -9324,6 +9381,7 @@ base::Status NameServerImpl::CreateProcedureInternal(const api::CreateProcedureR
                 status = {base::ReturnCode::kCreateZkFailed, "create zk node failed"};
                 break;
             }
+            AddCatalogChange(CatalogChange::kProcedure, sp_db_name, sp_name, 0, false);
         }
         {
             std::lock_guard<std::mutex> lock(mu_);
@@ -9444,6 +9502,7 @@ void NameServerImpl::DropProcedure(RpcController* controller, const api::DropPro
                 response->set_msg("delete storage procedure zk node failed");
                 return;
             }
+            AddCatalogChange(CatalogChange::kProcedure, db_name, sp_name, 0, true);
         }
         auto& sp_table_map = db_sp_table_map_[db_name];
         auto& db_table_pairs = sp_table_map[sp_name];
@@ -9731,6 +9790,7 @@ void NameServerImpl::UpdateOfflineTableInfo(::google::protobuf::RpcController* c
                 LOG(WARNING) << "set table info value failed. table " << table_name << ", node " << table_info_node;
                 return;
             }
+            AddCatalogChange(CatalogChange::kTable, db_name, table_name, tid, false);
         }
         // update in this
         table_infos[table_name] = new_info;
@@ -94,6 +94,7 @@ struct ZkPath {
     std::string db_sp_data_path_;
     std::string auto_failover_node_;
     std::string table_changed_notify_node_;
+    std::string table_changes_path_;
     std::string offline_endpoint_lock_node_;
     std::string zone_data_path_;
     std::string op_index_node_;
@@ -572,6 +573,10 @@ class NameServerImpl : public NameServer {
                           uint32_t concurrency = FLAGS_name_server_task_concurrency_for_replica_cluster);
     // kTable for normal table and kGlobalVar for global var table
     void NotifyTableChanged(::openmldb::type::NotifyType type);
+
+    // record a changed table or procedure node, it is published with the next kTable notify
+    void AddCatalogChange(CatalogChange::ChangeType type, const std::string& db, const std::string& name,
+                          uint32_t tid, bool deleted);
     void DeleteDoneOP();
     void UpdateTableStatus();
     int DropTableOnTablet(std::shared_ptr<::openmldb::nameserver::TableInfo> table_info);
@@ -690,6 +695,10 @@ class NameServerImpl : public NameServer {
 
  private:
     std::mutex mu_;
+    // guards pending_changes_ and the write of change records, it may be taken with mu_ held but not the reverse
+    std::mutex change_mu_;
+    // kept in memory only, a new leader publishes a version without record instead, see Recover
+    CatalogChangeRecord pending_changes_;
     Tablets tablets_;
     ::openmldb::nameserver::TableInfos table_info_;
     std::map<std::string, ::openmldb::nameserver::TableInfos> db_table_info_;
@@ -21,7 +21,9 @@
 
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
+#include "catalog/catalog_change.h"
 #include "client/ns_client.h"
+#include "client/tablet_client.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
 #include "nameserver/name_server_impl.h"
@@ -1281,6 +1283,108 @@ TEST_F(NameServerImplTest, AddField) {
     ASSERT_EQ(table_info1.schema_versions(0).field_count(), 3);
 }
 
+uint64_t GetNotifyVersion(ZkClient* zk_client) {
+    std::string value;
+    if (!zk_client->GetNodeValue(FLAGS_zk_root_path + "/table/notify", value)) {
+        return 0;
+    }
+    return std::stoull(value);
+}
+
+// return the code of a batch query on the tablet, non zero if its catalog misses the table
+int QueryTable(::openmldb::client::TabletClient* client, const std::string& db, const std::string& name) {
+    brpc::Controller cntl;
+    ::openmldb::api::QueryResponse response;
+    if (!client->Query(db, "select * from " + name + ";", {}, "", &cntl, &response)) {
+        return -1;
+    }
+    return response.code();
+}
+
+TEST_F(NameServerImplTest, CatalogChangeRecord) {
+    FLAGS_zk_root_path = "/rtidb3" + ::openmldb::test::GenRand();
+    ZkClient zk_client(FLAGS_zk_cluster, "", 1000, FLAGS_endpoint, FLAGS_zk_root_path, FLAGS_zk_auth_schema,
+                       FLAGS_zk_cert);
+    ASSERT_TRUE(zk_client.Init());
+    // a notify node left by the last leader, the new leader bumps it without a change record
+    ASSERT_TRUE(zk_client.CreateNode(FLAGS_zk_root_path + "/table/notify", "5"));
+
+    brpc::ServerOptions options;
+    brpc::Server server;
+    ASSERT_TRUE(StartNS("127.0.0.1:9634", &server, &options));
+    auto ns_client = std::make_shared<openmldb::client::NsClient>("127.0.0.1:9634", "127.0.0.1:9634");
+    ns_client->Init();
+    brpc::ServerOptions options1;
+    brpc::Server server1;
+    ASSERT_TRUE(StartTablet("127.0.0.1:9535", &server1, &options1));
+    ::openmldb::client::TabletClient tablet_client("127.0.0.1:9535", "");
+    ASSERT_EQ(0, tablet_client.Init());
+
+    std::string change_path = ::openmldb::catalog::CatalogChangePath(FLAGS_zk_root_path);
+    ASSERT_EQ(6u, GetNotifyVersion(&zk_client));
+    ASSERT_EQ(1, zk_client.IsExistNode(change_path + "/6"));
+    ::openmldb::catalog::CatalogDelta delta;
+    ASSERT_FALSE(::openmldb::catalog::LoadCatalogDelta(&zk_client, FLAGS_zk_root_path, 5, 6, &delta));
+
+    std::string db_name = "db1";
+    std::string msg;
+    ASSERT_TRUE(ns_client->CreateDatabase(db_name, msg, true));
+    auto create_table = [&](const std::string& name) {
+        TableInfo table_info;
+        table_info.set_name(name);
+        table_info.set_db(db_name);
+        ::openmldb::test::AddDefaultSchema(0, 0, ::openmldb::type::kAbsoluteTime, &table_info);
+        return ns_client->CreateTable(table_info, true, msg);
+    };
+
+    // the records of the versions in between name the created table
+    uint64_t version = GetNotifyVersion(&zk_client);
+    std::string name1 = "test" + ::openmldb::test::GenRand();
+    ASSERT_TRUE(create_table(name1)) << msg;
+    uint64_t version1 = GetNotifyVersion(&zk_client);
+    ASSERT_GT(version1, version);
+    delta = {};
+    ASSERT_TRUE(::openmldb::catalog::LoadCatalogDelta(&zk_client, FLAGS_zk_root_path, version, version1, &delta));
+    ASSERT_EQ(1u, delta.tables.size());
+    ASSERT_EQ(name1, delta.tables[0].name());
+    ASSERT_TRUE(delta.deleted_tables.empty());
+    uint32_t tid1 = delta.tables[0].tid();
+    sleep(2);
+    ASSERT_EQ(0, QueryTable(&tablet_client, db_name, name1));
+
+    // a dropped table is reported by db, name and tid
+    ASSERT_TRUE(ns_client->DropTable(db_name, name1, msg)) << msg;
+    uint64_t version2 = GetNotifyVersion(&zk_client);
+    delta = {};
+    ASSERT_TRUE(::openmldb::catalog::LoadCatalogDelta(&zk_client, FLAGS_zk_root_path, version, version2, &delta));
+    ASSERT_TRUE(delta.tables.empty());
+    ASSERT_EQ(1u, delta.deleted_tables.size());
+    ASSERT_EQ(tid1, delta.deleted_tables[0].tid());
+    ASSERT_EQ(name1, delta.deleted_tables[0].name());
+    sleep(2);
+    ASSERT_NE(0, QueryTable(&tablet_client, db_name, name1));
+
+    // a version bumped without record, e.g. by the sdk, makes the consumers reload the whole catalog
+    ASSERT_TRUE(zk_client.Increment(FLAGS_zk_root_path + "/table/notify"));
+    std::string name2 = "test" + ::openmldb::test::GenRand();
+    ASSERT_TRUE(create_table(name2)) << msg;
+    uint64_t version3 = GetNotifyVersion(&zk_client);
+    delta = {};
+    ASSERT_FALSE(::openmldb::catalog::LoadCatalogDelta(&zk_client, FLAGS_zk_root_path, version2, version3, &delta));
+    ASSERT_FALSE(::openmldb::catalog::LoadCatalogDelta(&zk_client, FLAGS_zk_root_path, 0, version3, &delta));
+    sleep(2);
+    ASSERT_EQ(0, QueryTable(&tablet_client, db_name, name2));
+    ASSERT_NE(0, QueryTable(&tablet_client, db_name, name1));
+
+    ::openmldb::api::GetCatalogRequest catalog_request;
+    ::openmldb::api::GetCatalogResponse catalog_response;
+    ::openmldb::RpcClient<::openmldb::api::TabletServer_Stub> client("127.0.0.1:9535", "");
+    ASSERT_EQ(0, client.Init());
+    ASSERT_TRUE(client.SendRequest(&::openmldb::api::TabletServer_Stub::GetCatalog, &catalog_request,
+                                   &catalog_response, FLAGS_request_timeout_ms, 1));
+    ASSERT_EQ(version3, catalog_response.catalog().version());
+}
+
 }  // namespace nameserver
 }  // namespace openmldb
 
@@ -391,6 +391,9 @@ base::Status SchemaAdapter::CheckTableMeta(const ::openmldb::nameserver::TableIn
         }
         partition_keys.insert(partition_column);
     }
+    if (table_info.memory_head_minutes() > 0 && table_info.storage_mode() == ::openmldb::common::kMemory) {
+        return {base::ReturnCode::kError, "memory_head_minutes is only supported by disk tables"};
+    }
     return {};
 }
 
@@ -31,11 +31,18 @@
 
 #include "base/hash.h"
 #include "base/strings.h"
+#include "bvar/bvar.h"
+#include "bvar/multi_dimension.h"
+#include "catalog/catalog_change.h"
+#include "common/timer.h"
 #include "glog/logging.h"
 #include "schema/schema_adapter.h"
 
 namespace openmldb::sdk {
 
+// catalog build latency in microseconds, labeled by full or delta build
+static bvar::MultiDimension<bvar::LatencyRecorder> g_catalog_refresh_latency("sdk_catalog_refresh", {"mode"});
+
 std::shared_ptr<::openmldb::client::NsClient> DBSDK::GetNsClient() {
     auto ns_client = std::atomic_load_explicit(&ns_client_, std::memory_order_relaxed);
     if (ns_client) return ns_client;
@@ -183,7 +190,9 @@ ClusterSDK::ClusterSDK(const ClusterOptions& options)
       leader_path_(options.zk_path + "/leader"),
       taskmanager_leader_path_(options.zk_path + "/taskmanager/leader"),
       zk_client_(nullptr),
-      pool_(1) {}
+      pool_(1),
+      build_mu_(),
+      catalog_version_(0) {}
 
 ClusterSDK::~ClusterSDK() {
     pool_.Stop(false);
@@ -400,10 +409,65 @@ bool ClusterSDK::InitTabletClient() {
     return true;
 }
 
+bool ClusterSDK::UpdateCatalogDelta(uint64_t version) {
+    ::openmldb::catalog::CatalogDelta delta;
+    if (!::openmldb::catalog::LoadCatalogDelta(zk_client_, options_.zk_path, catalog_version_, version, &delta)) {
+        LOG(INFO) << "fall back to full catalog build. version " << catalog_version_ << " -> " << version;
+        return false;
+    }
+    if (delta.Empty()) {
+        catalog_version_ = version;
+        return true;
+    }
+    auto new_catalog = std::make_shared<::openmldb::catalog::SDKCatalog>(client_manager_);
+    if (!new_catalog->Init(*GetCatalog(), delta)) {
+        LOG(WARNING) << "fail to apply catalog changes";
+        return false;
+    }
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+        for (const auto& change : delta.deleted_tables) {
+            auto db_it = table_to_tablets_.find(change.db());
+            if (db_it == table_to_tablets_.end()) {
+                continue;
+            }
+            auto it = db_it->second.find(change.name());
+            if (it != db_it->second.end() && it->second->tid() == change.tid()) {
+                db_it->second.erase(it);
+                if (db_it->second.empty()) {
+                    table_to_tablets_.erase(db_it);
+                }
+            }
+        }
+        for (const auto& table_info : delta.tables) {
+            table_to_tablets_[table_info.db()][table_info.name()] =
+                std::make_shared<::openmldb::nameserver::TableInfo>(table_info);
+        }
+        catalog_ = new_catalog;
+    }
+    engine_->UpdateCatalog(new_catalog);
+    catalog_version_ = version;
+    LOG(INFO) << "update catalog with " << delta.tables.size() + delta.deleted_tables.size() << " table and "
+              << delta.procedures.size() + delta.deleted_procedures.size() << " procedure changes. version "
+              << version;
+    return true;
+}
+
 bool ClusterSDK::BuildCatalog() {
+    std::lock_guard<std::mutex> build_lock(build_mu_);
     if (!InitTabletClient()) {
         return false;
     }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    // read the version before the nodes, changes after it are applied again by the next build
+    uint64_t version = 0;
+    if (std::string value; zk_client_->GetNodeValue(notify_path_, value)) {
+        version = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    if (catalog_version_ > 0 && UpdateCatalogDelta(version)) {
+        *g_catalog_refresh_latency.get_stats({"delta"}) << ::baidu::common::timer::get_micros() - start_time;
+        return true;
+    }
 
     std::vector<std::string> table_datas;
     if (zk_client_->IsExistNode(table_root_path_) == 0) {
@@ -425,7 +489,12 @@ bool ClusterSDK::BuildCatalog() {
     } else {
         DLOG(INFO) << "no procedures in db";
     }
-    return UpdateCatalog(table_datas, sp_datas);
+    if (!UpdateCatalog(table_datas, sp_datas)) {
+        return false;
+    }
+    catalog_version_ = version;
+    *g_catalog_refresh_latency.get_stats({"full"}) << ::baidu::common::timer::get_micros() - start_time;
+    return true;
 }
 
 std::vector<std::string> DBSDK::GetAllDbs() {
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -159,6 +160,8 @@ class ClusterSDK : public DBSDK {
  private:
     bool GetRealEndpointFromZk(const std::string& endpoint, std::string* real_endpoint);
     bool UpdateCatalog(const std::vector<std::string>& table_datas, const std::vector<std::string>& sp_datas);
+    // apply the change records up to `version` to a copy of the catalog, return false if a full build is needed
+    bool UpdateCatalogDelta(uint64_t version);
     bool InitTabletClient();
     void WatchNotify();
     void CheckZk();
@@ -177,6 +180,9 @@ class ClusterSDK : public DBSDK {
 
     ::openmldb::zk::ZkClient* zk_client_;
     ::baidu::common::ThreadPool pool_;
+    // serializes catalog builds, catalog_version_ is the notify version the catalog is built from, 0 if none
+    std::mutex build_mu_;
+    uint64_t catalog_version_;
 };
 
 class StandAloneSDK : public DBSDK {
@@ -17,6 +17,7 @@
 #include "sdk/node_adapter.h"
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
@@ -226,6 +227,7 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
 
     hybridse::node::StorageMode storage_mode = hybridse::node::kMemory;
     hybridse::node::CompressType compress_type = hybridse::node::kNoCompress;
+    int64_t memory_head_minutes = 0;
     // different default value for cluster and standalone mode
     int replica_num = 1;
     int partition_num = 1;
@@ -258,6 +260,11 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
                     compress_type = dynamic_cast<hybridse::node::CompressTypeNode *>(table_option)->GetCompressType();
                     break;
                 }
+                case hybridse::node::kMemoryHeadMinutes: {
+                    memory_head_minutes =
+                        dynamic_cast<hybridse::node::MemoryHeadMinutesNode*>(table_option)->GetMinutes();
+                    break;
+                }
                 case hybridse::node::kDistributions: {
                     distribution_list =
                         dynamic_cast<hybridse::node::DistributionsNode*>(table_option)->GetDistributionList();
@@ -282,6 +289,10 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
         *status = {hybridse::common::kUnsupportSql, "invalid storage mode"};
         return false;
     }
+    if (memory_head_minutes < 0 || memory_head_minutes > std::numeric_limits<uint32_t>::max()) {
+        *status = {hybridse::common::kUnsupportSql, "memory_head_minutes out of range"};
+        return false;
+    }
     // deny create table when invalid configuration in standalone mode
     if (!is_cluster_mode) {
         if (replica_num != 1) {
@@ -299,6 +310,9 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
     table->set_partition_num(partition_num);
     table->set_storage_mode(static_cast<common::StorageMode>(storage_mode));
     table->set_compress_type(static_cast<type::CompressType>(compress_type));
+    if (memory_head_minutes > 0) {
+        table->set_memory_head_minutes(static_cast<uint32_t>(memory_head_minutes));
+    }
     bool has_generate_index = false;
     std::set<std::string> index_names;
     std::map<std::string, ::openmldb::common::ColumnDesc*> column_names;
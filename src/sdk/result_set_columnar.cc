@@ -0,0 +1,282 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sdk/result_set_columnar.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/type.h"
+#include "client/tablet_client.h"
+#include "codec/fe_schema_codec.h"
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace sdk {
+
+ResultSetColumnar::ResultSetColumnar(const ::hybridse::vm::Schema& schema,
+                                     const std::shared_ptr<::openmldb::client::TabletClient>& client,
+                                     uint64_t timeout_ms)
+    : schema_(schema),
+      client_(client),
+      timeout_ms_(timeout_ms),
+      result_id_(0),
+      finished_(false),
+      total_cnt_(0),
+      loaded_cnt_(0),
+      cntls_(),
+      copied_blocks_(),
+      views_(),
+      block_idx_(0),
+      row_idx_(-1) {}
+
+std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetColumnar::MakeResultSet(
+    const std::shared_ptr<::openmldb::api::QueryResponse>& response, const std::shared_ptr<brpc::Controller>& cntl,
+    const std::shared_ptr<::openmldb::client::TabletClient>& client, uint64_t timeout_ms,
+    ::hybridse::sdk::Status* status) {
+    if (!status || !response || !cntl) {
+        return {};
+    }
+    ::hybridse::vm::Schema schema;
+    bool ok = ::hybridse::codec::SchemaCodec::Decode(response->schema(), &schema);
+    if (!ok) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "request error, fail to decodec schema"};
+        return {};
+    }
+    auto rs = std::make_shared<ResultSetColumnar>(schema, client, timeout_ms);
+    if (!rs->AddChunk(*response, cntl)) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "request error, ResultSetColumnar init failed"};
+        return {};
+    }
+    *status = {};
+    return rs;
+}
+
+// return the address of [pos, pos + size) in `buf` if it is in one backing block and 8 bytes aligned
+static const int8_t* GetAlignedRange(const butil::IOBuf& buf, size_t pos, size_t size) {
+    size_t start = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); i++) {
+        auto piece = buf.backing_block(i);
+        if (pos < start + piece.size()) {
+            if (pos + size > start + piece.size()) {
+                return nullptr;
+            }
+            const char* addr = piece.data() + (pos - start);
+            if (reinterpret_cast<uintptr_t>(addr) % sizeof(int64_t) != 0) {
+                return nullptr;
+            }
+            return reinterpret_cast<const int8_t*>(addr);
+        }
+        start += piece.size();
+    }
+    return nullptr;
+}
+
+bool ResultSetColumnar::AddChunk(const ::openmldb::api::QueryResponse& response,
+                                 const std::shared_ptr<brpc::Controller>& cntl) {
+    const butil::IOBuf& buf = cntl->response_attachment();
+    // the blocks of a broken chunk are dropped, so the cursor never reads a part of it
+    size_t view_cnt = views_.size();
+    size_t pos = 0;
+    uint32_t row_cnt = 0;
+    for (int i = 0; i < response.block_sizes_size(); i++) {
+        uint32_t size = response.block_sizes(i);
+        if (pos + size > buf.size()) {
+            LOG(WARNING) << "columnar block " << i << " out of attachment range";
+            views_.resize(view_cnt);
+            return false;
+        }
+        const int8_t* block = GetAlignedRange(buf, pos, size);
+        if (block == nullptr) {
+            copied_blocks_.emplace_back(new int64_t[(size + sizeof(int64_t) - 1) / sizeof(int64_t)]);
+            buf.copy_to(copied_blocks_.back().get(), size, pos);
+            block = reinterpret_cast<const int8_t*>(copied_blocks_.back().get());
+        }
+        views_.emplace_back();
+        if (!views_.back().Init(block, size)) {
+            LOG(WARNING) << "fail to init columnar block " << i;
+            views_.resize(view_cnt);
+            return false;
+        }
+        if (views_.back().GetColumnCount() != static_cast<uint32_t>(schema_.GetColumnCnt())) {
+            LOG(WARNING) << "columnar block " << i << " mismatch with schema";
+            views_.resize(view_cnt);
+            return false;
+        }
+        row_cnt += views_.back().GetRowCount();
+        pos += size;
+    }
+    uint32_t total_cnt = response.has_total_count() ? response.total_count() : loaded_cnt_ + row_cnt;
+    if (row_cnt != response.count() || (response.is_finish() && loaded_cnt_ + row_cnt != total_cnt)) {
+        LOG(WARNING) << "columnar row count " << row_cnt << " mismatch with record count " << response.count()
+                     << ", total count " << total_cnt;
+        views_.resize(view_cnt);
+        return false;
+    }
+    // the attachment is kept, the views may point into it
+    cntls_.push_back(cntl);
+    loaded_cnt_ += row_cnt;
+    total_cnt_ = total_cnt;
+    result_id_ = response.result_id();
+    finished_ = response.is_finish();
+    return true;
+}
+
+bool ResultSetColumnar::FetchNextChunk() {
+    if (finished_) {
+        return false;
+    }
+    if (!client_) {
+        LOG(WARNING) << "no tablet client to fetch columnar result " << result_id_;
+        finished_ = true;
+        return false;
+    }
+    auto cntl = std::make_shared<brpc::Controller>();
+    cntl->set_timeout_ms(timeout_ms_);
+    ::openmldb::api::QueryResponse response;
+    if (!client_->FetchColumnarResult(result_id_, cntl.get(), &response) || !AddChunk(response, cntl)) {
+        LOG(WARNING) << "fail to fetch columnar result " << result_id_ << ": " << response.msg()
+                     << ", loaded " << loaded_cnt_ << " of " << total_cnt_ << " rows";
+        finished_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ResultSetColumnar::Reset() {
+    block_idx_ = 0;
+    row_idx_ = -1;
+    return true;
+}
+
+bool ResultSetColumnar::Next() {
+    while (true) {
+        while (block_idx_ < static_cast<int32_t>(views_.size())) {
+            if (row_idx_ + 1 < static_cast<int32_t>(views_[block_idx_].GetRowCount())) {
+                row_idx_++;
+                return true;
+            }
+            block_idx_++;
+            row_idx_ = -1;
+        }
+        if (!FetchNextChunk()) {
+            return false;
+        }
+    }
+}
+
+bool ResultSetColumnar::CheckColumn(uint32_t index, ::hybridse::type::Type type) const {
+    if (block_idx_ >= static_cast<int32_t>(views_.size()) || row_idx_ < 0) {
+        return false;
+    }
+    const auto& view = views_[block_idx_];
+    if (index >= view.GetColumnCount() || view.GetColumnType(index) != type) {
+        return false;
+    }
+    return !view.IsNULL(index, row_idx_);
+}
+
+template <typename T>
+bool ResultSetColumnar::GetFixedValue(uint32_t index, ::hybridse::type::Type type, T* result) {
+    if (result == nullptr) {
+        LOG(WARNING) << "input ptr is null pointer";
+        return false;
+    }
+    if (!CheckColumn(index, type)) {
+        return false;
+    }
+    *result = views_[block_idx_].GetValues<T>(index)[row_idx_];
+    return true;
+}
+
+bool ResultSetColumnar::IsNULL(int index) {
+    if (block_idx_ >= static_cast<int32_t>(views_.size()) || row_idx_ < 0 ||
+        index >= static_cast<int32_t>(views_[block_idx_].GetColumnCount())) {
+        return true;
+    }
+    return views_[block_idx_].IsNULL(index, row_idx_);
+}
+
+bool ResultSetColumnar::GetString(uint32_t index, std::string* str) {
+    if (str == nullptr) {
+        LOG(WARNING) << "input ptr is null pointer";
+        return false;
+    }
+    if (!CheckColumn(index, ::hybridse::type::kVarchar)) {
+        return false;
+    }
+    const char* val = nullptr;
+    uint32_t length = 0;
+    views_[block_idx_].GetString(index, row_idx_, &val, &length);
+    str->assign(val, length);
+    return true;
+}
+
+bool ResultSetColumnar::GetBool(uint32_t index, bool* result) {
+    if (result == nullptr) {
+        LOG(WARNING) << "input ptr is null pointer";
+        return false;
+    }
+    if (!CheckColumn(index, ::hybridse::type::kBool)) {
+        return false;
+    }
+    *result = views_[block_idx_].GetBool(index, row_idx_);
+    return true;
+}
+
+bool ResultSetColumnar::GetInt16(uint32_t index, int16_t* result) {
+    return GetFixedValue(index, ::hybridse::type::kInt16, result);
+}
+
+bool ResultSetColumnar::GetInt32(uint32_t index, int32_t* result) {
+    return GetFixedValue(index, ::hybridse::type::kInt32, result);
+}
+
+bool ResultSetColumnar::GetInt64(uint32_t index, int64_t* result) {
+    return GetFixedValue(index, ::hybridse::type::kInt64, result);
+}
+
+bool ResultSetColumnar::GetFloat(uint32_t index, float* result) {
+    return GetFixedValue(index, ::hybridse::type::kFloat, result);
+}
+
+bool ResultSetColumnar::GetDouble(uint32_t index, double* result) {
+    return GetFixedValue(index, ::hybridse::type::kDouble, result);
+}
+
+bool ResultSetColumnar::GetDate(uint32_t index, int32_t* date) {
+    return GetFixedValue(index, ::hybridse::type::kDate, date);
+}
+
+bool ResultSetColumnar::GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) {
+    int32_t date = 0;
+    if (year == nullptr || month == nullptr || day == nullptr || !GetDate(index, &date)) {
+        return false;
+    }
+    return ::openmldb::base::Date::Decode(date, year, month, day);
+}
+
+bool ResultSetColumnar::GetTime(uint32_t index, int64_t* mills) {
+    return GetFixedValue(index, ::hybridse::type::kTimestamp, mills);
+}
+
+void ResultSetColumnar::CopyTo(hybridse::sdk::ByteArrayPtr buf) {
+    LOG(WARNING) << "columnar result has no row format data to copy";
+}
+
+}  // namespace sdk
+}  // namespace openmldb
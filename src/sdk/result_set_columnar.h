@@ -0,0 +1,132 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_SDK_RESULT_SET_COLUMNAR_H_
+#define SRC_SDK_RESULT_SET_COLUMNAR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "brpc/controller.h"
+#include "butil/iobuf.h"
+#include "codec/columnar_codec.h"
+#include "proto/tablet.pb.h"
+#include "sdk/base_impl.h"
+#include "sdk/result_set.h"
+
+namespace openmldb {
+namespace client {
+class TabletClient;
+}  // namespace client
+
+namespace sdk {
+
+// ResultSet over a columnar query response, see `codec::ColumnarBlockBuilder`.
+// Besides the row cursor api, the column buffers of each block can be read
+// directly through `GetBlock`, which avoids decoding row by row.
+//
+// A large result is sent by the tablet in chunks, the following chunks are
+// fetched by `Next` or `FetchNextChunk` when the loaded blocks are read up.
+class ResultSetColumnar : public ::hybridse::sdk::ResultSet {
+ public:
+    // `client` fetches the following chunks, it is not used if the result is in one chunk
+    ResultSetColumnar(const ::hybridse::vm::Schema& schema,
+                      const std::shared_ptr<::openmldb::client::TabletClient>& client, uint64_t timeout_ms);
+
+    ~ResultSetColumnar() {}
+
+    static std::shared_ptr<::hybridse::sdk::ResultSet> MakeResultSet(
+        const std::shared_ptr<::openmldb::api::QueryResponse>& response, const std::shared_ptr<brpc::Controller>& cntl,
+        const std::shared_ptr<::openmldb::client::TabletClient>& client, uint64_t timeout_ms,
+        ::hybridse::sdk::Status* status);
+
+    // load the blocks of a chunk, `cntl` holds them in its response attachment
+    bool AddChunk(const ::openmldb::api::QueryResponse& response, const std::shared_ptr<brpc::Controller>& cntl);
+
+    // fetch and load the next chunk, return false if the result is finished or the fetch fails
+    bool FetchNextChunk();
+
+    bool IsFinished() const { return finished_; }
+
+    bool Reset() override;
+
+    bool Next() override;
+
+    bool IsNULL(int index) override;
+
+    bool GetString(uint32_t index, std::string* str) override;
+
+    bool GetBool(uint32_t index, bool* result) override;
+
+    bool GetChar(uint32_t index, char* result) override { return false; }
+
+    bool GetInt16(uint32_t index, int16_t* result) override;
+
+    bool GetInt32(uint32_t index, int32_t* result) override;
+
+    bool GetInt64(uint32_t index, int64_t* result) override;
+
+    bool GetFloat(uint32_t index, float* result) override;
+
+    bool GetDouble(uint32_t index, double* result) override;
+
+    bool GetDate(uint32_t index, int32_t* date) override;
+
+    bool GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) override;
+
+    bool GetTime(uint32_t index, int64_t* mills) override;
+
+    const ::hybridse::sdk::Schema* GetSchema() override { return &schema_; }
+
+    int32_t Size() override { return total_cnt_; }
+
+    // there are no row format bytes in a columnar result, read it by the cursor or `GetBlock` instead
+    void CopyTo(hybridse::sdk::ByteArrayPtr buf) override;
+
+    int32_t GetDataLength() override { return 0; }
+
+    // count of the blocks loaded so far
+    uint32_t GetBlockCount() const { return views_.size(); }
+
+    const ::openmldb::codec::ColumnarBlockView& GetBlock(uint32_t idx) const { return views_[idx]; }
+
+ private:
+    template <typename T>
+    bool GetFixedValue(uint32_t index, ::hybridse::type::Type type, T* result);
+
+    bool CheckColumn(uint32_t index, ::hybridse::type::Type type) const;
+
+    ::hybridse::sdk::SchemaImpl schema_;
+    std::shared_ptr<::openmldb::client::TabletClient> client_;
+    uint64_t timeout_ms_;
+    uint64_t result_id_;
+    bool finished_;
+    uint32_t total_cnt_;
+    uint32_t loaded_cnt_;
+    // the blocks are read in place from the attachments of these controllers
+    std::vector<std::shared_ptr<brpc::Controller>> cntls_;
+    // a block which spans several attachment blocks or is not 8 bytes aligned is copied out
+    std::vector<std::unique_ptr<int64_t[]>> copied_blocks_;
+    std::vector<::openmldb::codec::ColumnarBlockView> views_;
+    int32_t block_idx_;
+    int32_t row_idx_;
+};
+
+}  // namespace sdk
+}  // namespace openmldb
+
+#endif  // SRC_SDK_RESULT_SET_COLUMNAR_H_
@@ -90,9 +90,14 @@ std::string SDKUtil::GenCreateTableSQL(const ::openmldb::nameserver::TableInfo&
     }
     if (table_info.compress_type() == type::CompressType::kSnappy) {
         ss << ", COMPRESS_TYPE='Snappy'";
+    } else if (table_info.compress_type() == type::CompressType::kZlibDict) {
+        ss << ", COMPRESS_TYPE='ZlibDict'";
     } else {
         ss << ", COMPRESS_TYPE='NoCompress'";
     }
+    if (table_info.memory_head_minutes() > 0) {
+        ss << ", MEMORY_HEAD_MINUTES=" << table_info.memory_head_minutes();
+    }
     ss << ");";
     return ss.str();
 }
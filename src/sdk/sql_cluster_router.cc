@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
 #include <future>
 #include <memory>
 #include <string>
@@ -54,6 +55,7 @@
 #include "sdk/file_option_parser.h"
 #include "sdk/job_table_helper.h"
 #include "sdk/node_adapter.h"
+#include "sdk/result_set_columnar.h"
 #include "sdk/result_set_sql.h"
 #include "sdk/sdk_util.h"
 #include "sdk/split.h"
@@ -915,52 +917,63 @@ bool SQLClusterRouter::DropTable(const std::string& db, const std::string& table
     }
 
     // delete pre-aggr meta info if need
+    std::vector<std::string> level_tables;
     if (table_info->base_table_tid() > 0) {
         std::string meta_db = openmldb::nameserver::INTERNAL_DB;
         std::string meta_table = openmldb::nameserver::PRE_AGG_META_NAME;
-        std::string select_aggr_info =
-            absl::StrCat("select base_db,base_table,aggr_func,aggr_col,partition_cols,order_by_col,filter_col from ",
-                         meta_db, ".", meta_table, " where aggr_table = '", table_info->name(), "';");
+        std::string select_aggr_info = absl::StrCat(
+            "select base_db,base_table,aggr_func,aggr_col,partition_cols,order_by_col,filter_col,bucket_size from ",
+            meta_db, ".", meta_table, " where aggr_table = '", table_info->name(), "';");
         auto rs = ExecuteSQL("", select_aggr_info, true, true, 0, status);
         WARN_NOT_OK_AND_RET(status, "get aggr info failed", false);
-        if (rs->Size() != 1) {
+        if (rs->Size() > 1) {
             SET_STATUS_AND_WARN(status, StatusCode::kCmdError,
                                 "duplicate records generate with aggr table name: " + table_info->name());
             return false;
         }
-        std::string idx_key;
-        if (rs->Next()) {
-            for (int i = 0; i < rs->GetSchema()->GetColumnCnt(); i++) {
-                if (!idx_key.empty()) {
-                    idx_key += "|";
+        // the coarser level tables of a multi-level long window have no meta info of their own,
+        // they are dropped together with the finest level table
+        if (rs->Size() == 1) {
+            std::string idx_key;
+            if (rs->Next()) {
+                // the unique key is made of the columns before bucket_size
+                int key_cnt = rs->GetSchema()->GetColumnCnt() - 1;
+                for (int i = 0; i < key_cnt; i++) {
+                    if (!idx_key.empty()) {
+                        idx_key += "|";
+                    }
+                    auto k = rs->GetAsStringUnsafe(i);
+                    if (k.empty()) {
+                        idx_key += hybridse::codec::EMPTY_STRING;
+                    } else {
+                        idx_key += k;
+                    }
                 }
-                auto k = rs->GetAsStringUnsafe(i);
-                if (k.empty()) {
-                    idx_key += hybridse::codec::EMPTY_STRING;
-                } else {
-                    idx_key += k;
+                std::vector<std::string> levels = absl::StrSplit(rs->GetAsStringUnsafe(key_cnt), '|');
+                for (size_t level = 1; level < levels.size(); level++) {
+                    level_tables.push_back(absl::StrCat(table_info->name(), "_", levels[level]));
                 }
+            } else {
+                SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "access ResultSet failed");
+                return false;
+            }
+            auto tablet_accessor = cluster_sdk_->GetTablet(meta_db, meta_table, (uint32_t)0);
+            if (!tablet_accessor) {
+                SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "get tablet accessor failed");
+                return false;
+            }
+            auto tablet_client = tablet_accessor->GetClient();
+            if (!tablet_client) {
+                SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "get tablet client failed");
+                return false;
+            }
+            auto tid = cluster_sdk_->GetTableId(meta_db, meta_table);
+            std::string msg;
+            if (!tablet_client->Delete(tid, 0, table_info->name(), "aggr_table", msg) ||
+                !tablet_client->Delete(tid, 0, idx_key, "unique_key", msg)) {
+                SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "delete aggr meta failed");
+                return false;
             }
-        } else {
-            SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "access ResultSet failed");
-            return false;
-        }
-        auto tablet_accessor = cluster_sdk_->GetTablet(meta_db, meta_table, (uint32_t)0);
-        if (!tablet_accessor) {
-            SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "get tablet accessor failed");
-            return false;
-        }
-        auto tablet_client = tablet_accessor->GetClient();
-        if (!tablet_client) {
-            SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "get tablet client failed");
-            return false;
-        }
-        auto tid = cluster_sdk_->GetTableId(meta_db, meta_table);
-        std::string msg;
-        if (!tablet_client->Delete(tid, 0, table_info->name(), "aggr_table", msg) ||
-            !tablet_client->Delete(tid, 0, idx_key, "unique_key", msg)) {
-            SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "delete aggr meta failed");
-            return false;
         }
     }
 
@@ -990,6 +1003,11 @@ bool SQLClusterRouter::DropTable(const std::string& db, const std::string& table
         SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "fail to drop, " + err);
         return false;
     }
+    for (const auto& level_table : level_tables) {
+        if (!DropTable(db, level_table, true, status)) {
+            return false;
+        }
+    }
     return true;
 }
 
@@ -1249,12 +1267,17 @@ std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParamete
     cntl->set_timeout_ms(options_->request_timeout);
     DLOG(INFO) << "send query to tablet " << client->GetEndpoint();
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
+    auto result_format =
+        options_->enable_columnar_result ? ::openmldb::api::kColumnarResult : ::openmldb::api::kRowResult;
     if (!client->Query(db, sql, parameter_types, parameter ? parameter->GetRow() : "", cntl.get(), response.get(),
-                       options_->enable_debug)) {
+                       options_->enable_debug, result_format)) {
         // rpc error is in cntl or response
         RPC_STATUS_AND_WARN(status, cntl, response, "Query rpc failed");
         return {};
     }
+    if (response->result_format() == ::openmldb::api::kColumnarResult) {
+        return ResultSetColumnar::MakeResultSet(response, cntl, client, options_->request_timeout, status);
+    }
     return ResultSetSQL::MakeResultSet(response, cntl, status);
 }
 
@@ -3968,6 +3991,12 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
                     }
                 }
             }
+            // a bucket size like `1h|1d|30d` keeps a pre-aggr table for every level
+            std::vector<std::string> levels = absl::StrSplit(lw.bucket_size_, '|');
+            auto level_status = CheckBucketLevels(levels);
+            if (!level_status.IsOK()) {
+                return level_status;
+            }
             // check if pre-aggr table exists
             ::hybridse::sdk::Status status;
             bool is_exist = CheckPreAggrTableExist(base_table, base_db, lw, &status);
@@ -3991,12 +4020,6 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
                 RETURN_NOT_OK_PREPEND(status, "insert pre-aggr meta failed");
             }
 
-            // create pre-aggr table
-            auto create_status = CreatePreAggrTable(aggr_db, aggr_table, lw, tables[0], ns_client);
-            if (!create_status.OK()) {
-                return {StatusCode::kRunError, "create pre-aggr table failed"};
-            }
-
             // create aggregator
             std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
             bool ret = cluster_sdk_->GetTablet(base_db, base_table, &tablets);
@@ -4007,7 +4030,6 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
             if (!base_table_info) {
                 return {StatusCode::kTableNotFound, "get table info failed"};
             }
-            auto aggr_id = cluster_sdk_->GetTableId(aggr_db, aggr_table);
             ::openmldb::api::TableMeta base_table_meta;
             base_table_meta.set_db(base_table_info->db());
             base_table_meta.set_name(base_table_info->name());
@@ -4035,14 +4057,25 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
             if (!found_idx) {
                 return {StatusCode::kIndexNotFound, "index associated with aggregator not found"};
             }
-            for (uint32_t pid = 0; pid < tablets.size(); ++pid) {
-                auto tablet_client = tablets[pid]->GetClient();
-                if (tablet_client == nullptr) {
-                    return {StatusCode::kRunError, "get tablet client failed"};
+            for (size_t level = 0; level < levels.size(); level++) {
+                // the meta info names the finest level table, coarser tables take the bucket size as suffix
+                std::string level_table = level == 0 ? aggr_table : absl::StrCat(aggr_table, "_", levels[level]);
+                auto create_status = CreatePreAggrTable(aggr_db, level_table, lw, tables[0], ns_client);
+                if (!create_status.OK()) {
+                    return {StatusCode::kRunError, "create pre-aggr table failed"};
                 }
-                base_table_meta.set_pid(pid);
-                if (!tablet_client->CreateAggregator(base_table_meta, aggr_id, pid, index_pos, lw)) {
-                    return {StatusCode::kRunError, "create aggregator failed"};
+                auto aggr_id = cluster_sdk_->GetTableId(aggr_db, level_table);
+                auto level_lw = lw;
+                level_lw.bucket_size_ = levels[level];
+                for (uint32_t pid = 0; pid < tablets.size(); ++pid) {
+                    auto tablet_client = tablets[pid]->GetClient();
+                    if (tablet_client == nullptr) {
+                        return {StatusCode::kRunError, "get tablet client failed"};
+                    }
+                    base_table_meta.set_pid(pid);
+                    if (!tablet_client->CreateAggregator(base_table_meta, aggr_id, pid, index_pos, level_lw)) {
+                        return {StatusCode::kRunError, "create aggregator failed"};
+                    }
                 }
             }
         }
@@ -4050,6 +4083,51 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
     return {};
 }
 
+hybridse::sdk::Status SQLClusterRouter::CheckBucketLevels(const std::vector<std::string>& levels) {
+    if (levels.size() <= 1) {
+        return {};
+    }
+    // every coarser bucket has to be made of whole finer buckets, so a range can be covered by mixing levels
+    int64_t prev_size = 0;
+    for (const auto& level : levels) {
+        if (level.empty() || openmldb::base::IsNumber(level)) {
+            return {StatusCode::kSyntaxError, "bucket size of multi-level long window should be interval: " + level};
+        }
+        std::string num = level.substr(0, level.size() - 1);
+        if (!openmldb::base::IsNumber(num)) {
+            return {StatusCode::kSyntaxError, "illegal bucket size " + level};
+        }
+        int64_t unit = 0;
+        switch (tolower(level.back())) {
+            case 's':
+                unit = 1000;
+                break;
+            case 'm':
+                unit = 1000 * 60;
+                break;
+            case 'h':
+                unit = 1000 * 60 * 60;
+                break;
+            case 'd':
+                unit = 1000 * 60 * 60 * 24;
+                break;
+            default:
+                return {StatusCode::kSyntaxError, "illegal bucket size " + level};
+        }
+        int64_t size = 0;
+        if (!absl::SimpleAtoi(num, &size) || size <= 0 || size > std::numeric_limits<int64_t>::max() / unit) {
+            return {StatusCode::kSyntaxError, "illegal bucket size " + level};
+        }
+        size *= unit;
+        if (size <= prev_size || (prev_size > 0 && size % prev_size != 0)) {
+            return {StatusCode::kSyntaxError,
+                    "bucket sizes of multi-level long window should be increasing multiples: " + level};
+        }
+        prev_size = size;
+    }
+    return {};
+}
+
 bool SQLClusterRouter::CheckPreAggrTableExist(const std::string& base_table, const std::string& base_db,
                                               const openmldb::base::LongWindowInfo& lw,
                                               ::hybridse::sdk::Status* status) {
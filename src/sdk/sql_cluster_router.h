@@ -380,6 +380,8 @@ class SQLClusterRouter : public SQLRouter {
 
     hybridse::sdk::Status HandleCreateFunction(const hybridse::node::CreateFunctionPlanNode* node);
 
+    static hybridse::sdk::Status CheckBucketLevels(const std::vector<std::string>& levels);
+
     hybridse::sdk::Status HandleLongWindows(const hybridse::node::DeployPlanNode* deploy_node,
                                             const std::set<std::pair<std::string, std::string>>& table_pair,
                                             const std::string& select_sql);
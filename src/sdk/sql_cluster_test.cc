@@ -275,6 +275,19 @@ TEST_F(SQLClusterDDLTest, ShowCreateTable) {
     ASSERT_TRUE(router->ExecuteDDL(db, "drop table t1;", &status));
 }
 
+TEST_F(SQLClusterDDLTest, MemoryHeadMinutes) {
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table if exists t1;", &status));
+    // the memory head is a part of disk tables, memory tables reject it
+    std::string ddl = "create table t1 (col1 string, col2 bigint, index(key=col1, ts=col2)) "
+                      "options (storage_mode='memory', memory_head_minutes=10);";
+    ASSERT_FALSE(router->ExecuteDDL(db, ddl, &status));
+    ASSERT_TRUE(status.msg.find("memory_head_minutes is only supported by disk tables") != std::string::npos)
+        << status.msg;
+    ddl = "create table t1 (col1 string, col2 bigint, index(key=col1, ts=col2)) options (memory_head_minutes=-1);";
+    ASSERT_FALSE(router->ExecuteDDL(db, ddl, &status));
+}
+
 TEST_F(SQLClusterDDLTest, CreateTableWithDatabaseWrongDDL) {
     std::string name = "test" + GenRand();
     ::hybridse::sdk::Status status;
@@ -788,6 +801,78 @@ TEST_F(SQLClusterTest, CreatePreAggrTable) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLClusterTest, MultiLevelLongWindow) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    SetOnlineMode(router);
+    ASSERT_TRUE(router != nullptr);
+    std::string base_table = "test" + GenRand();
+    std::string base_db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(base_db, &status));
+    std::string ddl = "create table " + base_table +
+                      "(col1 string, col2 bigint, col3 int,"
+                      " index(key=col1, ts=col2, TTL_TYPE=absolute, TTL=1m)) options(partitionnum=4);";
+    ASSERT_TRUE(router->ExecuteDDL(base_db, ddl, &status));
+    ASSERT_TRUE(router->RefreshCatalog());
+    router->ExecuteSQL(base_db, "use " + base_db + ";", &status);
+
+    auto deploy = [&](const std::string& bucket_size) {
+        std::string deploy_sql = "deploy test1 options(long_windows='w1:" + bucket_size +
+                                 "') select col1, sum(col3) over w1 as w1_sum_col3 from " + base_table +
+                                 " WINDOW w1 AS (PARTITION BY col1 ORDER BY col2"
+                                 " ROWS_RANGE BETWEEN 20m PRECEDING AND CURRENT ROW);";
+        router->ExecuteSQL(base_db, deploy_sql, &status);
+    };
+    deploy("1m|1s");
+    ASSERT_EQ(status.code, ::hybridse::common::StatusCode::kSyntaxError);
+    ASSERT_EQ(status.msg, "bucket sizes of multi-level long window should be increasing multiples: 1s");
+    deploy("1m|90s");
+    ASSERT_EQ(status.code, ::hybridse::common::StatusCode::kSyntaxError);
+    ASSERT_EQ(status.msg, "bucket sizes of multi-level long window should be increasing multiples: 90s");
+    deploy("1s|1000");
+    ASSERT_EQ(status.code, ::hybridse::common::StatusCode::kSyntaxError);
+    ASSERT_EQ(status.msg, "bucket size of multi-level long window should be interval: 1000");
+    deploy("1s|99999999999999999999d");
+    ASSERT_EQ(status.code, ::hybridse::common::StatusCode::kSyntaxError);
+    ASSERT_EQ(status.msg, "illegal bucket size 99999999999999999999d");
+
+    deploy("1s|1m");
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_TRUE(router->RefreshCatalog());
+    auto ns_client = mc_->GetNsClient();
+    std::string pre_aggr_db = openmldb::nameserver::PRE_AGG_DB;
+    std::string aggr_table = "pre_" + base_db + "_test1_w1_sum_col3";
+    std::string msg;
+    std::vector<::openmldb::nameserver::TableInfo> agg_tables;
+    ASSERT_TRUE(ns_client->ShowTable(aggr_table, pre_aggr_db, false, agg_tables, msg));
+    ASSERT_EQ(1, agg_tables.size());
+    agg_tables.clear();
+    ASSERT_TRUE(ns_client->ShowTable(aggr_table + "_1m", pre_aggr_db, false, agg_tables, msg));
+    ASSERT_EQ(1, agg_tables.size());
+    auto rs = router->ExecuteSQL(openmldb::nameserver::INTERNAL_DB,
+                                 "select bucket_size from " + std::string(openmldb::nameserver::PRE_AGG_META_NAME) +
+                                     " where aggr_table = '" + aggr_table + "';",
+                                 &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_EQ(1, rs->Size());
+    ASSERT_TRUE(rs->Next());
+    ASSERT_EQ("1s|1m", rs->GetStringUnsafe(0));
+
+    // dropping the finest level table drops the coarser level tables as well
+    ASSERT_TRUE(ns_client->DropProcedure(base_db, "test1", msg));
+    ASSERT_TRUE(router->ExecuteDDL(pre_aggr_db, "drop table " + aggr_table + ";", &status)) << status.msg;
+    ASSERT_TRUE(router->RefreshCatalog());
+    agg_tables.clear();
+    ns_client->ShowTable(aggr_table + "_1m", pre_aggr_db, false, agg_tables, msg);
+    ASSERT_EQ(0, agg_tables.size());
+
+    ASSERT_TRUE(router->ExecuteDDL(base_db, "drop table " + base_table + ";", &status));
+    ASSERT_TRUE(router->DropDB(base_db, &status));
+}
+
 TEST_F(SQLClusterTest, Aggregator) {
     SQLRouterOptions sql_opt;
     sql_opt.zk_cluster = mc_->GetZkCluster();
@@ -49,6 +49,9 @@ struct BasicRouterOptions {
     int glog_level = 0;
     // empty means to stderr
     std::string glog_dir = "";
+    // fetch batch query results in columnar blocks. A large result is fetched in chunks of about tablet
+    // scan_max_bytes_size, so it is not truncated as row results
+    bool enable_columnar_result = false;
 };
 
 struct SQLRouterOptions : BasicRouterOptions {
@@ -54,6 +54,16 @@ class TableReader {
                                                                  const std::string& key, int64_t st, int64_t et,
                                                                  const ScanOption& so, int64_t timeout_ms,
                                                                  hybridse::sdk::Status* status) = 0;
+
+    // scan many keys of one table, each tablet gets one request with all the keys of its partitions and the
+    // requests run in parallel, each of them within `timeout_ms`. return one result set per key in the order of
+    // `keys`, nullptr if the key failed
+    virtual std::vector<std::shared_ptr<hybridse::sdk::ResultSet>> MultiScan(const std::string& db,
+                                                                             const std::string& table,
+                                                                             const std::vector<std::string>& keys,
+                                                                             int64_t st, int64_t et,
+                                                                             const ScanOption& so, int64_t timeout_ms,
+                                                                             hybridse::sdk::Status* status) = 0;
 };
 
 }  // namespace sdk
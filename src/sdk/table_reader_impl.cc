@@ -16,13 +16,16 @@
 
 #include "sdk/table_reader_impl.h"
 
+#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/hash.h"
 #include "brpc/channel.h"
 #include "client/tablet_client.h"
 #include "proto/tablet.pb.h"
+#include "schema/schema_adapter.h"
 #include "sdk/result_set_sql.h"
 
 namespace openmldb {
@@ -197,5 +200,106 @@ std::shared_ptr<hybridse::sdk::ResultSet> TableReaderImpl::Scan(const std::strin
     return rs;
 }
 
+std::vector<std::shared_ptr<hybridse::sdk::ResultSet>> TableReaderImpl::MultiScan(
+    const std::string& db, const std::string& table, const std::vector<std::string>& keys, int64_t st, int64_t et,
+    const ScanOption& so, int64_t timeout_ms, ::hybridse::sdk::Status* status) {
+    std::vector<std::shared_ptr<hybridse::sdk::ResultSet>> result_sets(keys.size());
+    auto table_handler = cluster_sdk_->GetCatalog()->GetTable(db, table);
+    if (!table_handler) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "fail to get table " + table + " desc from catalog"};
+        return result_sets;
+    }
+    auto sdk_table_handler = dynamic_cast<::openmldb::catalog::SDKTableHandler*>(table_handler.get());
+    ::google::protobuf::RepeatedField<uint32_t> projection;
+    for (const auto& col : so.projection) {
+        int32_t col_idx = sdk_table_handler->GetColumnIndex(col);
+        if (col_idx < 0) {
+            *status = {::hybridse::common::StatusCode::kCmdError, "fail to get col " + col + " from table " + table};
+            return result_sets;
+        }
+        projection.Add(static_cast<uint32_t>(col_idx));
+    }
+    ::hybridse::vm::Schema schema = *(sdk_table_handler->GetSchema());
+    if (projection.size() > 0 &&
+        !::openmldb::schema::SchemaAdapter::SubSchema(sdk_table_handler->GetSchema(), projection, &schema)) {
+        *status = {::hybridse::common::StatusCode::kCmdError, "fail to get sub schema"};
+        return result_sets;
+    }
+    // group the keys by the partition they live in
+    uint32_t pid_num = sdk_table_handler->GetPartitionNum();
+    std::map<uint32_t, std::vector<size_t>> pid_keys;
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint32_t pid = pid_num > 0 ? ::openmldb::base::hash64(keys[i]) % pid_num : 0;
+        pid_keys[pid].push_back(i);
+    }
+    using Callback = openmldb::RpcCallback<openmldb::api::MultiScanResponse>;
+    std::vector<std::pair<Callback*, const std::vector<size_t>*>> calls;
+    *status = {};
+    for (const auto& kv : pid_keys) {
+        auto accessor = sdk_table_handler->GetTablet(kv.first);
+        auto client = accessor ? accessor->GetClient() : nullptr;
+        if (!client) {
+            *status = {::hybridse::common::StatusCode::kCmdError,
+                       "fail to get tablet of pid " + std::to_string(kv.first)};
+            continue;
+        }
+        ::openmldb::api::MultiScanRequest request;
+        request.set_tid(sdk_table_handler->GetTid());
+        request.set_pid(kv.first);
+        request.mutable_projection()->CopyFrom(projection);
+        for (size_t idx : kv.second) {
+            auto* key = request.add_keys();
+            key->set_pk(keys[idx]);
+            key->set_st(st);
+            key->set_et(et);
+            key->set_limit(so.limit);
+            if (!so.idx_name.empty()) {
+                key->set_idx_name(so.idx_name);
+            }
+        }
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(timeout_ms);
+        auto* callback = new Callback(std::make_shared<openmldb::api::MultiScanResponse>(), cntl);
+        // one reference for the rpc and one for the join below
+        callback->Ref();
+        if (!client->AsyncMultiScan(request, callback)) {
+            callback->UnRef();
+            callback->UnRef();
+            *status = {::hybridse::common::kRpcError, "fail to send request to pid " + std::to_string(kv.first)};
+            continue;
+        }
+        calls.emplace_back(callback, &kv.second);
+    }
+    for (const auto& call : calls) {
+        auto* callback = call.first;
+        const auto& cntl = callback->GetController();
+        const auto& response = callback->GetResponse();
+        brpc::Join(cntl->call_id());
+        if (cntl->Failed()) {
+            *status = {::hybridse::common::kRpcError, "request error, " + cntl->ErrorText()};
+        } else if (response->code() != ::openmldb::base::kOk ||
+                   static_cast<size_t>(response->results_size()) != call.second->size()) {
+            *status = {response->code(), "request error, " + response->msg()};
+        } else {
+            butil::IOBuf& buf = cntl->response_attachment();
+            for (int i = 0; i < response->results_size(); i++) {
+                const auto& result = response->results(i);
+                auto io_buf = std::make_shared<butil::IOBuf>();
+                buf.cutn(io_buf.get(), result.buf_size());
+                if (result.code() != ::openmldb::base::kOk) {
+                    *status = {result.code(), "request error, " + result.msg()};
+                    continue;
+                }
+                auto rs = std::make_shared<ResultSetSQL>(schema, result.count(), io_buf);
+                if (rs->Init()) {
+                    result_sets[call.second->at(i)] = rs;
+                }
+            }
+        }
+        callback->UnRef();
+    }
+    return result_sets;
+}
+
 }  // namespace sdk
 }  // namespace openmldb
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "sdk/db_sdk.h"
 #include "sdk/table_reader.h"
@@ -40,6 +41,12 @@ class TableReaderImpl : public TableReader {
                                                          const ScanOption& so, int64_t timeout_ms,
                                                          ::hybridse::sdk::Status* status);
 
+    std::vector<std::shared_ptr<hybridse::sdk::ResultSet>> MultiScan(const std::string& db, const std::string& table,
+                                                                     const std::vector<std::string>& keys, int64_t st,
+                                                                     int64_t et, const ScanOption& so,
+                                                                     int64_t timeout_ms,
+                                                                     ::hybridse::sdk::Status* status);
+
  private:
     DBSDK* cluster_sdk_;
 };
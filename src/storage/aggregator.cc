@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <utility>
 
+#include "absl/hash/hash.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -26,15 +27,29 @@
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
 #include "base/strings.h"
+#include "common/thread_pool.h"
 #include "common/timer.h"
 #include "storage/table.h"
 
 DECLARE_bool(binlog_notify_on_put);
+DECLARE_uint32(aggr_flush_thread_num);
+DECLARE_uint32(aggr_max_pending_flush);
+DECLARE_uint32(aggr_recover_batch_size);
 namespace openmldb {
 namespace storage {
 
 using ::openmldb::base::StringCompare;
 
+namespace {
+
+// shared by the aggregators of all the tables, a task writes the queued buckets of one aggregator
+::baidu::common::ThreadPool* GetFlushPool() {
+    static ::baidu::common::ThreadPool pool(FLAGS_aggr_flush_thread_num);
+    return &pool;
+}
+
+}  // namespace
+
 std::string AggrStatToString(AggrStat type) {
     std::string output;
     switch (type) {
@@ -106,68 +121,121 @@ bool Aggregator::Update(const std::string& key, const std::string& row, uint64_t
     }
     auto row_ptr = reinterpret_cast<const int8_t*>(row.c_str());
     int64_t cur_ts = 0;
+    std::string filter_key;
+    if (!ParseRow(row_ptr, &cur_ts, &filter_key)) {
+        return false;
+    }
+    AggrBufferLocked* aggr_buffer_lock = GetOrCreateBuffer(key, filter_key);
+    std::unique_lock<std::mutex> lock(*aggr_buffer_lock->mu_);
+    return UpdateBuffer(key, filter_key, row_ptr, cur_ts, offset, recover, &lock, &aggr_buffer_lock->buffer_);
+}
+
+bool Aggregator::Update(const std::vector<AggrRow>& rows, bool recover) {
+    if (!recover && GetStat() != AggrStat::kInited) {
+        PDLOG(WARNING, "Aggregator status is not kInited");
+        return false;
+    }
+    // group the rows by key and keep the order of the rows of one key
+    std::vector<uint32_t> order(rows.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&rows](uint32_t l, uint32_t r) { return rows[l].key < rows[r].key; });
+    bool ok = true;
+    AggrBufferLocked* aggr_buffer_lock = nullptr;
+    const std::string* cur_key = nullptr;
+    std::string cur_filter_key;
+    std::unique_lock<std::mutex> lock;
+    for (uint32_t idx : order) {
+        const auto& aggr_row = rows[idx];
+        auto row_ptr = reinterpret_cast<const int8_t*>(aggr_row.row.c_str());
+        int64_t cur_ts = 0;
+        std::string filter_key;
+        if (!ParseRow(row_ptr, &cur_ts, &filter_key)) {
+            ok = false;
+            continue;
+        }
+        if (aggr_buffer_lock == nullptr || *cur_key != aggr_row.key || cur_filter_key != filter_key) {
+            if (lock.owns_lock()) {
+                lock.unlock();
+            }
+            aggr_buffer_lock = GetOrCreateBuffer(aggr_row.key, filter_key);
+            cur_key = &aggr_row.key;
+            cur_filter_key = filter_key;
+            lock = std::unique_lock<std::mutex>(*aggr_buffer_lock->mu_);
+        } else if (!lock.owns_lock()) {
+            lock.lock();
+        }
+        if (!UpdateBuffer(aggr_row.key, filter_key, row_ptr, cur_ts, aggr_row.offset, recover, &lock,
+                          &aggr_buffer_lock->buffer_)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool Aggregator::ParseRow(const int8_t* row_ptr, int64_t* cur_ts, std::string* filter_key) {
     if  (ts_col_type_ == DataType::kBigInt || ts_col_type_ == DataType::kTimestamp) {
-        base_row_view_.GetValue(row_ptr, ts_col_idx_, ts_col_type_, &cur_ts);
+        base_row_view_.GetValue(row_ptr, ts_col_idx_, ts_col_type_, cur_ts);
     } else {
         PDLOG(ERROR, "Unsupported timestamp data type");
         return false;
     }
-    std::string filter_key = "";
+    filter_key->clear();
     if (filter_col_idx_ != -1) {
         if (!base_row_view_.IsNULL(row_ptr, filter_col_idx_)) {
-            base_row_view_.GetStrValue(row_ptr, filter_col_idx_, &filter_key);
+            base_row_view_.GetStrValue(row_ptr, filter_col_idx_, filter_key);
         }
     }
 
-    if (!filter_key.empty() && window_type_ != WindowType::kRowsRange) {
+    if (!filter_key->empty() && window_type_ != WindowType::kRowsRange) {
         LOG(ERROR) << "unsupport rows bucket window for *_where agg op";
         return false;
     }
+    return true;
+}
 
-    AggrBufferLocked* aggr_buffer_lock;
-    {
-        std::lock_guard<std::mutex> lock(mu_);
-        auto it = aggr_buffer_map_.find(key);
-        if (it == aggr_buffer_map_.end()) {
-            auto insert_pair = aggr_buffer_map_[key].emplace(filter_key, AggrBufferLocked{});
-            aggr_buffer_lock = &insert_pair.first->second;
-        } else {
-            auto& filter_map = it->second;
-            auto filter_it = filter_map.find(filter_key);
-            if (filter_it == filter_map.end()) {
-                auto insert_pair = filter_map.emplace(filter_key, AggrBufferLocked{});
-                aggr_buffer_lock = &insert_pair.first->second;
-            } else {
-                aggr_buffer_lock = &filter_it->second;
-            }
-        }
-    }
+Aggregator::BufferShard& Aggregator::GetShard(const std::string& key) {
+    return buffer_shards_[absl::Hash<std::string>{}(key) % kBufferShardNum];
+}
 
-    std::unique_lock<std::mutex> lock(*aggr_buffer_lock->mu_);
-    AggrBuffer& aggr_buffer = aggr_buffer_lock->buffer_;
+AggrBufferLocked* Aggregator::GetOrCreateBuffer(const std::string& key, const std::string& filter_key) {
+    auto& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto& filter_map = shard.buffer_map[key];
+    auto it = filter_map.find(filter_key);
+    if (it == filter_map.end()) {
+        it = filter_map.emplace(filter_key, AggrBufferLocked{}).first;
+    }
+    return &it->second;
+}
 
+bool Aggregator::UpdateBuffer(const std::string& key, const std::string& filter_key, const int8_t* row_ptr,
+                              int64_t cur_ts, uint64_t offset, bool recover, std::unique_lock<std::mutex>* lock,
+                              AggrBuffer* aggr_buffer) {
     // init buffer timestamp range
-    if (aggr_buffer.ts_begin_ == -1) {
-        aggr_buffer.data_type_ = aggr_col_type_;
-        aggr_buffer.ts_begin_ = AlignedStart(cur_ts);
+    if (aggr_buffer->ts_begin_ == -1) {
+        aggr_buffer->data_type_ = aggr_col_type_;
+        aggr_buffer->ts_begin_ = AlignedStart(cur_ts);
         if (window_type_ == WindowType::kRowsRange) {
-            aggr_buffer.ts_end_ = aggr_buffer.ts_begin_ + window_size_ - 1;
+            aggr_buffer->ts_end_ = aggr_buffer->ts_begin_ + window_size_ - 1;
         }
     }
 
-    if (offset < aggr_buffer.binlog_offset_) {
+    if (offset < aggr_buffer->binlog_offset_) {
         if (recover) {
             return true;
         } else {
             PDLOG(ERROR, "logical error: current offset %lu is smaller than binlog offset %lu",
-                  offset, aggr_buffer.binlog_offset_);
+                  offset, aggr_buffer->binlog_offset_);
             return false;
         }
     }
 
-    if (cur_ts < aggr_buffer.ts_begin_) {
+    if (cur_ts < aggr_buffer->ts_begin_) {
         // handle the case that the current timestamp is smaller than the begin timestamp in aggregate buffer
-        lock.unlock();
+        lock->unlock();
         if (recover) {
             // avoid out-of-order duplicate writes during the recovery phase
             return true;
@@ -180,26 +248,24 @@ bool Aggregator::Update(const std::string& key, const std::string& row, uint64_t
         return true;
     }
 
-    if (CheckBufferFilled(cur_ts, aggr_buffer.ts_end_, aggr_buffer.aggr_cnt_)) {
-        AggrBuffer flush_buffer = aggr_buffer;
-        uint64_t latest_binlog = aggr_buffer.binlog_offset_ + 1;
-        aggr_buffer.Clear();
-        aggr_buffer.binlog_offset_ = latest_binlog;
-        aggr_buffer.ts_begin_ = AlignedStart(cur_ts);
+    if (CheckBufferFilled(cur_ts, aggr_buffer->ts_end_, aggr_buffer->aggr_cnt_)) {
+        // the filled bucket is written by the flush pool, the put path only pays for a copy
+        ScheduleFlush(key, filter_key, *aggr_buffer);
+        uint64_t latest_binlog = aggr_buffer->binlog_offset_ + 1;
+        aggr_buffer->Clear();
+        aggr_buffer->binlog_offset_ = latest_binlog;
+        aggr_buffer->ts_begin_ = AlignedStart(cur_ts);
         if (window_type_ == WindowType::kRowsRange) {
-            aggr_buffer.ts_end_ = aggr_buffer.ts_begin_ + window_size_ - 1;
+            aggr_buffer->ts_end_ = aggr_buffer->ts_begin_ + window_size_ - 1;
         }
-        lock.unlock();
-        FlushAggrBuffer(key, filter_key, flush_buffer);
-        lock.lock();
     }
 
-    aggr_buffer.aggr_cnt_++;
-    aggr_buffer.binlog_offset_ = offset;
+    aggr_buffer->aggr_cnt_++;
+    aggr_buffer->binlog_offset_ = offset;
     if (window_type_ == WindowType::kRowsNum) {
-        aggr_buffer.ts_end_ = cur_ts;
+        aggr_buffer->ts_end_ = cur_ts;
     }
-    bool ok = UpdateAggrVal(base_row_view_, row_ptr, &aggr_buffer);
+    bool ok = UpdateAggrVal(base_row_view_, row_ptr, aggr_buffer);
     if (!ok) {
         PDLOG(ERROR, "Update aggr value failed");
         return false;
@@ -207,12 +273,65 @@ bool Aggregator::Update(const std::string& key, const std::string& row, uint64_t
     return true;
 }
 
+void Aggregator::ScheduleFlush(const std::string& key, const std::string& filter_key, const AggrBuffer& aggr_buffer) {
+    bool schedule = false;
+    bool too_many = false;
+    {
+        std::lock_guard<std::mutex> lock(flush_queue_mu_);
+        flush_queue_.push_back({key, filter_key, std::make_unique<AggrBuffer>(aggr_buffer)});
+        too_many = flush_queue_.size() >= FLAGS_aggr_max_pending_flush;
+        if (!flush_scheduled_ && !too_many) {
+            flush_scheduled_ = true;
+            schedule = true;
+        }
+    }
+    std::shared_ptr<Aggregator> self;
+    if (schedule) {
+        self = weak_from_this().lock();
+    }
+    if (self) {
+        GetFlushPool()->AddTask([self]() { self->WaitFlush(); });
+    } else if (schedule || too_many) {
+        // the flusher falls behind or the aggregator is not shared, write in the caller
+        WaitFlush();
+    }
+}
+
+bool Aggregator::WaitFlush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mu_);
+    return DrainFlushQueue();
+}
+
+bool Aggregator::DrainFlushQueue() {
+    bool ok = true;
+    while (true) {
+        std::vector<PendingFlush> pending;
+        {
+            std::lock_guard<std::mutex> lock(flush_queue_mu_);
+            if (flush_queue_.empty()) {
+                flush_scheduled_ = false;
+                break;
+            }
+            pending.swap(flush_queue_);
+        }
+        for (const auto& flush : pending) {
+            if (!FlushAggrBuffer(flush.key, flush.filter_key, *flush.buffer)) {
+                PDLOG(WARNING, "flush aggr buffer failed. key %s, aggr table %s", flush.key.c_str(),
+                      aggr_table_->GetName().c_str());
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
 bool Aggregator::DeleteData(const std::string& key, const std::optional<uint64_t>& start_ts,
         const std::optional<uint64_t>& end_ts) {
     if (!start_ts.has_value() && !end_ts.has_value()) {
-        std::lock_guard<std::mutex> lock(mu_);
-        // erase from the aggr_buffer_map_
-        aggr_buffer_map_.erase(key);
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mu);
+        // erase from the buffer map
+        shard.buffer_map.erase(key);
     }
     ::openmldb::api::LogEntry entry;
     entry.set_term(aggr_replicator_->GetLeaderTerm());
@@ -244,14 +363,18 @@ bool Aggregator::DeleteData(const std::string& key, const std::optional<uint64_t
 
 bool Aggregator::Delete(const std::string& key, const std::optional<uint64_t>& start_ts,
         const std::optional<uint64_t>& end_ts) {
+    // the queued buckets have to be in the aggr table before it is deleted from
+    std::lock_guard<std::mutex> flush_lock(flush_mu_);
+    DrainFlushQueue();
     if (!start_ts.has_value() && !end_ts.has_value()) {
         return DeleteData(key, start_ts, end_ts);
     }
     uint64_t real_start_ts = start_ts.has_value() ? start_ts.value() : UINT64_MAX;
     std::vector<AggrBufferLocked*> aggr_buffer_lock_vec;
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        if (auto it = aggr_buffer_map_.find(key); it != aggr_buffer_map_.end()) {
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mu);
+        if (auto it = shard.buffer_map.find(key); it != shard.buffer_map.end()) {
             for (auto& kv : it->second) {
                 auto& buffer = kv.second.buffer_;
                 if (buffer.IsInited() && real_start_ts >= static_cast<uint64_t>(buffer.ts_begin_) &&
@@ -399,19 +522,23 @@ bool Aggregator::RebuildAggrBuffer(const std::string& key, AggrBuffer* aggr_buff
 }
 
 bool Aggregator::FlushAll() {
-    // TODO(nauta): optimize the flush process
-    std::unique_lock<std::mutex> lock(mu_);
+    std::lock_guard<std::mutex> flush_lock(flush_mu_);
+    if (!DrainFlushQueue()) {
+        return false;
+    }
     absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, AggrBuffer>> flushed_buffer_map;
-    for (auto& it : aggr_buffer_map_) {
-        for (auto& filter_it : it.second) {
-            auto& aggr_buffer = filter_it.second.buffer_;
-            if (aggr_buffer.aggr_cnt_ == 0) {
-                continue;
+    for (auto& shard : buffer_shards_) {
+        std::lock_guard<std::mutex> lock(shard.mu);
+        for (auto& it : shard.buffer_map) {
+            for (auto& filter_it : it.second) {
+                auto& aggr_buffer = filter_it.second.buffer_;
+                if (aggr_buffer.aggr_cnt_ == 0) {
+                    continue;
+                }
+                flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
             }
-            flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
         }
     }
-    lock.unlock();
     for (auto& it : flushed_buffer_map) {
         for (auto& filter_it : it.second) {
             if (!FlushAggrBuffer(it.first, filter_it.first, filter_it.second)) {
@@ -451,7 +578,7 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
         if (!aggr_row_view_.IsNULL(data_ptr, 6)) {
             aggr_row_view_.GetStrValue(data_ptr, 6, &filter_key);
         }
-        auto insert_pair = aggr_buffer_map_[pk].emplace(std::move(filter_key), AggrBufferLocked{});
+        auto insert_pair = GetShard(pk).buffer_map[pk].emplace(std::move(filter_key), AggrBufferLocked{});
         auto& buffer = insert_pair.first->second.buffer_;
         auto val = it->GetValue();
         auto aggr_row_ptr = reinterpret_cast<const int8_t*>(val.data());
@@ -486,6 +613,8 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
     uint64_t cur_offset = recovery_offset;
     std::string buffer;
     int last_log_index = log_reader.GetLogIndex();
+    // puts are replayed in batches, a delete applies the rows before it first
+    std::vector<AggrRow> batch;
     while (true) {
         buffer.clear();
         ::openmldb::base::Slice record;
@@ -527,15 +656,22 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
                         std::optional<uint64_t>(entry.ts()) : std::nullopt;
                     std::optional<uint64_t> end_ts = entry.has_end_ts() ?
                         std::optional<uint64_t>(entry.end_ts()) : std::nullopt;
+                    Update(batch, true);
+                    batch.clear();
                     Delete(dimension.key(), start_ts, end_ts);
                 } else {
-                    Update(dimension.key(), entry.value(), entry.log_index(), true);
+                    batch.push_back({dimension.key(), entry.value(), entry.log_index()});
+                    if (batch.size() >= FLAGS_aggr_recover_batch_size) {
+                        Update(batch, true);
+                        batch.clear();
+                    }
                 }
                 break;
             }
         }
         cur_offset = entry.log_index();
     }
+    Update(batch, true);
     if (cur_offset < aggr_latest_offset) {
         PDLOG(ERROR, "base table is slower than aggregator");
         status_.store(AggrStat::kUnInit, std::memory_order_relaxed);
@@ -548,12 +684,13 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
 bool Aggregator::GetAggrBuffer(const std::string& key, AggrBuffer** buffer) { return GetAggrBuffer(key, "", buffer); }
 
 bool Aggregator::GetAggrBuffer(const std::string& key, const std::string& filter_key, AggrBuffer** buffer) {
-    std::lock_guard<std::mutex> lock(mu_);
-    auto it = aggr_buffer_map_.find(key);
-    if (it == aggr_buffer_map_.end()) {
+    auto& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto it = shard.buffer_map.find(key);
+    if (it == shard.buffer_map.end()) {
         return false;
     }
-    *buffer = &aggr_buffer_map_[key][filter_key].buffer_;
+    *buffer = &it->second[filter_key].buffer_;
     return true;
 }
 
@@ -604,7 +741,11 @@ bool Aggregator::EncodeAggrBuffer(const std::string& key, const std::string& fil
     if (!row_builder_.SetInt32(row_ptr, 3, buffer.aggr_cnt_)) {
         return false;
     }
-    if ((aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin) && buffer.AggrValEmpty()) {
+    bool null_val = (aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin) && buffer.AggrValEmpty();
+    // sketch aggregators encode nothing before the first value
+    null_val |= (aggr_type_ == AggrType::kApproxDistinctCount || aggr_type_ == AggrType::kApproxMedian) &&
+                aggr_val.empty();
+    if (null_val) {
         if (!row_builder_.SetNULL(row_ptr, row_size, 4)) {
             return false;
         }
@@ -658,6 +799,9 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
 
 bool Aggregator::UpdateFlushedBuffer(const std::string& key, const std::string& filter_key, const int8_t* base_row_ptr,
                                      int64_t cur_ts, uint64_t offset) {
+    // the bucket of the row may still be queued
+    std::lock_guard<std::mutex> flush_lock(flush_mu_);
+    DrainFlushQueue();
     std::unique_ptr<TraverseIterator> it(aggr_table_->NewTraverseIterator(0));
     // If there is no repetition of ts, `seek` will locate to the position that less than ts.
     it->Seek(key, cur_ts + 1);
@@ -1235,6 +1379,170 @@ bool AvgAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
     return true;
 }
 
+SketchAggregator::SketchAggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<Table> base_table,
+        const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
+        std::shared_ptr<LogReplicator> aggr_replicator,
+        uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+        const std::string& ts_col, WindowType window_tpye, uint32_t window_size)
+    : Aggregator(base_meta, base_table, aggr_meta, aggr_table, aggr_replicator, index_pos,
+            aggr_col, aggr_type, ts_col, window_tpye, window_size) {}
+
+bool SketchAggregator::UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr,
+                                     AggrBuffer* aggr_buffer) {
+    if (row_view.IsNULL(row_ptr, aggr_col_idx_)) {
+        return true;
+    }
+    if (!aggr_buffer->sketch_) {
+        aggr_buffer->sketch_ = NewSketch();
+    }
+    if (!AddValue(row_view, row_ptr, aggr_buffer->sketch_.get())) {
+        return false;
+    }
+    aggr_buffer->non_null_cnt_++;
+    return true;
+}
+
+bool SketchAggregator::EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) {
+    aggr_val->clear();
+    if (buffer.sketch_) {
+        buffer.sketch_->Serialize(aggr_val);
+    }
+    return true;
+}
+
+bool SketchAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
+    char* aggr_val = nullptr;
+    uint32_t ch_length = 0;
+    if (aggr_row_view_.GetValue(row_ptr, 4, &aggr_val, &ch_length) == 1) {
+        return true;
+    }
+    buffer->sketch_ = NewSketch();
+    if (!buffer->sketch_->MergeFrom(aggr_val, ch_length)) {
+        PDLOG(ERROR, "decode sketch failed");
+        return false;
+    }
+    return true;
+}
+
+ApproxDistinctCountAggregator::ApproxDistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta,
+        std::shared_ptr<Table> base_table, const ::openmldb::api::TableMeta& aggr_meta,
+        std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+        uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+        const std::string& ts_col, WindowType window_tpye, uint32_t window_size)
+    : SketchAggregator(base_meta, base_table, aggr_meta, aggr_table, aggr_replicator, index_pos,
+            aggr_col, aggr_type, ts_col, window_tpye, window_size) {}
+
+std::unique_ptr<::hybridse::base::Sketch> ApproxDistinctCountAggregator::NewSketch() const {
+    return std::make_unique<::hybridse::base::HyperLogLog>();
+}
+
+bool ApproxDistinctCountAggregator::AddValue(const codec::RowView& row_view, const int8_t* row_ptr,
+                                             ::hybridse::base::Sketch* sketch) {
+    // hash values the same way as approx_distinct_count in the sql engine
+    uint64_t hash = 0;
+    switch (aggr_col_type_) {
+        case DataType::kSmallInt: {
+            int16_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::SketchHash(val);
+            break;
+        }
+        case DataType::kDate:
+        case DataType::kInt: {
+            int32_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::SketchHash(val);
+            break;
+        }
+        case DataType::kTimestamp:
+        case DataType::kBigInt: {
+            int64_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::SketchHash(val);
+            break;
+        }
+        case DataType::kFloat: {
+            float val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::SketchHash(val);
+            break;
+        }
+        case DataType::kDouble: {
+            double val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::SketchHash(val);
+            break;
+        }
+        case DataType::kString:
+        case DataType::kVarchar: {
+            char* ch = nullptr;
+            uint32_t ch_length = 0;
+            row_view.GetValue(row_ptr, aggr_col_idx_, &ch, &ch_length);
+            hash = ::hybridse::base::SketchHash(ch, ch_length);
+            break;
+        }
+        default: {
+            PDLOG(ERROR, "Unsupported data type");
+            return false;
+        }
+    }
+    static_cast<::hybridse::base::HyperLogLog*>(sketch)->Add(hash);
+    return true;
+}
+
+ApproxMedianAggregator::ApproxMedianAggregator(const ::openmldb::api::TableMeta& base_meta,
+        std::shared_ptr<Table> base_table, const ::openmldb::api::TableMeta& aggr_meta,
+        std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+        uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+        const std::string& ts_col, WindowType window_tpye, uint32_t window_size)
+    : SketchAggregator(base_meta, base_table, aggr_meta, aggr_table, aggr_replicator, index_pos,
+            aggr_col, aggr_type, ts_col, window_tpye, window_size) {}
+
+std::unique_ptr<::hybridse::base::Sketch> ApproxMedianAggregator::NewSketch() const {
+    return std::make_unique<::hybridse::base::QuantileSketch>();
+}
+
+bool ApproxMedianAggregator::AddValue(const codec::RowView& row_view, const int8_t* row_ptr,
+                                      ::hybridse::base::Sketch* sketch) {
+    double val = 0;
+    switch (aggr_col_type_) {
+        case DataType::kSmallInt: {
+            int16_t tmp_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &tmp_val);
+            val = tmp_val;
+            break;
+        }
+        case DataType::kInt: {
+            int32_t tmp_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &tmp_val);
+            val = tmp_val;
+            break;
+        }
+        case DataType::kBigInt: {
+            int64_t tmp_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &tmp_val);
+            val = tmp_val;
+            break;
+        }
+        case DataType::kFloat: {
+            float tmp_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &tmp_val);
+            val = tmp_val;
+            break;
+        }
+        case DataType::kDouble: {
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            break;
+        }
+        default: {
+            PDLOG(ERROR, "Unsupported data type");
+            return false;
+        }
+    }
+    static_cast<::hybridse::base::QuantileSketch*>(sketch)->Add(val);
+    return true;
+}
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              std::shared_ptr<Table> base_table,
                                              const ::openmldb::api::TableMeta& aggr_meta,
@@ -1298,6 +1606,13 @@ std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& b
     } else if (aggr_type == "avg" || aggr_type == "avg_where") {
         agg = std::make_shared<AvgAggregator>(base_meta, base_table, aggr_meta, aggr_table, aggr_replicator,
                 index_pos, aggr_col, AggrType::kAvg, ts_col, window_type, window_size);
+    } else if (aggr_type == "approx_distinct_count") {
+        agg = std::make_shared<ApproxDistinctCountAggregator>(base_meta, base_table, aggr_meta, aggr_table,
+                aggr_replicator, index_pos, aggr_col, AggrType::kApproxDistinctCount, ts_col, window_type,
+                window_size);
+    } else if (aggr_type == "approx_median") {
+        agg = std::make_shared<ApproxMedianAggregator>(base_meta, base_table, aggr_meta, aggr_table,
+                aggr_replicator, index_pos, aggr_col, AggrType::kApproxMedian, ts_col, window_type, window_size);
     } else {
         PDLOG(ERROR, "Unsupported aggregate function type");
         return {};
@@ -17,12 +17,14 @@
 #ifndef SRC_STORAGE_AGGREGATOR_H_
 #define SRC_STORAGE_AGGREGATOR_H_
 
+#include <array>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "base/fe_sketch.h"
 #include "codec/codec.h"
 #include "proto/tablet.pb.h"
 #include "proto/type.pb.h"
@@ -43,6 +45,8 @@ enum class AggrType {
     kMax = 3,
     kCount = 4,
     kAvg = 5,
+    kApproxDistinctCount = 6,
+    kApproxMedian = 7,
 };
 
 enum class WindowType {
@@ -75,6 +79,8 @@ class AggrBuffer {
     int64_t non_null_cnt_;
     int32_t aggr_cnt_;
     DataType data_type_;
+    // the state of sketch aggregators, created on the first value
+    std::unique_ptr<::hybridse::base::Sketch> sketch_;
     AggrBuffer() : aggr_val_(), ts_begin_(-1), ts_end_(0), binlog_offset_(0), non_null_cnt_(0), aggr_cnt_(0) {}
     AggrBuffer(const AggrBuffer& buffer) {
         memcpy(&aggr_val_, &buffer.aggr_val_, sizeof(aggr_val_));
@@ -84,6 +90,9 @@ class AggrBuffer {
         binlog_offset_ = buffer.binlog_offset_;
         non_null_cnt_ = buffer.non_null_cnt_;
         data_type_ = buffer.data_type_;
+        if (buffer.sketch_) {
+            sketch_ = buffer.sketch_->Clone();
+        }
         if (data_type_ == DataType::kString || data_type_ == DataType::kVarchar) {
             if (buffer.aggr_val_.vstring.data != nullptr) {
                 aggr_val_.vstring.data = new char[buffer.aggr_val_.vstring.len];
@@ -105,6 +114,7 @@ class AggrBuffer {
         aggr_cnt_ = 0;
         binlog_offset_ = 0;
         non_null_cnt_ = 0;
+        sketch_.reset();
     }
     bool AggrValEmpty() const { return non_null_cnt_ == 0; }
 
@@ -118,7 +128,14 @@ struct AggrBufferLocked {
     AggrBufferLocked() : mu_(std::make_unique<std::mutex>()), buffer_() {}
 };
 
-class Aggregator {
+// a row of the base table and its key of the aggregator index
+struct AggrRow {
+    std::string key;
+    std::string row;
+    uint64_t offset;
+};
+
+class Aggregator : public std::enable_shared_from_this<Aggregator> {
  public:
     Aggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<Table> base_table,
             const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
@@ -130,10 +147,16 @@ class Aggregator {
 
     bool Update(const std::string& key, const std::string& row, uint64_t offset, bool recover = false);
 
+    // update with a batch of rows, the rows of one key are applied with a single buffer lookup and lock
+    bool Update(const std::vector<AggrRow>& rows, bool recover = false);
+
     bool Delete(const std::string& key, const std::optional<uint64_t>& start_ts, const std::optional<uint64_t>& end_ts);
 
     bool FlushAll();
 
+    // write the filled buffers queued for the background flusher to the aggr table
+    bool WaitFlush();
+
     bool Init(std::shared_ptr<LogReplicator> base_replicator);
 
     uint32_t GetIndexPos() const { return index_pos_; }
@@ -162,9 +185,15 @@ class Aggregator {
  protected:
     codec::Schema base_table_schema_;
 
-    using FilterMap = absl::flat_hash_map<std::string, AggrBufferLocked>;  // filter_column -> aggregator buffer
-    absl::flat_hash_map<std::string, FilterMap> aggr_buffer_map_;          // key -> filter_map
-    std::mutex mu_;
+    // node maps keep the buffers in place, they are used out of the shard lock
+    using FilterMap = absl::node_hash_map<std::string, AggrBufferLocked>;  // filter_column -> aggregator buffer
+    struct BufferShard {
+        std::mutex mu;
+        absl::node_hash_map<std::string, FilterMap> buffer_map;  // key -> filter_map
+    };
+    static constexpr uint32_t kBufferShardNum = 16;
+    // buffers sharded by key, puts of different keys do not contend on one lock
+    std::array<BufferShard, kBufferShardNum> buffer_shards_;
     DataType aggr_col_type_;
     DataType ts_col_type_;
     std::shared_ptr<Table> base_table_;
@@ -179,7 +208,25 @@ class Aggregator {
                              int64_t cur_ts, uint64_t offset);
     bool CheckBufferFilled(int64_t cur_ts, int64_t buffer_end, int32_t buffer_cnt);
 
+    BufferShard& GetShard(const std::string& key);
+    AggrBufferLocked* GetOrCreateBuffer(const std::string& key, const std::string& filter_key);
+
  private:
+    struct PendingFlush {
+        std::string key;
+        std::string filter_key;
+        std::unique_ptr<AggrBuffer> buffer;
+    };
+
+    bool ParseRow(const int8_t* row_ptr, int64_t* cur_ts, std::string* filter_key);
+    // apply one row to the locked `aggr_buffer`, `lock` may be released on return
+    bool UpdateBuffer(const std::string& key, const std::string& filter_key, const int8_t* row_ptr, int64_t cur_ts,
+                      uint64_t offset, bool recover, std::unique_lock<std::mutex>* lock, AggrBuffer* aggr_buffer);
+    // queue a filled buffer, it is written by the flush pool in order
+    void ScheduleFlush(const std::string& key, const std::string& filter_key, const AggrBuffer& aggr_buffer);
+    // write the queued buffers, flush_mu_ must be held
+    bool DrainFlushQueue();
+
     bool DeleteData(const std::string& key, const std::optional<uint64_t>& start_ts,
         const std::optional<uint64_t>& end_ts);
 
@@ -218,6 +265,14 @@ class Aggregator {
     codec::RowView base_row_view_;
     codec::RowView aggr_row_view_;
     codec::RowBuilder row_builder_;
+
+ private:
+    std::mutex flush_queue_mu_;
+    std::vector<PendingFlush> flush_queue_;
+    bool flush_scheduled_ = false;
+    // held while writing the aggr table, keeps the queued buffers in order and
+    // the out-of-order updates, deletes and FlushAll behind them
+    std::mutex flush_mu_;
 };
 
 class SumAggregator : public Aggregator {
@@ -319,6 +374,64 @@ class AvgAggregator : public Aggregator {
     bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
 };
 
+// keeps a mergeable sketch of the aggr col in each bucket, the query merges
+// the sketches of the buckets instead of scanning the rows of a long window
+class SketchAggregator : public Aggregator {
+ public:
+    SketchAggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<Table> base_table,
+            const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
+            std::shared_ptr<LogReplicator> aggr_replicator,
+            uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+            const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~SketchAggregator() = default;
+
+ protected:
+    virtual std::unique_ptr<::hybridse::base::Sketch> NewSketch() const = 0;
+
+    // add the aggr col value of the row to the sketch, the value is not null
+    virtual bool AddValue(const codec::RowView& row_view, const int8_t* row_ptr, ::hybridse::base::Sketch* sketch) = 0;
+
+ private:
+    bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) override;
+
+    bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) override;
+
+    bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
+};
+
+class ApproxDistinctCountAggregator : public SketchAggregator {
+ public:
+    ApproxDistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<Table> base_table,
+            const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
+            std::shared_ptr<LogReplicator> aggr_replicator,
+            uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+            const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~ApproxDistinctCountAggregator() = default;
+
+ private:
+    std::unique_ptr<::hybridse::base::Sketch> NewSketch() const override;
+
+    bool AddValue(const codec::RowView& row_view, const int8_t* row_ptr, ::hybridse::base::Sketch* sketch) override;
+};
+
+class ApproxMedianAggregator : public SketchAggregator {
+ public:
+    ApproxMedianAggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<Table> base_table,
+            const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
+            std::shared_ptr<LogReplicator> aggr_replicator,
+            uint32_t index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+            const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~ApproxMedianAggregator() = default;
+
+ private:
+    std::unique_ptr<::hybridse::base::Sketch> NewSketch() const override;
+
+    bool AddValue(const codec::RowView& row_view, const int8_t* row_ptr, ::hybridse::base::Sketch* sketch) override;
+};
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              std::shared_ptr<Table> base_table,
                                              const ::openmldb::api::TableMeta& aggr_meta,
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <map>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "base/file_util.h"
@@ -102,7 +105,8 @@ bool UpdateAggr(std::shared_ptr<Aggregator> aggr, codec::RowBuilder* row_builder
             return false;
         }
     }
-    return true;
+    // the filled buckets are written by the flush pool
+    return aggr->WaitFlush();
 }
 
 bool GetUpdatedResult(const uint32_t& id, const std::string& aggr_col, const std::string& aggr_type,
@@ -704,6 +708,65 @@ TEST_F(AggregatorTest, AvgAggregatorUpdate) {
     ASSERT_EQ(last_buffer->non_null_cnt_, static_cast<int64_t>(0));
 }
 
+TEST_F(AggregatorTest, SketchAggregatorUpdate) {
+    std::shared_ptr<Aggregator> aggregator;
+    AggrBuffer* last_buffer;
+    std::shared_ptr<Table> aggr_table;
+    // merge the sketches of all the buckets like a long window query does
+    auto merge_all = [](std::shared_ptr<Table> aggr_table, ::hybridse::base::Sketch* merged) {
+        ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+        auto it = aggr_table->NewTraverseIterator(0);
+        it->SeekToFirst();
+        while (it->Valid()) {
+            std::string origin_data = it->GetValue().ToString();
+            codec::RowView origin_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                           reinterpret_cast<int8_t*>(const_cast<char*>(origin_data.c_str())),
+                                           origin_data.size());
+            char* ch = NULL;
+            uint32_t ch_length = 0;
+            ASSERT_EQ(0, origin_row_view.GetString(4, &ch, &ch_length));
+            ASSERT_TRUE(merged->MergeFrom(ch, ch_length));
+            it->Next();
+        }
+    };
+
+    for (const char* col : {"col3", "col4", "col5", "col6", "col7", "col8"}) {
+        ASSERT_TRUE(GetUpdatedResult(counter, col, "approx_distinct_count", "1s", aggregator, aggr_table,
+                                     &last_buffer));
+        ::hybridse::base::HyperLogLog merged;
+        merge_all(aggr_table, &merged);
+        ASSERT_NEAR(100, merged.Estimate(), 3) << col;
+        ASSERT_EQ(last_buffer->non_null_cnt_, 1);
+        counter += 2;
+    }
+    // all the buckets have both strings
+    ASSERT_TRUE(GetUpdatedResult(counter, "col9", "approx_distinct_count", "1s", aggregator, aggr_table,
+                                 &last_buffer));
+    ::hybridse::base::HyperLogLog merged_str;
+    merge_all(aggr_table, &merged_str);
+    ASSERT_EQ(2u, merged_str.Estimate());
+    counter += 2;
+    // the buckets of null values keep no sketch
+    ASSERT_TRUE(GetUpdatedResult(counter, "col_null", "approx_distinct_count", "1s", aggregator, aggr_table,
+                                 &last_buffer));
+    ASSERT_FALSE(last_buffer->sketch_);
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    std::string null_row = it->GetValue().ToString();
+    codec::RowView null_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                 reinterpret_cast<int8_t*>(const_cast<char*>(null_row.c_str())), null_row.size());
+    ASSERT_TRUE(null_row_view.IsNULL(4));
+    counter += 2;
+
+    ASSERT_TRUE(GetUpdatedResult(counter, "col5", "approx_median", "1s", aggregator, aggr_table, &last_buffer));
+    ::hybridse::base::QuantileSketch merged_quantile;
+    merge_all(aggr_table, &merged_quantile);
+    ASSERT_EQ(100u, merged_quantile.Count());
+    ASSERT_NEAR(50, merged_quantile.Quantile(0.5), 2);
+    counter += 2;
+}
+
 TEST_F(AggregatorTest, CountWhereAggregatorUpdate) {
     std::shared_ptr<Aggregator> aggregator;
     AggrBuffer* last_buffer;
@@ -965,6 +1028,7 @@ TEST_F(AggregatorTest, AlignedCountWhere) {
         (void)row_builder.AppendInt32(0);
         bool ok = aggr->Update(key, encoded_row, 101);
         ASSERT_TRUE(ok);
+        ASSERT_TRUE(aggr->WaitFlush());
         ASSERT_EQ(aggr_table->GetRecordCnt(), 100);
         AggrBuffer* last_buffer;
         aggr->GetAggrBuffer(key, "0", &last_buffer);
@@ -1030,6 +1094,7 @@ TEST_F(AggregatorTest, AlignedCountWhere) {
         (void)row_builder.AppendInt32(2);
         bool ok = aggr->Update(key, encoded_row, 101);
         ASSERT_TRUE(ok);
+        ASSERT_TRUE(aggr->WaitFlush());
         ASSERT_EQ(aggr_table->GetRecordCnt(), 100);
         AggrBuffer* last_buffer;
         aggr->GetAggrBuffer(key, "2", &last_buffer);
@@ -1089,6 +1154,7 @@ TEST_F(AggregatorTest, AlignedCountWhere) {
         (void)row_builder.AppendNULL();
         bool ok = aggr->Update(key, encoded_row, 101);
         ASSERT_TRUE(ok);
+        ASSERT_TRUE(aggr->WaitFlush());
         ASSERT_EQ(aggr_table->GetRecordCnt(), 100);
         AggrBuffer* last_buffer;
         aggr->GetAggrBuffer(key, &last_buffer);
@@ -1140,6 +1206,112 @@ TEST_F(AggregatorTest, FlushAll) {
     ASSERT_EQ(last_buffer->aggr_cnt_, 1);
 }
 
+void RunUpdateBench(bool batch) {
+    std::map<std::string, std::string> map;
+    ::openmldb::test::TempPath tmp_path;
+    std::string folder = tmp_path.GetTempPath();
+    ::openmldb::api::TableMeta base_table_meta;
+    base_table_meta.set_tid(counter++);
+    AddDefaultAggregatorBaseSchema(&base_table_meta);
+    ::openmldb::api::TableMeta aggr_table_meta;
+    aggr_table_meta.set_tid(counter++);
+    AddDefaultAggregatorSchema(&aggr_table_meta);
+    std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+    aggr_table->Init();
+    std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+        aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+    replicator->Init();
+    auto aggr = CreateAggregator(base_table_meta, nullptr, aggr_table_meta, aggr_table, replicator, 0, "col3", "sum",
+                                 "ts_col", "1s", "");
+    ASSERT_TRUE(aggr);
+    std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+        base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+    base_replicator->Init();
+    ASSERT_TRUE(aggr->Init(base_replicator));
+
+    // every thread puts to its own keys, a bucket is filled every 10 rows of a key
+    const uint32_t thread_num = 8;
+    const uint32_t key_num = 100;
+    const uint32_t row_num = 200;
+    std::vector<std::vector<AggrRow>> thread_rows(thread_num);
+    codec::RowBuilder row_builder(base_table_meta.column_desc());
+    for (uint32_t t = 0; t < thread_num; t++) {
+        for (uint32_t i = 0; i < row_num; i++) {
+            for (uint32_t k = 0; k < key_num; k++) {
+                std::string encoded_row;
+                uint32_t row_size = row_builder.CalTotalLength(6 + 3);
+                encoded_row.resize(row_size);
+                row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+                (void)row_builder.AppendString("id1", 3);
+                (void)row_builder.AppendString("id2", 3);
+                (void)row_builder.AppendTimestamp(static_cast<int64_t>(i) * 100);
+                (void)row_builder.AppendInt32(1);
+                (void)row_builder.AppendInt16(1);
+                (void)row_builder.AppendInt64(1);
+                (void)row_builder.AppendFloat(1.0);
+                (void)row_builder.AppendDouble(1.0);
+                (void)row_builder.AppendDate(1);
+                (void)row_builder.AppendString("abc", 3);
+                (void)row_builder.AppendNULL();
+                (void)row_builder.AppendInt32(0);
+                std::string key = "key" + std::to_string(t) + "_" + std::to_string(k);
+                thread_rows[t].push_back({key, encoded_row, i * key_num + k + 1});
+            }
+        }
+    }
+    std::atomic<uint32_t> failed = 0;
+    uint64_t start = ::baidu::common::timer::get_micros();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+            const auto& rows = thread_rows[t];
+            if (batch) {
+                for (size_t pos = 0; pos < rows.size(); pos += key_num) {
+                    std::vector<AggrRow> batch_rows(rows.begin() + pos, rows.begin() + pos + key_num);
+                    if (!aggr->Update(batch_rows)) {
+                        failed++;
+                    }
+                }
+            } else {
+                for (const auto& row : rows) {
+                    if (!aggr->Update(row.key, row.row, row.offset)) {
+                        failed++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() - start;
+    ASSERT_EQ(0u, failed.load());
+    uint64_t total = thread_num * key_num * row_num;
+    std::cout << "update " << total << " rows by " << thread_num << " threads, batch " << batch << ", cost " << cost
+              << " us, " << total * 1000000.0 / cost << " rows/s" << std::endl;
+
+    ASSERT_TRUE(aggr->FlushAll());
+    // every row is counted by exactly one bucket
+    uint64_t counted = 0;
+    std::unique_ptr<TraverseIterator> it(aggr_table->NewTraverseIterator(0));
+    it->SeekToFirst();
+    while (it->Valid()) {
+        auto val = it->GetValue();
+        codec::RowView row_view(aggr_table_meta.column_desc(), reinterpret_cast<int8_t*>(const_cast<char*>(val.data())),
+                                val.size());
+        int32_t num_rows = 0;
+        row_view.GetInt32(3, &num_rows);
+        counted += num_rows;
+        it->Next();
+    }
+    ASSERT_EQ(total, counted);
+    ASSERT_EQ(thread_num * key_num * row_num / 10, aggr_table->GetRecordCnt());
+}
+
+TEST_F(AggregatorTest, UpdateBench) { RunUpdateBench(false); }
+
+TEST_F(AggregatorTest, BatchUpdateBench) { RunUpdateBench(true); }
+
 }  // namespace storage
 }  // namespace openmldb
 
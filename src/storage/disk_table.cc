@@ -30,6 +30,8 @@ DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
+DECLARE_uint32(disk_prefix_filter_bits_per_key);
+DECLARE_bool(disk_prefix_filter_ribbon);
 DECLARE_int32(disk_gc_interval);
 DECLARE_uint32(max_log_file_size);
 DECLARE_uint32(keep_log_file_num);
@@ -41,6 +43,71 @@ static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
 static bool options_template_initialized = false;
 
+TTLCompactionFilter::TTLCompactionFilter(const std::shared_ptr<InnerIndexSt>& inner_index, bool skip_lat)
+    : has_ts_idx_(inner_index->GetIndex().size() > 1), skip_lat_(skip_lat) {
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    auto to_rule = [cur_time](const TTLSt& ttl) {
+        TTLRule rule;
+        rule.ttl_type = ttl.ttl_type;
+        if (ttl.abs_ttl > 0 && ttl.abs_ttl < cur_time) {
+            rule.expire_time = cur_time - ttl.abs_ttl;
+        }
+        rule.lat_ttl = ttl.lat_ttl;
+        return rule;
+    };
+    const auto& indexs = inner_index->GetIndex();
+    if (!has_ts_idx_) {
+        single_rule_ = to_rule(*indexs.front()->GetTTL());
+        return;
+    }
+    for (const auto& index : indexs) {
+        auto ts_col = index->GetTsColumn();
+        if (ts_col) {
+            rules_.emplace(ts_col->GetId(), to_rule(*index->GetTTL()));
+        }
+    }
+}
+
+bool TTLCompactionFilter::Filter(int /*level*/, const rocksdb::Slice& key, const rocksdb::Slice& /*existing_value*/,
+                                 std::string* /*new_value*/, bool* /*value_changed*/) const {
+    rocksdb::Slice pk;
+    uint64_t ts = 0;
+    uint32_t ts_idx = 0;
+    if (ParseKeyAndTs(has_ts_idx_, key, &pk, &ts, &ts_idx) < 0) {
+        return false;
+    }
+    const TTLRule* rule = &single_rule_;
+    if (has_ts_idx_) {
+        auto iter = rules_.find(ts_idx);
+        if (iter == rules_.end()) {
+            return false;
+        }
+        rule = &iter->second;
+    }
+    // the rows of one pk and ts column are adjacent, they only differ in the trailing ts
+    rocksdb::Slice prefix(key.data(), key.size() - TS_LEN);
+    if (prefix.compare(rocksdb::Slice(last_prefix_)) == 0) {
+        count_++;
+    } else {
+        last_prefix_.assign(prefix.data(), prefix.size());
+        count_ = 1;
+    }
+    bool abs_expired = rule->expire_time > 0 && ts < rule->expire_time;
+    bool lat_expired = !skip_lat_ && rule->lat_ttl > 0 && count_ > rule->lat_ttl;
+    switch (rule->ttl_type) {
+        case TTLType::kAbsoluteTime:
+            return abs_expired;
+        case TTLType::kLatestTime:
+            return lat_expired;
+        case TTLType::kAbsAndLat:
+            return abs_expired && lat_expired;
+        case TTLType::kAbsOrLat:
+            return abs_expired || lat_expired;
+        default:
+            return false;
+    }
+}
+
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
                      const std::string& table_path)
@@ -102,12 +169,25 @@ void DiskTable::initOptionTemplate() {
         ssd_option_template.max_bytes_for_level_base >> 4;  // number of L1 files = 16
 
     rocksdb::BlockBasedTableOptions table_options;
-    // table_options.cache_index_and_filter_blocks = true;
-    // table_options.pin_l0_filter_and_index_blocks_in_cache = true;
     table_options.block_cache = cache;
-    // table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10,
-    // false));
+    // the keys are pk + ts, KeyTsPrefixTransform makes the filters answer whether a pk is in a file
+    // so seeks of absent pks skip the data blocks
+    if (FLAGS_disk_prefix_filter_bits_per_key > 0) {
+        if (FLAGS_disk_prefix_filter_ribbon) {
+            table_options.filter_policy.reset(rocksdb::NewRibbonFilterPolicy(FLAGS_disk_prefix_filter_bits_per_key));
+        } else {
+            table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(FLAGS_disk_prefix_filter_bits_per_key,
+                                                                            false));
+        }
+        table_options.partition_filters = true;
+    }
     table_options.whole_key_filtering = false;
+    // partitioned index and filters, only the top level partitions stay pinned in the block cache
+    table_options.index_type = rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.cache_index_and_filter_blocks_with_high_priority = true;
+    table_options.pin_top_level_index_and_filter = true;
+    table_options.pin_l0_filter_and_index_blocks_in_cache = true;
     table_options.block_size = 256 << 10;
     table_options.use_delta_encoding = false;
 #ifdef PZFPGA_ENABLE
@@ -132,7 +212,8 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::LOW);   // compaction threads
     hdd_option_template.memtable_prefix_bloom_size_ratio = 0.02;
-    hdd_option_template.optimize_filters_for_hits = true;
+    // the last level needs filters too, most lookups of absent pks end there
+    hdd_option_template.optimize_filters_for_hits = false;
     hdd_option_template.level_compaction_dynamic_level_bytes = true;
     hdd_option_template.max_file_opening_threads =
         1;  // set to the number of disks on which the db root folder is mounted
@@ -150,6 +231,17 @@ void DiskTable::initOptionTemplate() {
     options_template_initialized = true;
 }
 
+// the periodic compaction of a column family with ttl, 0 if none of its indexes has ttl
+static uint64_t GetPeriodicCompactionSeconds(const std::shared_ptr<InnerIndexSt>& inner_index) {
+    for (const auto& index_def : inner_index->GetIndex()) {
+        auto ttl = index_def->GetTTL();
+        if (ttl->abs_ttl > 0 || ttl->lat_ttl > 0) {
+            return static_cast<uint64_t>(FLAGS_disk_gc_interval) * 60;
+        }
+    }
+    return 0;
+}
+
 bool DiskTable::InitColumnFamilyDescriptor() {
     cf_ds_.clear();
     cf_ds_.push_back(
@@ -161,23 +253,23 @@ bool DiskTable::InitColumnFamilyDescriptor() {
     }
     options_.max_log_file_size = FLAGS_max_log_file_size;
     options_.keep_log_file_num = FLAGS_keep_log_file_num;
+    filter_factories_.clear();
+    periodic_compaction_seconds_.clear();
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (const auto& inner_index : *inner_indexs) {
         rocksdb::Options cur_options = options_;
-        bool use_compaction_filter = false;
-        for (const auto& index_def : inner_index->GetIndex()) {
-            if (index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime) {
-                cur_options.periodic_compaction_seconds = FLAGS_disk_gc_interval * 60;
-                use_compaction_filter = true;
-                break;
-            }
+        uint64_t periodic_seconds = GetPeriodicCompactionSeconds(inner_index);
+        if (periodic_seconds > 0) {
+            cur_options.periodic_compaction_seconds = periodic_seconds;
         }
+        periodic_compaction_seconds_.push_back(periodic_seconds);
         rocksdb::ColumnFamilyOptions cfo(cur_options);
         cfo.comparator = &cmp_;
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
-        if (use_compaction_filter) {
-            cfo.compaction_filter_factory = std::make_shared<AbsoluteTTLFilterFactory>(inner_index);
-        }
+        // installed even without ttl, so a ttl set later applies to the next compactions
+        auto factory = std::make_shared<TTLCompactionFilterFactory>(inner_index);
+        filter_factories_.push_back(factory);
+        cfo.compaction_filter_factory = factory;
         const auto& indexs = inner_index->GetIndex();
         auto index_def = indexs.front();
         cf_ds_.push_back(rocksdb::ColumnFamilyDescriptor(index_def->GetName(), cfo));
@@ -186,6 +278,21 @@ bool DiskTable::InitColumnFamilyDescriptor() {
     return true;
 }
 
+// the number of range deletions in the files of a column family
+static uint64_t GetRangeDeletionCnt(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf) {
+    rocksdb::TablePropertiesCollection props;
+    rocksdb::Status s = db->GetPropertiesOfAllTables(cf, &props);
+    if (!s.ok()) {
+        PDLOG(WARNING, "fail to get table properties of %s: %s", cf->GetName().c_str(), s.ToString().c_str());
+        return UINT64_MAX;
+    }
+    uint64_t cnt = 0;
+    for (const auto& kv : props) {
+        cnt += kv.second->num_range_deletions;
+    }
+    return cnt;
+}
+
 bool DiskTable::Init() {
     if (!InitFromMeta()) {
         return false;
@@ -210,6 +317,12 @@ bool DiskTable::Init() {
     }
     PDLOG(INFO, "Open DB. tid %u pid %u ColumnFamilyHandle size %u with data path %s", id_, pid_, GetIdxCnt(),
           path.c_str());
+    // the range deletions written before the restart may still be in the files
+    for (uint32_t i = 0; i < filter_factories_.size(); i++) {
+        if (GetRangeDeletionCnt(db_, cf_hs_[i + 1]) > 0) {
+            filter_factories_[i]->AddRangeDeletion();
+        }
+    }
     return true;
 }
 
@@ -337,6 +450,7 @@ bool DiskTable::Delete(uint32_t idx, const std::string& pk,
         combine_key2 = CombineKeyTs(pk, real_end_ts);
     }
     rocksdb::WriteBatch batch;
+    filter_factories_[inner_pos]->AddRangeDeletion();
     batch.DeleteRange(cf_hs_[inner_pos + 1], rocksdb::Slice(combine_key1), rocksdb::Slice(combine_key2));
     rocksdb::Status s = db_->Write(write_opts_, &batch);
     if (!s.ok()) {
@@ -368,7 +482,7 @@ base::Status DiskTable::Truncate() {
     absl::Cleanup release_snapshot = [this, snapshot] { this->db_->ReleaseSnapshot(snapshot); };
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     ro.snapshot = snapshot;
-    ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::WriteBatch batch;
     for (const auto& inner_index : *(table_index_.GetAllInnerIndex())) {
@@ -393,6 +507,7 @@ base::Status DiskTable::Truncate() {
                 }
                 PDLOG(INFO, "delete range. start key %s end key %s inner idx %u tid %u pid %u",
                         start_key.c_str(), end_key.c_str(), idx, id_, pid_);
+                filter_factories_[idx]->AddRangeDeletion();
                 batch.DeleteRange(cf_hs_[idx + 1], rocksdb::Slice(start_key), rocksdb::Slice(end_key));
             }
         }
@@ -406,133 +521,48 @@ base::Status DiskTable::Truncate() {
 }
 
 void DiskTable::SchedGc() {
-    GcHead();
     UpdateTTL();
+    UpdatePeriodicCompaction();
+    RefreshRangeDeletion();
 }
 
-void DiskTable::GcHead() {
-    uint64_t start_time = ::baidu::common::timer::get_micros() / 1000;
+void DiskTable::UpdatePeriodicCompaction() {
     auto inner_indexs = table_index_.GetAllInnerIndex();
-    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
-    absl::Cleanup release_snapshot = [this, snapshot] { this->db_->ReleaseSnapshot(snapshot); };
-    for (const auto& inner_index : *inner_indexs) {
-        uint32_t idx = inner_index->GetId();
-        rocksdb::ReadOptions ro = rocksdb::ReadOptions();
-        ro.snapshot = snapshot;
-        // ro.prefix_same_as_start = true;
-        ro.pin_data = true;
-        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf_hs_[idx + 1]));
-        it->SeekToFirst();
-        const auto& indexs = inner_index->GetIndex();
-        if (indexs.size() > 1) {
-            bool need_ttl = false;
-            std::map<uint32_t, uint64_t> ttl_map;
-            for (const auto& index : indexs) {
-                if (index->GetTTLType() != ::openmldb::storage::TTLType::kLatestTime) {
-                    continue;
-                }
-                auto ts_col = index->GetTsColumn();
-                if (ts_col) {
-                    auto lat_ttl = index->GetTTL()->lat_ttl;
-                    if (lat_ttl > 0) {
-                        ttl_map.emplace(ts_col->GetId(), lat_ttl);
-                        need_ttl = true;
-                    }
-                }
-            }
-            if (!need_ttl) {
-                continue;
-            }
-            std::map<uint32_t, uint32_t> key_cnt;
-            std::map<uint32_t, uint64_t> delete_key_map;
-            std::string last_pk;
-            while (it->Valid()) {
-                rocksdb::Slice cur_pk;
-                uint64_t ts = 0;
-                uint32_t ts_idx = 0;
-                ParseKeyAndTs(true, it->key(), &cur_pk, &ts, &ts_idx);
-                if (!last_pk.empty() && cur_pk.compare(rocksdb::Slice(last_pk)) == 0) {
-                    auto ttl_iter = ttl_map.find(ts_idx);
-                    if (ttl_iter != ttl_map.end() && ttl_iter->second > 0) {
-                        auto key_cnt_iter = key_cnt.find(ts_idx);
-                        if (key_cnt_iter == key_cnt.end()) {
-                            key_cnt.insert(std::make_pair(ts_idx, 1));
-                        } else {
-                            key_cnt_iter->second++;
-                        }
-                        if (key_cnt_iter->second > ttl_iter->second &&
-                            delete_key_map.find(ts_idx) == delete_key_map.end()) {
-                            delete_key_map.insert(std::make_pair(ts_idx, ts));
-                        }
-                    }
-                } else {
-                    for (const auto& kv : delete_key_map) {
-                        std::string combine_key1 = CombineKeyTs(rocksdb::Slice(last_pk), kv.second, kv.first);
-                        std::string combine_key2 = CombineKeyTs(rocksdb::Slice(last_pk), 0, kv.first);
-                        rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                             rocksdb::Slice(combine_key2));
-                        if (!s.ok()) {
-                            PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                        }
-                    }
-                    delete_key_map.clear();
-                    key_cnt.clear();
-                    key_cnt.insert(std::make_pair(ts_idx, 1));
-                    last_pk.assign(cur_pk.data(), cur_pk.size());
-                }
-                it->Next();
-            }
-            for (const auto& kv : delete_key_map) {
-                std::string combine_key1 = CombineKeyTs(last_pk, kv.second, kv.first);
-                std::string combine_key2 = CombineKeyTs(last_pk, 0, kv.first);
-                rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                     rocksdb::Slice(combine_key2));
-                if (!s.ok()) {
-                    PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                }
-            }
-        } else {
-            auto index = indexs.front();
-            auto ttl_num = index->GetTTL()->lat_ttl;
-            if (ttl_num < 1 || index->GetTTLType() != ::openmldb::storage::TTLType::kLatestTime) {
-                continue;
-            }
-            std::string last_pk;
-            uint64_t count = 0;
-            while (it->Valid()) {
-                rocksdb::Slice cur_pk;
-                uint64_t ts = 0;
-                ParseKeyAndTs(it->key(), &cur_pk, &ts);
-                if (!last_pk.empty() && cur_pk.compare(rocksdb::Slice(last_pk)) == 0) {
-                    if (ts == 0 || count < ttl_num) {
-                        it->Next();
-                        count++;
-                        continue;
-                    } else {
-                        std::string combine_key1 = CombineKeyTs(cur_pk, ts);
-                        std::string combine_key2 = CombineKeyTs(cur_pk, 0);
-                        rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                             rocksdb::Slice(combine_key2));
-                        if (!s.ok()) {
-                            PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                        }
-                        it->Seek(rocksdb::Slice(combine_key2));
-                    }
-                } else {
-                    count = 1;
-                    last_pk.assign(cur_pk.data(), cur_pk.size());
-                    it->Next();
-                }
-            }
+    for (uint32_t i = 0; i < inner_indexs->size() && i < periodic_compaction_seconds_.size(); i++) {
+        uint64_t periodic_seconds = GetPeriodicCompactionSeconds(inner_indexs->at(i));
+        if (periodic_seconds == periodic_compaction_seconds_[i]) {
+            continue;
+        }
+        rocksdb::Status s = db_->SetOptions(
+            cf_hs_[i + 1], {{"periodic_compaction_seconds", std::to_string(periodic_seconds)}});
+        if (!s.ok()) {
+            PDLOG(WARNING, "fail to set periodic compaction. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
+            continue;
         }
+        periodic_compaction_seconds_[i] = periodic_seconds;
+        PDLOG(INFO, "set periodic compaction seconds %lu of inner index %u. tid %u pid %u", periodic_seconds, i, id_,
+              pid_);
     }
-    uint64_t time_used = ::baidu::common::timer::get_micros() / 1000 - start_time;
-    PDLOG(INFO, "Gc used %lu second. tid %u pid %u", time_used / 1000, id_, pid_);
 }
 
-void DiskTable::GcTTLOrHead() {}
-
-void DiskTable::GcTTLAndHead() {}
+void DiskTable::RefreshRangeDeletion() {
+    for (uint32_t i = 0; i < filter_factories_.size(); i++) {
+        auto& factory = filter_factories_[i];
+        if (!factory->HasRangeDeletion()) {
+            continue;
+        }
+        // the deletions counted so far are in the files after the flush, a later one keeps the mark
+        uint64_t cnt = factory->GetRangeDeletionCnt();
+        rocksdb::Status s = db_->Flush(rocksdb::FlushOptions(), cf_hs_[i + 1]);
+        if (!s.ok()) {
+            PDLOG(WARNING, "fail to flush. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
+            continue;
+        }
+        if (GetRangeDeletionCnt(db_, cf_hs_[i + 1]) == 0) {
+            factory->ClearRangeDeletion(cnt);
+        }
+    }
+}
 
 // ttl as ms
 uint64_t DiskTable::GetExpireTime(const TTLSt& ttl_st) {
@@ -604,7 +634,8 @@ TraverseIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    // walks across pks, the prefix filters do not apply
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -630,7 +661,8 @@ TraverseIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    // walks across pks, the prefix filters do not apply
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -680,7 +712,7 @@ int DiskTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count)
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
 
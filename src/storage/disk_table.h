@@ -83,73 +83,63 @@ class KeyTsPrefixTransform : public rocksdb::SliceTransform {
     bool SameResultWhenAppended(const rocksdb::Slice& prefix) const override { return InDomain(prefix); }
 };
 
-class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
+// Enforces all the ttl types of the indexes of one column family while rocksdb compacts it.
+//
+// Compaction hands the keys over in comparator order, so the rows of one pk and ts column
+// come newest first and latest-N is a running count per pk. The count only covers the rows
+// in the compaction input, newer rows in other files make it keep more rows, never fewer.
+// Rows covered by a DeleteRange still reach the filter, so with `skip_lat` latest ttl expires
+// nothing and abs|lat falls back to the absolute ttl.
+class TTLCompactionFilter : public rocksdb::CompactionFilter {
  public:
-    explicit AbsoluteTTLCompactionFilter(std::shared_ptr<InnerIndexSt> inner_index) : inner_index_(inner_index) {}
-    virtual ~AbsoluteTTLCompactionFilter() {}
+    TTLCompactionFilter(const std::shared_ptr<InnerIndexSt>& inner_index, bool skip_lat);
 
-    const char* Name() const override { return "AbsoluteTTLCompactionFilter"; }
+    const char* Name() const override { return "TTLCompactionFilter"; }
 
-    bool Filter(int /*level*/, const rocksdb::Slice& key, const rocksdb::Slice& /*existing_value*/,
-                std::string* /*new_value*/, bool* /*value_changed*/) const override {
-        if (key.size() < TS_LEN) {
-            return false;
-        }
-        uint64_t real_ttl = 0;
-        const auto& indexs = inner_index_->GetIndex();
-        if (indexs.size() > 1) {
-            if (key.size() < TS_LEN + TS_POS_LEN) {
-                return false;
-            }
-            uint32_t ts_idx = *((uint32_t*)(key.data() + key.size() - TS_LEN -  // NOLINT
-                                          TS_POS_LEN));
-            bool has_found = false;
-            for (const auto& index : indexs) {
-                auto ts_col = index->GetTsColumn();
-                if (!ts_col) {
-                    return false;
-                }
-                if (ts_col->GetId() == ts_idx &&
-                        index->GetTTL()->ttl_type == openmldb::storage::TTLType::kAbsoluteTime) {
-                    real_ttl = index->GetTTL()->abs_ttl;
-                    has_found = true;
-                    break;
-                }
-            }
-            if (!has_found) {
-                return false;
-            }
-        } else {
-            real_ttl = indexs.front()->GetTTL()->abs_ttl;
-        }
-        if (real_ttl < 1) {
-            return false;
-        }
-        uint64_t ts = 0;
-        memcpy(static_cast<void*>(&ts), key.data() + key.size() - TS_LEN, TS_LEN);
-        memrev64ifbe(static_cast<void*>(&ts));
-        uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
-        if (ts < cur_time - real_ttl) {
-            return true;
-        }
-        return false;
-    }
+    bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value, std::string* new_value,
+                bool* value_changed) const override;
 
  private:
-    std::shared_ptr<InnerIndexSt> inner_index_;
+    struct TTLRule {
+        TTLType ttl_type = TTLType::kAbsoluteTime;
+        // rows older than expire_time are expired, 0 if there is no absolute ttl
+        uint64_t expire_time = 0;
+        uint64_t lat_ttl = 0;
+    };
+
+    bool has_ts_idx_;
+    bool skip_lat_;
+    // ttl of each ts column, the ttl is read once when the compaction starts
+    std::map<uint32_t, TTLRule> rules_;
+    TTLRule single_rule_;
+    // pk and ts column of the last row and the number of its rows seen so far
+    mutable std::string last_prefix_;
+    mutable uint64_t count_ = 0;
 };
 
-class AbsoluteTTLFilterFactory : public rocksdb::CompactionFilterFactory {
+class TTLCompactionFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-    explicit AbsoluteTTLFilterFactory(const std::shared_ptr<InnerIndexSt>& inner_index) : inner_index_(inner_index) {}
+    explicit TTLCompactionFilterFactory(const std::shared_ptr<InnerIndexSt>& inner_index)
+        : inner_index_(inner_index), range_del_cnt_(0), cleared_range_del_cnt_(0) {}
     std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
         const rocksdb::CompactionFilter::Context& context) override {
-        return std::unique_ptr<rocksdb::CompactionFilter>(new AbsoluteTTLCompactionFilter(inner_index_));
+        return std::unique_ptr<rocksdb::CompactionFilter>(new TTLCompactionFilter(inner_index_, HasRangeDeletion()));
+    }
+    const char* Name() const override { return "TTLCompactionFilterFactory"; }
+
+    // called before a DeleteRange is written to the column family
+    void AddRangeDeletion() { range_del_cnt_.fetch_add(1, std::memory_order_acq_rel); }
+    uint64_t GetRangeDeletionCnt() const { return range_del_cnt_.load(std::memory_order_acquire); }
+    // none of the first `cnt` range deletions is left in the column family
+    void ClearRangeDeletion(uint64_t cnt) { cleared_range_del_cnt_.store(cnt, std::memory_order_release); }
+    bool HasRangeDeletion() const {
+        return GetRangeDeletionCnt() != cleared_range_del_cnt_.load(std::memory_order_acquire);
     }
-    const char* Name() const override { return "AbsoluteTTLFilterFactory"; }
 
  private:
     std::shared_ptr<InnerIndexSt> inner_index_;
+    std::atomic<uint64_t> range_del_cnt_;
+    std::atomic<uint64_t> cleared_range_del_cnt_;
 };
 
 class DiskTable : public Table {
@@ -181,7 +171,7 @@ class DiskTable : public Table {
 
     bool Delete(const ::openmldb::api::LogEntry& entry) override;
 
-    base::Status Truncate();
+    virtual base::Status Truncate();
 
     bool Delete(uint32_t idx, const std::string& pk,
             const std::optional<uint64_t>& start_ts, const std::optional<uint64_t>& end_ts) override;
@@ -210,12 +200,9 @@ class DiskTable : public Table {
 
     ::hybridse::vm::WindowIterator* NewWindowIterator(uint32_t idx) override;
 
+    // the rows are expired by TTLCompactionFilter during compaction, SchedGc only refreshes the ttl
     void SchedGc() override;
 
-    void GcHead();
-    void GcTTLAndHead();
-    void GcTTLOrHead();
-
     bool IsExpire(const ::openmldb::api::LogEntry& entry) override;
 
     void CompactDB() {
@@ -235,16 +222,29 @@ class DiskTable : public Table {
 
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override; // NOLINT
 
+ protected:
+    rocksdb::DB* db_;
+    // the column family of inner index i is cf_hs_[i + 1]
+    std::vector<rocksdb::ColumnFamilyHandle*> cf_hs_;
+
  private:
     base::Status Delete(uint32_t idx, const std::string& pk, uint64_t start_ts, const std::optional<uint64_t>& end_ts);
 
+    // clear the range deletion marks of the column families whose files hold no range deletion any more
+    void RefreshRangeDeletion();
+    // turn periodic compaction on for the column families with ttl, so files nobody writes to any more
+    // still get compacted and expired
+    void UpdatePeriodicCompaction();
+
  private:
-    rocksdb::DB* db_;
     rocksdb::WriteOptions write_opts_;
     std::vector<rocksdb::ColumnFamilyDescriptor> cf_ds_;
-    std::vector<rocksdb::ColumnFamilyHandle*> cf_hs_;
     rocksdb::Options options_;
     KeyTSComparator cmp_;
+    // the compaction filter factory of inner index i
+    std::vector<std::shared_ptr<TTLCompactionFilterFactory>> filter_factories_;
+    // periodic_compaction_seconds of the column family of inner index i
+    std::vector<uint64_t> periodic_compaction_seconds_;
     std::atomic<uint64_t> offset_;
     std::string table_path_;
 };
@@ -16,7 +16,11 @@
 
 #include "storage/disk_table.h"
 #include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "codec/schema_codec.h"
@@ -1018,7 +1022,7 @@ TEST_F(DiskTableTest, GcHeadMulTs) {
             }
         }
     }
-    table->SchedGc();
+    table->CompactDB();
     iter = table->NewIterator(0, "card0", ticket);
     iter->SeekToFirst();
     while (iter->Valid()) {
@@ -1097,7 +1101,7 @@ TEST_F(DiskTableTest, GcHead) {
             }
         }
     }
-    table->GcHead();
+    table->CompactDB();
     for (int idx = 0; idx < 100; idx++) {
         std::string key = "test" + std::to_string(idx);
         uint64_t ts = 9537;
@@ -1119,6 +1123,136 @@ TEST_F(DiskTableTest, GcHead) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, CompactFilterAbsAndLatOrLat) {
+    // <ttl type, lat ttl, rows kept of each pk>
+    std::vector<std::tuple<::openmldb::type::TTLType, uint64_t, int>> cases = {
+        {::openmldb::type::TTLType::kAbsAndLat, 4, 4}, {::openmldb::type::TTLType::kAbsOrLat, 2, 2}};
+    uint32_t tid = 20;
+    for (const auto& [ttl_type, lat_ttl, keep] : cases) {
+        ::openmldb::api::TableMeta table_meta;
+        table_meta.set_tid(tid);
+        table_meta.set_pid(1);
+        table_meta.set_storage_mode(::openmldb::common::kHDD);
+        SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+        SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+        SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ttl_type, 5, lat_ttl);
+        std::string table_path = FLAGS_hdd_root_path + "/" + std::to_string(tid++) + "_1";
+        DiskTable* table = new DiskTable(table_meta, table_path);
+        ASSERT_TRUE(table->Init());
+        codec::SDKCodec codec(table_meta);
+        uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+        // three rows in the absolute ttl and three expired ones per pk
+        auto get_ts = [cur_time](int i) { return i < 3 ? cur_time - i : cur_time - i - 10 * 60 * 1000; };
+        for (int idx = 0; idx < 100; idx++) {
+            Dimensions dims;
+            auto dim = dims.Add();
+            dim->set_key("card" + std::to_string(idx));
+            dim->set_idx(0);
+            for (int i = 0; i < 6; i++) {
+                std::string value;
+                ASSERT_EQ(0, codec.EncodeRow({"card" + std::to_string(idx), std::to_string(get_ts(i))}, &value));
+                ASSERT_TRUE(table->Put(get_ts(i), value, dims));
+            }
+        }
+        table->CompactDB();
+        for (int idx = 0; idx < 100; idx++) {
+            for (int i = 0; i < 6; i++) {
+                std::string value;
+                ASSERT_EQ(i < keep, table->Get(0, "card" + std::to_string(idx), get_ts(i), value))
+                    << "ttl type " << ttl_type << " pk " << idx << " row " << i;
+            }
+        }
+        delete table;
+        RemoveData(table_path);
+    }
+}
+
+// exposes the column family of the first index to flush and compact chosen files
+class CompactableDiskTable : public DiskTable {
+ public:
+    using DiskTable::DiskTable;
+
+    void Flush() { ASSERT_TRUE(db_->Flush(rocksdb::FlushOptions(), cf_hs_[1]).ok()); }
+
+    // compact the files flushed so far into the bottommost level
+    void CompactFlushedFiles() {
+        std::vector<rocksdb::LiveFileMetaData> metas;
+        db_->GetLiveFilesMetaData(&metas);
+        std::vector<std::string> files;
+        for (const auto& meta : metas) {
+            if (meta.column_family_name == cf_hs_[1]->GetName()) {
+                files.push_back(meta.name);
+            }
+        }
+        ASSERT_FALSE(files.empty());
+        ASSERT_TRUE(db_->CompactFiles(rocksdb::CompactionOptions(), cf_hs_[1], files,
+                                      db_->NumberLevels(cf_hs_[1]) - 1).ok());
+    }
+};
+
+TEST_F(DiskTableTest, CompactFilterRangeDeletion) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/17_1";
+    auto table = std::make_unique<CompactableDiskTable>("t1", 17, 1, mapping, 2,
+                                                        ::openmldb::type::TTLType::kLatestTime,
+                                                        ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (uint64_t ts = 1; ts <= 5; ts++) {
+        ASSERT_TRUE(table->Put("pk", ts, "value", 5));
+    }
+    table->Flush();
+    // the newest rows are deleted by a range deletion which is not in the compacted file
+    ASSERT_TRUE(table->Delete(0, "pk", 5, 3));
+    table->CompactFlushedFiles();
+    std::string value;
+    for (uint64_t ts = 1; ts <= 5; ts++) {
+        ASSERT_EQ(ts <= 3, table->Get("pk", ts, value)) << "ts " << ts;
+    }
+
+    // a full compaction drops the range deletion, latest ttl applies again after the next gc
+    table->CompactDB();
+    table->SchedGc();
+    table->CompactDB();
+    for (uint64_t ts = 1; ts <= 5; ts++) {
+        ASSERT_EQ(ts == 2 || ts == 3, table->Get("pk", ts, value)) << "ts " << ts;
+    }
+    table.reset();
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, LookupBenchmark) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/16_1";
+    DiskTable* table = new DiskTable("t1", 16, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    const int pk_num = 100000;
+    for (int idx = 0; idx < pk_num; idx++) {
+        std::string key = "pk" + std::to_string(idx * 2);
+        ASSERT_TRUE(table->Put(key, 9527, "value", 5));
+    }
+    // move the rows out of the memtable into sst files
+    table->CompactDB();
+    for (bool hit : {true, false}) {
+        uint64_t start = ::baidu::common::timer::get_micros();
+        int found = 0;
+        for (int idx = 0; idx < pk_num; idx++) {
+            // the absent pks sort between the existing ones
+            std::string key = "pk" + std::to_string(hit ? idx * 2 : idx * 2 + 1);
+            std::string value;
+            found += table->Get(key, 9527, value) ? 1 : 0;
+        }
+        uint64_t cost = ::baidu::common::timer::get_micros() - start;
+        ASSERT_EQ(hit ? pk_num : 0, found);
+        std::cout << pk_num << (hit ? " hit" : " miss") << " lookups cost " << cost << " us, "
+                  << cost * 1000.0 / pk_num << " ns/lookup" << std::endl;
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
 TEST_F(DiskTableTest, CheckPoint) {
     std::map<std::string, uint32_t> mapping;
     mapping.insert(std::make_pair("idx0", 0));
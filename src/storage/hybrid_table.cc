@@ -0,0 +1,278 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/hybrid_table.h"
+
+#include <snappy.h>
+
+#include <utility>
+
+#include "base/glog_wrapper.h"
+#include "common/timer.h"
+#include "storage/hybrid_table_iterator.h"
+
+namespace openmldb {
+namespace storage {
+
+HybridTable::HybridTable(const ::openmldb::api::TableMeta& table_meta, const std::string& table_path)
+    : DiskTable(table_meta, table_path),
+      horizon_ms_(static_cast<uint64_t>(table_meta.memory_head_minutes()) * 60 * 1000),
+      head_() {}
+
+bool HybridTable::Init() {
+    if (!DiskTable::Init()) {
+        return false;
+    }
+    auto head = NewHead();
+    if (!head) {
+        return false;
+    }
+    // the data is restored from the checkpoint or left by the last run, the binlog is replayed afterwards
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    if (!LoadHead(head.get())) {
+        return false;
+    }
+    std::atomic_store_explicit(&head_, head, std::memory_order_release);
+    PDLOG(INFO, "load memory head of %lu minutes. record cnt %lu byte size %lu time %lu ms, tid %u pid %u",
+          horizon_ms_ / 60 / 1000, head->GetRecordIdxCnt(), head->GetRecordByteSize(),
+          (::baidu::common::timer::get_micros() - consumed) / 1000, id_, pid_);
+    return true;
+}
+
+std::shared_ptr<MemTable> HybridTable::NewHead() {
+    ::openmldb::api::TableMeta head_meta(*GetTableMeta());
+    head_meta.set_storage_mode(::openmldb::common::kMemory);
+    // the head only has to cover the horizon, the real ttl is applied by the readers
+    for (auto& column_key : *head_meta.mutable_column_key()) {
+        auto ttl = column_key.mutable_ttl();
+        ttl->set_ttl_type(::openmldb::type::TTLType::kAbsoluteTime);
+        ttl->set_abs_ttl(head_meta.memory_head_minutes());
+        ttl->set_lat_ttl(0);
+    }
+    auto head = std::make_shared<MemTable>(head_meta);
+    if (!head->Init()) {
+        PDLOG(WARNING, "fail to init memory head. tid %u pid %u", id_, pid_);
+        return nullptr;
+    }
+    return head;
+}
+
+bool HybridTable::LoadHead(MemTable* head) {
+    uint64_t boundary = GetHeadBoundary();
+    rocksdb::ReadOptions ro = rocksdb::ReadOptions();
+    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
+    ro.snapshot = snapshot;
+    // walks across pks, the prefix filters do not apply
+    ro.total_order_seek = true;
+    bool ok = true;
+    for (const auto& inner_index : *(table_index_.GetAllInnerIndex())) {
+        const auto& indexs = inner_index->GetIndex();
+        std::shared_ptr<IndexDef> ready_index;
+        for (const auto& index_def : indexs) {
+            if (index_def->IsReady()) {
+                ready_index = index_def;
+                break;
+            }
+        }
+        if (!ready_index) {
+            continue;
+        }
+        bool has_ts_idx = indexs.size() > 1;
+        Dimensions dimensions;
+        auto dimension = dimensions.Add();
+        dimension->set_idx(ready_index->GetId());
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf_hs_[inner_index->GetId() + 1]));
+        it->SeekToFirst();
+        while (it->Valid()) {
+            rocksdb::Slice pk;
+            uint64_t ts = 0;
+            uint32_t ts_idx = 0;
+            ParseKeyAndTs(has_ts_idx, it->key(), &pk, &ts, &ts_idx);
+            if (ts < boundary) {
+                // the rest of the rows of the pk are older, skip to the next pk or ts column
+                std::string last_key = has_ts_idx ? CombineKeyTs(pk, 0, ts_idx) : CombineKeyTs(pk, 0);
+                it->Seek(rocksdb::Slice(last_key));
+                if (it->Valid() && it->key() == rocksdb::Slice(last_key)) {
+                    it->Next();
+                }
+                continue;
+            }
+            std::string value(it->value().data(), it->value().size());
+            std::string raw_value;
+            if (GetCompressType() == openmldb::type::kSnappy) {
+                snappy::Uncompress(value.data(), value.size(), &raw_value);
+            } else {
+                raw_value = value;
+            }
+            // a row is stored once per ts column of the inner index, the head puts it to all of them at once.
+            // so only put it on the first ts column which is inside the horizon
+            bool first = true;
+            if (has_ts_idx) {
+                const int8_t* data = reinterpret_cast<const int8_t*>(raw_value.data());
+                auto decoder = GetVersionDecoder(codec::RowView::GetSchemaVersion(data));
+                for (const auto& index_def : indexs) {
+                    auto ts_col = index_def->GetTsColumn();
+                    if (!index_def->IsReady() || !ts_col) {
+                        continue;
+                    }
+                    if (ts_col->GetId() == ts_idx) {
+                        break;
+                    }
+                    int64_t col_ts = 0;
+                    if (ts_col->IsAutoGenTs()) {
+                        col_ts = ts;
+                    } else if (decoder == nullptr ||
+                               decoder->GetInteger(data, ts_col->GetId(), ts_col->GetType(), &col_ts) != 0) {
+                        continue;
+                    }
+                    if (col_ts >= 0 && static_cast<uint64_t>(col_ts) >= boundary) {
+                        first = false;
+                        break;
+                    }
+                }
+            }
+            if (first) {
+                dimension->set_key(pk.data(), pk.size());
+                if (!head->Put(ts, value, dimensions, raw_value)) {
+                    PDLOG(WARNING, "fail to load row into memory head. inner index %u tid %u pid %u",
+                          inner_index->GetId(), id_, pid_);
+                    ok = false;
+                    break;
+                }
+            }
+            it->Next();
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    db_->ReleaseSnapshot(snapshot);
+    return ok;
+}
+
+uint64_t HybridTable::GetHeadBoundary() const {
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    return cur_time > horizon_ms_ ? cur_time - horizon_ms_ : 0;
+}
+
+bool HybridTable::Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) {
+    absl::ReaderMutexLock lock(&head_mu_);
+    if (!DiskTable::Put(pk, time, data, size)) {
+        return false;
+    }
+    GetHead()->Put(pk, time, data, size);
+    return true;
+}
+
+bool HybridTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    absl::ReaderMutexLock lock(&head_mu_);
+    if (!DiskTable::Put(time, value, dimensions)) {
+        return false;
+    }
+    // rows older than the horizon are evicted by the next gc of the head
+    GetHead()->Put(time, value, dimensions);
+    return true;
+}
+
+bool HybridTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                      const std::string& raw_value) {
+    absl::ReaderMutexLock lock(&head_mu_);
+    if (!DiskTable::Put(time, value, dimensions)) {
+        return false;
+    }
+    GetHead()->Put(time, value, dimensions, raw_value);
+    return true;
+}
+
+bool HybridTable::Delete(const ::openmldb::api::LogEntry& entry) {
+    // deletes every pk through the Delete below, which takes head_mu_ and updates the head as well
+    return DiskTable::Delete(entry);
+}
+
+bool HybridTable::Delete(uint32_t idx, const std::string& pk, const std::optional<uint64_t>& start_ts,
+                         const std::optional<uint64_t>& end_ts) {
+    absl::ReaderMutexLock lock(&head_mu_);
+    if (!DiskTable::Delete(idx, pk, start_ts, end_ts)) {
+        return false;
+    }
+    GetHead()->Delete(idx, pk, start_ts, end_ts);
+    return true;
+}
+
+base::Status HybridTable::Truncate() {
+    // a write between clearing rocksdb and the swap would only reach the dropped head
+    absl::WriterMutexLock lock(&head_mu_);
+    auto status = DiskTable::Truncate();
+    if (!status.OK()) {
+        return status;
+    }
+    auto head = NewHead();
+    if (!head) {
+        return {-1, "fail to create memory head"};
+    }
+    // iterators on the old head hold it until they are released
+    std::atomic_store_explicit(&head_, head, std::memory_order_release);
+    return {};
+}
+
+TableIterator* HybridTable::NewIterator(const std::string& pk, Ticket& ticket) {
+    return HybridTable::NewIterator(0, pk, ticket);
+}
+
+TableIterator* HybridTable::NewIterator(uint32_t idx, const std::string& pk, Ticket& ticket) {
+    auto head = GetHead();
+    TableIterator* head_it = head->NewIterator(idx, pk, ticket);
+    if (head_it == nullptr) {
+        return nullptr;
+    }
+    // the gc of the head keeps the rows newer than the boundary for at least gc_safe_offset longer
+    uint64_t boundary = GetHeadBoundary();
+    return new HybridTableIterator(head, head_it, boundary, [this, idx, pk] {
+        Ticket ticket;
+        return DiskTable::NewIterator(idx, pk, ticket);
+    });
+}
+
+::hybridse::vm::WindowIterator* HybridTable::NewWindowIterator(uint32_t idx) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx);
+    if (!index_def) {
+        return nullptr;
+    }
+    auto pk_it = DiskTable::NewWindowIterator(idx);
+    if (pk_it == nullptr) {
+        return nullptr;
+    }
+    auto ttl = index_def->GetTTL();
+    return new HybridTableKeyIterator(
+        pk_it, [this, idx](const std::string& pk, Ticket& ticket) { return NewIterator(idx, pk, ticket); },
+        ttl->ttl_type, GetExpireTime(*ttl), ttl->lat_ttl);
+}
+
+void HybridTable::SchedGc() {
+    DiskTable::SchedGc();
+    GetHead()->SchedGc();
+}
+
+bool HybridTable::DeleteIndex(const std::string& idx_name) {
+    if (!DiskTable::DeleteIndex(idx_name)) {
+        return false;
+    }
+    GetHead()->DeleteIndex(idx_name);
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
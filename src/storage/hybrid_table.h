@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_HYBRID_TABLE_H_
+#define SRC_STORAGE_HYBRID_TABLE_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/synchronization/mutex.h"
+#include "storage/disk_table.h"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace storage {
+
+// A disk table which also keeps the rows of the last `memory_head_minutes` of each pk in a MemTable.
+//
+// rocksdb holds all the rows, so snapshots, recovery and ttl work as in DiskTable. The memory head is
+// written through and evicted by its own absolute ttl of the horizon, rows older than the horizon are
+// only left in rocksdb. Readers of a pk get the rows newer than the horizon from the head and only
+// open a rocksdb iterator if they walk past it.
+class HybridTable : public DiskTable {
+ public:
+    HybridTable(const ::openmldb::api::TableMeta& table_meta, const std::string& table_path);
+    HybridTable(const HybridTable&) = delete;
+    HybridTable& operator=(const HybridTable&) = delete;
+
+    bool Init() override;
+
+    bool Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) override;
+
+    bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
+
+    bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions,
+             const std::string& raw_value) override;
+
+    bool Delete(const ::openmldb::api::LogEntry& entry) override;
+
+    bool Delete(uint32_t idx, const std::string& pk,
+            const std::optional<uint64_t>& start_ts, const std::optional<uint64_t>& end_ts) override;
+
+    base::Status Truncate() override;
+
+    TableIterator* NewIterator(const std::string& pk, Ticket& ticket) override;
+
+    TableIterator* NewIterator(uint32_t idx, const std::string& pk, Ticket& ticket) override;
+
+    ::hybridse::vm::WindowIterator* NewWindowIterator(uint32_t idx) override;
+
+    // refresh the ttl of rocksdb and evict the rows older than the horizon from the memory head
+    void SchedGc() override;
+
+    bool DeleteIndex(const std::string& idx_name) override;
+
+    // the memory used by the head
+    uint64_t GetRecordByteSize() const override { return GetHead()->GetRecordByteSize(); }
+
+    // the rows with ts not less than it are all in the memory head
+    uint64_t GetHeadBoundary() const;
+
+ private:
+    std::shared_ptr<MemTable> GetHead() const { return std::atomic_load_explicit(&head_, std::memory_order_acquire); }
+
+    std::shared_ptr<MemTable> NewHead();
+
+    // load the rows newer than the horizon from rocksdb after the table is opened
+    bool LoadHead(MemTable* head);
+
+ private:
+    uint64_t horizon_ms_;
+    // writers hold it shared across rocksdb and the head, Truncate holds it exclusive to swap the head
+    absl::Mutex head_mu_;
+    std::shared_ptr<MemTable> head_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_HYBRID_TABLE_H_
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/hybrid_table_iterator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace openmldb {
+namespace storage {
+
+HybridTableIterator::HybridTableIterator(std::shared_ptr<Table> head, TableIterator* head_it, uint64_t boundary,
+                                         std::function<TableIterator*()> new_tail_it)
+    : head_(std::move(head)),
+      head_it_(head_it),
+      boundary_(boundary),
+      new_tail_it_(std::move(new_tail_it)),
+      tail_it_(nullptr),
+      in_head_(true) {}
+
+HybridTableIterator::~HybridTableIterator() {
+    delete head_it_;
+    delete tail_it_;
+}
+
+bool HybridTableIterator::Valid() {
+    if (in_head_) {
+        return head_it_->Valid();
+    }
+    return tail_it_ != nullptr && tail_it_->Valid();
+}
+
+void HybridTableIterator::Next() {
+    if (!in_head_) {
+        tail_it_->Next();
+        return;
+    }
+    head_it_->Next();
+    if (!head_it_->Valid() || head_it_->GetKey() < boundary_) {
+        SeekTail(boundary_);
+    }
+}
+
+openmldb::base::Slice HybridTableIterator::GetValue() const {
+    return in_head_ ? head_it_->GetValue() : tail_it_->GetValue();
+}
+
+std::string HybridTableIterator::GetPK() const { return in_head_ ? head_it_->GetPK() : tail_it_->GetPK(); }
+
+uint64_t HybridTableIterator::GetKey() const { return in_head_ ? head_it_->GetKey() : tail_it_->GetKey(); }
+
+void HybridTableIterator::SeekToFirst() {
+    in_head_ = true;
+    head_it_->SeekToFirst();
+    if (!head_it_->Valid() || head_it_->GetKey() < boundary_) {
+        SeekTail(boundary_);
+    }
+}
+
+void HybridTableIterator::Seek(uint64_t time) {
+    if (time < boundary_) {
+        SeekTail(time);
+        return;
+    }
+    in_head_ = true;
+    head_it_->Seek(time);
+    if (!head_it_->Valid() || head_it_->GetKey() < boundary_) {
+        SeekTail(boundary_);
+    }
+}
+
+void HybridTableIterator::SeekTail(uint64_t time) {
+    in_head_ = false;
+    if (boundary_ == 0) {
+        // nothing is older than the head
+        return;
+    }
+    if (tail_it_ == nullptr) {
+        tail_it_ = new_tail_it_();
+        if (tail_it_ == nullptr) {
+            return;
+        }
+    }
+    // the rows of the head are skipped, rocksdb has them as well
+    tail_it_->Seek(std::min(time, boundary_ - 1));
+}
+
+HybridTableRowIterator::HybridTableRowIterator(std::unique_ptr<Ticket> ticket, TableIterator* it,
+                                               ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                                               uint64_t expire_cnt)
+    : ticket_(std::move(ticket)),
+      it_(it),
+      record_idx_(1),
+      expire_value_(expire_time, expire_cnt, ttl_type),
+      key_(0),
+      row_(),
+      valid_value_(false) {}
+
+HybridTableRowIterator::~HybridTableRowIterator() {
+    // the head iterator has to be released before the ticket
+    delete it_;
+}
+
+bool HybridTableRowIterator::Valid() const {
+    return it_->Valid() && !expire_value_.IsExpired(it_->GetKey(), record_idx_);
+}
+
+void HybridTableRowIterator::Next() {
+    valid_value_ = false;
+    it_->Next();
+    record_idx_++;
+}
+
+const uint64_t& HybridTableRowIterator::GetKey() const {
+    key_ = it_->GetKey();
+    return key_;
+}
+
+const ::hybridse::codec::Row& HybridTableRowIterator::GetValue() {
+    if (valid_value_) {
+        return row_;
+    }
+    valid_value_ = true;
+    // the row may come from a rocksdb iterator which does not outlive us
+    auto value = it_->GetValue();
+    int8_t* copyed_row_data = reinterpret_cast<int8_t*>(malloc(value.size()));
+    memcpy(copyed_row_data, value.data(), value.size());
+    row_.Reset(::hybridse::base::RefCountedSlice::CreateManaged(copyed_row_data, value.size()));
+    return row_;
+}
+
+void HybridTableRowIterator::Seek(const uint64_t& key) {
+    valid_value_ = false;
+    if (expire_value_.ttl_type == TTLType::kAbsoluteTime) {
+        it_->Seek(key);
+    } else {
+        SeekToFirst();
+        while (Valid() && GetKey() > key) {
+            Next();
+        }
+    }
+}
+
+void HybridTableRowIterator::SeekToFirst() {
+    valid_value_ = false;
+    record_idx_ = 1;
+    it_->SeekToFirst();
+}
+
+HybridTableKeyIterator::HybridTableKeyIterator(::hybridse::vm::WindowIterator* pk_it, RowIteratorFactory new_row_it,
+                                               ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                                               uint64_t expire_cnt)
+    : pk_it_(pk_it),
+      new_row_it_(std::move(new_row_it)),
+      ttl_type_(ttl_type),
+      expire_time_(expire_time),
+      expire_cnt_(expire_cnt) {}
+
+HybridTableKeyIterator::~HybridTableKeyIterator() { delete pk_it_; }
+
+void HybridTableKeyIterator::Seek(const std::string& pk) { pk_it_->Seek(pk); }
+
+void HybridTableKeyIterator::SeekToFirst() { pk_it_->SeekToFirst(); }
+
+void HybridTableKeyIterator::Next() { pk_it_->Next(); }
+
+bool HybridTableKeyIterator::Valid() { return pk_it_->Valid(); }
+
+const hybridse::codec::Row HybridTableKeyIterator::GetKey() { return pk_it_->GetKey(); }
+
+std::unique_ptr<::hybridse::vm::RowIterator> HybridTableKeyIterator::GetValue() {
+    return std::unique_ptr<::hybridse::vm::RowIterator>(GetRawValue());
+}
+
+::hybridse::vm::RowIterator* HybridTableKeyIterator::GetRawValue() {
+    auto key = pk_it_->GetKey();
+    std::string pk(reinterpret_cast<const char*>(key.buf()), key.size());
+    auto ticket = std::make_unique<Ticket>();
+    TableIterator* it = new_row_it_(pk, *ticket);
+    return new HybridTableRowIterator(std::move(ticket), it, ttl_type_, expire_time_, expire_cnt_);
+}
+
+}  // namespace storage
+}  // namespace openmldb
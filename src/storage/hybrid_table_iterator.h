@@ -0,0 +1,116 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_HYBRID_TABLE_ITERATOR_H_
+#define SRC_STORAGE_HYBRID_TABLE_ITERATOR_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "storage/iterator.h"
+#include "storage/schema.h"
+#include "storage/ticket.h"
+#include "vm/catalog.h"
+
+namespace openmldb {
+namespace storage {
+
+class Table;
+
+// Rows of one pk, the ones with ts >= `boundary` from the memory head and the older ones from rocksdb.
+// The rocksdb iterator is only created once the head is exhausted.
+class HybridTableIterator : public TableIterator {
+ public:
+    HybridTableIterator(std::shared_ptr<Table> head, TableIterator* head_it, uint64_t boundary,
+                        std::function<TableIterator*()> new_tail_it);
+    ~HybridTableIterator() override;
+    bool Valid() override;
+    void Next() override;
+    openmldb::base::Slice GetValue() const override;
+    std::string GetPK() const override;
+    uint64_t GetKey() const override;
+    void SeekToFirst() override;
+    void Seek(uint64_t time) override;
+
+ private:
+    // move to the rows older than the head, `time` is the first ts to read
+    void SeekTail(uint64_t time);
+
+ private:
+    // keeps the segments of `head_it_` alive if the head is replaced
+    std::shared_ptr<Table> head_;
+    TableIterator* head_it_;
+    uint64_t boundary_;
+    std::function<TableIterator*()> new_tail_it_;
+    TableIterator* tail_it_;
+    bool in_head_;
+};
+
+class HybridTableRowIterator : public ::hybridse::vm::RowIterator {
+ public:
+    // `it` is created with `ticket`, which is owned by the row iterator from then on
+    HybridTableRowIterator(std::unique_ptr<Ticket> ticket, TableIterator* it, ::openmldb::storage::TTLType ttl_type,
+                           uint64_t expire_time, uint64_t expire_cnt);
+    ~HybridTableRowIterator() override;
+
+    bool Valid() const override;
+    void Next() override;
+    const uint64_t& GetKey() const override;
+    const ::hybridse::codec::Row& GetValue() override;
+    void Seek(const uint64_t& key) override;
+    void SeekToFirst() override;
+    bool IsSeekable() const override { return true; }
+
+ private:
+    std::unique_ptr<Ticket> ticket_;
+    TableIterator* it_;
+    uint32_t record_idx_;
+    TTLSt expire_value_;
+    mutable uint64_t key_;
+    ::hybridse::codec::Row row_;
+    bool valid_value_;
+};
+
+// walks the pks in rocksdb, the rows of each pk are read by HybridTableIterator
+class HybridTableKeyIterator : public ::hybridse::vm::WindowIterator {
+ public:
+    using RowIteratorFactory = std::function<TableIterator*(const std::string& pk, Ticket& ticket)>;
+
+    HybridTableKeyIterator(::hybridse::vm::WindowIterator* pk_it, RowIteratorFactory new_row_it,
+                           ::openmldb::storage::TTLType ttl_type, uint64_t expire_time, uint64_t expire_cnt);
+    ~HybridTableKeyIterator() override;
+
+    void Seek(const std::string& pk) override;
+    void SeekToFirst() override;
+    void Next() override;
+    bool Valid() override;
+    std::unique_ptr<::hybridse::vm::RowIterator> GetValue() override;
+    ::hybridse::vm::RowIterator* GetRawValue() override;
+    const hybridse::codec::Row GetKey() override;
+
+ private:
+    ::hybridse::vm::WindowIterator* pk_it_;
+    RowIteratorFactory new_row_it_;
+    ::openmldb::storage::TTLType ttl_type_;
+    uint64_t expire_time_;
+    uint64_t expire_cnt_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_HYBRID_TABLE_ITERATOR_H_
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/hybrid_table.h"
+
+#include <snappy.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "base/file_util.h"
+#include "base/glog_wrapper.h"
+#include "codec/schema_codec.h"
+#include "codec/sdk_codec.h"
+#include "common/timer.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "storage/ticket.h"
+#include "test/util.h"
+
+using ::openmldb::codec::SchemaCodec;
+
+DECLARE_string(ssd_root_path);
+DECLARE_string(hdd_root_path);
+
+namespace openmldb {
+namespace storage {
+
+class HybridTableTest : public ::testing::Test {};
+
+using GetTs = std::function<uint64_t(int)>;
+
+::openmldb::api::TableMeta GetHybridTableMeta(uint32_t tid, bool two_ts) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(tid);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_compress_type(::openmldb::type::kSnappy);
+    table_meta.set_memory_head_minutes(10);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "index1", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0,
+                          0);
+    if (two_ts) {
+        SchemaCodec::SetIndex(table_meta.add_column_key(), "index2", "card", "ts2", ::openmldb::type::kAbsoluteTime,
+                              0, 0);
+    }
+    return table_meta;
+}
+
+// six rows of each pk
+void PutRows(Table* table, const ::openmldb::api::TableMeta& table_meta, int pk_num, const GetTs& get_ts1,
+             const GetTs& get_ts2) {
+    codec::SDKCodec codec(table_meta);
+    for (int idx = 0; idx < pk_num; idx++) {
+        std::string key = "card" + std::to_string(idx);
+        Dimensions dims;
+        for (int i = 0; i < table_meta.column_key_size(); i++) {
+            auto dim = dims.Add();
+            dim->set_key(key);
+            dim->set_idx(i);
+        }
+        for (int i = 0; i < 6; i++) {
+            std::string raw;
+            ASSERT_EQ(0, codec.EncodeRow({key, std::to_string(get_ts1(i)), std::to_string(get_ts2(i))}, &raw));
+            std::string value;
+            ::snappy::Compress(raw.data(), raw.size(), &value);
+            ASSERT_TRUE(table->Put(get_ts1(i), value, dims, raw));
+        }
+    }
+}
+
+// `get_ts` gives the ts of the rows in descending order
+void CheckRows(Table* table, uint32_t idx, int pk_num, const GetTs& get_ts) {
+    for (int pk = 0; pk < pk_num; pk++) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator(idx, "card" + std::to_string(pk), ticket));
+        it->SeekToFirst();
+        for (int i = 0; i < 6; i++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(get_ts(i), it->GetKey());
+            it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+        it->Seek(get_ts(1));
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(get_ts(1), it->GetKey());
+        it->Seek(get_ts(4));
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(get_ts(4), it->GetKey());
+        it->Next();
+        ASSERT_EQ(get_ts(5), it->GetKey());
+    }
+}
+
+TEST_F(HybridTableTest, MergedIterator) {
+    auto table_meta = GetHybridTableMeta(1, false);
+    std::string table_path = FLAGS_hdd_root_path + "/1_1";
+    auto table = std::make_unique<HybridTable>(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    // rows 0..2 of each pk are inside the 10 minutes head, rows 3..5 are older
+    GetTs get_ts = [cur_time](int i) { return i < 3 ? cur_time - i : cur_time - i - 20 * 60 * 1000; };
+    PutRows(table.get(), table_meta, 10, get_ts, get_ts);
+    CheckRows(table.get(), 0, 10, get_ts);
+    // the rows out of the horizon leave the head, they are still read from rocksdb
+    uint64_t byte_size = table->GetRecordByteSize();
+    table->SchedGc();
+    ASSERT_GT(byte_size, table->GetRecordByteSize());
+    ASSERT_GT(table->GetRecordByteSize(), 0u);
+    CheckRows(table.get(), 0, 10, get_ts);
+
+    std::string value;
+    ASSERT_TRUE(table->Get(0, "card3", get_ts(5), value));
+    ASSERT_TRUE(table->Delete(0, "card3", std::nullopt, std::nullopt));
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(table->NewIterator(0, "card3", ticket));
+    it->SeekToFirst();
+    ASSERT_FALSE(it->Valid());
+    it.reset();
+    table.reset();
+    ::openmldb::base::RemoveDir(table_path);
+}
+
+TEST_F(HybridTableTest, WindowIterator) {
+    auto table_meta = GetHybridTableMeta(2, false);
+    auto ttl = table_meta.mutable_column_key(0)->mutable_ttl();
+    ttl->set_ttl_type(::openmldb::type::kLatestTime);
+    ttl->set_lat_ttl(5);
+    std::string table_path = FLAGS_hdd_root_path + "/2_1";
+    auto table = std::make_unique<HybridTable>(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    GetTs get_ts = [cur_time](int i) { return i < 3 ? cur_time - i : cur_time - i - 20 * 60 * 1000; };
+    PutRows(table.get(), table_meta, 10, get_ts, get_ts);
+    std::unique_ptr<::hybridse::vm::WindowIterator> window_it(table->NewWindowIterator(0));
+    window_it->SeekToFirst();
+    int pk_cnt = 0;
+    while (window_it->Valid()) {
+        auto row_it = window_it->GetValue();
+        row_it->SeekToFirst();
+        int row_cnt = 0;
+        while (row_it->Valid()) {
+            ASSERT_EQ(get_ts(row_cnt), row_it->GetKey());
+            const auto& row = row_it->GetValue();
+            codec::RowView row_view(*table->GetSchema(), row.buf(), row.size());
+            int64_t ts = 0;
+            ASSERT_EQ(0, row_view.GetInt64(1, &ts));
+            ASSERT_EQ(get_ts(row_cnt), static_cast<uint64_t>(ts));
+            row_cnt++;
+            row_it->Next();
+        }
+        // the latest ttl of the index is counted across the head and rocksdb
+        ASSERT_EQ(5, row_cnt);
+        pk_cnt++;
+        window_it->Next();
+    }
+    ASSERT_EQ(10, pk_cnt);
+    window_it.reset();
+    table.reset();
+    ::openmldb::base::RemoveDir(table_path);
+}
+
+TEST_F(HybridTableTest, Recover) {
+    auto table_meta = GetHybridTableMeta(3, true);
+    std::string table_path = FLAGS_hdd_root_path + "/3_1";
+    auto table = std::make_unique<HybridTable>(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    // rows 0..2 are inside the head by both ts columns, rows 3..5 only by ts2
+    GetTs get_ts1 = [cur_time](int i) { return i < 3 ? cur_time - i : cur_time - i - 20 * 60 * 1000; };
+    GetTs get_ts2 = [cur_time](int i) { return cur_time - i; };
+    PutRows(table.get(), table_meta, 10, get_ts1, get_ts2);
+    uint64_t byte_size = table->GetRecordByteSize();
+    table.reset();
+
+    // the head is loaded from rocksdb, each row once although it is stored under both ts columns
+    table = std::make_unique<HybridTable>(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_EQ(byte_size, table->GetRecordByteSize());
+    CheckRows(table.get(), 0, 10, get_ts1);
+    CheckRows(table.get(), 1, 10, get_ts2);
+    table.reset();
+    ::openmldb::base::RemoveDir(table_path);
+}
+
+int CountRows(TableIterator* it) {
+    int cnt = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        cnt++;
+    }
+    return cnt;
+}
+
+TEST_F(HybridTableTest, TruncateWithPut) {
+    auto table_meta = GetHybridTableMeta(6, false);
+    std::string table_path = FLAGS_hdd_root_path + "/6_1";
+    auto table = std::make_unique<HybridTable>(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    codec::SDKCodec codec(table_meta);
+    const int row_num = 20000;
+    std::thread writer([&] {
+        Dimensions dims;
+        auto dim = dims.Add();
+        dim->set_key("card0");
+        dim->set_idx(0);
+        for (int i = 0; i < row_num; i++) {
+            uint64_t ts = cur_time - i;
+            std::string raw;
+            codec.EncodeRow({"card0", std::to_string(ts), std::to_string(ts)}, &raw);
+            std::string value;
+            ::snappy::Compress(raw.data(), raw.size(), &value);
+            table->Put(ts, value, dims, raw);
+        }
+    });
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(table->Truncate().OK());
+    }
+    writer.join();
+    // all the rows are inside the horizon, the head has every row rocksdb kept after the last truncate
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(table->NewIterator(0, "card0", ticket));
+    Ticket disk_ticket;
+    std::unique_ptr<TableIterator> disk_it(table->DiskTable::NewIterator(0, "card0", disk_ticket));
+    ASSERT_EQ(CountRows(disk_it.get()), CountRows(it.get()));
+    it.reset();
+    disk_it.reset();
+    table.reset();
+    ::openmldb::base::RemoveDir(table_path);
+}
+
+TEST_F(HybridTableTest, RecentWindowBenchmark) {
+    const int pk_num = 20000;
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    GetTs get_ts = [cur_time](int i) { return i < 3 ? cur_time - i : cur_time - i - 20 * 60 * 1000; };
+    for (bool hybrid : {false, true}) {
+        auto table_meta = GetHybridTableMeta(hybrid ? 5 : 4, false);
+        std::string table_path = FLAGS_hdd_root_path + "/" + std::to_string(table_meta.tid()) + "_1";
+        std::unique_ptr<DiskTable> table;
+        if (hybrid) {
+            table = std::make_unique<HybridTable>(table_meta, table_path);
+        } else {
+            table = std::make_unique<DiskTable>(table_meta, table_path);
+        }
+        ASSERT_TRUE(table->Init());
+        PutRows(table.get(), table_meta, pk_num, get_ts, get_ts);
+        table->CompactDB();
+        uint64_t start = ::baidu::common::timer::get_micros();
+        for (int pk = 0; pk < pk_num; pk++) {
+            // a window over the last minute
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(table->NewIterator(0, "card" + std::to_string(pk), ticket));
+            int cnt = 0;
+            for (it->SeekToFirst(); it->Valid() && it->GetKey() + 60 * 1000 > cur_time; it->Next()) {
+                cnt++;
+            }
+            ASSERT_EQ(3, cnt);
+        }
+        uint64_t cost = ::baidu::common::timer::get_micros() - start;
+        std::cout << (hybrid ? "hybrid" : "disk") << " table, " << pk_num << " windows of the last minute cost "
+                  << cost << " us, " << cost * 1000.0 / pk_num << " ns/window" << std::endl;
+        table.reset();
+        ::openmldb::base::RemoveDir(table_path);
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::openmldb::test::TempPath tmp_path;
+    FLAGS_hdd_root_path = tmp_path.GetTempPath();
+    FLAGS_ssd_root_path = tmp_path.GetTempPath();
+    return RUN_ALL_TESTS();
+}
@@ -39,6 +39,8 @@ class TableIterator {
     virtual void Seek(const std::string& pk, uint64_t time) {}
     virtual void Seek(uint64_t time) {}
     virtual uint64_t GetCount() const { return 0; }
+    // true if the iteration stopped at a row which can not be read, the result read so far is incomplete
+    virtual bool HasError() const { return false; }
 };
 
 class TraverseIterator : public TableIterator {
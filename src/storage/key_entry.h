@@ -51,16 +51,9 @@ struct DataBlock {
     }
 };
 
-// the desc time comparator
+// the desc time comparator, computed without branches
 struct TimeComparator {
-    int operator() (uint64_t a, uint64_t b) const {
-        if (a > b) {
-            return -1;
-        } else if (a == b) {
-            return 0;
-        }
-        return 1;
-    }
+    int operator() (uint64_t a, uint64_t b) const { return static_cast<int>(a < b) - static_cast<int>(a > b); }
 };
 
 static const TimeComparator tcmp;
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <utility>
 
+#include "absl/container/inlined_vector.h"
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "base/slice.h"
@@ -33,6 +34,8 @@ DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
+DECLARE_uint32(compress_dict_sample_cnt);
+DECLARE_uint32(compress_dict_max_size);
 
 namespace openmldb {
 namespace storage {
@@ -47,7 +50,8 @@ MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t
       segments_(MAX_INDEX_NUM, nullptr),
       enable_gc_(true),
       segment_released_(false),
-      record_byte_size_(0) {}
+      record_byte_size_(0),
+      dict_train_time_(0) {}
 
 MemTable::MemTable(const ::openmldb::api::TableMeta& table_meta)
     : Table(table_meta.storage_mode(), table_meta.name(), table_meta.tid(), table_meta.pid(), 0, true, 60 * 1000,
@@ -59,6 +63,7 @@ MemTable::MemTable(const ::openmldb::api::TableMeta& table_meta)
     segment_released_ = false;
     record_byte_size_ = 0;
     diskused_ = 0;
+    dict_train_time_ = 0;
     table_meta_ = std::make_shared<::openmldb::api::TableMeta>(table_meta);
 }
 
@@ -87,6 +92,15 @@ bool MemTable::Init() {
     if (table_meta_->seg_cnt() > 0) {
         seg_cnt_ = table_meta_->seg_cnt();
     }
+    if (GetCompressType() == openmldb::type::kZlibDict) {
+        dict_compressor_ =
+            std::make_unique<codec::DictCompressor>(FLAGS_compress_dict_sample_cnt, FLAGS_compress_dict_max_size);
+        if (table_meta_->has_compress_dict() && dict_compressor_->AddDict(table_meta_->compress_dict().dict())) {
+            PDLOG(INFO, "load compress dict version %u size %u. tid %u pid %u", table_meta_->compress_dict().version(),
+                  table_meta_->compress_dict().dict().size(), id_, pid_);
+        }
+        dict_train_time_ = ::baidu::common::timer::get_micros() / 1000;
+    }
     uint32_t global_key_entry_max_height = 0;
     if (table_meta_->has_key_entry_max_height() && table_meta_->key_entry_max_height() <= FLAGS_skiplist_max_height &&
         table_meta_->key_entry_max_height() > 0) {
@@ -134,35 +148,64 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     }
     Segment* segment = segments_[0][index];
     Slice spk(pk);
+    if (dict_compressor_) {
+        std::string value;
+        dict_compressor_->Sample(data, size);
+        dict_compressor_->Compress(data, size, &value);
+        segment->Put(spk, time, value.data(), value.size());
+        record_byte_size_.fetch_add(GetRecordSize(value.size()));
+        return true;
+    }
     segment->Put(spk, time, data, size);
     record_byte_size_.fetch_add(GetRecordSize(size));
     return true;
 }
 
 bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    if (GetCompressType() == openmldb::type::kSnappy) {
+        std::string uncompress_data;
+        snappy::Uncompress(value.data(), value.size(), &uncompress_data);
+        return PutRow(time, value, dimensions, reinterpret_cast<const int8_t*>(uncompress_data.data()),
+                      uncompress_data.size());
+    }
+    return PutRow(time, value, dimensions, reinterpret_cast<const int8_t*>(value.data()), value.size());
+}
+
+bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                   const std::string& raw_value) {
+    return PutRow(time, value, dimensions, reinterpret_cast<const int8_t*>(raw_value.data()), raw_value.size());
+}
+
+bool MemTable::PutRow(uint64_t time, const std::string& value, const Dimensions& dimensions, const int8_t* data,
+                      uint32_t data_size) {
     if (dimensions.empty()) {
         PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
         return false;
     }
-    if (value.length() < codec::HEADER_LENGTH) {
+    if (value.length() < codec::HEADER_LENGTH || data_size < codec::HEADER_LENGTH) {
         PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
         return false;
     }
-    std::map<int32_t, Slice> inner_index_key_map;
-    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
-        int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
+    // the keys of each inner index ordered by inner index pos, the first key wins if an
+    // inner index appears more than once. Inline storage keeps the common case off the heap.
+    struct InnerPut {
+        int32_t inner_pos;
+        Slice key;
+        uint32_t ts_begin;
+        uint32_t ts_end;
+    };
+    absl::InlinedVector<InnerPut, 8> inner_puts;
+    for (const auto& dimension : dimensions) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(dimension.idx());
         if (inner_pos < 0) {
-            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", iter->idx(), id_, pid_);
+            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", dimension.idx(), id_, pid_);
             return false;
         }
-        inner_index_key_map.emplace(inner_pos, iter->key());
-    }
-    uint32_t real_ref_cnt = 0;
-    const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
-    std::string uncompress_data;
-    if (GetCompressType() == openmldb::type::kSnappy) {
-        snappy::Uncompress(value.data(), value.size(), &uncompress_data);
-        data = reinterpret_cast<const int8_t*>(uncompress_data.data());
+        auto it = std::lower_bound(inner_puts.begin(), inner_puts.end(), inner_pos,
+                                   [](const InnerPut& put, int32_t pos) { return put.inner_pos < pos; });
+        if (it == inner_puts.end() || it->inner_pos != inner_pos) {
+            inner_puts.insert(it, InnerPut{inner_pos, Slice(dimension.key()), 0, 0});
+        }
     }
     uint8_t version = codec::RowView::GetSchemaVersion(data);
     auto decoder = GetVersionDecoder(version);
@@ -170,15 +213,17 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "invalid schema version %u, tid %u pid %u", version, id_, pid_);
         return false;
     }
-    std::map<uint32_t, std::map<int32_t, uint64_t>> ts_value_map;
-    for (const auto& kv : inner_index_key_map) {
-        auto inner_index = table_index_.GetInnerIndex(kv.first);
-        if (!inner_index) {
-            PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", kv.first, id_, pid_);
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    // ts values of all inner indexes, [ts_begin, ts_end) of each inner index
+    absl::InlinedVector<TsValue, 8> ts_values;
+    uint32_t real_ref_cnt = 0;
+    for (auto& put : inner_puts) {
+        if (put.inner_pos >= static_cast<int32_t>(inner_indexs->size()) || !inner_indexs->at(put.inner_pos)) {
+            PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", put.inner_pos, id_, pid_);
             return false;
         }
-        std::map<int32_t, uint64_t> ts_map;
-        for (const auto& index_def : inner_index->GetIndex()) {
+        put.ts_begin = ts_values.size();
+        for (const auto& index_def : inner_indexs->at(put.inner_pos)->GetIndex()) {
             if (!index_def->IsReady()) {
                 continue;
             }
@@ -195,31 +240,46 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
                     PDLOG(WARNING, "ts %ld is negative. tid %u pid %u", ts, id_, pid_);
                     return false;
                 }
-                ts_map.emplace(ts_col->GetId(), ts);
+                bool exists = false;
+                for (uint32_t i = put.ts_begin; i < ts_values.size(); i++) {
+                    if (ts_values[i].first == static_cast<int32_t>(ts_col->GetId())) {
+                        exists = true;
+                        break;
+                    }
+                }
+                if (!exists) {
+                    ts_values.emplace_back(ts_col->GetId(), ts);
+                }
                 real_ref_cnt++;
             }
         }
-        if (!ts_map.empty()) {
-            ts_value_map.emplace(kv.first, std::move(ts_map));
-        }
+        put.ts_end = ts_values.size();
     }
-    if (ts_value_map.empty()) {
+    if (ts_values.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
-    for (const auto& kv : inner_index_key_map) {
-        auto iter = ts_value_map.find(kv.first);
-        if (iter == ts_value_map.end()) {
+    DataBlock* block = nullptr;
+    if (dict_compressor_) {
+        // the buffer is reused by the puts of this thread
+        static thread_local std::string compressed;
+        dict_compressor_->Sample(reinterpret_cast<const char*>(data), data_size);
+        dict_compressor_->Compress(reinterpret_cast<const char*>(data), data_size, &compressed);
+        block = new DataBlock(real_ref_cnt, compressed.c_str(), compressed.length());
+    } else {
+        block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    }
+    for (const auto& put : inner_puts) {
+        if (put.ts_begin == put.ts_end) {
             continue;
         }
         uint32_t seg_idx = 0;
         if (seg_cnt_ > 1) {
-            seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
+            seg_idx = ::openmldb::base::hash(put.key.data(), put.key.size(), SEED) % seg_cnt_;
         }
-        Segment* segment = segments_[kv.first][seg_idx];
-        segment->Put(::openmldb::base::Slice(kv.second), iter->second, block);
+        Segment* segment = segments_[put.inner_pos][seg_idx];
+        segment->Put(put.key, ts_values.data() + put.ts_begin, put.ts_end - put.ts_begin, block);
     }
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(GetRecordSize(block->size));
     return true;
 }
 
@@ -252,6 +312,9 @@ bool MemTable::Delete(const ::openmldb::api::LogEntry& entry) {
                 iter->NextPK();
                 Delete(idx, pk, start_ts, end_ts);
             }
+            if (iter->HasError()) {
+                return false;
+            }
         }
     }
     return true;
@@ -518,9 +581,9 @@ TableIterator* MemTable::NewIterator(uint32_t index, const std::string& pk, Tick
     Segment* segment = segments_[real_idx][seg_idx];
     auto ts_col = index_def->GetTsColumn();
     if (ts_col) {
-        return segment->NewIterator(spk, ts_col->GetId(), ticket, GetCompressType());
+        return segment->NewIterator(spk, ts_col->GetId(), ticket, GetCompressType(), dict_compressor_.get());
     }
-    return segment->NewIterator(spk, ticket, GetCompressType());
+    return segment->NewIterator(spk, ticket, GetCompressType(), dict_compressor_.get());
 }
 
 uint64_t MemTable::GetRecordIdxByteSize() {
@@ -701,6 +764,47 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
     return true;
 }
 
+bool MemTable::TrainCompressDict(uint64_t retrain_interval_ms) {
+    if (!dict_compressor_) {
+        return false;
+    }
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    if (dict_compressor_->GetSlot() > 0) {
+        if (cur_time < dict_train_time_ + retrain_interval_ms) {
+            return false;
+        }
+        if (dict_compressor_->GetSlot() >= codec::DictCompressor::kMaxSlot) {
+            // warn once every retrain interval
+            dict_train_time_ = cur_time;
+            PDLOG(WARNING, "all %u compress dict slots are used, keep the current dict until the table is reloaded. "
+                  "tid %u pid %u", codec::DictCompressor::kMaxSlot, id_, pid_);
+            return false;
+        }
+        if (!dict_compressor_->IsSampling()) {
+            // the rows written from now on train the next dictionary
+            dict_compressor_->StartSample();
+            return false;
+        }
+    }
+    std::string dict;
+    if (!dict_compressor_->Train(&dict)) {
+        return false;
+    }
+    if (!dict_compressor_->AddDict(dict)) {
+        PDLOG(WARNING, "too many compress dicts, keep the current one. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    dict_train_time_ = cur_time;
+    auto new_table_meta = std::make_shared<::openmldb::api::TableMeta>(*GetTableMeta());
+    auto compress_dict = new_table_meta->mutable_compress_dict();
+    compress_dict->set_version(compress_dict->version() + 1);
+    compress_dict->set_dict(dict);
+    std::atomic_store_explicit(&table_meta_, new_table_meta, std::memory_order_release);
+    PDLOG(INFO, "train compress dict version %u size %u cost %lu ms. tid %u pid %u", compress_dict->version(),
+          dict.size(), ::baidu::common::timer::get_micros() / 1000 - cur_time, id_, pid_);
+    return true;
+}
+
 bool MemTable::DeleteIndex(const std::string& idx_name) {
     std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx_name);
     if (!index_def) {
@@ -745,7 +849,7 @@ bool MemTable::DeleteIndex(const std::string& idx_name) {
         ts_idx = ts_col->GetId();
     }
     return new MemTableKeyIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type,
-            expire_time, expire_cnt, ts_idx, GetCompressType());
+            expire_time, expire_cnt, ts_idx, GetCompressType(), dict_compressor_.get());
 }
 
 TraverseIterator* MemTable::NewTraverseIterator(uint32_t index) {
@@ -765,10 +869,10 @@ TraverseIterator* MemTable::NewTraverseIterator(uint32_t index) {
     auto ts_col = index_def->GetTsColumn();
     if (ts_col) {
         return new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type,
-                expire_time, expire_cnt, ts_col->GetId(), GetCompressType());
+                expire_time, expire_cnt, ts_col->GetId(), GetCompressType(), dict_compressor_.get());
     }
     return new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type,
-            expire_time, expire_cnt, 0, GetCompressType());
+            expire_time, expire_cnt, 0, GetCompressType(), dict_compressor_.get());
 }
 
 bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response) {
@@ -817,6 +921,11 @@ bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response)
 
 bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                         const ::google::protobuf::RepeatedPtrField<::openmldb::api::BulkLoadIndex>& indexes) {
+    if (dict_compressor_) {
+        // bulk loaded blocks are raw rows, they are not encoded by the dictionary of this table
+        PDLOG(WARNING, "bulk load is not supported by zlib dict table. tid %u pid %u", id_, pid_);
+        return false;
+    }
     // data_block[i] is the block which id == i
     for (int i = 0; i < indexes.size(); ++i) {
         const auto& inner_index = indexes.Get(i);
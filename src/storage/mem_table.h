@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "codec/dict_compressor.h"
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/segment.h"
@@ -53,6 +54,9 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions,
+             const std::string& raw_value) override;
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -106,7 +110,17 @@ class MemTable : public Table {
 
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
+    // train a dictionary of a kZlibDict table from the sampled rows if there is none yet or the
+    // latest one is older than `retrain_interval_ms`. return true if the dictionary in table meta is changed
+    bool TrainCompressDict(uint64_t retrain_interval_ms);
+
+    const codec::DictCompressor* GetDictCompressor() const { return dict_compressor_.get(); }
+
  private:
+    // `data` is the uncompressed row of `value` which ts columns are read from
+    bool PutRow(uint64_t time, const std::string& value, const Dimensions& dimensions, const int8_t* data,
+                uint32_t data_size);
+
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
@@ -119,6 +133,9 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    // only set for kZlibDict tables, the rows in segments are encoded by it
+    std::unique_ptr<codec::DictCompressor> dict_compressor_;
+    uint64_t dict_train_time_;
 };
 
 }  // namespace storage
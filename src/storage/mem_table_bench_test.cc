@@ -0,0 +1,214 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <snappy.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "codec/schema_codec.h"
+#include "codec/sdk_codec.h"
+#include "common/timer.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+#include "storage/segment.h"
+
+DECLARE_bool(enable_pk_bloom_filter);
+
+// count heap allocations of the test thread to track the allocations of the put path
+static thread_local bool g_count_alloc = false;
+static thread_local uint64_t g_alloc_cnt = 0;
+
+void* operator new(size_t size) {
+    if (g_count_alloc) {
+        g_alloc_cnt++;
+    }
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    if (g_count_alloc) {
+        g_alloc_cnt++;
+    }
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::codec::SchemaCodec;
+
+class MemTableBenchTest : public ::testing::Test {
+ public:
+    MemTableBenchTest() {}
+    ~MemTableBenchTest() {}
+};
+
+struct PutCase {
+    std::string value;
+    std::string raw_value;
+    Dimensions dimensions;
+};
+
+void BuildTableMeta(::openmldb::api::TableMeta* table_meta) {
+    table_meta->set_name("t1");
+    table_meta->set_tid(1);
+    table_meta->set_pid(0);
+    table_meta->set_seg_cnt(8);
+    table_meta->set_key_entry_max_height(8);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "price", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "ts2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "card1", "card", "ts2", ::openmldb::type::kAbsoluteTime, 0,
+                          0);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "mcc", "mcc", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+}
+
+std::vector<PutCase> BuildCases(const ::openmldb::api::TableMeta& table_meta, uint32_t num, bool compress) {
+    codec::SDKCodec codec(table_meta);
+    std::vector<PutCase> cases(num);
+    for (uint32_t i = 0; i < num; i++) {
+        std::vector<std::string> row = {"card" + std::to_string(i % 100), "mcc" + std::to_string(i % 10), "13",
+                                        std::to_string(1000 + i), std::to_string(2000 + i)};
+        auto& put_case = cases[i];
+        codec.EncodeRow(row, &put_case.raw_value);
+        if (compress) {
+            snappy::Compress(put_case.raw_value.data(), put_case.raw_value.size(), &put_case.value);
+        } else {
+            put_case.value = put_case.raw_value;
+        }
+        auto dim = put_case.dimensions.Add();
+        dim->set_idx(0);
+        dim->set_key(row[0]);
+        dim = put_case.dimensions.Add();
+        dim->set_idx(1);
+        dim->set_key(row[0]);
+        dim = put_case.dimensions.Add();
+        dim->set_idx(2);
+        dim->set_key(row[1]);
+    }
+    return cases;
+}
+
+void RunPutBench(bool compress, bool with_raw_value) {
+    ::openmldb::api::TableMeta table_meta;
+    BuildTableMeta(&table_meta);
+    if (compress) {
+        table_meta.set_compress_type(::openmldb::type::CompressType::kSnappy);
+    }
+    MemTable table(table_meta);
+    ASSERT_TRUE(table.Init());
+    const uint32_t num = 100000;
+    auto cases = BuildCases(table_meta, num, compress);
+    // create all the keys first, the bench only covers puts of existing keys
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(table.Put(0, cases[i].value, cases[i].dimensions));
+    }
+    g_alloc_cnt = 0;
+    g_count_alloc = true;
+    uint64_t start = ::baidu::common::timer::get_micros();
+    for (uint32_t i = 100; i < num; i++) {
+        if (with_raw_value) {
+            table.Put(0, cases[i].value, cases[i].dimensions, cases[i].raw_value);
+        } else {
+            table.Put(0, cases[i].value, cases[i].dimensions);
+        }
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() - start;
+    g_count_alloc = false;
+    double allocs_per_row = static_cast<double>(g_alloc_cnt) / (num - 100);
+    std::cout << "put " << (num - 100) << " rows, compress " << compress << ", raw value " << with_raw_value
+              << ", cost " << cost << " us, " << cost * 1000.0 / (num - 100) << " ns/row, " << allocs_per_row
+              << " allocs/row" << std::endl;
+    ASSERT_EQ(num, table.GetRecordCnt());
+    if (!compress || with_raw_value) {
+        // only the data block and the skiplist nodes of the three ts indexes are allocated,
+        // a node is allocated together with its tower
+        ASSERT_LE(allocs_per_row, 2 + 3);
+    }
+}
+
+TEST_F(MemTableBenchTest, Put) { RunPutBench(false, false); }
+
+TEST_F(MemTableBenchTest, PutCompressed) { RunPutBench(true, false); }
+
+TEST_F(MemTableBenchTest, PutCompressedWithRawValue) { RunPutBench(true, true); }
+
+uint64_t RunMissHeavyLookupBench(bool pk_filter) {
+    FLAGS_enable_pk_bloom_filter = pk_filter;
+    Segment segment(8);
+    FLAGS_enable_pk_bloom_filter = false;
+    const uint32_t pk_num = 100000;
+    const uint32_t lookups = 1000000;
+    std::string value = "value";
+    for (uint32_t i = 0; i < pk_num; i++) {
+        std::string pk = "user" + std::to_string(i);
+        segment.Put(Slice(pk), 1000 + i, value.c_str(), value.size());
+    }
+    std::vector<std::string> keys;
+    keys.reserve(lookups);
+    for (uint32_t i = 0; i < lookups; i++) {
+        // one hit in ten like request windows on mostly new users, the missing pks sort between the existing ones
+        keys.push_back("user" + std::to_string(i % 10 == 0 ? i % pk_num : pk_num + i));
+    }
+    uint64_t found = 0;
+    uint64_t start = ::baidu::common::timer::get_micros();
+    for (const auto& key : keys) {
+        uint64_t count = 0;
+        if (segment.GetCount(Slice(key), count) == 0) {
+            found++;
+        }
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() - start;
+    EXPECT_EQ(lookups / 10, found);
+    std::cout << lookups << " lookups, 90% missing pks, pk filter " << pk_filter << ", cost " << cost << " us, "
+              << cost * 1000.0 / lookups << " ns/lookup" << std::endl;
+    return cost;
+}
+
+TEST_F(MemTableBenchTest, MissHeavyLookup) {
+    RunMissHeavyLookupBench(false);
+    RunMissHeavyLookupBench(true);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
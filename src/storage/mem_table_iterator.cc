@@ -17,6 +17,7 @@
 #include "storage/mem_table_iterator.h"
 #include <snappy.h>
 #include <string>
+#include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "gflags/gflags.h"
 
@@ -32,7 +33,7 @@ MemTableWindowIterator::~MemTableWindowIterator() {
 }
 
 bool MemTableWindowIterator::Valid() const {
-    if (!it_->Valid() || expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
+    if (error_ || !it_->Valid() || expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
         return false;
     }
     return true;
@@ -41,6 +42,17 @@ bool MemTableWindowIterator::Valid() const {
 void MemTableWindowIterator::Next() {
     it_->Next();
     record_idx_++;
+    DecodeValue();
+}
+
+void MemTableWindowIterator::DecodeValue() {
+    if (compress_type_ != type::CompressType::kZlibDict) {
+        return;
+    }
+    if (Valid() && !dict_compressor_->Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_)) {
+        PDLOG(ERROR, "fail to decode the row of ts %lu", it_->GetKey());
+        error_ = true;
+    }
 }
 
 const uint64_t& MemTableWindowIterator::GetKey() const {
@@ -52,6 +64,9 @@ const ::hybridse::codec::Row& MemTableWindowIterator::GetValue() {
         tmp_buf_.clear();
         snappy::Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_);
         row_.Reset(reinterpret_cast<const int8_t*>(tmp_buf_.data()), tmp_buf_.size());
+    } else if (compress_type_ == type::CompressType::kZlibDict) {
+        // decoded when the iterator moves
+        row_.Reset(reinterpret_cast<const int8_t*>(tmp_buf_.data()), tmp_buf_.size());
     } else {
         row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
     }
@@ -62,21 +77,25 @@ void MemTableWindowIterator::Seek(const uint64_t& key) {
     if (expire_value_.ttl_type == TTLType::kAbsoluteTime) {
         it_->Seek(key);
     } else {
-        SeekToFirst();
+        record_idx_ = 1;
+        it_->SeekToFirst();
         while (Valid() && GetKey() > key) {
-            Next();
+            it_->Next();
+            record_idx_++;
         }
     }
+    DecodeValue();
 }
 
 void MemTableWindowIterator::SeekToFirst() {
     record_idx_ = 1;
     it_->SeekToFirst();
+    DecodeValue();
 }
 
 MemTableKeyIterator::MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
         uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index,
-        type::CompressType compress_type)
+        type::CompressType compress_type, const codec::DictCompressor* dict_compressor)
     : segments_(segments),
       seg_cnt_(seg_cnt),
       seg_idx_(0),
@@ -87,7 +106,8 @@ MemTableKeyIterator::MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, :
       expire_cnt_(expire_cnt),
       ticket_(),
       ts_idx_(0),
-      compress_type_(compress_type) {
+      compress_type_(compress_type),
+      dict_compressor_(dict_compressor) {
     uint32_t idx = 0;
     if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
         ts_idx_ = idx;
@@ -150,7 +170,7 @@ void MemTableKeyIterator::Next() {
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
     }
     it->SeekToFirst();
-    return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_, compress_type_);
+    return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_, compress_type_, dict_compressor_);
 }
 
 std::unique_ptr<::hybridse::vm::RowIterator> MemTableKeyIterator::GetValue() {
@@ -187,7 +207,7 @@ void MemTableKeyIterator::NextPK() {
 MemTableTraverseIterator::MemTableTraverseIterator(Segment** segments, uint32_t seg_cnt,
         ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
         uint64_t expire_cnt, uint32_t ts_index,
-        type::CompressType compress_type)
+        type::CompressType compress_type, const codec::DictCompressor* dict_compressor)
     : segments_(segments),
       seg_cnt_(seg_cnt),
       seg_idx_(0),
@@ -198,7 +218,9 @@ MemTableTraverseIterator::MemTableTraverseIterator(Segment** segments, uint32_t
       expire_value_(expire_time, expire_cnt, ttl_type),
       ticket_(),
       traverse_cnt_(0),
-      compress_type_(compress_type) {
+      compress_type_(compress_type),
+      dict_compressor_(dict_compressor),
+      error_(false) {
     uint32_t idx = 0;
     if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
         ts_idx_ = idx;
@@ -211,7 +233,7 @@ MemTableTraverseIterator::~MemTableTraverseIterator() {
 }
 
 bool MemTableTraverseIterator::Valid() {
-    return pk_it_ != nullptr && pk_it_->Valid() && it_ != nullptr && it_->Valid() &&
+    return !error_ && pk_it_ != nullptr && pk_it_->Valid() && it_ != nullptr && it_->Valid() &&
            !expire_value_.IsExpired(it_->GetKey(), record_idx_);
 }
 
@@ -223,10 +245,26 @@ void MemTableTraverseIterator::Next() {
         NextPK();
         return;
     }
+    DecodeValue();
 }
 uint64_t MemTableTraverseIterator::GetCount() const { return traverse_cnt_; }
 
+void MemTableTraverseIterator::DecodeValue() {
+    if (compress_type_ != type::CompressType::kZlibDict) {
+        return;
+    }
+    if (Valid() && !dict_compressor_->Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_)) {
+        PDLOG(ERROR, "fail to decode the row of pk %s ts %lu", GetPK().c_str(), it_->GetKey());
+        error_ = true;
+    }
+}
+
 void MemTableTraverseIterator::NextPK() {
+    MoveToNextPK();
+    DecodeValue();
+}
+
+void MemTableTraverseIterator::MoveToNextPK() {
     delete it_;
     it_ = nullptr;
     do {
@@ -302,6 +340,8 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
             record_idx_ = 1;
             if (!it_->Valid() || expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
                 NextPK();
+            } else {
+                DecodeValue();
             }
         } else {
             if (expire_value_.ttl_type == ::openmldb::storage::TTLType::kLatestTime) {
@@ -310,6 +350,7 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
                 while (it_->Valid() && record_idx_ <= expire_value_.lat_ttl) {
                     traverse_cnt_++;
                     if (it_->GetKey() <= ts) {
+                        DecodeValue();
                         return;
                     }
                     it_->Next();
@@ -321,6 +362,8 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
                 traverse_cnt_++;
                 if (!it_->Valid() || expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
                     NextPK();
+                } else {
+                    DecodeValue();
                 }
             }
         }
@@ -334,6 +377,9 @@ openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
         tmp_buf_.clear();
         snappy::Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_);
         return openmldb::base::Slice(tmp_buf_);
+    } else if (compress_type_ == type::CompressType::kZlibDict) {
+        // decoded when the iterator moves
+        return openmldb::base::Slice(tmp_buf_);
     } else {
         return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
     }
@@ -380,6 +426,7 @@ void MemTableTraverseIterator::SeekToFirst() {
             traverse_cnt_++;
             if (it_->Valid() && !expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
                 record_idx_ = 1;
+                DecodeValue();
                 return;
             }
             delete it_;
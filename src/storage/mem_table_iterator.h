@@ -27,9 +27,10 @@ namespace storage {
 class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
  public:
     MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
-            uint64_t expire_cnt, type::CompressType compress_type)
+            uint64_t expire_cnt, type::CompressType compress_type,
+            const codec::DictCompressor* dict_compressor = nullptr)
         : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type),
-        row_(), compress_type_(compress_type) {}
+        row_(), compress_type_(compress_type), dict_compressor_(dict_compressor), error_(false) {}
 
     ~MemTableWindowIterator();
 
@@ -47,20 +48,28 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
 
     bool IsSeekable() const override { return true; }
 
+    // true if the iteration stopped at a row which fails to decode
+    bool HasError() const { return error_; }
+
  private:
+    // decode the row of a kZlibDict table, the iteration stops with an error at a row which fails to decode
+    void DecodeValue();
+
     TimeEntries::Iterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
     type::CompressType compress_type_;
+    const codec::DictCompressor* dict_compressor_;
     std::string tmp_buf_;
+    bool error_;
 };
 
 class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
  public:
     MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
                         uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index,
-                        type::CompressType compress_type);
+                        type::CompressType compress_type, const codec::DictCompressor* dict_compressor = nullptr);
 
     ~MemTableKeyIterator() override;
 
@@ -92,13 +101,14 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
     Ticket ticket_;
     uint32_t ts_idx_;
     type::CompressType compress_type_;
+    const codec::DictCompressor* dict_compressor_;
 };
 
 class MemTableTraverseIterator : public TraverseIterator {
  public:
     MemTableTraverseIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
             uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index,
-            type::CompressType compress_type);
+            type::CompressType compress_type, const codec::DictCompressor* dict_compressor = nullptr);
     ~MemTableTraverseIterator() override;
     inline bool Valid() override;
     void Next() override;
@@ -109,8 +119,13 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint64_t GetKey() const override;
     void SeekToFirst() override;
     uint64_t GetCount() const override;
+    bool HasError() const override { return error_; }
 
  private:
+    // decode the row of a kZlibDict table, the iteration stops with an error at a row which fails to decode
+    void DecodeValue();
+    void MoveToNextPK();
+
     Segment** segments_;
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
@@ -122,7 +137,9 @@ class MemTableTraverseIterator : public TraverseIterator {
     Ticket ticket_;
     uint64_t traverse_cnt_;
     type::CompressType compress_type_;
+    const codec::DictCompressor* dict_compressor_;
     mutable std::string tmp_buf_;
+    bool error_;
 };
 
 }  // namespace storage
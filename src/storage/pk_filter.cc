@@ -0,0 +1,73 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "storage/pk_filter.h"
+
+#include <algorithm>
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+static constexpr uint32_t kPkFilterSeed = 0x9747b28c;
+
+PkFilter::PkFilter(uint64_t capacity, uint32_t bits_per_key)
+    : capacity_(std::max<uint64_t>(capacity, 1)), probes_(0), block_num_(0), blocks_(), count_(0) {
+    bits_per_key = std::max<uint32_t>(bits_per_key, 1);
+    // k = bits_per_key * ln(2) minimizes the false positive rate
+    probes_ = std::min<uint32_t>(std::max<uint32_t>(bits_per_key * 69 / 100, 1), 16);
+    block_num_ = (capacity_ * bits_per_key + kBlockBits - 1) / kBlockBits;
+    blocks_.reset(new Block[block_num_]);
+    for (uint64_t i = 0; i < block_num_; i++) {
+        for (auto& word : blocks_[i].words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PkFilter::Add(const base::Slice& key) {
+    uint64_t h = base::MurmurHash64A(key.data(), key.size(), kPkFilterSeed);
+    Block& block = blocks_[h % block_num_];
+    // double hashing inside the block with the high bits
+    uint32_t h1 = static_cast<uint32_t>(h >> 32);
+    uint32_t delta = (h1 >> 17) | (h1 << 15);
+    for (uint32_t i = 0; i < probes_; i++) {
+        uint32_t bit = h1 % kBlockBits;
+        block.words[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+        h1 += delta;
+    }
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool PkFilter::MayContain(const base::Slice& key) const {
+    uint64_t h = base::MurmurHash64A(key.data(), key.size(), kPkFilterSeed);
+    const Block& block = blocks_[h % block_num_];
+    uint32_t h1 = static_cast<uint32_t>(h >> 32);
+    uint32_t delta = (h1 >> 17) | (h1 << 15);
+    for (uint32_t i = 0; i < probes_; i++) {
+        uint32_t bit = h1 % kBlockBits;
+        if ((block.words[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64))) == 0) {
+            return false;
+        }
+        h1 += delta;
+    }
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
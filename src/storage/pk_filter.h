@@ -0,0 +1,63 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SRC_STORAGE_PK_FILTER_H_
+#define SRC_STORAGE_PK_FILTER_H_
+
+#include <atomic>
+#include <memory>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+// Blocked bloom filter over the pks of a segment. All the bits of one key live in a
+// single 512 bit block, so a lookup touches one cache line.
+// Add and MayContain are thread safe.
+class PkFilter {
+ public:
+    PkFilter(uint64_t capacity, uint32_t bits_per_key);
+
+    void Add(const base::Slice& key);
+
+    // false means the key has never been added
+    bool MayContain(const base::Slice& key) const;
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Capacity() const { return capacity_; }
+    // the false positive rate grows quickly once more keys than the capacity are added
+    bool Full() const { return Count() >= capacity_; }
+
+ private:
+    static constexpr uint32_t kBlockBits = 512;
+
+    struct alignas(64) Block {
+        std::atomic<uint64_t> words[kBlockBits / 64];
+    };
+
+    uint64_t capacity_;
+    uint32_t probes_;
+    uint64_t block_num_;
+    std::unique_ptr<Block[]> blocks_;
+    std::atomic<uint64_t> count_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_PK_FILTER_H_
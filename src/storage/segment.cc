@@ -16,10 +16,14 @@
 
 #include "storage/segment.h"
 #include <snappy.h>
+#include <algorithm>
 #include <memory>
 
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/inlined_vector.h"
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "bvar/bvar.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "storage/record.h"
@@ -27,11 +31,26 @@
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_bool(enable_pk_bloom_filter);
+DECLARE_uint32(pk_bloom_filter_bits_per_key);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+static constexpr uint64_t kMinPkFilterCapacity = 1024;
+
+// negative / probe is the share of lookups the pk filter answers without the skiplist
+static bvar::Adder<int64_t> g_pk_filter_probe("segment_pk_filter_probe_count");
+static bvar::Adder<int64_t> g_pk_filter_negative("segment_pk_filter_negative_count");
+static bvar::Adder<int64_t> g_pk_filter_false_positive("segment_pk_filter_false_positive_count");
+
+static PkFilter* NewPkFilter() {
+    if (!FLAGS_enable_pk_bloom_filter) {
+        return nullptr;
+    }
+    return new PkFilter(kMinPkFilterCapacity, FLAGS_pk_bloom_filter_bits_per_key);
+}
 
 Segment::Segment(uint8_t height)
     : entries_(nullptr),
@@ -42,7 +61,10 @@ Segment::Segment(uint8_t height)
       ts_cnt_(1),
       gc_version_(0),
       ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
-      node_cache_(1, height) {
+      node_cache_(1, height),
+      pk_filter_(NewPkFilter()),
+      building_pk_filter_(nullptr),
+      deleted_pk_cnt_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
 }
@@ -56,7 +78,10 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
       ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
-      node_cache_(ts_idx_vec.size(), height) {
+      node_cache_(ts_idx_vec.size(), height),
+      pk_filter_(NewPkFilter()),
+      building_pk_filter_(nullptr),
+      deleted_pk_cnt_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
         ts_idx_map_[ts_idx_vec[i]] = i;
@@ -66,6 +91,10 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 
 Segment::~Segment() {
     delete entries_;
+    delete pk_filter_.load(std::memory_order_relaxed);
+    for (auto& kv : retired_pk_filters_) {
+        delete kv.second;
+    }
 }
 
 void Segment::Release(StatisticsInfo* statistics_info) {
@@ -147,8 +176,11 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
-    PutUnlock(key, time, row);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        PutUnlock(key, time, row);
+    }
+    GrowPkFilter();
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
@@ -161,6 +193,7 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
         // need to delete memory when free node
         Slice skey(pk, key.size());
         entry = reinterpret_cast<void*>(new KeyEntry(key_entry_max_height_));
+        AddPkToFilter(skey);
         uint8_t height = entries_->Insert(skey, entry);
         byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
         pk_cnt_.fetch_add(1, std::memory_order_relaxed);
@@ -173,6 +206,7 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
 }
 
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
+    absl::Cleanup grow_pk_filter = [this] { GrowPkFilter(); };
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
     std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
@@ -189,6 +223,7 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
                 entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
             }
             auto entry_arr = reinterpret_cast<void*>(entry_arr_tmp);
+            AddPkToFilter(skey);
             uint8_t height = entries_->Insert(skey, entry_arr);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
@@ -202,21 +237,31 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
 }
 
 void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
-    uint32_t ts_size = ts_map.size();
+    absl::InlinedVector<TsValue, 8> ts_values(ts_map.begin(), ts_map.end());
+    Put(key, ts_values.data(), ts_values.size(), row);
+}
+
+void Segment::Put(const Slice& key, const TsValue* ts_values, uint32_t ts_size, DataBlock* row) {
     if (ts_size == 0) {
         return;
     }
     if (ts_cnt_ == 1) {
-        if (auto pos = ts_map.find(ts_idx_map_.begin()->first); pos != ts_map.end()) {
-            Put(key, pos->second, row);
+        int32_t ts_col = ts_idx_map_.begin()->first;
+        for (uint32_t i = 0; i < ts_size; i++) {
+            if (ts_values[i].first == ts_col) {
+                Put(key, ts_values[i].second, row);
+                break;
+            }
         }
         return;
     }
+    // declared before the lock so it runs after the lock is released
+    absl::Cleanup grow_pk_filter = [this] { GrowPkFilter(); };
     void* entry_arr = nullptr;
     std::lock_guard<std::mutex> lock(mu_);
-    for (const auto& kv : ts_map) {
+    for (uint32_t i = 0; i < ts_size; i++) {
         uint32_t byte_size = 0;
-        auto pos = ts_idx_map_.find(kv.first);
+        auto pos = ts_idx_map_.find(ts_values[i].first);
         if (pos == ts_idx_map_.end()) {
             continue;
         }
@@ -227,17 +272,18 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
                 memcpy(pk, key.data(), key.size());
                 Slice skey(pk, key.size());
                 KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-                for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
+                for (uint32_t j = 0; j < ts_cnt_; j++) {
+                    entry_arr_tmp[j] = new KeyEntry(key_entry_max_height_);
                 }
                 entry_arr = reinterpret_cast<void*>(entry_arr_tmp);
+                AddPkToFilter(skey);
                 uint8_t height = entries_->Insert(skey, entry_arr);
                 byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
                 pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             }
         }
         auto entry = reinterpret_cast<KeyEntry**>(entry_arr)[pos->second];
-        uint8_t height = entry->entries.Insert(kv.second, row);
+        uint8_t height = entry->entries.Insert(ts_values[i].second, row);
         entry->count_.fetch_add(1, std::memory_order_relaxed);
         byte_size += GetRecordTsIdxSize(height);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
@@ -257,6 +303,7 @@ bool Segment::Delete(const std::optional<uint32_t>& idx, const Slice& key) {
         }
         if (entry_node != nullptr) {
             node_cache_.AddKeyEntryNode(gc_version_.load(std::memory_order_relaxed), entry_node);
+            deleted_pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             return true;
         }
     } else {
@@ -367,6 +414,7 @@ void Segment::FreeList(uint32_t ts_idx, ::openmldb::base::Node<uint64_t, DataBlo
 
 
 void Segment::GcFreeList(StatisticsInfo* statistics_info) {
+    RebuildPkFilter();
     uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
     if (cur_version < FLAGS_gc_deleted_pk_version_delta) {
         return;
@@ -374,6 +422,19 @@ void Segment::GcFreeList(StatisticsInfo* statistics_info) {
     StatisticsInfo old = *statistics_info;
     uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
     node_cache_.Free(free_list_version, statistics_info);
+    {
+        // same grace period as the removed key entries before a replaced filter is freed
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = std::remove_if(retired_pk_filters_.begin(), retired_pk_filters_.end(),
+                                 [free_list_version](const std::pair<uint64_t, PkFilter*>& kv) {
+                                     if (kv.first > free_list_version) {
+                                         return false;
+                                     }
+                                     delete kv.second;
+                                     return true;
+                                 });
+        retired_pk_filters_.erase(it, retired_pk_filters_.end());
+    }
     for (size_t idx = 0; idx < idx_cnt_vec_.size(); idx++) {
         idx_cnt_vec_[idx]->fetch_sub(statistics_info->GetIdxCnt(idx) - old.GetIdxCnt(idx), std::memory_order_relaxed);
     }
@@ -578,6 +639,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, StatisticsI
             }
             if (entry_node != nullptr) {
                 node_cache_.AddKeyEntryNode(gc_version_.load(std::memory_order_relaxed), entry_node);
+                deleted_pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             }
         }
     }
@@ -622,6 +684,7 @@ void Segment::Gc4TTL(const uint64_t time, StatisticsInfo* statistics_info) {
         if (entry_node != nullptr) {
             DLOG(INFO) << "add key " << key.ToString() << " to node cache. version " << gc_version_;
             node_cache_.AddKeyEntryNode(gc_version_.load(std::memory_order_relaxed), entry_node);
+            deleted_pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
         uint64_t cur_idx_cnt = statistics_info->GetIdxCnt(0);
         FreeList(0, node, statistics_info);
@@ -704,6 +767,7 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, Statist
         }
         if (entry_node != nullptr) {
             node_cache_.AddKeyEntryNode(gc_version_.load(std::memory_order_relaxed), entry_node);
+            deleted_pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
         uint64_t cur_idx_cnt = statistics_info->GetIdxCnt(0);
         FreeList(0, node, statistics_info);
@@ -719,7 +783,7 @@ int Segment::GetCount(const Slice& key, uint64_t& count) {
         return -1;
     }
     void* entry = nullptr;
-    if (entries_->Get(key, entry) < 0 || entry == nullptr) {
+    if (!GetPkEntry(key, &entry)) {
         return -1;
     }
     count = reinterpret_cast<KeyEntry*>(entry)->count_.load(std::memory_order_relaxed);
@@ -735,45 +799,131 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
         return GetCount(key, count);
     }
     void* entry_arr = nullptr;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
+    if (!GetPkEntry(key, &entry_arr)) {
         return -1;
     }
     count = reinterpret_cast<KeyEntry**>(entry_arr)[pos->second]->count_.load(std::memory_order_relaxed);
     return 0;
 }
 
-MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket, type::CompressType compress_type) {
+bool Segment::GetPkEntry(const Slice& key, void** entry) const {
+    PkFilter* filter = pk_filter_.load(std::memory_order_acquire);
+    if (filter != nullptr) {
+        g_pk_filter_probe << 1;
+        if (!filter->MayContain(key)) {
+            g_pk_filter_negative << 1;
+            return false;
+        }
+    }
+    if (entries_->Get(key, *entry) < 0 || *entry == nullptr) {
+        if (filter != nullptr) {
+            g_pk_filter_false_positive << 1;
+        }
+        return false;
+    }
+    return true;
+}
+
+void Segment::AddPkToFilter(const Slice& key) {
+    PkFilter* filter = pk_filter_.load(std::memory_order_relaxed);
+    if (filter == nullptr) {
+        return;
+    }
+    // a full filter keeps taking pks until GrowPkFilter replaces it, only its false positive rate rises
+    filter->Add(key);
+    if (building_pk_filter_ != nullptr) {
+        building_pk_filter_->Add(key);
+    }
+}
+
+void Segment::FillPkFilter(PkFilter* filter) {
+    std::unique_ptr<KeyEntries::Iterator> it(entries_->NewIterator());
+    it->SeekToFirst();
+    while (it->Valid()) {
+        filter->Add(it->GetKey());
+        it->Next();
+    }
+}
+
+void Segment::GrowPkFilter() {
+    PkFilter* filter = pk_filter_.load(std::memory_order_relaxed);
+    if (filter == nullptr || !filter->Full()) {
+        return;
+    }
+    // doubling keeps the cost per insert constant
+    ReplacePkFilter(filter, filter->Count() * 2);
+}
+
+void Segment::RebuildPkFilter() {
+    PkFilter* filter = pk_filter_.load(std::memory_order_relaxed);
+    if (filter == nullptr) {
+        return;
+    }
+    uint64_t deleted = deleted_pk_cnt_.load(std::memory_order_relaxed);
+    uint64_t added = filter->Count();
+    if (deleted == 0 || deleted * 2 < added) {
+        return;
+    }
+    uint64_t live = added > deleted ? added - deleted : 0;
+    ReplacePkFilter(filter, std::max(kMinPkFilterCapacity, live * 2));
+}
+
+void Segment::ReplacePkFilter(PkFilter* filter, uint64_t capacity) {
+    PkFilter* rebuilt = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        // another writer or the gc is replacing it already
+        if (building_pk_filter_ != nullptr || pk_filter_.load(std::memory_order_relaxed) != filter) {
+            return;
+        }
+        rebuilt = new PkFilter(capacity, FLAGS_pk_bloom_filter_bits_per_key);
+        building_pk_filter_ = rebuilt;
+        deleted_pk_cnt_.store(0, std::memory_order_relaxed);
+    }
+    // scan without the lock, pks put meanwhile are added to both filters by AddPkToFilter
+    FillPkFilter(rebuilt);
+    std::lock_guard<std::mutex> lock(mu_);
+    building_pk_filter_ = nullptr;
+    retired_pk_filters_.emplace_back(gc_version_.load(std::memory_order_relaxed), filter);
+    pk_filter_.store(rebuilt, std::memory_order_release);
+}
+
+MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket, type::CompressType compress_type,
+                                       const codec::DictCompressor* dict_compressor) {
     if (entries_ == nullptr || ts_cnt_ > 1) {
-        return new MemTableIterator(nullptr, compress_type);
+        return new MemTableIterator(nullptr, compress_type, dict_compressor);
     }
     void* entry = nullptr;
-    if (entries_->Get(key, entry) < 0 || entry == nullptr) {
-        return new MemTableIterator(nullptr, compress_type);
+    if (!GetPkEntry(key, &entry)) {
+        return new MemTableIterator(nullptr, compress_type, dict_compressor);
     }
     ticket.Push(reinterpret_cast<KeyEntry*>(entry));
-    return new MemTableIterator(reinterpret_cast<KeyEntry*>(entry)->entries.NewIterator(), compress_type);
+    return new MemTableIterator(reinterpret_cast<KeyEntry*>(entry)->entries.NewIterator(), compress_type,
+                                dict_compressor);
 }
 
-MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx,
-        Ticket& ticket, type::CompressType compress_type) {
+MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket,
+                                       type::CompressType compress_type,
+                                       const codec::DictCompressor* dict_compressor) {
     auto pos = ts_idx_map_.find(idx);
     if (pos == ts_idx_map_.end()) {
-        return new MemTableIterator(nullptr, compress_type);
+        return new MemTableIterator(nullptr, compress_type, dict_compressor);
     }
     if (ts_cnt_ == 1) {
-        return NewIterator(key, ticket, compress_type);
+        return NewIterator(key, ticket, compress_type, dict_compressor);
     }
     void* entry_arr = nullptr;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
-        return new MemTableIterator(nullptr, compress_type);
+    if (!GetPkEntry(key, &entry_arr)) {
+        return new MemTableIterator(nullptr, compress_type, dict_compressor);
     }
     auto entry = reinterpret_cast<KeyEntry**>(entry_arr)[pos->second];
     ticket.Push(entry);
-    return new MemTableIterator(entry->entries.NewIterator(), compress_type);
+    return new MemTableIterator(entry->entries.NewIterator(), compress_type, dict_compressor);
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it, type::CompressType compress_type)
-    : it_(it), compress_type_(compress_type) {}
+MemTableIterator::MemTableIterator(TimeEntries::Iterator* it, type::CompressType compress_type,
+                                   const codec::DictCompressor* dict_compressor)
+    : it_(it), compress_type_(compress_type), dict_compressor_(dict_compressor), error_(false) {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != nullptr) {
@@ -784,18 +934,32 @@ MemTableIterator::~MemTableIterator() {
 void MemTableIterator::Seek(const uint64_t time) {
     if (it_) {
         it_->Seek(time);
+        DecodeValue();
     }
 }
 
 bool MemTableIterator::Valid() {
-    if (it_ == nullptr) {
+    if (it_ == nullptr || error_) {
         return false;
     }
     return it_->Valid();
 }
 
 void MemTableIterator::Next() {
-    if (it_) it_->Next();
+    if (it_) {
+        it_->Next();
+        DecodeValue();
+    }
+}
+
+void MemTableIterator::DecodeValue() {
+    if (compress_type_ != type::CompressType::kZlibDict) {
+        return;
+    }
+    if (Valid() && !dict_compressor_->Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_)) {
+        PDLOG(ERROR, "fail to decode the row of ts %lu", it_->GetKey());
+        error_ = true;
+    }
 }
 
 ::openmldb::base::Slice MemTableIterator::GetValue() const {
@@ -803,6 +967,9 @@ void MemTableIterator::Next() {
         tmp_buf_.clear();
         snappy::Uncompress(it_->GetValue()->data, it_->GetValue()->size, &tmp_buf_);
         return openmldb::base::Slice(tmp_buf_);
+    } else if (compress_type_ == type::CompressType::kZlibDict) {
+        // decoded when the iterator moves
+        return openmldb::base::Slice(tmp_buf_);
     }
     return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
 }
@@ -810,11 +977,17 @@ void MemTableIterator::Next() {
 uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
 
 void MemTableIterator::SeekToFirst() {
-    if (it_) it_->SeekToFirst();
+    if (it_) {
+        it_->SeekToFirst();
+        DecodeValue();
+    }
 }
 
 void MemTableIterator::SeekToLast() {
-    if (it_) it_->SeekToLast();
+    if (it_) {
+        it_->SeekToLast();
+        DecodeValue();
+    }
 }
 
 }  // namespace storage
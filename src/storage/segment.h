@@ -23,14 +23,17 @@
 #include <mutex>  // NOLINT
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "base/slice.h"
+#include "codec/dict_compressor.h"
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/key_entry.h"
 #include "storage/node_cache.h"
+#include "storage/pk_filter.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
 
@@ -39,9 +42,13 @@ namespace storage {
 
 using ::openmldb::base::Slice;
 
+// <ts column id, ts> of a row
+using TsValue = std::pair<int32_t, uint64_t>;
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it, type::CompressType compress_type);
+    MemTableIterator(TimeEntries::Iterator* it, type::CompressType compress_type,
+                     const codec::DictCompressor* dict_compressor = nullptr);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -50,14 +57,21 @@ class MemTableIterator : public TableIterator {
     uint64_t GetKey() const override;
     void SeekToFirst() override;
     void SeekToLast() override;
+    bool HasError() const override { return error_; }
 
  private:
+    // decode the row of a kZlibDict table, the iteration stops with an error at a row which fails to decode
+    void DecodeValue();
+
     TimeEntries::Iterator* it_;
     type::CompressType compress_type_;
+    const codec::DictCompressor* dict_compressor_;
     mutable std::string tmp_buf_;
+    bool error_;
 };
 
 struct SliceComparator {
+    static constexpr bool kBytewise = true;
     int operator()(const ::openmldb::base::Slice& a, const ::openmldb::base::Slice& b) const { return a.compare(b); }
 };
 
@@ -81,6 +95,9 @@ class Segment {
 
     void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
+    // same as above with `ts_size` ts values of distinct ts columns
+    void Put(const Slice& key, const TsValue* ts_values, uint32_t ts_size, DataBlock* row);
+
     bool Delete(const std::optional<uint32_t>& idx, const Slice& key);
     bool Delete(const std::optional<uint32_t>& idx, const Slice& key,
             uint64_t ts, const std::optional<uint64_t>& end_ts);
@@ -96,9 +113,12 @@ class Segment {
     void Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, StatisticsInfo* statistics_info);
     void GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, StatisticsInfo* statistics_info);
 
-    MemTableIterator* NewIterator(const Slice& key, Ticket& ticket, type::CompressType compress_type);  // NOLINT
-    MemTableIterator* NewIterator(const Slice& key, uint32_t idx,
-                                  Ticket& ticket, type::CompressType compress_type);  // NOLINT
+    // `dict_compressor` decodes the rows of kZlibDict tables
+    MemTableIterator* NewIterator(const Slice& key, Ticket& ticket, type::CompressType compress_type,  // NOLINT
+                                  const codec::DictCompressor* dict_compressor = nullptr);
+    MemTableIterator* NewIterator(const Slice& key, uint32_t idx, Ticket& ticket,  // NOLINT
+                                  type::CompressType compress_type,
+                                  const codec::DictCompressor* dict_compressor = nullptr);
 
     uint64_t GetIdxCnt() const {
         return idx_cnt_vec_[0]->load(std::memory_order_relaxed);
@@ -149,6 +169,19 @@ class Segment {
         StatisticsInfo* statistics_info);
     void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
 
+    // look up the pk in entries_, skipping the skiplist if the pk filter rules the key out
+    bool GetPkEntry(const Slice& key, void** entry) const;
+    // called under mu_ before a new pk is inserted into entries_
+    void AddPkToFilter(const Slice& key);
+    void FillPkFilter(PkFilter* filter);
+    // replace a full filter by a larger one, called by writers after mu_ is released
+    void GrowPkFilter();
+    // replace the filter once many of its pks have been removed by gc
+    void RebuildPkFilter();
+    // build a filter of `capacity` from entries_ without holding mu_ and swap it in, unless `filter` is no longer
+    // the current one or another replacement is running
+    void ReplacePkFilter(PkFilter* filter, uint64_t capacity);
+
  private:
     KeyEntries* entries_;
     std::mutex mu_;
@@ -161,6 +194,14 @@ class Segment {
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
     NodeCache node_cache_;
+    // nullptr if FLAGS_enable_pk_bloom_filter is off
+    std::atomic<PkFilter*> pk_filter_;
+    // the filter RebuildPkFilter is filling, new pks go to both. guarded by mu_
+    PkFilter* building_pk_filter_;
+    // pks removed from entries_ since pk_filter_ was built
+    std::atomic<uint64_t> deleted_pk_cnt_;
+    // <gc version, filter> replaced filters which readers may still use. guarded by mu_
+    std::vector<std::pair<uint64_t, PkFilter*>> retired_pk_filters_;
 };
 
 }  // namespace storage
@@ -18,13 +18,19 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
+#include "codec/dict_compressor.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "storage/record.h"
 
+DECLARE_bool(enable_pk_bloom_filter);
+
 using ::openmldb::base::Slice;
 
 namespace openmldb {
@@ -199,6 +205,46 @@ TEST_F(SegmentTest, Iterator) {
     ASSERT_TRUE(it->Valid());
 }
 
+TEST_F(SegmentTest, DictCorruptRow) {
+    codec::DictCompressor compressor(10, 1024);
+    ASSERT_TRUE(compressor.AddDict("row_value_of_a_dict_table"));
+    Segment segment(8);
+    Slice pk("test1");
+    for (uint64_t ts = 1; ts <= 4; ts++) {
+        std::string value;
+        std::string row = "row_value_" + std::to_string(ts);
+        compressor.Compress(row.data(), row.size(), &value);
+        if (ts == 2) {
+            // a truncated deflate stream
+            ASSERT_EQ(1, value[0]);
+            value.resize(value.size() / 2);
+        }
+        segment.Put(pk, ts, value.data(), value.size());
+    }
+    Ticket ticket;
+    std::unique_ptr<MemTableIterator> it(
+        segment.NewIterator("test1", ticket, type::CompressType::kZlibDict, &compressor));
+    it->SeekToFirst();
+    std::vector<std::string> rows;
+    while (it->Valid()) {
+        rows.push_back(it->GetValue().ToString());
+        it->Next();
+    }
+    // the iteration stops with an error at the row failed to decode
+    ASSERT_EQ(std::vector<std::string>({"row_value_4", "row_value_3"}), rows);
+    ASSERT_TRUE(it->HasError());
+
+    std::unique_ptr<MemTableIterator> seek_it(
+        segment.NewIterator("test1", ticket, type::CompressType::kZlibDict, &compressor));
+    seek_it->Seek(3);
+    ASSERT_TRUE(seek_it->Valid());
+    ASSERT_FALSE(seek_it->HasError());
+    ASSERT_EQ("row_value_3", seek_it->GetValue().ToString());
+    seek_it->Seek(2);
+    ASSERT_FALSE(seek_it->Valid());
+    ASSERT_TRUE(seek_it->HasError());
+}
+
 TEST_F(SegmentTest, TestGc4Head) {
     Segment segment(8);
     Slice pk("PK");
@@ -424,6 +470,98 @@ TEST_F(SegmentTest, TestDeleteRange) {
     CheckStatisticsInfo(CreateStatisticsInfo(20, 1012, 20 * (6 + sizeof(DataBlock))), gc_info);
 }
 
+TEST_F(SegmentTest, PkFilterFalsePositive) {
+    PkFilter filter(10000, 10);
+    for (int i = 0; i < 10000; i++) {
+        std::string key = absl::StrCat("key", i);
+        filter.Add(Slice(key));
+    }
+    ASSERT_TRUE(filter.Full());
+    int positive = 0;
+    for (int i = 0; i < 10000; i++) {
+        std::string key = absl::StrCat("key", i);
+        ASSERT_TRUE(filter.MayContain(Slice(key)));
+        key = absl::StrCat("miss", i);
+        positive += filter.MayContain(Slice(key)) ? 1 : 0;
+    }
+    // about 1% with 10 bits per key, blocking costs a bit more
+    ASSERT_LT(positive, 300);
+}
+
+TEST_F(SegmentTest, PkFilter) {
+    FLAGS_enable_pk_bloom_filter = true;
+    Segment segment(8);
+    FLAGS_enable_pk_bloom_filter = false;
+    std::string value = "value";
+    // more pks than the initial capacity of the filter
+    for (int i = 0; i < 5000; i++) {
+        std::string pk = absl::StrCat("pk", i);
+        segment.Put(Slice(pk), i < 4000 ? 1000 : 2000, value.c_str(), value.size());
+    }
+    auto check = [&segment](const std::string& pk, bool exist) {
+        uint64_t count = 0;
+        Ticket ticket;
+        std::unique_ptr<MemTableIterator> it(segment.NewIterator(Slice(pk), ticket, type::CompressType::kNoCompress));
+        it->SeekToFirst();
+        if (exist) {
+            ASSERT_EQ(0, segment.GetCount(Slice(pk), count)) << pk;
+            ASSERT_EQ(1u, count);
+            ASSERT_TRUE(it->Valid()) << pk;
+        } else {
+            ASSERT_EQ(-1, segment.GetCount(Slice(pk), count)) << pk;
+            ASSERT_FALSE(it->Valid()) << pk;
+        }
+    };
+    for (int i = 0; i < 5000; i++) {
+        check(absl::StrCat("pk", i), true);
+        check(absl::StrCat("miss", i), false);
+    }
+
+    // gc removes most of the pks, the filter is rebuilt from the remaining ones
+    StatisticsInfo gc_info(1);
+    segment.Gc4TTL(1500, &gc_info);
+    segment.IncrGcVersion();
+    segment.GcFreeList(&gc_info);
+    for (int i = 0; i < 5000; i++) {
+        check(absl::StrCat("pk", i), i >= 4000);
+    }
+    std::string pk = "pk1";
+    segment.Put(Slice(pk), 3000, value.c_str(), value.size());
+    check(pk, true);
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(&gc_info);
+    check(pk, true);
+}
+
+TEST_F(SegmentTest, PkFilterConcurrentGrow) {
+    FLAGS_enable_pk_bloom_filter = true;
+    Segment segment(8);
+    FLAGS_enable_pk_bloom_filter = false;
+    std::string value = "value";
+    // the writers fill the filter many times over, it is grown while the others keep putting
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&segment, &value, t] {
+            for (int i = 0; i < 5000; i++) {
+                std::string pk = absl::StrCat("pk", t, "_", i);
+                segment.Put(Slice(pk), 1000, value.c_str(), value.size());
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < 5000; i++) {
+            uint64_t count = 0;
+            std::string pk = absl::StrCat("pk", t, "_", i);
+            ASSERT_EQ(0, segment.GetCount(Slice(pk), count)) << pk;
+            ASSERT_EQ(1u, count);
+        }
+    }
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -53,6 +53,13 @@ class Table {
 
     virtual bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) = 0;
 
+    // `raw_value` is the uncompressed `value`, tables may read columns from it instead of
+    // decompressing `value` again
+    virtual bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                     const std::string& raw_value) {
+        return Put(time, value, dimensions);
+    }
+
     bool Put(const ::openmldb::api::LogEntry& entry) {
         return Put(entry.ts(), entry.value(), entry.dimensions());
     }
@@ -38,6 +38,7 @@ DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_int32(gc_safe_offset);
+DECLARE_uint32(compress_dict_sample_cnt);
 
 namespace openmldb {
 namespace storage {
@@ -1942,6 +1943,87 @@ TEST_P(TableTest, NegativeTs) {
     ASSERT_FALSE(table->Put(0, value, request.dimensions()));
 }
 
+TEST_F(TableTest, ZlibDictCompress) {
+    FLAGS_compress_dict_sample_cnt = 100;
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("table1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(1);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_format_version(1);
+    table_meta.set_compress_type(::openmldb::type::CompressType::kZlibDict);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "merchant", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable table(table_meta);
+    ASSERT_TRUE(table.Init());
+    codec::SDKCodec codec(table_meta);
+    auto put = [&](int i) {
+        std::vector<std::string> row = {"card" + std::to_string(i % 10),
+                                        "merchant_category_restaurant_" + std::to_string(i % 5),
+                                        std::to_string(1000 + i)};
+        ::openmldb::api::PutRequest request;
+        auto dim = request.add_dimensions();
+        dim->set_idx(0);
+        dim->set_key(row[0]);
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        ASSERT_TRUE(table.Put(0, value, request.dimensions(), value));
+    };
+    auto check = [&](int num) {
+        std::unique_ptr<TableIterator> it(table.NewTraverseIterator(0));
+        it->SeekToFirst();
+        int count = 0;
+        while (it->Valid()) {
+            std::vector<std::string> row;
+            ASSERT_EQ(0, codec.DecodeRow(it->GetValue().ToString(), &row));
+            ASSERT_EQ(it->GetPK(), row[0]);
+            ASSERT_EQ(std::to_string(it->GetKey()), row[2]);
+            count++;
+            it->Next();
+        }
+        ASSERT_EQ(num, count);
+    };
+    for (int i = 0; i < 200; i++) {
+        put(i);
+    }
+    uint64_t raw_byte_size = table.GetRecordByteSize();
+    ASSERT_TRUE(table.TrainCompressDict(24 * 60 * 60 * 1000));
+    ASSERT_EQ(1u, table.GetTableMeta()->compress_dict().version());
+    ASSERT_FALSE(table.GetTableMeta()->compress_dict().dict().empty());
+    // not retrained until the interval passes
+    for (int i = 200; i < 400; i++) {
+        put(i);
+    }
+    ASSERT_FALSE(table.TrainCompressDict(24 * 60 * 60 * 1000));
+    ASSERT_LT(table.GetRecordByteSize() - raw_byte_size, raw_byte_size);
+    // rows encoded before and after the dictionary are all readable
+    check(400);
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(table.NewIterator(0, "card1", ticket));
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    std::vector<std::string> row;
+    ASSERT_EQ(0, codec.DecodeRow(it->GetValue().ToString(), &row));
+    ASSERT_EQ("1391", row[2]);
+
+    // a retrain samples the rows written after it is due
+    ASSERT_FALSE(table.TrainCompressDict(0));
+    ASSERT_FALSE(table.TrainCompressDict(0));
+    for (int i = 400; i < 600; i++) {
+        put(i);
+    }
+    ASSERT_TRUE(table.TrainCompressDict(0));
+    ASSERT_EQ(2u, table.GetTableMeta()->compress_dict().version());
+    check(600);
+
+    // a table loaded with the dictionary in table meta compresses rows from the beginning
+    MemTable table2(*table.GetTableMeta());
+    ASSERT_TRUE(table2.Init());
+    ASSERT_EQ(1u, table2.GetDictCompressor()->GetSlot());
+}
+
 INSTANTIATE_TEST_CASE_P(TestMemAndHDD, TableTest,
                         ::testing::Values(::openmldb::common::kMemory, ::openmldb::common::kHDD));
 
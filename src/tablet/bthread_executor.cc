@@ -0,0 +1,53 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/bthread_executor.h"
+
+#include "base/glog_wrapper.h"
+#include "bthread/bthread.h"
+
+namespace openmldb {
+namespace tablet {
+
+static void* RunTask(void* args) {
+    (*reinterpret_cast<const std::function<void()>*>(args))();
+    return nullptr;
+}
+
+void BthreadExecutor::RunAll(const std::vector<std::function<void()>>& tasks) {
+    std::vector<bthread_t> workers;
+    workers.reserve(tasks.size());
+    for (size_t idx = 1; idx < tasks.size(); idx++) {
+        bthread_t worker;
+        int ret = bthread_start_background(&worker, nullptr, RunTask,
+                                           const_cast<std::function<void()>*>(&tasks[idx]));
+        if (ret != 0) {
+            PDLOG(WARNING, "fail to start bthread with errno %d, run the producer inline", ret);
+            tasks[idx]();
+            continue;
+        }
+        workers.push_back(worker);
+    }
+    if (!tasks.empty()) {
+        tasks[0]();
+    }
+    for (auto worker : workers) {
+        bthread_join(worker, nullptr);
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_BTHREAD_EXECUTOR_H_
+#define SRC_TABLET_BTHREAD_EXECUTOR_H_
+
+#include <functional>
+#include <vector>
+
+#include "vm/parallel_executor.h"
+
+namespace openmldb {
+namespace tablet {
+
+// Runs the concurrent producers of a request query as bthreads. The first task runs
+// on the calling bthread and the others are joined after it, so waiting yields the
+// worker instead of blocking it. A task whose bthread fails to start runs inline.
+class BthreadExecutor : public hybridse::vm::ParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+#endif  // SRC_TABLET_BTHREAD_EXECUTOR_H_
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/bthread_executor.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class BthreadExecutorTest : public ::testing::Test {};
+
+TEST_F(BthreadExecutorTest, RunAll) {
+    BthreadExecutor executor;
+    executor.RunAll({});
+
+    std::vector<int> outputs(8, 0);
+    std::atomic<int> finished = 0;
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        tasks.emplace_back([i, &outputs, &finished]() {
+            bthread_usleep(1000);
+            outputs[i] = i + 1;
+            finished++;
+        });
+    }
+    executor.RunAll(tasks);
+    // every task has finished once RunAll returns
+    ASSERT_EQ(static_cast<int>(outputs.size()), finished.load());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        ASSERT_EQ(static_cast<int>(i + 1), outputs[i]);
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
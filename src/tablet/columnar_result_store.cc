@@ -0,0 +1,99 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/columnar_result_store.h"
+
+#include "base/status.h"
+
+namespace openmldb {
+namespace tablet {
+
+void ColumnarResult::AddBlock(uint32_t size, uint32_t rows) {
+    block_sizes.push_back(size);
+    block_rows.push_back(rows);
+    total_count += rows;
+}
+
+void ColumnarResult::CutChunk(uint64_t max_bytes, ::openmldb::api::QueryResponse* response, butil::IOBuf* buf) {
+    uint64_t byte_size = 0;
+    uint32_t count = 0;
+    while (!block_sizes.empty() && (byte_size == 0 || byte_size < max_bytes)) {
+        uint32_t size = block_sizes.front();
+        blocks.cutn(buf, size);
+        response->add_block_sizes(size);
+        byte_size += size;
+        count += block_rows.front();
+        block_sizes.pop_front();
+        block_rows.pop_front();
+    }
+    response->set_result_format(::openmldb::api::kColumnarResult);
+    response->set_schema(schema);
+    response->set_byte_size(byte_size);
+    response->set_count(count);
+    response->set_total_count(total_count);
+    response->set_is_finish(IsFinished());
+    response->set_code(::openmldb::base::kOk);
+}
+
+ColumnarResultStore::ColumnarResultStore(uint64_t keep_alive_ms)
+    : keep_alive_ms_(keep_alive_ms), mu_(), next_id_(1), results_() {}
+
+uint64_t ColumnarResultStore::Put(const std::shared_ptr<ColumnarResult>& result, uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint64_t id = next_id_++;
+    result->last_access_ms = now_ms;
+    results_.emplace(id, result);
+    return id;
+}
+
+std::shared_ptr<ColumnarResult> ColumnarResultStore::Take(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = results_.find(id);
+    if (it == results_.end()) {
+        return {};
+    }
+    auto result = it->second;
+    results_.erase(it);
+    return result;
+}
+
+void ColumnarResultStore::PutBack(uint64_t id, const std::shared_ptr<ColumnarResult>& result, uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    result->last_access_ms = now_ms;
+    results_[id] = result;
+}
+
+uint32_t ColumnarResultStore::Expire(uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t cnt = 0;
+    for (auto it = results_.begin(); it != results_.end();) {
+        if (it->second->last_access_ms + keep_alive_ms_ <= now_ms) {
+            it = results_.erase(it);
+            cnt++;
+        } else {
+            ++it;
+        }
+    }
+    return cnt;
+}
+
+size_t ColumnarResultStore::Size() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return results_.size();
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_COLUMNAR_RESULT_STORE_H_
+#define SRC_TABLET_COLUMNAR_RESULT_STORE_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "butil/iobuf.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace tablet {
+
+// Encoded columnar blocks of a batch query result which are not sent yet.
+struct ColumnarResult {
+    // encoded output schema
+    std::string schema;
+    butil::IOBuf blocks;
+    std::deque<uint32_t> block_sizes;
+    std::deque<uint32_t> block_rows;
+    uint32_t total_count = 0;
+    uint64_t last_access_ms = 0;
+
+    // add a block encoded at the end of `blocks`
+    void AddBlock(uint32_t size, uint32_t rows);
+
+    // move the leading blocks into `buf` until at least `max_bytes` are moved, one block at least,
+    // and fill the columnar fields of `response`
+    void CutChunk(uint64_t max_bytes, ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+
+    bool IsFinished() const { return block_sizes.empty(); }
+};
+
+// Keeps the columnar results which do not fit into one response, until the client fetches
+// the rest of them or they are idle for `keep_alive_ms`.
+class ColumnarResultStore {
+ public:
+    explicit ColumnarResultStore(uint64_t keep_alive_ms);
+
+    // return the id to fetch the rest of `result`
+    uint64_t Put(const std::shared_ptr<ColumnarResult>& result, uint64_t now_ms);
+
+    // remove the result from the store, so its next chunk is cut by one caller only.
+    // return nullptr if it is not found or expired
+    std::shared_ptr<ColumnarResult> Take(uint64_t id);
+
+    // put back a result taken out which is not finished
+    void PutBack(uint64_t id, const std::shared_ptr<ColumnarResult>& result, uint64_t now_ms);
+
+    // drop the results idle for `keep_alive_ms` and return the count of them
+    uint32_t Expire(uint64_t now_ms);
+
+    size_t Size();
+
+ private:
+    const uint64_t keep_alive_ms_;
+    std::mutex mu_;
+    uint64_t next_id_;
+    std::map<uint64_t, std::shared_ptr<ColumnarResult>> results_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_COLUMNAR_RESULT_STORE_H_
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/columnar_result_store.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class ColumnarResultStoreTest : public ::testing::Test {};
+
+static std::shared_ptr<ColumnarResult> MakeResult(uint32_t block_cnt, uint32_t block_size, uint32_t block_rows) {
+    auto result = std::make_shared<ColumnarResult>();
+    result->schema = "schema";
+    for (uint32_t i = 0; i < block_cnt; i++) {
+        result->blocks.append(std::string(block_size, 'a' + i));
+        result->AddBlock(block_size, block_rows);
+    }
+    return result;
+}
+
+TEST_F(ColumnarResultStoreTest, CutChunk) {
+    auto result = MakeResult(5, 100, 10);
+    ASSERT_EQ(50u, result->total_count);
+
+    // stop once the chunk reaches max bytes
+    ::openmldb::api::QueryResponse response;
+    butil::IOBuf buf;
+    result->CutChunk(250, &response, &buf);
+    ASSERT_EQ(3, response.block_sizes_size());
+    ASSERT_EQ(300u, buf.size());
+    ASSERT_EQ(std::string(100, 'a'), buf.to_string().substr(0, 100));
+    ASSERT_EQ(300u, response.byte_size());
+    ASSERT_EQ(30u, response.count());
+    ASSERT_EQ(50u, response.total_count());
+    ASSERT_EQ("schema", response.schema());
+    ASSERT_EQ(::openmldb::api::kColumnarResult, response.result_format());
+    ASSERT_FALSE(response.is_finish());
+    ASSERT_FALSE(result->IsFinished());
+
+    // one block at least even if it is larger than max bytes
+    response.Clear();
+    buf.clear();
+    result->CutChunk(10, &response, &buf);
+    ASSERT_EQ(1, response.block_sizes_size());
+    ASSERT_EQ(std::string(100, 'd'), buf.to_string());
+    ASSERT_FALSE(response.is_finish());
+
+    response.Clear();
+    buf.clear();
+    result->CutChunk(1000, &response, &buf);
+    ASSERT_EQ(1, response.block_sizes_size());
+    ASSERT_EQ(10u, response.count());
+    ASSERT_TRUE(response.is_finish());
+    ASSERT_TRUE(result->IsFinished());
+
+    // an empty result is finished in the first chunk
+    auto empty = MakeResult(0, 100, 10);
+    response.Clear();
+    buf.clear();
+    empty->CutChunk(1000, &response, &buf);
+    ASSERT_EQ(0, response.block_sizes_size());
+    ASSERT_EQ(0u, response.count());
+    ASSERT_TRUE(response.is_finish());
+}
+
+TEST_F(ColumnarResultStoreTest, TakeAndExpire) {
+    ColumnarResultStore store(1000);
+    auto result = MakeResult(2, 100, 10);
+    uint64_t id = store.Put(result, 100);
+    uint64_t other_id = store.Put(MakeResult(2, 100, 10), 100);
+    ASSERT_NE(id, other_id);
+    ASSERT_EQ(2u, store.Size());
+
+    // a taken result is fetched by one caller only
+    ASSERT_EQ(result, store.Take(id));
+    ASSERT_FALSE(store.Take(id));
+    store.PutBack(id, result, 800);
+    ASSERT_EQ(2u, store.Size());
+
+    // only the result idle for keep alive time is dropped
+    ASSERT_EQ(1u, store.Expire(1100));
+    ASSERT_FALSE(store.Take(other_id));
+    ASSERT_EQ(result, store.Take(id));
+    ASSERT_EQ(0u, store.Expire(10000));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -32,7 +32,8 @@ CombineIterator::CombineIterator(std::vector<QueryIt> q_its, uint64_t start_time
       ttl_type_(expired_value.ttl_type),
       expire_time_(expired_value.abs_ttl),
       expire_cnt_(expired_value.lat_ttl),
-      cur_qit_(nullptr) {}
+      cur_qit_(nullptr),
+      error_(false) {}
 
 void CombineIterator::SeekToFirst() {
     q_its_.erase(
@@ -81,6 +82,12 @@ void CombineIterator::SelectIterator() {
     cur_qit_ = nullptr;
     for (auto iter = q_its_.begin(); iter != q_its_.end(); iter++) {
         uint64_t cur_ts = 0;
+        if (iter->it && iter->it->HasError()) {
+            // rows of the other iterators can not be merged in order any more
+            error_ = true;
+            cur_qit_ = nullptr;
+            return;
+        }
         if (iter->it && iter->it->Valid()) {
             cur_ts = iter->it->GetKey();
             bool is_expire = false;
@@ -124,6 +124,8 @@ class CombineIterator {
     openmldb::base::Slice GetValue();
     inline uint64_t GetExpireTime() const { return expire_time_; }
     inline ::openmldb::storage::TTLType GetTTLType() const { return ttl_type_; }
+    // true if one of the iterators stopped at a row which can not be read
+    inline bool HasError() const { return error_; }
 
  private:
     void SelectIterator();
@@ -136,6 +138,7 @@ class CombineIterator {
     uint64_t expire_time_;
     const uint32_t expire_cnt_;
     QueryIt* cur_qit_;
+    bool error_;
 };
 
 }  // namespace tablet
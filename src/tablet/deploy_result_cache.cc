@@ -0,0 +1,313 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/deploy_result_cache.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/time.h"
+#include "base/hash.h"
+#include "base/time.h"
+#include "bvar/bvar.h"
+#include "bvar/multi_dimension.h"
+#include "glog/logging.h"
+#include "sdk/base_impl.h"
+
+namespace openmldb {
+namespace tablet {
+
+static bvar::MultiDimension<bvar::Adder<int64_t>> g_deploy_result_cache_stats("deploy_result_cache",
+                                                                              {"db", "deployment", "result"});
+
+ResultCacheVersions::ResultCacheVersions()
+    : key_versions_(new std::atomic<uint64_t>[KEY_BUCKET_NUM]),
+      table_versions_(new std::atomic<uint64_t>[TABLE_BUCKET_NUM]),
+      table_epochs_(new std::atomic<uint64_t>[TABLE_BUCKET_NUM]) {
+    for (uint32_t i = 0; i < KEY_BUCKET_NUM; i++) {
+        key_versions_[i].store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < TABLE_BUCKET_NUM; i++) {
+        table_versions_[i].store(0, std::memory_order_relaxed);
+        table_epochs_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ResultCacheVersions::TableHash(const std::string& db, const std::string& table) {
+    return ::openmldb::base::hash64(db + "." + table);
+}
+
+uint32_t ResultCacheVersions::KeyBucket(uint64_t table_hash, const std::string& key) const {
+    return (::openmldb::base::hash64(key) * 31 + table_hash) % KEY_BUCKET_NUM;
+}
+
+void ResultCacheVersions::OnPut(const std::string& db, const std::string& table, const Dimensions& dimensions) {
+    uint64_t table_hash = TableHash(db, table);
+    for (const auto& dimension : dimensions) {
+        key_versions_[KeyBucket(table_hash, dimension.key())].fetch_add(1, std::memory_order_release);
+    }
+    table_versions_[table_hash % TABLE_BUCKET_NUM].fetch_add(1, std::memory_order_release);
+}
+
+void ResultCacheVersions::OnTableChanged(const std::string& db, const std::string& table) {
+    uint64_t table_hash = TableHash(db, table);
+    table_epochs_[table_hash % TABLE_BUCKET_NUM].fetch_add(1, std::memory_order_release);
+    table_versions_[table_hash % TABLE_BUCKET_NUM].fetch_add(1, std::memory_order_release);
+}
+
+const std::atomic<uint64_t>* ResultCacheVersions::GetKeySlot(const std::string& db, const std::string& table,
+                                                             const std::string& key) const {
+    return &key_versions_[KeyBucket(TableHash(db, table), key)];
+}
+
+const std::atomic<uint64_t>* ResultCacheVersions::GetTableSlot(const std::string& db,
+                                                               const std::string& table) const {
+    return &table_versions_[TableHash(db, table) % TABLE_BUCKET_NUM];
+}
+
+const std::atomic<uint64_t>* ResultCacheVersions::GetTableEpochSlot(const std::string& db,
+                                                                    const std::string& table) const {
+    return &table_epochs_[TableHash(db, table) % TABLE_BUCKET_NUM];
+}
+
+DeployResultCache::DeployResultCache(const std::string& db, const std::string& sp_name, uint64_t ttl_ms,
+                                     uint64_t max_bytes,
+                                     const std::vector<std::pair<std::string, std::string>>& tables,
+                                     const std::vector<uint32_t>& key_cols,
+                                     const hybridse::codec::Schema& request_schema,
+                                     std::shared_ptr<ResultCacheVersions> versions)
+    : db_(db),
+      sp_name_(sp_name),
+      ttl_ms_(ttl_ms),
+      max_bytes_(max_bytes),
+      tables_(tables),
+      key_cols_(key_cols),
+      request_view_(request_schema),
+      versions_(versions),
+      mu_(),
+      entries_(),
+      lru_(),
+      byte_size_(0),
+      hit_cnt_(0),
+      miss_cnt_(0) {}
+
+std::shared_ptr<DeployResultCache> DeployResultCache::Create(const hybridse::sdk::ProcedureInfo& sp_info,
+                                                             uint64_t max_bytes,
+                                                             std::shared_ptr<ResultCacheVersions> versions) {
+    auto ttl_option = sp_info.GetOption(RESULT_CACHE_TTL);
+    if (ttl_option == nullptr || max_bytes == 0 || !versions) {
+        return nullptr;
+    }
+    // ttl is in milliseconds or a duration like 500ms, 10s, 1m
+    uint64_t ttl_ms = 0;
+    if (!absl::SimpleAtoi(*ttl_option, &ttl_ms)) {
+        absl::Duration duration;
+        if (!absl::ParseDuration(absl::AsciiStrToLower(*ttl_option), &duration)) {
+            LOG(WARNING) << "invalid " << RESULT_CACHE_TTL << " " << *ttl_option << " of " << sp_info.GetDbName()
+                         << "." << sp_info.GetSpName();
+            return nullptr;
+        }
+        ttl_ms = absl::ToInt64Milliseconds(duration);
+    }
+    if (ttl_ms == 0) {
+        return nullptr;
+    }
+    auto schema_impl = dynamic_cast<const hybridse::sdk::SchemaImpl*>(&sp_info.GetInputSchema());
+    if (schema_impl == nullptr) {
+        return nullptr;
+    }
+    const auto& request_schema = schema_impl->GetSchema();
+    std::vector<uint32_t> key_cols;
+    auto keys_option = sp_info.GetOption(RESULT_CACHE_KEYS);
+    if (keys_option != nullptr) {
+        for (auto name : absl::StrSplit(*keys_option, ',', absl::SkipWhitespace())) {
+            name = absl::StripAsciiWhitespace(name);
+            int idx = 0;
+            for (; idx < request_schema.size(); idx++) {
+                if (request_schema.Get(idx).name() == name) {
+                    break;
+                }
+            }
+            if (idx == request_schema.size()) {
+                LOG(WARNING) << "result cache key " << name << " not found in " << sp_info.GetDbName() << "."
+                             << sp_info.GetSpName();
+                return nullptr;
+            }
+            key_cols.push_back(idx);
+        }
+    }
+    std::vector<std::pair<std::string, std::string>> tables;
+    const auto& dbs = sp_info.GetDbs();
+    const auto& table_names = sp_info.GetTables();
+    for (size_t i = 0; i < table_names.size(); i++) {
+        tables.emplace_back(i < dbs.size() ? dbs[i] : sp_info.GetDbName(), table_names[i]);
+    }
+    return std::make_shared<DeployResultCache>(sp_info.GetDbName(), sp_info.GetSpName(), ttl_ms, max_bytes, tables,
+                                               key_cols, request_schema, versions);
+}
+
+void DeployResultCache::TakeSnapshot(const hybridse::codec::Row& request, Snapshot* snapshot) {
+    snapshot->slots.clear();
+    snapshot->versions.clear();
+    if (key_cols_.empty()) {
+        for (const auto& table : tables_) {
+            snapshot->slots.push_back(versions_->GetTableSlot(table.first, table.second));
+        }
+    } else {
+        // build the partition key the same way as the insert path does
+        std::string key;
+        const int8_t* buf = request.buf();
+        for (auto idx : key_cols_) {
+            if (!key.empty()) {
+                key.append("|");
+            }
+            auto type = request_view_.GetSchema()->Get(idx).type();
+            if (request_view_.IsNULL(buf, idx)) {
+                key.append(hybridse::codec::NONETOKEN);
+                continue;
+            }
+            switch (type) {
+                case hybridse::type::kBool: {
+                    bool val = false;
+                    request_view_.GetValue(buf, idx, type, &val);
+                    key.append(val ? "true" : "false");
+                    break;
+                }
+                case hybridse::type::kVarchar: {
+                    const char* val = nullptr;
+                    uint32_t length = 0;
+                    request_view_.GetValue(buf, idx, &val, &length);
+                    if (length == 0) {
+                        key.append(hybridse::codec::EMPTY_STRING);
+                    } else {
+                        key.append(val, length);
+                    }
+                    break;
+                }
+                default: {
+                    int64_t val = 0;
+                    if (request_view_.GetInteger(buf, idx, type, &val) != 0) {
+                        return;
+                    }
+                    key.append(std::to_string(val));
+                    break;
+                }
+            }
+        }
+        for (const auto& table : tables_) {
+            snapshot->slots.push_back(versions_->GetKeySlot(table.first, table.second, key));
+            snapshot->slots.push_back(versions_->GetTableEpochSlot(table.first, table.second));
+        }
+    }
+    for (auto slot : snapshot->slots) {
+        snapshot->versions.push_back(slot->load(std::memory_order_acquire));
+    }
+}
+
+bool DeployResultCache::IsValid(const Snapshot& snapshot) {
+    if (snapshot.slots.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < snapshot.slots.size(); i++) {
+        if (snapshot.slots[i]->load(std::memory_order_acquire) != snapshot.versions[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DeployResultCache::RecordStats(bool hit) {
+    if (hit) {
+        hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto stats = g_deploy_result_cache_stats.get_stats({db_, sp_name_, hit ? "hit" : "miss"});
+    if (stats != nullptr) {
+        *stats << 1;
+    }
+}
+
+void DeployResultCache::EraseLocked(std::unordered_map<std::string, Entry>::iterator it) {
+    byte_size_ -= it->first.size() + it->second.output.size();
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+}
+
+bool DeployResultCache::Get(const hybridse::codec::Row& request, hybridse::codec::Row* output, Snapshot* snapshot) {
+    if (request.GetRowPtrCnt() != 1 || request.size() == 0) {
+        return false;
+    }
+    std::string key(reinterpret_cast<const char*>(request.buf()), request.size());
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            if (it->second.expire_time > ::baidu::common::timer::get_micros() / 1000 &&
+                IsValid(it->second.snapshot)) {
+                *output = it->second.output;
+                lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+                RecordStats(true);
+                return true;
+            }
+            EraseLocked(it);
+        }
+    }
+    RecordStats(false);
+    TakeSnapshot(request, snapshot);
+    return false;
+}
+
+void DeployResultCache::Put(const hybridse::codec::Row& request, const hybridse::codec::Row& output,
+                            Snapshot&& snapshot) {
+    if (snapshot.slots.empty() || request.GetRowPtrCnt() != 1 || output.GetRowPtrCnt() != 1) {
+        return;
+    }
+    std::string key(reinterpret_cast<const char*>(request.buf()), request.size());
+    uint64_t entry_size = key.size() + output.size();
+    if (entry_size > max_bytes_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        EraseLocked(it);
+    }
+    while (byte_size_ + entry_size > max_bytes_ && !lru_.empty()) {
+        EraseLocked(entries_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    Entry entry{output, ::baidu::common::timer::get_micros() / 1000 + ttl_ms_, std::move(snapshot), lru_.begin()};
+    entries_.emplace(std::move(key), std::move(entry));
+    byte_size_ += entry_size;
+}
+
+uint64_t DeployResultCache::GetByteSize() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return byte_size_;
+}
+
+size_t DeployResultCache::GetEntryCount() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return entries_.size();
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_DEPLOY_RESULT_CACHE_H_
+#define SRC_TABLET_DEPLOY_RESULT_CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "google/protobuf/repeated_field.h"
+#include "proto/tablet.pb.h"
+#include "sdk/base.h"
+
+namespace openmldb {
+namespace tablet {
+
+// deployment options to enable the result cache
+inline constexpr const char* RESULT_CACHE_TTL = "result_cache_ttl";
+inline constexpr const char* RESULT_CACHE_KEYS = "result_cache_keys";
+
+using Dimensions = ::google::protobuf::RepeatedPtrField<::openmldb::api::Dimension>;
+
+// Write versions of tables and partition keys, bumped by the write path of this tablet.
+// Keys and tables are hashed into fixed size buckets, so a collision only causes an
+// unnecessary invalidation.
+class ResultCacheVersions {
+ public:
+    ResultCacheVersions();
+
+    // a row is put into the table with the given index keys
+    void OnPut(const std::string& db, const std::string& table, const Dimensions& dimensions);
+    // rows of the table are changed without key information, e.g. delete, drop or load
+    void OnTableChanged(const std::string& db, const std::string& table);
+
+    const std::atomic<uint64_t>* GetKeySlot(const std::string& db, const std::string& table,
+                                            const std::string& key) const;
+    const std::atomic<uint64_t>* GetTableSlot(const std::string& db, const std::string& table) const;
+    const std::atomic<uint64_t>* GetTableEpochSlot(const std::string& db, const std::string& table) const;
+
+ private:
+    static constexpr uint32_t KEY_BUCKET_NUM = 1 << 16;
+    static constexpr uint32_t TABLE_BUCKET_NUM = 1 << 10;
+
+    static uint64_t TableHash(const std::string& db, const std::string& table);
+    uint32_t KeyBucket(uint64_t table_hash, const std::string& key) const;
+
+    // bumped by every put of the key
+    std::unique_ptr<std::atomic<uint64_t>[]> key_versions_;
+    // bumped by every write of the table
+    std::unique_ptr<std::atomic<uint64_t>[]> table_versions_;
+    // bumped only by writes without key information
+    std::unique_ptr<std::atomic<uint64_t>[]> table_epochs_;
+};
+
+// Per deployment cache of request results keyed by the request row.
+//
+// An entry is valid until its ttl expires or a write on this tablet touches the
+// tables the deployment reads. If `result_cache_keys` are declared, only writes
+// of the same partition key invalidate the entry, so the declared columns must be
+// the partition key of every window and join in the deployment. Writes served by
+// other tablets are not observed, the ttl bounds the staleness of such results.
+class DeployResultCache {
+ public:
+    struct Snapshot {
+        std::vector<const std::atomic<uint64_t>*> slots;
+        std::vector<uint64_t> versions;
+    };
+
+    DeployResultCache(const std::string& db, const std::string& sp_name, uint64_t ttl_ms, uint64_t max_bytes,
+                      const std::vector<std::pair<std::string, std::string>>& tables,
+                      const std::vector<uint32_t>& key_cols, const hybridse::codec::Schema& request_schema,
+                      std::shared_ptr<ResultCacheVersions> versions);
+
+    // build the cache from the deployment options, return nullptr if it is not enabled or invalid
+    static std::shared_ptr<DeployResultCache> Create(const hybridse::sdk::ProcedureInfo& sp_info, uint64_t max_bytes,
+                                                     std::shared_ptr<ResultCacheVersions> versions);
+
+    // return true and set `output` if `request` hits the cache, otherwise fill `snapshot`
+    // which should be passed to `Put` after the request is computed
+    bool Get(const hybridse::codec::Row& request, hybridse::codec::Row* output, Snapshot* snapshot);
+
+    void Put(const hybridse::codec::Row& request, const hybridse::codec::Row& output, Snapshot&& snapshot);
+
+    uint64_t GetHitCount() const { return hit_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetMissCount() const { return miss_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetByteSize() const;
+    size_t GetEntryCount() const;
+
+ private:
+    struct Entry {
+        hybridse::codec::Row output;
+        uint64_t expire_time;
+        Snapshot snapshot;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    static bool IsValid(const Snapshot& snapshot);
+    void TakeSnapshot(const hybridse::codec::Row& request, Snapshot* snapshot);
+    void EraseLocked(std::unordered_map<std::string, Entry>::iterator it);
+    void RecordStats(bool hit);
+
+    const std::string db_;
+    const std::string sp_name_;
+    const uint64_t ttl_ms_;
+    const uint64_t max_bytes_;
+    // <db, table> read by the deployment
+    const std::vector<std::pair<std::string, std::string>> tables_;
+    const std::vector<uint32_t> key_cols_;
+    hybridse::codec::RowView request_view_;
+    std::shared_ptr<ResultCacheVersions> versions_;
+
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, Entry> entries_;
+    // most recently used first
+    std::list<std::string> lru_;
+    uint64_t byte_size_;
+    std::atomic<uint64_t> hit_cnt_;
+    std::atomic<uint64_t> miss_cnt_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_DEPLOY_RESULT_CACHE_H_
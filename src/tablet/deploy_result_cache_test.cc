@@ -0,0 +1,172 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/deploy_result_cache.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class DeployResultCacheTest : public ::testing::Test {
+ public:
+    DeployResultCacheTest() : versions_(std::make_shared<ResultCacheVersions>()) {
+        auto col = schema_.Add();
+        col->set_name("card");
+        col->set_type(hybridse::type::kVarchar);
+        col = schema_.Add();
+        col->set_name("amt");
+        col->set_type(hybridse::type::kInt64);
+    }
+
+    hybridse::codec::Row BuildRow(const std::string& card, int64_t amt) {
+        hybridse::codec::RowBuilder builder(schema_);
+        uint32_t size = builder.CalTotalLength(card.size());
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        builder.AppendString(card.c_str(), card.size());
+        builder.AppendInt64(amt);
+        return hybridse::codec::Row(hybridse::codec::RefCountedSlice::CreateManaged(buf, size));
+    }
+
+    std::unique_ptr<DeployResultCache> NewCache(uint64_t ttl_ms, uint64_t max_bytes,
+                                                const std::vector<uint32_t>& key_cols) {
+        std::vector<std::pair<std::string, std::string>> tables = {{"db", "t1"}};
+        return std::make_unique<DeployResultCache>("db", "demo", ttl_ms, max_bytes, tables, key_cols, schema_,
+                                                   versions_);
+    }
+
+    Dimensions BuildDimensions(const std::string& key) {
+        Dimensions dimensions;
+        auto dimension = dimensions.Add();
+        dimension->set_key(key);
+        dimension->set_idx(0);
+        return dimensions;
+    }
+
+ protected:
+    hybridse::codec::Schema schema_;
+    std::shared_ptr<ResultCacheVersions> versions_;
+};
+
+TEST_F(DeployResultCacheTest, HitAndTableInvalidation) {
+    auto cache = NewCache(60000, 1 << 20, {});
+    auto request = BuildRow("card0", 1);
+    auto result = BuildRow("result", 100);
+    hybridse::codec::Row output;
+    DeployResultCache::Snapshot snapshot;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot));
+    cache->Put(request, result, std::move(snapshot));
+    ASSERT_EQ(1u, cache->GetEntryCount());
+
+    DeployResultCache::Snapshot snapshot2;
+    ASSERT_TRUE(cache->Get(request, &output, &snapshot2));
+    ASSERT_EQ(0, output.compare(result));
+    ASSERT_EQ(1u, cache->GetHitCount());
+    ASSERT_EQ(1u, cache->GetMissCount());
+
+    // other tables do not invalidate the entry
+    versions_->OnPut("db", "t2", BuildDimensions("card0"));
+    ASSERT_TRUE(cache->Get(request, &output, &snapshot2));
+    // any put into the table invalidates the entry without keys
+    versions_->OnPut("db", "t1", BuildDimensions("card1"));
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot2));
+    ASSERT_EQ(0u, cache->GetEntryCount());
+}
+
+TEST_F(DeployResultCacheTest, KeyInvalidation) {
+    auto cache = NewCache(60000, 1 << 20, {0});
+    auto request = BuildRow("card0", 1);
+    auto result = BuildRow("result", 100);
+    hybridse::codec::Row output;
+    DeployResultCache::Snapshot snapshot;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot));
+    cache->Put(request, result, std::move(snapshot));
+
+    versions_->OnPut("db", "t1", BuildDimensions("card1"));
+    DeployResultCache::Snapshot snapshot2;
+    ASSERT_TRUE(cache->Get(request, &output, &snapshot2));
+
+    versions_->OnPut("db", "t1", BuildDimensions("card0"));
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot2));
+    cache->Put(request, result, std::move(snapshot2));
+
+    DeployResultCache::Snapshot snapshot3;
+    ASSERT_TRUE(cache->Get(request, &output, &snapshot3));
+    versions_->OnTableChanged("db", "t1");
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot3));
+}
+
+TEST_F(DeployResultCacheTest, WriteDuringCompute) {
+    auto cache = NewCache(60000, 1 << 20, {0});
+    auto request = BuildRow("card0", 1);
+    hybridse::codec::Row output;
+    DeployResultCache::Snapshot snapshot;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot));
+    // the key is written after the snapshot, the computed result may be stale
+    versions_->OnPut("db", "t1", BuildDimensions("card0"));
+    cache->Put(request, BuildRow("result", 100), std::move(snapshot));
+    DeployResultCache::Snapshot snapshot2;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot2));
+}
+
+TEST_F(DeployResultCacheTest, Ttl) {
+    auto cache = NewCache(10, 1 << 20, {});
+    auto request = BuildRow("card0", 1);
+    hybridse::codec::Row output;
+    DeployResultCache::Snapshot snapshot;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot));
+    cache->Put(request, BuildRow("result", 100), std::move(snapshot));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    DeployResultCache::Snapshot snapshot2;
+    ASSERT_FALSE(cache->Get(request, &output, &snapshot2));
+}
+
+TEST_F(DeployResultCacheTest, ByteBound) {
+    auto request = BuildRow("card0", 0);
+    auto result = BuildRow("result", 100);
+    uint64_t entry_size = request.size() + result.size();
+    auto cache = NewCache(60000, entry_size * 3, {});
+    for (int64_t i = 0; i < 10; i++) {
+        hybridse::codec::Row output;
+        DeployResultCache::Snapshot snapshot;
+        auto row = BuildRow("card0", i);
+        ASSERT_FALSE(cache->Get(row, &output, &snapshot));
+        cache->Put(row, result, std::move(snapshot));
+        ASSERT_LE(cache->GetByteSize(), entry_size * 3);
+    }
+    ASSERT_EQ(3u, cache->GetEntryCount());
+    // the least recently used entries are evicted
+    hybridse::codec::Row output;
+    DeployResultCache::Snapshot snapshot;
+    ASSERT_FALSE(cache->Get(BuildRow("card0", 0), &output, &snapshot));
+    ASSERT_TRUE(cache->Get(BuildRow("card0", 9), &output, &snapshot));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/memory_quota.h"
+
+#include "bvar/bvar.h"
+#include "bvar/multi_dimension.h"
+
+namespace openmldb {
+namespace tablet {
+
+static bvar::MultiDimension<bvar::Adder<int64_t>> g_memory_admission("tablet_memory_admission",
+                                                                     {"db", "table", "result"});
+static bvar::IntRecorder g_query_peak_memory("query_run_step_peak_memory");
+static bvar::Adder<int64_t> g_query_memory_exceeded("query_memory_exceeded_count");
+
+MemoryQuota::MemoryQuota(uint64_t limit, double soft_ratio, uint64_t max_delay_us)
+    : limit_(limit),
+      soft_limit_(soft_ratio > 0 && soft_ratio < 1 ? static_cast<uint64_t>(limit * soft_ratio) : limit),
+      max_delay_us_(max_delay_us) {}
+
+QuotaState MemoryQuota::Check(uint64_t used) const {
+    if (limit_ == 0) {
+        return QuotaState::kNormal;
+    }
+    if (used > limit_) {
+        return QuotaState::kHardLimit;
+    }
+    if (used > soft_limit_) {
+        return QuotaState::kSoftLimit;
+    }
+    return QuotaState::kNormal;
+}
+
+uint64_t MemoryQuota::GetDelayUs(uint64_t used) const {
+    if (Check(used) != QuotaState::kSoftLimit || limit_ == soft_limit_) {
+        return 0;
+    }
+    return max_delay_us_ * (used - soft_limit_) / (limit_ - soft_limit_);
+}
+
+void RecordMemoryAdmission(const std::string& db, const std::string& table, QuotaState state) {
+    if (state == QuotaState::kNormal) {
+        return;
+    }
+    auto stats = g_memory_admission.get_stats({db, table, state == QuotaState::kHardLimit ? "reject" : "slow_down"});
+    if (stats != nullptr) {
+        *stats << 1;
+    }
+}
+
+void RecordQueryMemory(uint64_t peak_bytes, bool exceeded) {
+    g_query_peak_memory << peak_bytes;
+    if (exceeded) {
+        g_query_memory_exceeded << 1;
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_MEMORY_QUOTA_H_
+#define SRC_TABLET_MEMORY_QUOTA_H_
+
+#include <stdint.h>
+
+#include <string>
+
+namespace openmldb {
+namespace tablet {
+
+enum class QuotaState { kNormal = 0, kSoftLimit = 1, kHardLimit = 2 };
+
+// Admission of writes by memory usage. Usage over `soft_ratio * limit` is in soft
+// limit state and the write is delayed, the delay grows linearly to `max_delay_us`
+// at the limit. Usage over the limit is rejected. 0 limit means unlimited.
+class MemoryQuota {
+ public:
+    MemoryQuota(uint64_t limit, double soft_ratio, uint64_t max_delay_us);
+
+    QuotaState Check(uint64_t used) const;
+
+    uint64_t GetDelayUs(uint64_t used) const;
+
+    uint64_t GetLimit() const { return limit_; }
+    uint64_t GetSoftLimit() const { return soft_limit_; }
+
+ private:
+    const uint64_t limit_;
+    const uint64_t soft_limit_;
+    const uint64_t max_delay_us_;
+};
+
+// export the admission result of a write of the table
+void RecordMemoryAdmission(const std::string& db, const std::string& table, QuotaState state);
+
+// export the peak run step memory of a query
+void RecordQueryMemory(uint64_t peak_bytes, bool exceeded);
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_MEMORY_QUOTA_H_
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/memory_quota.h"
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class MemoryQuotaTest : public ::testing::Test {};
+
+TEST_F(MemoryQuotaTest, Check) {
+    MemoryQuota quota(1000, 0.8, 1000);
+    ASSERT_EQ(800u, quota.GetSoftLimit());
+    ASSERT_EQ(QuotaState::kNormal, quota.Check(0));
+    ASSERT_EQ(QuotaState::kNormal, quota.Check(800));
+    ASSERT_EQ(QuotaState::kSoftLimit, quota.Check(801));
+    ASSERT_EQ(QuotaState::kSoftLimit, quota.Check(1000));
+    ASSERT_EQ(QuotaState::kHardLimit, quota.Check(1001));
+
+    MemoryQuota unlimited(0, 0.8, 1000);
+    ASSERT_EQ(QuotaState::kNormal, unlimited.Check(UINT64_MAX));
+    ASSERT_EQ(0u, unlimited.GetDelayUs(UINT64_MAX));
+}
+
+TEST_F(MemoryQuotaTest, Delay) {
+    MemoryQuota quota(1000, 0.8, 1000);
+    ASSERT_EQ(0u, quota.GetDelayUs(800));
+    ASSERT_EQ(500u, quota.GetDelayUs(900));
+    ASSERT_EQ(1000u, quota.GetDelayUs(1000));
+    ASSERT_EQ(0u, quota.GetDelayUs(1001));
+
+    // no soft limit
+    MemoryQuota hard_only(1000, 1, 1000);
+    ASSERT_EQ(QuotaState::kNormal, hard_only.Check(1000));
+    ASSERT_EQ(0u, hard_only.GetDelayUs(1000));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/partition_registry.h"
+
+#include <utility>
+
+namespace openmldb {
+namespace tablet {
+
+namespace {
+
+size_t SetEntries(std::shared_ptr<const PartitionRegistry::EntryMap>& bg,  // NOLINT
+                  const std::shared_ptr<const PartitionRegistry::EntryMap>& entries) {
+    bg = entries;
+    return 1;
+}
+
+}  // namespace
+
+PartitionRegistry::PartitionRegistry() : entries_() { Publish(std::make_shared<const EntryMap>()); }
+
+void PartitionRegistry::Publish(std::shared_ptr<const EntryMap> entries) {
+    // the old map is released once the last reader holding it is done
+    entries_.Modify(SetEntries, entries);
+}
+
+size_t PartitionRegistry::Size() const {
+    butil::DoublyBufferedData<std::shared_ptr<const EntryMap>>::ScopedPtr ptr;
+    if (entries_.Read(&ptr) != 0) {
+        return 0;
+    }
+    return (*ptr)->size();
+}
+
+}  // namespace tablet
+}  // namespace openmldb
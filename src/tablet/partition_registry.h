@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_PARTITION_REGISTRY_H_
+#define SRC_TABLET_PARTITION_REGISTRY_H_
+
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "butil/containers/doubly_buffered_data.h"
+#include "replica/log_replicator.h"
+#include "storage/aggregator.h"
+#include "storage/snapshot.h"
+#include "storage/table.h"
+
+namespace openmldb {
+namespace tablet {
+
+// everything the tablet holds for one partition
+struct PartitionEntry {
+    std::shared_ptr<::openmldb::storage::Table> table;
+    std::shared_ptr<::openmldb::replica::LogReplicator> replicator;
+    std::shared_ptr<::openmldb::storage::Snapshot> snapshot;
+    // never modified in place, writers publish a new vector
+    std::shared_ptr<const ::openmldb::storage::Aggrs> aggrs;
+};
+
+// Read mostly lookup of the partitions by (tid, pid).
+//
+// Readers find the entry in an immutable map without taking a shared lock, the
+// writer builds a new map and swaps it in. Writers have to be serialized by the caller.
+class PartitionRegistry {
+ public:
+    using EntryMap = absl::flat_hash_map<uint64_t, PartitionEntry>;
+
+    PartitionRegistry();
+
+    static uint64_t Key(uint32_t tid, uint32_t pid) { return static_cast<uint64_t>(tid) << 32 | pid; }
+
+    std::shared_ptr<::openmldb::storage::Table> GetTable(uint32_t tid, uint32_t pid) const {
+        return Find(tid, pid, &PartitionEntry::table);
+    }
+    std::shared_ptr<::openmldb::replica::LogReplicator> GetReplicator(uint32_t tid, uint32_t pid) const {
+        return Find(tid, pid, &PartitionEntry::replicator);
+    }
+    std::shared_ptr<::openmldb::storage::Snapshot> GetSnapshot(uint32_t tid, uint32_t pid) const {
+        return Find(tid, pid, &PartitionEntry::snapshot);
+    }
+    std::shared_ptr<const ::openmldb::storage::Aggrs> GetAggrs(uint32_t tid, uint32_t pid) const {
+        return Find(tid, pid, &PartitionEntry::aggrs);
+    }
+
+    // replace all the entries, readers see either the old or the new map
+    void Publish(std::shared_ptr<const EntryMap> entries);
+
+    size_t Size() const;
+
+ private:
+    template <typename T>
+    T Find(uint32_t tid, uint32_t pid, T PartitionEntry::*field) const {
+        butil::DoublyBufferedData<std::shared_ptr<const EntryMap>>::ScopedPtr ptr;
+        if (entries_.Read(&ptr) != 0) {
+            return T();
+        }
+        const auto& entries = **ptr;
+        auto it = entries.find(Key(tid, pid));
+        if (it == entries.end()) {
+            return T();
+        }
+        return it->second.*field;
+    }
+
+    // Read only takes a thread local lock, so lookups from different threads never contend
+    mutable butil::DoublyBufferedData<std::shared_ptr<const EntryMap>> entries_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_PARTITION_REGISTRY_H_
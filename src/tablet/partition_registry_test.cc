@@ -0,0 +1,166 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/partition_registry.h"
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/spinlock.h"
+#include "common/timer.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace tablet {
+
+using ::openmldb::storage::MemTable;
+using ::openmldb::storage::Table;
+
+class PartitionRegistryTest : public ::testing::Test {};
+
+std::shared_ptr<Table> MakeTable(uint32_t tid, uint32_t pid) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(tid);
+    table_meta.set_pid(pid);
+    table_meta.set_name("t" + std::to_string(tid));
+    return std::make_shared<MemTable>(table_meta);
+}
+
+TEST_F(PartitionRegistryTest, Lookup) {
+    PartitionRegistry registry;
+    ASSERT_EQ(0u, registry.Size());
+    ASSERT_FALSE(registry.GetTable(1, 0));
+
+    auto entries = std::make_shared<PartitionRegistry::EntryMap>();
+    auto table = MakeTable(1, 0);
+    (*entries)[PartitionRegistry::Key(1, 0)].table = table;
+    (*entries)[PartitionRegistry::Key(1, 1)].table = MakeTable(1, 1);
+    auto aggrs = std::make_shared<::openmldb::storage::Aggrs>();
+    (*entries)[PartitionRegistry::Key(1, 0)].aggrs = aggrs;
+    registry.Publish(entries);
+    ASSERT_EQ(2u, registry.Size());
+    ASSERT_EQ(table, registry.GetTable(1, 0));
+    ASSERT_EQ(1u, registry.GetTable(1, 1)->GetPid());
+    ASSERT_EQ(aggrs, registry.GetAggrs(1, 0));
+    ASSERT_FALSE(registry.GetAggrs(1, 1));
+    ASSERT_FALSE(registry.GetReplicator(1, 0));
+    ASSERT_FALSE(registry.GetTable(0, 1));
+
+    // the table handed out before stays valid after it is removed from the registry
+    registry.Publish(std::make_shared<PartitionRegistry::EntryMap>());
+    ASSERT_FALSE(registry.GetTable(1, 0));
+    ASSERT_EQ(1u, table->GetId());
+}
+
+TEST_F(PartitionRegistryTest, ConcurrentPublish) {
+    PartitionRegistry registry;
+    std::atomic<bool> stop{false};
+    std::thread writer([&registry, &stop] {
+        for (uint32_t i = 0; i < 1000; i++) {
+            auto entries = std::make_shared<PartitionRegistry::EntryMap>();
+            (*entries)[PartitionRegistry::Key(1, 0)].table = MakeTable(1, 0);
+            (*entries)[PartitionRegistry::Key(2, i)].table = MakeTable(2, i);
+            registry.Publish(entries);
+        }
+        stop.store(true);
+    });
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&registry, &stop] {
+            while (!stop.load()) {
+                auto table = registry.GetTable(1, 0);
+                if (table) {
+                    ASSERT_EQ(1u, table->GetId());
+                }
+            }
+        });
+    }
+    writer.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(999u, registry.GetTable(2, 999)->GetPid());
+}
+
+TEST_F(PartitionRegistryTest, ContentionBenchmark) {
+    const uint32_t tid_num = 100;
+    const uint32_t pid_num = 8;
+    const uint32_t lookups = 1000000;
+    std::map<uint32_t, std::map<uint32_t, std::shared_ptr<Table>>> tables;
+    auto entries = std::make_shared<PartitionRegistry::EntryMap>();
+    for (uint32_t tid = 1; tid <= tid_num; tid++) {
+        for (uint32_t pid = 0; pid < pid_num; pid++) {
+            auto table = MakeTable(tid, pid);
+            tables[tid][pid] = table;
+            (*entries)[PartitionRegistry::Key(tid, pid)].table = table;
+        }
+    }
+    PartitionRegistry registry;
+    registry.Publish(entries);
+    ::openmldb::base::SpinMutex spin_mutex;
+
+    auto run = [&](uint32_t thread_num, bool use_registry) {
+        std::vector<std::thread> threads;
+        uint64_t consumed = ::baidu::common::timer::get_micros();
+        for (uint32_t i = 0; i < thread_num; i++) {
+            threads.emplace_back([&, i] {
+                uint64_t found = 0;
+                for (uint32_t j = 0; j < lookups; j++) {
+                    uint32_t tid = (i + j) % tid_num + 1;
+                    uint32_t pid = j % pid_num;
+                    std::shared_ptr<Table> table;
+                    if (use_registry) {
+                        table = registry.GetTable(tid, pid);
+                    } else {
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(spin_mutex);
+                        auto it = tables.find(tid);
+                        if (it != tables.end()) {
+                            auto tit = it->second.find(pid);
+                            if (tit != it->second.end()) {
+                                table = tit->second;
+                            }
+                        }
+                    }
+                    found += table ? 1 : 0;
+                }
+                ASSERT_EQ(lookups, found);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return ::baidu::common::timer::get_micros() - consumed;
+    };
+    for (uint32_t thread_num : {1, 4, 16}) {
+        uint64_t locked = run(thread_num, false);
+        uint64_t lock_free = run(thread_num, true);
+        std::cout << thread_num << " threads, " << lookups << " lookups per thread. spin lock + map: " << locked / 1000
+                  << "ms, registry: " << lock_free / 1000 << "ms" << std::endl;
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tablet/query_trace.h"
+
+#include <atomic>
+#include <map>
+
+#include "absl/strings/str_cat.h"
+#include "base/glog_wrapper.h"
+#include "brpc/traceprintf.h"
+#include "bvar/bvar.h"
+#include "bvar/multi_dimension.h"
+#include "gflags/gflags.h"
+
+DECLARE_uint32(query_trace_sample_interval);
+DECLARE_uint32(query_slow_log_threshold);
+
+namespace openmldb {
+namespace tablet {
+
+static constexpr const char kAdhocQuery[] = "_adhoc";
+
+// in microseconds, the stages of queries and the self time of runners, labeled by deployment
+static bvar::MultiDimension<bvar::LatencyRecorder> g_query_stage_latency("tablet_query_stage",
+                                                                         {"db", "deployment", "stage"});
+static bvar::MultiDimension<bvar::LatencyRecorder> g_query_runner_latency("tablet_query_runner",
+                                                                          {"db", "deployment", "runner"});
+static std::atomic<uint64_t> g_query_cnt(0);
+
+static bool SampleQuery() {
+    uint32_t interval = FLAGS_query_trace_sample_interval;
+    if (interval > 0 && g_query_cnt.fetch_add(1, std::memory_order_relaxed) % interval == 0) {
+        return true;
+    }
+    return ::brpc::CanAnnotateSpan();
+}
+
+QueryTrace::QueryTrace(const std::string& db, const std::string& deployment)
+    : db_(), deployment_(), run_trace_(), stage_(nullptr), stage_start_us_(0), stages_(), finished_(false) {
+    if (SampleQuery()) {
+        db_ = db;
+        deployment_ = deployment.empty() ? kAdhocQuery : deployment;
+        run_trace_.emplace();
+    }
+}
+
+void QueryTrace::Stage(const char* stage) {
+    if (!run_trace_ || finished_) {
+        return;
+    }
+    int64_t now = run_trace_->ElapsedMicros();
+    if (stage_ != nullptr) {
+        stages_.emplace_back(stage_, now - stage_start_us_);
+    }
+    stage_ = stage;
+    stage_start_us_ = now;
+}
+
+void QueryTrace::Finish() {
+    if (!run_trace_ || finished_) {
+        return;
+    }
+    int64_t total_us = run_trace_->ElapsedMicros();
+    if (stage_ != nullptr) {
+        stages_.emplace_back(stage_, total_us - stage_start_us_);
+    }
+    finished_ = true;
+    bool annotate = ::brpc::CanAnnotateSpan();
+    bool slow = total_us > FLAGS_query_slow_log_threshold;
+    std::string detail = "stages";
+    for (const auto& [stage, us] : stages_) {
+        if (auto stats = g_query_stage_latency.get_stats({db_, deployment_, stage}); stats != nullptr) {
+            *stats << us;
+        }
+        if (annotate) {
+            ::brpc::AnnotateSpan("query stage %s: %ld us", stage, us);
+        }
+        if (slow) {
+            absl::StrAppend(&detail, " ", stage, ":", us);
+        }
+    }
+    if (auto stats = g_query_stage_latency.get_stats({db_, deployment_, "total"}); stats != nullptr) {
+        *stats << total_us;
+    }
+    // a runner type may run several times in a query, e.g. the windows of a deployment
+    std::map<std::string, int64_t> runner_us;
+    for (const auto& span : run_trace_->GetSpans()) {
+        runner_us[span.name] += span.self_us;
+        if (annotate) {
+            ::brpc::AnnotateSpan("runner %s[%d] start %ld us, cost %ld us, self %ld us", span.name.c_str(),
+                                 span.runner_id, span.start_us, span.cost_us, span.self_us);
+        }
+    }
+    detail.append(", runners");
+    for (const auto& [name, us] : runner_us) {
+        if (auto stats = g_query_runner_latency.get_stats({db_, deployment_, name}); stats != nullptr) {
+            *stats << us;
+        }
+        if (slow) {
+            absl::StrAppend(&detail, " ", name, ":", us);
+        }
+    }
+    if (slow) {
+        PDLOG(INFO, "slow log[query]. db %s deployment %s time %ld us, %s", db_.c_str(),
+              deployment_.c_str(), total_us, detail.c_str());
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SRC_TABLET_QUERY_TRACE_H_
+#define SRC_TABLET_QUERY_TRACE_H_
+
+#include <stdint.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vm/run_trace.h"
+
+namespace openmldb {
+namespace tablet {
+
+// Latency breakdown of a sampled query. A query is sampled once every FLAGS_query_trace_sample_interval
+// queries, or if rpcz traces its request. The query marks its stages, and the runners of the engine
+// record their spans into the run trace. When the trace finishes, the stages and the self time of each
+// runner type are aggregated by deployment into bvars and annotated into the rpcz span of the request.
+// A trace of a query slower than FLAGS_query_slow_log_threshold is logged.
+class QueryTrace {
+ public:
+    // `deployment` is empty for a query which isn't a deployment
+    QueryTrace(const std::string& db, const std::string& deployment);
+    ~QueryTrace() { Finish(); }
+    QueryTrace(const QueryTrace&) = delete;
+    QueryTrace& operator=(const QueryTrace&) = delete;
+
+    bool IsSampled() const { return run_trace_.has_value(); }
+
+    // end the current stage and start `stage`, the last stage ends with the trace
+    void Stage(const char* stage);
+
+    // the trace to bind to the run session, null if the query isn't sampled
+    ::hybridse::vm::RunTrace* GetRunTrace() { return run_trace_ ? &run_trace_.value() : nullptr; }
+
+    void Finish();
+
+    // the finished stages and their time in microseconds
+    const std::vector<std::pair<const char*, int64_t>>& GetStages() const { return stages_; }
+
+ private:
+    std::string db_;
+    std::string deployment_;
+    std::optional<::hybridse::vm::RunTrace> run_trace_;
+    const char* stage_;
+    int64_t stage_start_us_;
+    std::vector<std::pair<const char*, int64_t>> stages_;
+    bool finished_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_QUERY_TRACE_H_
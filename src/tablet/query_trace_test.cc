@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tablet/query_trace.h"
+
+#include <string>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_uint32(query_trace_sample_interval);
+
+namespace openmldb {
+namespace tablet {
+
+class QueryTraceTest : public ::testing::Test {
+ public:
+    ~QueryTraceTest() { FLAGS_query_trace_sample_interval = 0; }
+};
+
+TEST_F(QueryTraceTest, Sample) {
+    FLAGS_query_trace_sample_interval = 0;
+    {
+        QueryTrace trace("db", "deploy");
+        ASSERT_FALSE(trace.IsSampled());
+        ASSERT_EQ(nullptr, trace.GetRunTrace());
+        trace.Stage("run");
+        trace.Finish();
+        ASSERT_TRUE(trace.GetStages().empty());
+    }
+    FLAGS_query_trace_sample_interval = 4;
+    int sampled = 0;
+    for (int i = 0; i < 100; i++) {
+        QueryTrace trace("db", "deploy");
+        sampled += trace.IsSampled() ? 1 : 0;
+    }
+    ASSERT_EQ(25, sampled);
+}
+
+TEST_F(QueryTraceTest, Stage) {
+    FLAGS_query_trace_sample_interval = 1;
+    QueryTrace trace("db", "");
+    ASSERT_TRUE(trace.IsSampled());
+    trace.Stage("compile");
+    trace.Stage("run");
+    auto run_trace = trace.GetRunTrace();
+    ASSERT_NE(nullptr, run_trace);
+    run_trace->AddSpan({"WINDOW_AGG", 1, 0, 10, 10});
+    trace.Stage("encode");
+    trace.Finish();
+    // stages after finish are ignored
+    trace.Stage("other");
+    const auto& stages = trace.GetStages();
+    ASSERT_EQ(3u, stages.size());
+    ASSERT_EQ(std::string("compile"), stages[0].first);
+    ASSERT_EQ(std::string("run"), stages[1].first);
+    ASSERT_EQ(std::string("encode"), stages[2].first);
+    for (const auto& stage : stages) {
+        ASSERT_GE(stage.second, 0);
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
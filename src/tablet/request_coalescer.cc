@@ -0,0 +1,107 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_coalescer.h"
+
+#include <mutex>  // NOLINT
+
+#include "common/timer.h"
+#include "bvar/bvar.h"
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace tablet {
+
+static bvar::IntRecorder g_request_coalesce_batch_size("request_coalesce_batch_size");
+
+RequestCoalescer::RequestCoalescer(uint32_t window_us, uint32_t max_rows)
+    : window_us_(window_us), max_rows_(max_rows > 0 ? max_rows : 1), mu_(), states_(), batch_cnt_(0), row_cnt_(0) {}
+
+int32_t RequestCoalescer::Run(const std::string& key, const hybridse::codec::Row& row,
+                              const BatchExecutor& executor, hybridse::codec::Row* output) {
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    auto& state = states_[key];
+    if (state.pending) {
+        // join the open batch and wait for its leader
+        auto batch = state.pending;
+        size_t idx = batch->inputs.size();
+        batch->inputs.push_back(row);
+        if (batch->inputs.size() >= max_rows_) {
+            batch->full = true;
+            state.pending.reset();
+            batch->cv.notify_all();
+        }
+        while (!batch->done) {
+            batch->cv.wait(lock);
+        }
+        if (batch->ret != 0) {
+            return batch->ret;
+        }
+        *output = batch->outputs[idx];
+        return 0;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->inputs.push_back(row);
+    if (max_rows_ > 1 && state.running > 0) {
+        // the requests arriving while the running batches finish join this one
+        state.pending = batch;
+        uint64_t deadline = ::baidu::common::timer::get_micros() + window_us_;
+        while (!batch->full) {
+            uint64_t now = ::baidu::common::timer::get_micros();
+            if (now >= deadline) {
+                break;
+            }
+            batch->cv.wait_for(lock, deadline - now);
+        }
+        if (!batch->full) {
+            // the state is kept in the map while a batch of it is pending or running
+            states_[key].pending.reset();
+        }
+    }
+    states_[key].running++;
+    // the batch is closed, inputs will not be changed any more
+    lock.unlock();
+
+    std::vector<hybridse::codec::Row> outputs;
+    int32_t ret = executor(batch->inputs, &outputs);
+    if (ret == 0 && outputs.size() != batch->inputs.size()) {
+        LOG(WARNING) << "coalesced batch of " << key << " output " << outputs.size() << " rows for "
+                     << batch->inputs.size() << " requests";
+        ret = -1;
+    }
+    batch_cnt_.fetch_add(1, std::memory_order_relaxed);
+    row_cnt_.fetch_add(batch->inputs.size(), std::memory_order_relaxed);
+    g_request_coalesce_batch_size << batch->inputs.size();
+
+    lock.lock();
+    auto state_it = states_.find(key);
+    if (--state_it->second.running == 0 && !state_it->second.pending) {
+        states_.erase(state_it);
+    }
+    batch->ret = ret;
+    batch->outputs = std::move(outputs);
+    batch->done = true;
+    batch->cv.notify_all();
+    if (ret != 0) {
+        return ret;
+    }
+    *output = batch->outputs[0];
+    return 0;
+}
+
+}  // namespace tablet
+}  // namespace openmldb
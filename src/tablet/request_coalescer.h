@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_REQUEST_COALESCER_H_
+#define SRC_TABLET_REQUEST_COALESCER_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "bthread/condition_variable.h"
+#include "codec/row.h"
+
+namespace openmldb {
+namespace tablet {
+
+// Collects concurrent single row requests of the same deployment and runs them
+// as one batch request.
+//
+// The first request of a batch becomes the leader. If another batch of the
+// deployment is running, it waits at most `window_us` or until `max_rows`
+// requests joined, otherwise it runs at once since nothing else is coming in.
+// The leader runs the whole batch with its own executor and hands the output
+// rows back to the other callers.
+class RequestCoalescer {
+ public:
+    // returned by an executor whose batch exceeds the query memory limit
+    static constexpr int32_t kMemoryExceeded = -3;
+
+    // run a batch of request rows, `outputs` must have the same size as `inputs` on success
+    using BatchExecutor =
+        std::function<int32_t(const std::vector<hybridse::codec::Row>&, std::vector<hybridse::codec::Row>*)>;
+
+    RequestCoalescer(uint32_t window_us, uint32_t max_rows);
+
+    // return 0 and set `output` if the batch containing `row` runs successfully
+    int32_t Run(const std::string& key, const hybridse::codec::Row& row, const BatchExecutor& executor,
+                hybridse::codec::Row* output);
+
+    uint64_t GetBatchCount() const { return batch_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetRowCount() const { return row_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct Batch {
+        std::vector<hybridse::codec::Row> inputs;
+        std::vector<hybridse::codec::Row> outputs;
+        int32_t ret = 0;
+        bool full = false;
+        bool done = false;
+        bthread::ConditionVariable cv;
+    };
+
+    struct KeyState {
+        // the batch which is still open for new requests
+        std::shared_ptr<Batch> pending;
+        // the number of batches being run
+        uint32_t running = 0;
+    };
+
+    const uint32_t window_us_;
+    const uint32_t max_rows_;
+    bthread::Mutex mu_;
+    std::map<std::string, KeyState> states_;
+    std::atomic<uint64_t> batch_cnt_;
+    std::atomic<uint64_t> row_cnt_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_REQUEST_COALESCER_H_
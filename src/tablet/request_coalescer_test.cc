@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_coalescer.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class RequestCoalescerTest : public ::testing::Test {};
+
+hybridse::codec::Row BuildIntRow(int64_t val) {
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(sizeof(int64_t)));
+    *reinterpret_cast<int64_t*>(buf) = val;
+    return hybridse::codec::Row(hybridse::codec::RefCountedSlice::CreateManaged(buf, sizeof(int64_t)));
+}
+
+int64_t GetIntRow(const hybridse::codec::Row& row) { return *reinterpret_cast<const int64_t*>(row.buf()); }
+
+TEST_F(RequestCoalescerTest, SingleRequest) {
+    RequestCoalescer coalescer(1000000, 8);
+    auto executor = [](const std::vector<hybridse::codec::Row>& inputs, std::vector<hybridse::codec::Row>* outputs) {
+        for (const auto& row : inputs) {
+            outputs->push_back(BuildIntRow(GetIntRow(row) * 2));
+        }
+        return 0;
+    };
+    hybridse::codec::Row output;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(0, coalescer.Run("db.sp", BuildIntRow(21), executor, &output));
+    // a request alone runs at once instead of waiting for the window
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    ASSERT_EQ(42, GetIntRow(output));
+    ASSERT_EQ(1u, coalescer.GetBatchCount());
+}
+
+TEST_F(RequestCoalescerTest, ConcurrentRequests) {
+    const int thread_num = 16;
+    RequestCoalescer coalescer(200000, 4);
+    std::atomic<int> executed_rows = 0;
+    auto executor = [&executed_rows](const std::vector<hybridse::codec::Row>& inputs,
+                                     std::vector<hybridse::codec::Row>* outputs) {
+        // the requests arriving while a batch runs are coalesced
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        executed_rows += inputs.size();
+        for (const auto& row : inputs) {
+            outputs->push_back(BuildIntRow(GetIntRow(row) + 1000));
+        }
+        return 0;
+    };
+    std::vector<int64_t> results(thread_num, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i]() {
+            hybridse::codec::Row output;
+            if (coalescer.Run("db.sp", BuildIntRow(i), executor, &output) == 0) {
+                results[i] = GetIntRow(output);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int i = 0; i < thread_num; i++) {
+        ASSERT_EQ(i + 1000, results[i]);
+    }
+    ASSERT_EQ(thread_num, executed_rows.load());
+    ASSERT_EQ(static_cast<uint64_t>(thread_num), coalescer.GetRowCount());
+    // batches are closed once they are full
+    ASSERT_LT(coalescer.GetBatchCount(), static_cast<uint64_t>(thread_num));
+}
+
+TEST_F(RequestCoalescerTest, ExecutorFail) {
+    RequestCoalescer coalescer(100, 8);
+    auto executor = [](const std::vector<hybridse::codec::Row>& inputs, std::vector<hybridse::codec::Row>* outputs) {
+        return -1;
+    };
+    hybridse::codec::Row output;
+    ASSERT_NE(0, coalescer.Run("db.sp", BuildIntRow(1), executor, &output));
+    // output rows mismatch with requests
+    auto bad_executor = [](const std::vector<hybridse::codec::Row>& inputs,
+                           std::vector<hybridse::codec::Row>* outputs) { return 0; };
+    ASSERT_NE(0, coalescer.Run("db.sp", BuildIntRow(1), bad_executor, &output));
+}
+
+TEST_F(RequestCoalescerTest, MemoryExceeded) {
+    const int thread_num = 8;
+    RequestCoalescer coalescer(200000, 4);
+    auto executor = [](const std::vector<hybridse::codec::Row>& inputs, std::vector<hybridse::codec::Row>* outputs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return RequestCoalescer::kMemoryExceeded;
+    };
+    std::vector<int32_t> results(thread_num, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i]() {
+            hybridse::codec::Row output;
+            results[i] = coalescer.Run("db.sp", BuildIntRow(i), executor, &output);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    // every request of a batch over the memory limit gets the same code
+    for (int i = 0; i < thread_num; i++) {
+        ASSERT_EQ(RequestCoalescer::kMemoryExceeded, results[i]);
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
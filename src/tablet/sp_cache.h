@@ -23,6 +23,7 @@
 #include <utility>
 
 #include "absl/status/statusor.h"
+#include "tablet/deploy_result_cache.h"
 #include "vm/engine.h"
 
 namespace openmldb {
@@ -35,11 +36,14 @@ struct SQLProcedureCacheEntry {
     std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info;
     std::shared_ptr<hybridse::vm::CompileInfo> request_info;
     std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    // nullptr if the result cache is not enabled for the procedure
+    std::shared_ptr<DeployResultCache> result_cache;
 
     SQLProcedureCacheEntry(const std::shared_ptr<hybridse::sdk::ProcedureInfo> pinfo,
                            std::shared_ptr<hybridse::vm::CompileInfo> rinfo,
-                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo)
-        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo) {}
+                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo,
+                           std::shared_ptr<DeployResultCache> cache = nullptr)
+        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo), result_cache(cache) {}
 };
 
 class SpCache : public hybridse::vm::CompileInfoCache {
@@ -66,11 +70,25 @@ class SpCache : public hybridse::vm::CompileInfoCache {
     void InsertSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name,
                                       std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info,
                                       std::shared_ptr<hybridse::vm::CompileInfo> request_info,
-                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info) {
+                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info,
+                                      std::shared_ptr<DeployResultCache> result_cache = nullptr) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
         auto& sp_map_of_db = db_sp_map_[db];
-        sp_map_of_db.insert(
-            std::make_pair(sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info)));
+        sp_map_of_db.insert(std::make_pair(
+            sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info, result_cache)));
+    }
+
+    std::shared_ptr<DeployResultCache> GetResultCache(const std::string& db, const std::string& sp_name) const {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        auto db_it = db_sp_map_.find(db);
+        if (db_it == db_sp_map_.end()) {
+            return nullptr;
+        }
+        auto sp_it = db_it->second.find(sp_name);
+        if (sp_it == db_it->second.end()) {
+            return nullptr;
+        }
+        return sp_it->second.result_cache;
     }
 
     void DropSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name) {
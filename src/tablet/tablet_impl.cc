@@ -44,8 +44,13 @@
 #include "base/status.h"
 #include "base/strings.h"
 #include "brpc/controller.h"
+#include "bthread/bthread.h"
 #include "butil/iobuf.h"
+#include "bvar/bvar.h"
+#include "bvar/multi_dimension.h"
+#include "catalog/catalog_change.h"
 #include "codec/codec.h"
+#include "codec/columnar_codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
 #include "common/timer.h"
@@ -61,17 +66,23 @@
 #include "schema/schema_adapter.h"
 #include "storage/binlog.h"
 #include "storage/disk_table_snapshot.h"
+#include "storage/hybrid_table.h"
 #include "storage/segment.h"
 #include "storage/table.h"
+#include "tablet/bthread_executor.h"
 #include "tablet/file_sender.h"
 
 using ::openmldb::base::ReturnCode;
 using ::openmldb::storage::DiskTable;
+using ::openmldb::storage::HybridTable;
 using ::openmldb::storage::Table;
 
 DECLARE_int32(gc_interval);
+DECLARE_int32(compress_dict_check_interval);
+DECLARE_int32(compress_dict_retrain_interval);
 DECLARE_int32(gc_pool_size);
 DECLARE_int32(disk_gc_interval);
+DECLARE_int32(memory_head_gc_interval);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
 DECLARE_uint32(scan_reserve_size);
@@ -119,7 +130,18 @@ DECLARE_uint32(snapshot_ttl_time);
 DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
+DECLARE_uint32(request_max_parallel_producers);
+DECLARE_uint32(columnar_block_rows);
+DECLARE_uint32(columnar_result_keep_alive_ms);
+DECLARE_uint32(deploy_result_cache_max_mb);
+DECLARE_uint32(request_coalesce_window_us);
+DECLARE_uint32(request_coalesce_max_rows);
+DECLARE_uint32(table_max_memory_mb);
+DECLARE_double(memory_soft_limit_ratio);
+DECLARE_uint32(memory_max_write_delay_us);
+DECLARE_uint32(query_max_memory_mb);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_bool(enable_catalog_delta_refresh);
 
 namespace openmldb {
 namespace tablet {
@@ -128,6 +150,17 @@ static const uint32_t SEED = 0xe17a1465;
 
 static constexpr const char DEPLOY_STATS[] = "deploy_stats";
 
+// catalog refresh latency in microseconds, labeled by full or delta refresh
+static bvar::MultiDimension<bvar::LatencyRecorder> g_catalog_refresh_latency("tablet_catalog_refresh", {"mode"});
+
+// in minutes. the memory head of a hybrid table has to be evicted well before the rocksdb ttl refresh
+static int32_t GetGcInterval(const std::shared_ptr<Table>& table) {
+    if (table->GetStorageMode() == common::kMemory) {
+        return FLAGS_gc_interval;
+    }
+    return dynamic_cast<HybridTable*>(table.get()) != nullptr ? FLAGS_memory_head_gc_interval : FLAGS_disk_gc_interval;
+}
+
 TabletImpl::TabletImpl()
     : tables_(),
       mu_(),
@@ -148,6 +181,12 @@ TabletImpl::TabletImpl()
       zk_path_(),
       endpoint_(),
       sp_cache_(std::shared_ptr<SpCache>(new SpCache())),
+      result_cache_versions_(std::make_shared<ResultCacheVersions>()),
+      request_coalescer_(FLAGS_request_coalesce_window_us > 0
+                             ? std::make_unique<RequestCoalescer>(FLAGS_request_coalesce_window_us,
+                                                                  FLAGS_request_coalesce_max_rows)
+                             : nullptr),
+      columnar_results_(FLAGS_columnar_result_keep_alive_ms),
       notify_path_(),
       globalvar_changed_notify_path_(),
       startup_mode_(::openmldb::type::StartupMode::kStandalone) {}
@@ -312,6 +351,8 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     if (FLAGS_recycle_ttl != 0) {
         task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this));
     }
+    task_pool_.DelayTask(std::max(FLAGS_columnar_result_keep_alive_ms, 1000u),
+                         boost::bind(&TabletImpl::SchedExpireColumnarResult, this));
 #ifdef TCMALLOC_ENABLE
     MallocExtension* tcmalloc = MallocExtension::instance();
     tcmalloc->SetMemoryReleaseRate(FLAGS_mem_release_rate);
@@ -348,7 +389,10 @@ void TabletImpl::UpdateTTL(RpcController* ctrl, const ::openmldb::api::UpdateTTL
     // different ttl type is ok
     // no ttl value limit check in tablet, do it in nameserver before send request
     ::openmldb::storage::TTLSt ttl_st(ttl);
+    std::lock_guard<std::mutex> meta_lock(table_meta_mu_);
     table->SetTTL(::openmldb::storage::UpdateTTLMeta(ttl_st, request->index_name()));
+    // rows may expire earlier or later now
+    result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     std::string db_root_path;
     if (!ChooseDBRootPath(tid, pid, table->GetStorageMode(), db_root_path)) {
         base::SetResponseStatus(base::ReturnCode::kFailToGetDbRootPath, "fail to get db root path", response);
@@ -543,6 +587,9 @@ int32_t TabletImpl::GetIndex(const ::openmldb::api::GetRequest* request, const :
         }
         return 0;
     }
+    if (it->HasError()) {
+        return -5;
+    }
     // not found
     return 1;
 }
@@ -679,6 +726,10 @@ void TabletImpl::Get(RpcController* controller, const ::openmldb::api::GetReques
             response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
             response->set_msg("st/et sub key type is invalid");
             return;
+        case -5:
+            response->set_code(::openmldb::base::ReturnCode::kDecodeRowFailed);
+            response->set_msg("fail to decode row");
+            return;
         default:
             return;
     }
@@ -714,10 +765,7 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         response->set_msg("table is loading");
         return;
     }
-    if (table->GetStorageMode() == ::openmldb::common::StorageMode::kMemory &&
-        memory_used_.load(std::memory_order_relaxed) > FLAGS_max_memory_mb) {
-        PDLOG(WARNING, "current memory %lu MB exceed max memory limit %lu MB. tid %u, pid %u",
-              memory_used_.load(std::memory_order_relaxed), FLAGS_max_memory_mb, tid, pid);
+    if (table->GetStorageMode() == ::openmldb::common::StorageMode::kMemory && !AdmitMemoryWrite(table)) {
         response->set_code(::openmldb::base::ReturnCode::kExceedMaxMemory);
         response->set_msg("exceed max memory");
         return;
@@ -747,13 +795,15 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
             return;
         }
         DLOG(INFO) << "put data to tid " << tid << " pid " << pid << " with key " << request->dimensions(0).key();
-        ok = table->Put(entry.ts(), entry.value(), entry.dimensions());
+        // ts columns are read from the uncompressed value
+        ok = table->Put(entry.ts(), entry.value(), entry.dimensions(), request->value());
     }
     if (!ok) {
         response->set_code(::openmldb::base::ReturnCode::kPutFailed);
         response->set_msg("put failed");
         return;
     }
+    result_cache_versions_->OnPut(table->GetDB(), table->GetName(), entry.dimensions());
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
     std::shared_ptr<LogReplicator> replicator;
@@ -976,6 +1026,9 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
         }
         combine_it->Next();
     }
+    if (combine_it->HasError()) {
+        return -5;
+    }
     *count = record_count;
     return 0;
 }
@@ -1090,6 +1143,9 @@ int32_t TabletImpl::CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::open
         internal_cnt++;
         it->Next();
     }
+    if (it->HasError()) {
+        return -5;
+    }
     *count = internal_cnt;
     return 0;
 }
@@ -1204,11 +1260,106 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
             response->set_msg("fail to encode data rows");
             response->set_code(::openmldb::base::ReturnCode::kEncodeError);
             return;
+        case -5:
+            response->set_msg("fail to decode row");
+            response->set_code(::openmldb::base::ReturnCode::kDecodeRowFailed);
+            return;
         default:
             return;
     }
 }
 
+void TabletImpl::MultiScan(RpcController* controller, const ::openmldb::api::MultiScanRequest* request,
+                           ::openmldb::api::MultiScanResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table does not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table does not exist");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    auto table_meta = table->GetTableMeta();
+    const std::map<int32_t, std::shared_ptr<Schema>> vers_schema = table->GetAllVersionSchema();
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    butil::IOBuf& buf = cntl->response_attachment();
+    // the keys usually share a few indexes, resolve each of them once
+    std::map<std::string, std::pair<uint32_t, ::openmldb::storage::TTLSt>> indexes;
+    ::openmldb::api::ScanRequest scan_request;
+    scan_request.mutable_projection()->CopyFrom(request->projection());
+    for (const auto& key : request->keys()) {
+        auto* result = response->add_results();
+        if (key.st() < key.et()) {
+            result->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+            result->set_msg("starttime less than endtime");
+            continue;
+        }
+        const std::string& index_name = key.idx_name().empty() ? table->GetPkIndex()->GetName() : key.idx_name();
+        auto index_it = indexes.find(index_name);
+        if (index_it == indexes.end()) {
+            std::shared_ptr<IndexDef> index_def = table->GetIndex(index_name);
+            if (!index_def || !index_def->IsReady()) {
+                result->set_code(::openmldb::base::ReturnCode::kIdxNameNotFound);
+                result->set_msg("idx name not found");
+                continue;
+            }
+            ::openmldb::storage::TTLSt expired_value = *index_def->GetTTL();
+            expired_value.abs_ttl = table->GetExpireTime(expired_value);
+            index_it = indexes.emplace(index_name, std::make_pair(index_def->GetId(), expired_value)).first;
+        }
+        std::vector<QueryIt> query_its(1);
+        GetIterator(table, key.pk(), index_it->second.first, &query_its[0].it, &query_its[0].ticket);
+        if (!query_its[0].it) {
+            result->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
+            result->set_msg("ts name not found");
+            continue;
+        }
+        query_its[0].table = table;
+        CombineIterator combine_it(std::move(query_its), key.st(), openmldb::api::GetType::kSubKeyLe,
+                                   index_it->second.second);
+        scan_request.set_st(key.st());
+        scan_request.set_et(key.et());
+        scan_request.set_limit(key.limit());
+        uint32_t count = 0;
+        bool is_finish = true;
+        size_t buf_size = buf.size();
+        int32_t code = ScanIndex(&scan_request, *table_meta, vers_schema, true, &combine_it, &buf, &count, &is_finish);
+        if (code != 0) {
+            buf.pop_back(buf.size() - buf_size);
+            if (code == -4) {
+                result->set_code(::openmldb::base::ReturnCode::kEncodeError);
+                result->set_msg("fail to encode data rows");
+            } else if (code == -5) {
+                result->set_code(::openmldb::base::ReturnCode::kDecodeRowFailed);
+                result->set_msg("fail to decode row");
+            } else {
+                result->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+                result->set_msg("invalid args");
+            }
+            continue;
+        }
+        result->set_code(::openmldb::base::ReturnCode::kOk);
+        result->set_count(count);
+        result->set_buf_size(buf.size() - buf_size);
+        result->set_is_finish(is_finish);
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_query_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[multi scan]. key num %d time %lu. tid %u, pid %u", request->keys_size(),
+              end_time - start_time, tid, pid);
+    }
+}
+
 void TabletImpl::Count(RpcController* controller, const ::openmldb::api::CountRequest* request,
                        ::openmldb::api::CountResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -1286,6 +1437,10 @@ void TabletImpl::Count(RpcController* controller, const ::openmldb::api::CountRe
             response->set_msg("fail to encode data rows");
             response->set_code(::openmldb::base::ReturnCode::kFailToUpdateTtlFromTablet);
             return;
+        case -5:
+            response->set_msg("fail to decode row");
+            response->set_code(::openmldb::base::ReturnCode::kDecodeRowFailed);
+            return;
         default:
             return;
     }
@@ -1405,6 +1560,13 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
     } else if (scount < request->limit()) {
         is_finish = true;
     }
+    if (it->HasError()) {
+        delete it;
+        PDLOG(WARNING, "fail to decode row. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kDecodeRowFailed);
+        response->set_msg("fail to decode row");
+        return;
+    }
     buf.copy_to(response->mutable_pairs());
     delete it;
     DLOG(INFO) << "tid " << tid << " pid " << pid << " traverse count " << scount << " last_pk " << last_pk
@@ -1490,6 +1652,10 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
         PDLOG(WARNING, "invalid args. tid %u, pid %u", tid, pid);
         return;
     }
+    // the deleted rows may be read by cached deployment results
+    absl::Cleanup invalidate_result_cache = [this, &table]() {
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
+    };
     auto aggrs = GetAggregators(tid, pid);
     if (!aggrs) {
         if (table->Delete(entry)) {
@@ -1559,6 +1725,11 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
                         }
                     }
                 }
+                if (iter->HasError()) {
+                    response->set_code(::openmldb::base::ReturnCode::kDeleteFailed);
+                    response->set_msg("fail to decode row");
+                    return;
+                }
             }
         }
     }
@@ -1590,8 +1761,13 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
             }
         }
     };
+    QueryTrace trace(request->db(), request->is_procedure() ? request->sp_name() : "");
 
     ::hybridse::base::Status status;
+    if (request->is_batch() && request->has_result_id()) {
+        FetchColumnarResult(request->result_id(), response, buf);
+        return;
+    }
     if (request->is_batch()) {
         // convert repeated openmldb:type::DataType into hybridse::codec::Schema
         hybridse::codec::Schema parameter_schema;
@@ -1612,6 +1788,7 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
             session.EnableDebug();
         }
         session.SetParameterSchema(parameter_schema);
+        trace.Stage("compile");
         {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok) {
@@ -1622,6 +1799,7 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
             }
         }
 
+        trace.Stage("decode");
         ::hybridse::codec::Row parameter_row;
         auto& request_buf = static_cast<brpc::Controller*>(ctrl)->request_attachment();
         if (request->parameter_row_size() > 0 &&
@@ -1632,13 +1810,27 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
             return;
         }
         std::vector<::hybridse::codec::Row> output_rows;
+        session.SetMemoryLimit(static_cast<size_t>(FLAGS_query_max_memory_mb) << 20);
+        session.SetTrace(trace.GetRunTrace());
+        trace.Stage("run");
         int32_t run_ret = session.Run(parameter_row, output_rows);
+        RecordQueryMemory(session.GetPeakMemory(), session.IsMemoryExceeded());
+        if (session.IsMemoryExceeded()) {
+            response->set_msg("exceed query memory limit");
+            response->set_code(::openmldb::base::kExceedMaxMemory);
+            return;
+        }
         if (run_ret != 0) {
             response->set_msg(status.msg);
             response->set_code(::openmldb::base::kSQLRunError);
             DLOG(WARNING) << "fail to run sql: " << request->sql();
             return;
         }
+        trace.Stage("encode");
+        if (request->result_format() == ::openmldb::api::kColumnarResult) {
+            EncodeColumnarResult(session.GetSchema(), session.GetEncodedSchema(), output_rows, response, buf);
+            return;
+        }
         uint32_t byte_size = 0;
         uint32_t count = 0;
         for (auto& output_row : output_rows) {
@@ -1665,6 +1857,8 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
         if (request->is_debug()) {
             session.EnableDebug();
         }
+        session.SetTrace(trace.GetRunTrace());
+        trace.Stage("compile");
         if (request->is_procedure()) {
             const std::string& db_name = request->db();
             const std::string& sp_name = request->sp_name();
@@ -1681,7 +1875,7 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(sp_name);
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            RunRequestQuery(ctrl, *request, session, *response, *buf, &trace);
         } else {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok || session.GetCompileInfo() == nullptr) {
@@ -1690,7 +1884,7 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
                 DLOG(WARNING) << "fail to compile sql in request mode:\n" << request->sql();
                 return;
             }
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            RunRequestQuery(ctrl, *request, session, *response, *buf, &trace);
         }
         const std::string& sql = session.GetCompileInfo()->GetSql();
         if (response->code() != ::openmldb::base::kOk) {
@@ -1701,6 +1895,61 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
     }
 }
 
+void TabletImpl::EncodeColumnarResult(const ::hybridse::codec::Schema& schema, const std::string& encoded_schema,
+                                      const std::vector<::hybridse::codec::Row>& rows,
+                                      ::openmldb::api::QueryResponse* response, butil::IOBuf* buf) {
+    auto result = std::make_shared<ColumnarResult>();
+    result->schema = encoded_schema;
+    ::openmldb::codec::ColumnarBlockBuilder builder(schema);
+    uint32_t block_size = 0;
+    for (const auto& row : rows) {
+        if (!builder.Append(row)) {
+            response->set_code(::openmldb::base::kSQLRunError);
+            response->set_msg("fail to encode columnar result");
+            return;
+        }
+        if (builder.GetRowCount() >= FLAGS_columnar_block_rows) {
+            uint32_t block_rows = builder.GetRowCount();
+            builder.Flush(&result->blocks, &block_size);
+            result->AddBlock(block_size, block_rows);
+        }
+    }
+    if (builder.GetRowCount() > 0) {
+        uint32_t block_rows = builder.GetRowCount();
+        builder.Flush(&result->blocks, &block_size);
+        result->AddBlock(block_size, block_rows);
+    }
+    // a response carries about scan_max_bytes_size, the client fetches the rest chunk by chunk
+    result->CutChunk(FLAGS_scan_max_bytes_size, response, buf);
+    if (!result->IsFinished()) {
+        response->set_result_id(columnar_results_.Put(result, ::baidu::common::timer::get_micros() / 1000));
+    }
+}
+
+void TabletImpl::FetchColumnarResult(uint64_t result_id, ::openmldb::api::QueryResponse* response,
+                                     butil::IOBuf* buf) {
+    auto result = columnar_results_.Take(result_id);
+    if (!result) {
+        response->set_code(::openmldb::base::kSQLRunError);
+        response->set_msg("columnar result is not found or expired");
+        return;
+    }
+    result->CutChunk(FLAGS_scan_max_bytes_size, response, buf);
+    if (!result->IsFinished()) {
+        columnar_results_.PutBack(result_id, result, ::baidu::common::timer::get_micros() / 1000);
+        response->set_result_id(result_id);
+    }
+}
+
+void TabletImpl::SchedExpireColumnarResult() {
+    uint32_t cnt = columnar_results_.Expire(::baidu::common::timer::get_micros() / 1000);
+    if (cnt > 0) {
+        LOG(INFO) << "drop " << cnt << " expired columnar results";
+    }
+    task_pool_.DelayTask(std::max(FLAGS_columnar_result_keep_alive_ms, 1000u),
+                         boost::bind(&TabletImpl::SchedExpireColumnarResult, this));
+}
+
 void TabletImpl::SubQuery(RpcController* ctrl, const openmldb::api::QueryRequest* request,
                           openmldb::api::QueryResponse* response, Closure* done) {
     DLOG(INFO) << "handle subquery request begin!";
@@ -1731,6 +1980,8 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
         }
     };
 
+    QueryTrace trace(request->db(), request->is_procedure() ? request->sp_name() : "");
+
     ::hybridse::base::Status status;
     ::hybridse::vm::BatchRequestRunSession session;
     // run session
@@ -1738,6 +1989,7 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
         session.EnableDebug();
     }
     bool is_procedure = request->is_procedure();
+    trace.Stage("compile");
 
     if (is_procedure) {
         std::shared_ptr<hybridse::vm::CompileInfo> request_compile_info;
@@ -1788,6 +2040,7 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
         return;
     }
 
+    trace.Stage("decode");
     auto& io_buf = static_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t buf_offset = 0;
     std::vector<::hybridse::codec::Row> input_rows(input_row_num);
@@ -1826,11 +2079,20 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
     }
     std::vector<::hybridse::codec::Row> output_rows;
     int32_t run_ret = 0;
+    session.SetMemoryLimit(static_cast<size_t>(FLAGS_query_max_memory_mb) << 20);
+    session.SetTrace(trace.GetRunTrace());
+    trace.Stage("run");
     if (request->has_task_id()) {
         run_ret = session.Run(request->task_id(), input_rows, output_rows);
     } else {
         run_ret = session.Run(input_rows, output_rows);
     }
+    RecordQueryMemory(session.GetPeakMemory(), session.IsMemoryExceeded());
+    if (session.IsMemoryExceeded()) {
+        response->set_msg("exceed query memory limit");
+        response->set_code(::openmldb::base::kExceedMaxMemory);
+        return;
+    }
     if (run_ret != 0) {
         response->set_msg(status.msg);
         response->set_code(::openmldb::base::kSQLRunError);
@@ -1839,6 +2101,7 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
     }
 
     // fill output data
+    trace.Stage("encode");
     size_t output_col_num = session.GetSchema().size();
     auto& output_common_indices = batch_request_info.output_common_column_indices;
     bool has_common_and_uncomon_slice =
@@ -1954,6 +2217,8 @@ void TabletImpl::ChangeRole(RpcController* controller, const ::openmldb::api::Ch
             }
         }
         PDLOG(INFO, "change to leader. tid[%u] pid[%u] term[%lu]", tid, pid, request->term());
+        // the rows replicated to this tablet as a follower are not observed by the result caches
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
         if (catalog_->AddTable(*(table->GetTableMeta()), table)) {
             LOG(INFO) << "add table " << table->GetName() << " to catalog with db " << table->GetDB();
         } else {
@@ -1991,6 +2256,7 @@ void TabletImpl::ChangeRole(RpcController* controller, const ::openmldb::api::Ch
         if (!table->GetDB().empty()) {
             catalog_->DeleteTable(table->GetDB(), table->GetName(), tid, pid);
         }
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -2238,6 +2504,7 @@ void TabletImpl::UpdateTableMetaForAddField(RpcController* controller,
     for (auto pit = table_map.begin(); pit != table_map.end(); ++pit) {
         uint32_t pid = pit->first;
         std::shared_ptr<Table> table = pit->second;
+        std::lock_guard<std::mutex> meta_lock(table_meta_mu_);
         // judge if field exists
         ::openmldb::api::TableMeta table_meta(*table->GetTableMeta());
         if (request->has_column_desc()) {
@@ -3082,11 +3349,17 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
             }
 
             table->SetTableStat(::openmldb::storage::kNormal);
+            result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
             replicator->SetOffset(latest_offset);
             replicator->SetSnapshotLogPartIndex(snapshot->GetOffset());
             replicator->StartSyncing();
             table->SchedGc();
             gc_pool_.DelayTask(FLAGS_gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
+            if (table->GetCompressType() == ::openmldb::type::CompressType::kZlibDict) {
+                gc_pool_.DelayTask(FLAGS_compress_dict_check_interval,
+                                   boost::bind(&TabletImpl::TrainCompressDict, this, tid, pid,
+                                               std::weak_ptr<Table>(table)));
+            }
             io_pool_.DelayTask(FLAGS_binlog_sync_to_disk_interval,
                                boost::bind(&TabletImpl::SchedSyncDisk, this, tid, pid));
             task_pool_.DelayTask(FLAGS_binlog_delete_interval,
@@ -3177,12 +3450,13 @@ int TabletImpl::LoadDiskTableInternal(uint32_t tid, uint32_t pid, const ::openml
         ::openmldb::storage::Binlog binlog(replicator->GetLogPart(), binlog_path);
         if (binlog.RecoverFromBinlog(table, snapshot_offset, latest_offset)) {
             table->SetTableStat(::openmldb::storage::kNormal);
+            result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
             replicator->SetOffset(latest_offset);
             replicator->SetSnapshotLogPartIndex(snapshot->GetOffset());
             replicator->StartSyncing();
             disk_table->SetOffset(latest_offset);
             table->SchedGc();
-            gc_pool_.DelayTask(FLAGS_disk_gc_interval * 60 * 1000,
+            gc_pool_.DelayTask(GetGcInterval(table) * 60 * 1000,
                                boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
             io_pool_.DelayTask(FLAGS_binlog_sync_to_disk_interval,
                                boost::bind(&TabletImpl::SchedSyncDisk, this, tid, pid));
@@ -3248,6 +3522,7 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
             if (snapshots_[tid].empty()) {
                 snapshots_.erase(tid);
             }
+            PublishPartitionsUnLock();
         }
         engine_->ClearCacheLocked("");
         if (replicator) {
@@ -3257,19 +3532,23 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
         if (!table->GetDB().empty()) {
             catalog_->DeleteTable(table->GetDB(), table->GetName(), tid, pid);
         }
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
         // delete related aggregator
         uint32_t base_tid = table->GetTableMeta()->base_table_tid();
         if (base_tid > 0) {
             std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
             uint64_t uid = (uint64_t)base_tid << 32 | pid;
             if (auto it = aggregators_.find(uid); it != aggregators_.end()) {
-                auto& aggrs = *it->second;
-                for (auto it = aggrs.begin(); it != aggrs.end(); it++) {
-                    if ((*it)->GetAggrTid() == tid) {
-                        aggrs.erase(it);
+                // readers may still iterate the old vector
+                auto aggrs = std::make_shared<Aggrs>(*it->second);
+                for (auto aggr_it = aggrs->begin(); aggr_it != aggrs->end(); aggr_it++) {
+                    if ((*aggr_it)->GetAggrTid() == tid) {
+                        aggrs->erase(aggr_it);
                         break;
                     }
                 }
+                it->second = aggrs;
+                PublishPartitionsUnLock();
             }
         }
         // bulk load data receiver should be destroyed too, and can't do table and data receiver destroy at the same
@@ -3384,8 +3663,13 @@ void TabletImpl::CreateTable(RpcController* controller, const ::openmldb::api::C
     task_pool_.DelayTask(FLAGS_binlog_delete_interval, boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid));
     PDLOG(INFO, "create table with id %u pid %u name %s", tid, pid, name.c_str());
 
-    int gc_interval = table->GetStorageMode() == common::kMemory ? FLAGS_gc_interval : FLAGS_disk_gc_interval;
+    int gc_interval = GetGcInterval(table);
     gc_pool_.DelayTask(gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
+    if (table->GetStorageMode() == common::kMemory &&
+        table->GetCompressType() == ::openmldb::type::CompressType::kZlibDict) {
+        gc_pool_.DelayTask(FLAGS_compress_dict_check_interval,
+                           boost::bind(&TabletImpl::TrainCompressDict, this, tid, pid, std::weak_ptr<Table>(table)));
+    }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
 }
@@ -3471,6 +3755,12 @@ base::Status TabletImpl::TruncateTableInternal(uint32_t tid, uint32_t pid) {
         {
             std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
             tables_[tid].insert_or_assign(pid, new_table);
+            PublishPartitionsUnLock();
+        }
+        if (new_table->GetCompressType() == ::openmldb::type::CompressType::kZlibDict) {
+            gc_pool_.DelayTask(FLAGS_compress_dict_check_interval,
+                               boost::bind(&TabletImpl::TrainCompressDict, this, tid, pid,
+                                           std::weak_ptr<Table>(new_table)));
         }
         auto mem_snapshot = std::dynamic_pointer_cast<storage::MemTableSnapshot>(snapshot);
         mem_snapshot->Truncate(replicator->GetOffset(), replicator->GetLeaderTerm());
@@ -3490,6 +3780,7 @@ base::Status TabletImpl::TruncateTableInternal(uint32_t tid, uint32_t pid) {
         }
         snapshot_pool_.AddTask(boost::bind(&TabletImpl::MakeSnapshotInternal, this, tid, pid, 0, nullptr, true));
     }
+    result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     PDLOG(INFO, "truncate table success. tid[%u] pid[%u]", tid, pid);
     return {};
 }
@@ -3905,6 +4196,8 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
     std::string table_db_path = GetDBPath(db_root_path, tid, pid);
     if (table_meta->storage_mode() == openmldb::common::kMemory) {
         table = std::make_shared<MemTable>(*table_meta);
+    } else if (table_meta->memory_head_minutes() > 0) {
+        table = std::make_shared<HybridTable>(*table_meta, table_db_path);
     } else {
         table = std::make_shared<DiskTable>(*table_meta, table_db_path);
     }
@@ -3955,6 +4248,7 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
     tables_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), table));
     snapshots_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), snapshot));
     replicators_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), replicator));
+    PublishPartitionsUnLock();
     if (!table_meta->db().empty() && table_meta->mode() == ::openmldb::api::TableMode::kTableLeader) {
         if (catalog_->AddTable(*table_meta, table)) {
             LOG(INFO) << "add table " << table_meta->name() << " to catalog with db " << table_meta->db();
@@ -4141,7 +4435,7 @@ bool TabletImpl::IsExistTaskUnLock(const ::openmldb::api::TaskInfo& task) {
 void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
     std::shared_ptr<Table> table = GetTable(tid, pid);
     if (table) {
-        int32_t gc_interval = table->GetStorageMode() == common::kMemory ? FLAGS_gc_interval : FLAGS_disk_gc_interval;
+        int32_t gc_interval = GetGcInterval(table);
         table->SchedGc();
         if (!execute_once) {
             gc_pool_.DelayTask(gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
@@ -4150,9 +4444,33 @@ void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
     }
 }
 
+void TabletImpl::TrainCompressDict(uint32_t tid, uint32_t pid, const std::weak_ptr<Table>& table) {
+    auto cur_table = GetTable(tid, pid);
+    if (!cur_table || cur_table != table.lock()) {
+        // the new table of a reload or truncate has its own chain
+        PDLOG(INFO, "stop training compress dict of a dropped or replaced table. tid %u, pid %u", tid, pid);
+        return;
+    }
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(cur_table);
+    if (!mem_table) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> meta_lock(table_meta_mu_);
+        if (mem_table->TrainCompressDict(static_cast<uint64_t>(FLAGS_compress_dict_retrain_interval) * 60 * 1000)) {
+            // persist the dict, so rows loaded after restart are compressed from the beginning
+            std::string root_path;
+            if (ChooseDBRootPath(tid, pid, mem_table->GetStorageMode(), root_path)) {
+                WriteTableMeta(GetDBPath(root_path, tid, pid), mem_table->GetTableMeta().get());
+            }
+        }
+    }
+    gc_pool_.DelayTask(FLAGS_compress_dict_check_interval,
+                       boost::bind(&TabletImpl::TrainCompressDict, this, tid, pid, table));
+}
+
 std::shared_ptr<Snapshot> TabletImpl::GetSnapshot(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetSnapshotUnLock(tid, pid);
+    return partitions_.GetSnapshot(tid, pid);
 }
 
 std::shared_ptr<Snapshot> TabletImpl::GetSnapshotUnLock(uint32_t tid, uint32_t pid) {
@@ -4178,14 +4496,10 @@ std::shared_ptr<LogReplicator> TabletImpl::GetReplicatorUnLock(uint32_t tid, uin
 }
 
 std::shared_ptr<LogReplicator> TabletImpl::GetReplicator(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetReplicatorUnLock(tid, pid);
+    return partitions_.GetReplicator(tid, pid);
 }
 
-std::shared_ptr<Table> TabletImpl::GetTable(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetTableUnLock(tid, pid);
-}
+std::shared_ptr<Table> TabletImpl::GetTable(uint32_t tid, uint32_t pid) { return partitions_.GetTable(tid, pid); }
 
 std::shared_ptr<Table> TabletImpl::GetTableUnLock(uint32_t tid, uint32_t pid) {
     Tables::iterator it = tables_.find(tid);
@@ -4198,18 +4512,40 @@ std::shared_ptr<Table> TabletImpl::GetTableUnLock(uint32_t tid, uint32_t pid) {
     return std::shared_ptr<Table>();
 }
 
-std::shared_ptr<Aggrs> TabletImpl::GetAggregators(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetAggregatorsUnLock(tid, pid);
+std::shared_ptr<const Aggrs> TabletImpl::GetAggregators(uint32_t tid, uint32_t pid) {
+    return partitions_.GetAggrs(tid, pid);
 }
 
-std::shared_ptr<Aggrs> TabletImpl::GetAggregatorsUnLock(uint32_t tid, uint32_t pid) {
+std::shared_ptr<const Aggrs> TabletImpl::GetAggregatorsUnLock(uint32_t tid, uint32_t pid) {
     uint64_t uid = (uint64_t)tid << 32 | pid;
     auto it = aggregators_.find(uid);
     if (it != aggregators_.end()) {
         return it->second;
     }
-    return std::shared_ptr<Aggrs>();
+    return std::shared_ptr<const Aggrs>();
+}
+
+void TabletImpl::PublishPartitionsUnLock() {
+    auto entries = std::make_shared<PartitionRegistry::EntryMap>();
+    for (const auto& kv : tables_) {
+        for (const auto& table_kv : kv.second) {
+            (*entries)[PartitionRegistry::Key(kv.first, table_kv.first)].table = table_kv.second;
+        }
+    }
+    for (const auto& kv : replicators_) {
+        for (const auto& replicator_kv : kv.second) {
+            (*entries)[PartitionRegistry::Key(kv.first, replicator_kv.first)].replicator = replicator_kv.second;
+        }
+    }
+    for (const auto& kv : snapshots_) {
+        for (const auto& snapshot_kv : kv.second) {
+            (*entries)[PartitionRegistry::Key(kv.first, snapshot_kv.first)].snapshot = snapshot_kv.second;
+        }
+    }
+    for (const auto& kv : aggregators_) {
+        (*entries)[kv.first].aggrs = kv.second;
+    }
+    partitions_.Publish(entries);
 }
 
 bool TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& value,
@@ -4345,6 +4681,13 @@ void TabletImpl::RefreshTableInfo() {
     } catch (const std::exception& e) {
         LOG(WARNING) << "value is not integer";
     }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    if (FLAGS_enable_catalog_delta_refresh && catalog_loaded_.load(std::memory_order_relaxed) &&
+        RefreshTableInfoDelta(version)) {
+        *g_catalog_refresh_latency.get_stats({"delta"}) << ::baidu::common::timer::get_micros() - start_time;
+        RefreshAggrCatalog();
+        return;
+    }
     std::string db_table_data_path = zk_path_ + "/table/db_table_data";
     std::vector<std::string> table_datas;
     if (zk_client_->IsExistNode(db_table_data_path) == 0) {
@@ -4440,10 +4783,49 @@ void TabletImpl::RefreshTableInfo() {
             }
         }
     }
+    catalog_loaded_.store(true, std::memory_order_relaxed);
+    *g_catalog_refresh_latency.get_stats({"full"}) << ::baidu::common::timer::get_micros() - start_time;
 
     RefreshAggrCatalog();
 }
 
+bool TabletImpl::RefreshTableInfoDelta(uint64_t version) {
+    uint64_t cur_version = catalog_->GetVersion();
+    ::openmldb::catalog::CatalogDelta delta;
+    if (!::openmldb::catalog::LoadCatalogDelta(zk_client_, zk_path_, cur_version, version, &delta)) {
+        LOG(INFO) << "fall back to full catalog refresh. version " << cur_version << " -> " << version;
+        return false;
+    }
+    bool updated = false;
+    for (const auto& change : delta.deleted_tables) {
+        updated |= catalog_->RemoveTable(change.db(), change.name(), change.tid());
+    }
+    for (const auto& table_info : delta.tables) {
+        if (bool index_updated = false; catalog_->UpdateTableInfo(table_info, &index_updated) && index_updated) {
+            updated = true;
+        }
+    }
+    for (const auto& change : delta.deleted_procedures) {
+        catalog_->DropProcedure(change.db(), change.name());
+    }
+    if (updated) {
+        engine_->ClearCacheLocked("");
+    }
+    // procedure nodes are only written on creation, so a changed node is always compiled again
+    for (const auto& sp_info : delta.procedures) {
+        if (catalog_->GetProcedureInfo(sp_info->GetDbName(), sp_info->GetSpName())) {
+            catalog_->DropProcedure(sp_info->GetDbName(), sp_info->GetSpName());
+        }
+        catalog_->AddProcedure(sp_info->GetDbName(), sp_info->GetSpName(), sp_info);
+        CreateProcedure(sp_info);
+    }
+    catalog_->SetVersion(version);
+    LOG(INFO) << "refresh catalog with " << delta.tables.size() + delta.deleted_tables.size() << " table and "
+              << delta.procedures.size() + delta.deleted_procedures.size() << " procedure changes. version "
+              << version;
+    return true;
+}
+
 bool TabletImpl::RefreshAggrCatalog() {
     std::string meta_db = nameserver::INTERNAL_DB;
     std::string meta_table = nameserver::PRE_AGG_META_NAME;
@@ -4663,6 +5045,39 @@ void TabletImpl::GetDiskused() {
     task_pool_.DelayTask(FLAGS_get_table_diskused_interval, boost::bind(&TabletImpl::GetDiskused, this));
 }
 
+bool TabletImpl::AdmitMemoryWrite(const std::shared_ptr<Table>& table) {
+    uint32_t tid = table->GetId();
+    uint32_t pid = table->GetPid();
+    MemoryQuota process_quota(FLAGS_max_memory_mb, FLAGS_memory_soft_limit_ratio, FLAGS_memory_max_write_delay_us);
+    uint64_t process_used = memory_used_.load(std::memory_order_relaxed);
+    QuotaState state = process_quota.Check(process_used);
+    uint64_t delay_us = process_quota.GetDelayUs(process_used);
+    if (state == QuotaState::kHardLimit) {
+        PDLOG(WARNING, "current memory %lu MB exceed max memory limit %lu MB. tid %u, pid %u", process_used,
+              FLAGS_max_memory_mb, tid, pid);
+    } else if (FLAGS_table_max_memory_mb > 0) {
+        MemoryQuota table_quota(static_cast<uint64_t>(FLAGS_table_max_memory_mb) << 20, FLAGS_memory_soft_limit_ratio,
+                                FLAGS_memory_max_write_delay_us);
+        uint64_t table_used = table->GetRecordByteSize() + table->GetRecordIdxByteSize();
+        QuotaState table_state = table_quota.Check(table_used);
+        if (table_state == QuotaState::kHardLimit) {
+            PDLOG(WARNING, "table memory %lu bytes exceed max table memory limit %u MB. tid %u, pid %u", table_used,
+                  FLAGS_table_max_memory_mb, tid, pid);
+        }
+        state = std::max(state, table_state);
+        delay_us = std::max(delay_us, table_quota.GetDelayUs(table_used));
+    }
+    RecordMemoryAdmission(table->GetDB(), table->GetName(), state);
+    if (state == QuotaState::kHardLimit) {
+        return false;
+    }
+    if (delay_us > 0) {
+        // slow down the writer before the hard limit is reached
+        bthread_usleep(delay_us);
+    }
+    return true;
+}
+
 void TabletImpl::GetMemoryStat() {
     auto size = base::GetRSS() >> 20;
     memory_used_.store(size, std::memory_order_relaxed);
@@ -4704,12 +5119,14 @@ void TabletImpl::DeleteIndex(RpcController* controller, const ::openmldb::api::D
         return;
     }
     MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+    std::lock_guard<std::mutex> meta_lock(table_meta_mu_);
     if (!mem_table->DeleteIndex(request->idx_name())) {
         response->set_code(::openmldb::base::ReturnCode::kDeleteIndexFailed);
         response->set_msg("delete index failed");
         PDLOG(WARNING, "delete index %s failed. tid %u pid %u", request->idx_name().c_str(), tid, pid);
         return;
     }
+    result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     std::string db_path = GetDBPath(root_path, tid, pid);
     WriteTableMeta(db_path, table->GetTableMeta().get());
     PDLOG(INFO, "delete index %s success. tid %u pid %u", request->idx_name().c_str(), tid, pid);
@@ -4891,6 +5308,7 @@ void TabletImpl::ExtractIndexDataInternal(std::shared_ptr<::openmldb::storage::T
         }
     }
     auto status = memtable_snapshot->ExtractIndexData(table, column_keys, whs, offset, dump_data);
+    result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     if (status.OK()) {
         PDLOG(INFO, "extract index on table tid[%u] pid[%u] succeed", tid, pid);
         SetTaskStatus(task, ::openmldb::api::kDone);
@@ -5034,6 +5452,9 @@ void TabletImpl::LoadIndexDataInternal(uint32_t tid, uint32_t pid, uint32_t cur_
         replicator->AppendEntry(entry);
         succ_cnt++;
     }
+    if (succ_cnt > 0) {
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
+    }
     if (cur_pid == partition_num - 1 || (cur_pid + 1 == pid && pid == partition_num - 1)) {
         if (FLAGS_recycle_bin_enabled) {
             std::string recycle_bin_root_path;
@@ -5147,6 +5568,7 @@ void TabletImpl::AddIndex(RpcController* controller, const ::openmldb::api::AddI
         base::SetResponseStatus(base::ReturnCode::kTableTypeMismatch, "table is not memtable", response);
         return;
     }
+    std::lock_guard<std::mutex> meta_lock(table_meta_mu_);
     if (request->column_keys_size() > 0) {
         for (const auto& column_key : request->column_keys()) {
             // TODO(denglong): support add multi indexs in memory table
@@ -5163,6 +5585,7 @@ void TabletImpl::AddIndex(RpcController* controller, const ::openmldb::api::AddI
             return;
         }
     }
+    result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
     std::string db_root_path;
     bool ok = ChooseDBRootPath(tid, pid, table->GetStorageMode(), db_root_path);
     if (!ok) {
@@ -5327,8 +5750,10 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
         LOG(WARNING) << "fail to add procedure " << sp_name << " to catalog with db " << db_name;
     }
 
-    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+    sp_cache_->InsertSQLProcedureCacheEntry(
+        db_name, sp_name, sp_info_impl, session.GetCompileInfo(), batch_session.GetCompileInfo(),
+        DeployResultCache::Create(*sp_info_impl, static_cast<uint64_t>(FLAGS_deploy_result_cache_max_mb) * 1024 * 1024,
+                                  result_cache_versions_));
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -5365,10 +5790,15 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
 
 void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::QueryRequest& request,
                                  ::hybridse::vm::RequestRunSession& session, openmldb::api::QueryResponse& response,
-                                 butil::IOBuf& buf) {
+                                 butil::IOBuf& buf, QueryTrace* trace) {
     if (request.is_debug()) {
         session.EnableDebug();
     }
+    static BthreadExecutor parallel_executor;
+    session.SetMaxParallelProducers(FLAGS_request_max_parallel_producers);
+    session.SetParallelExecutor(&parallel_executor);
+    session.SetMemoryLimit(static_cast<size_t>(FLAGS_query_max_memory_mb) << 20);
+    trace->Stage("decode");
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
@@ -5377,22 +5807,72 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
         response.set_msg("fail to decode input row");
         return;
     }
+    trace->Stage("run");
     ::hybridse::codec::Row output;
-    int32_t ret = 0;
-    if (request.has_task_id()) {
-        ret = session.Run(request.task_id(), row, &output);
-    } else {
-        ret = session.Run(row, &output);
-    }
-    if (ret != 0) {
-        response.set_code(::openmldb::base::kSQLRunError);
-        response.set_msg("fail to run sql");
-        return;
-    } else if (row.GetRowPtrCnt() != 1) {
-        response.set_code(::openmldb::base::kSQLRunError);
-        response.set_msg("do not support multiple output row slices");
-        return;
+    std::shared_ptr<DeployResultCache> result_cache;
+    DeployResultCache::Snapshot snapshot;
+    bool cache_hit = false;
+    if (request.is_procedure() && !request.has_task_id() && !request.is_debug()) {
+        result_cache = sp_cache_->GetResultCache(request.db(), request.sp_name());
+        if (result_cache) {
+            cache_hit = result_cache->Get(row, &output, &snapshot);
+        }
+    }
+    if (!cache_hit) {
+        int32_t ret = 0;
+        std::shared_ptr<hybridse::vm::CompileInfo> batch_compile_info;
+        if (request_coalescer_ && request.is_procedure() && !request.has_task_id() && !request.is_debug()) {
+            hybridse::base::Status status;
+            batch_compile_info = sp_cache_->GetBatchRequestInfo(request.db(), request.sp_name(), status);
+            // rows with common columns are split into two slices in batch request mode, run them separately
+            if (!status.isOK() || !batch_compile_info ||
+                !batch_compile_info->GetBatchRequestInfo().common_column_indices.empty()) {
+                batch_compile_info.reset();
+            }
+        }
+        bool memory_exceeded = false;
+        if (request.has_task_id()) {
+            ret = session.Run(request.task_id(), row, &output);
+            memory_exceeded = session.IsMemoryExceeded();
+        } else if (batch_compile_info && row.GetRowPtrCnt() == 1) {
+            // run by the leader of the batch only, the memory of the batch is recorded once
+            auto executor = [&batch_compile_info, &request](const std::vector<::hybridse::codec::Row>& inputs,
+                                                            std::vector<::hybridse::codec::Row>* outputs) {
+                ::hybridse::vm::BatchRequestRunSession batch_session;
+                batch_session.SetCompileInfo(batch_compile_info);
+                batch_session.SetSpName(request.sp_name());
+                batch_session.SetMemoryLimit(static_cast<size_t>(FLAGS_query_max_memory_mb) << 20);
+                int32_t batch_ret = batch_session.Run(inputs, *outputs);
+                RecordQueryMemory(batch_session.GetPeakMemory(), batch_session.IsMemoryExceeded());
+                return batch_session.IsMemoryExceeded() ? RequestCoalescer::kMemoryExceeded : batch_ret;
+            };
+            ret = request_coalescer_->Run(absl::StrCat(request.db(), ".", request.sp_name()), row, executor,
+                                          &output);
+            memory_exceeded = ret == RequestCoalescer::kMemoryExceeded;
+        } else {
+            ret = session.Run(row, &output);
+            RecordQueryMemory(session.GetPeakMemory(), session.IsMemoryExceeded());
+            memory_exceeded = session.IsMemoryExceeded();
+        }
+        if (memory_exceeded) {
+            response.set_code(::openmldb::base::kExceedMaxMemory);
+            response.set_msg("exceed query memory limit");
+            return;
+        }
+        if (ret != 0) {
+            response.set_code(::openmldb::base::kSQLRunError);
+            response.set_msg("fail to run sql");
+            return;
+        } else if (row.GetRowPtrCnt() != 1) {
+            response.set_code(::openmldb::base::kSQLRunError);
+            response.set_msg("do not support multiple output row slices");
+            return;
+        }
+        if (result_cache) {
+            result_cache->Put(row, output, std::move(snapshot));
+        }
     }
+    trace->Stage("encode");
     size_t buf_total_size;
     if (!codec::EncodeRpcRow(output, &buf, &buf_total_size)) {
         response.set_code(::openmldb::base::kSQLRunError);
@@ -5442,8 +5922,10 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
         LOG(WARNING) << "fail to compile batch request for sql " << sql;
         return;
     }
-    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+    sp_cache_->InsertSQLProcedureCacheEntry(
+        db_name, sp_name, sp_info, session.GetCompileInfo(), batch_session.GetCompileInfo(),
+        DeployResultCache::Create(*sp_info, static_cast<uint64_t>(FLAGS_deploy_result_cache_max_mb) * 1024 * 1024,
+                                  result_cache_versions_));
 
     LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
 }
@@ -5608,6 +6090,7 @@ void TabletImpl::BulkLoad(RpcController* controller, const ::openmldb::api::Bulk
             LOG(WARNING) << tid << "-" << pid << " " << response->msg();
             return;
         }
+        result_cache_versions_->OnTableChanged(table->GetDB(), table->GetName());
 
         uint64_t load_time = ::baidu::common::timer::get_micros();
         PDLOG(INFO, "%u-%u, bulk load only load cost %lu us", request->tid(), request->pid(), load_time - start_time);
@@ -5756,11 +6239,13 @@ bool TabletImpl::CreateAggregatorInternal(const ::openmldb::api::CreateAggregato
     uint64_t uid = (uint64_t)base_meta.tid() << 32 | base_meta.pid();
     {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-        auto iter = aggregators_.find(uid);
-        if (iter == aggregators_.end()) {
-            iter = aggregators_.emplace(uid, std::make_shared<Aggrs>()).first;
+        auto aggrs = std::make_shared<Aggrs>();
+        if (auto iter = aggregators_.find(uid); iter != aggregators_.end()) {
+            *aggrs = *iter->second;
         }
-        iter->second->push_back(aggregator);
+        aggrs->push_back(aggregator);
+        aggregators_[uid] = aggrs;
+        PublishPartitionsUnLock();
     }
     return true;
 }
@@ -39,8 +39,13 @@
 #include "storage/mem_table.h"
 #include "storage/mem_table_snapshot.h"
 #include "tablet/bulk_load_mgr.h"
+#include "tablet/columnar_result_store.h"
 #include "tablet/combine_iterator.h"
 #include "tablet/file_receiver.h"
+#include "tablet/memory_quota.h"
+#include "tablet/partition_registry.h"
+#include "tablet/query_trace.h"
+#include "tablet/request_coalescer.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
 #include "zk/zk_client.h"
@@ -68,7 +73,7 @@ inline constexpr uint32_t INVALID_REMOTE_TID = UINT32_MAX;
 typedef std::map<uint32_t, std::map<uint32_t, std::shared_ptr<Table>>> Tables;
 typedef std::map<uint32_t, std::map<uint32_t, std::shared_ptr<LogReplicator>>> Replicators;
 typedef std::map<uint32_t, std::map<uint32_t, std::shared_ptr<Snapshot>>> Snapshots;
-typedef std::map<uint64_t, std::shared_ptr<Aggrs>> Aggregators;
+typedef std::map<uint64_t, std::shared_ptr<const Aggrs>> Aggregators;
 
 class TabletImpl : public ::openmldb::api::TabletServer {
  public:
@@ -91,6 +96,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Scan(RpcController* controller, const ::openmldb::api::ScanRequest* request,
               ::openmldb::api::ScanResponse* response, Closure* done);
 
+    void MultiScan(RpcController* controller, const ::openmldb::api::MultiScanRequest* request,
+                   ::openmldb::api::MultiScanResponse* response, Closure* done);
+
     void Delete(RpcController* controller, const ::openmldb::api::DeleteRequest* request,
                 ::openmldb::api::GeneralResponse* response, Closure* done);
 
@@ -267,7 +275,7 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void CreateAggregator(RpcController* controller, const ::openmldb::api::CreateAggregatorRequest* request,
                           ::openmldb::api::CreateAggregatorResponse* response, Closure* done);
 
-    std::shared_ptr<Aggrs> GetAggregators(uint32_t tid, uint32_t pid);
+    std::shared_ptr<const Aggrs> GetAggregators(uint32_t tid, uint32_t pid);
 
     void GetAndFlushDeployStats(::google::protobuf::RpcController* controller,
                                 const ::openmldb::api::GAFDeployStatsRequest* request,
@@ -297,10 +305,17 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     std::shared_ptr<Snapshot> GetSnapshotUnLock(uint32_t tid, uint32_t pid);
 
-    std::shared_ptr<Aggrs> GetAggregatorsUnLock(uint32_t tid, uint32_t pid);
+    std::shared_ptr<const Aggrs> GetAggregatorsUnLock(uint32_t tid, uint32_t pid);
+
+    // rebuild the lock free view of the partitions after tables_, replicators_, snapshots_ or
+    // aggregators_ changed, spin_mutex_ must be held
+    void PublishPartitionsUnLock();
 
     void GcTable(uint32_t tid, uint32_t pid, bool execute_once);
 
+    // the chain of checks stops once `table` is dropped or replaced by a reload or truncate
+    void TrainCompressDict(uint32_t tid, uint32_t pid, const std::weak_ptr<Table>& table);
+
     void GcTableSnapshot(uint32_t tid, uint32_t pid);
 
     int CheckTableMeta(const openmldb::api::TableMeta* table_meta,
@@ -339,10 +354,16 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void GetMemoryStat();
 
+    // check the process and table memory quota before a write, may delay the caller
+    bool AdmitMemoryWrite(const std::shared_ptr<Table>& table);
+
     void CheckZkClient();
 
     void RefreshTableInfo();
 
+    // apply the change records up to `version` to the catalog, return false if a full refresh is needed
+    bool RefreshTableInfoDelta(uint64_t version);
+
     void UpdateGlobalVarTable();
 
     bool RefreshSingleTable(uint32_t tid);
@@ -406,6 +427,12 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void ProcessQuery(bool is_sub, RpcController* controller, const openmldb::api::QueryRequest* request,
                       ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+    // send the first chunk of a columnar result and keep the rest in `columnar_results_`
+    void EncodeColumnarResult(const ::hybridse::codec::Schema& schema, const std::string& encoded_schema,
+                              const std::vector<::hybridse::codec::Row>& rows,
+                              ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+    void FetchColumnarResult(uint64_t result_id, ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+    void SchedExpireColumnarResult();
     void ProcessBatchRequestQuery(bool is_sub, RpcController* controller,
                                   const openmldb::api::SQLBatchRequestQueryRequest* request,
                                   openmldb::api::SQLBatchRequestQueryResponse* response,
@@ -428,7 +455,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void RunRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
                          ::hybridse::vm::RequestRunSession& session,                  // NOLINT
-                         openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+                         openmldb::api::QueryResponse& response, butil::IOBuf& buf,  // NOLINT
+                         QueryTrace* trace);
 
     void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
 
@@ -438,11 +466,15 @@ class TabletImpl : public ::openmldb::api::TabletServer {
  private:
     Tables tables_;
     std::mutex mu_;
+    // serializes the read-modify-write of a table meta and the write of its table_meta.txt
+    std::mutex table_meta_mu_;
     SpinMutex spin_mutex_;
     ThreadPool gc_pool_;
     Replicators replicators_;
     Snapshots snapshots_;
     Aggregators aggregators_;
+    // read path of the four maps above, they stay the source of truth for the writers
+    PartitionRegistry partitions_;
     ZkClient* zk_client_;
     ThreadPool keep_alive_pool_;
     ThreadPool task_pool_;
@@ -465,6 +497,12 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::string zk_path_;
     std::string endpoint_;
     std::shared_ptr<SpCache> sp_cache_;
+    // write versions observed by the deployment result caches
+    std::shared_ptr<ResultCacheVersions> result_cache_versions_;
+    // nullptr if request coalescing is disabled
+    std::unique_ptr<RequestCoalescer> request_coalescer_;
+    // columnar results which are not fetched fully
+    ColumnarResultStore columnar_results_;
     std::string notify_path_;
     std::string sp_root_path_;
     std::string globalvar_changed_notify_path_;
@@ -474,6 +512,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     std::unique_ptr<openmldb::statistics::DeploymentMetricCollector> deploy_collector_;
     std::atomic<uint64_t> memory_used_ = 0;
+    // the catalog is loaded from zk fully at least once, later refreshes may apply the change records only
+    std::atomic<bool> catalog_loaded_ = false;
 };
 
 }  // namespace tablet
@@ -1803,6 +1803,51 @@ TEST_P(TabletImplTest, ScanWithLimit) {
     ASSERT_EQ(2, (signed)srp.count());
 }
 
+TEST_P(TabletImplTest, MultiScan) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    for (uint64_t ts = 9527; ts < 9530; ts++) {
+        ASSERT_EQ(0, PutKVData(id, 1, "test1", "value" + std::to_string(ts), ts, &tablet));
+    }
+    ASSERT_EQ(0, PutKVData(id, 1, "test2", "value", 9527, &tablet));
+    ::openmldb::api::MultiScanRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    auto key = request.add_keys();
+    key->set_pk("test1");
+    key->set_limit(2);
+    key = request.add_keys();
+    key->set_pk("test3");
+    key = request.add_keys();
+    key->set_pk("test2");
+    key = request.add_keys();
+    key->set_pk("test1");
+    key->set_idx_name("unknown");
+    ::openmldb::api::MultiScanResponse response;
+    brpc::Controller cntl;
+    MockClosure closure;
+    tablet.MultiScan(&cntl, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(4, response.results_size());
+    ASSERT_EQ(0, response.results(0).code());
+    ASSERT_EQ(2u, response.results(0).count());
+    ASSERT_FALSE(response.results(0).is_finish());
+    ASSERT_EQ(0, response.results(1).code());
+    ASSERT_EQ(0u, response.results(1).count());
+    ASSERT_EQ(0u, response.results(1).buf_size());
+    ASSERT_EQ(1u, response.results(2).count());
+    ASSERT_EQ(::openmldb::base::ReturnCode::kIdxNameNotFound, response.results(3).code());
+    ASSERT_EQ(response.results(0).buf_size() + response.results(2).buf_size(), cntl.response_attachment().size());
+
+    request.set_pid(2);
+    response.Clear();
+    tablet.MultiScan(&cntl, &request, &response, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kTableIsNotExist, response.code());
+}
+
 TEST_P(TabletImplTest, Scan) {
     ::openmldb::common::StorageMode storage_mode = GetParam();
     TabletImpl tablet;